@@ -0,0 +1,101 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchperf.h"
+
+#include <glog/logging.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! \return the counters of the calling thread, or null if not available.
+PerfCounters* threadCounters() {
+  thread_local std::unique_ptr<PerfCounters> myCounters;
+  thread_local bool                          myTried = false;
+  if (not myTried) {
+    myTried = true;
+    try {
+      myCounters = std::make_unique<PerfCounters>();
+    } catch (const std::runtime_error& aErr) {
+      static bool myWarned = false;
+      LOG_IF(WARNING, not myWarned)
+          << aErr.what() << ", hardware counters will not be reported";
+      myWarned = true;
+    }
+  }
+  return myCounters.get();
+}
+
+} // namespace
+
+BenchPerf::BenchPerf()
+    : theCounters(threadCounters())
+    , theStart()
+    , theTotal() {
+  // noop
+}
+
+void BenchPerf::start() {
+  if (theCounters != nullptr) {
+    theStart = theCounters->read();
+  }
+}
+
+void BenchPerf::stop() {
+  if (theCounters != nullptr) {
+    theTotal += theCounters->read() - theStart;
+  }
+}
+
+void BenchPerf::report(benchmark::State& aState) const {
+  if (theCounters == nullptr) {
+    return;
+  }
+  const auto myAvg = [](const double aValue) {
+    return benchmark::Counter(aValue, benchmark::Counter::kAvgIterations);
+  };
+  aState.counters["cycles"]        = myAvg(theTotal.theCycles);
+  aState.counters["instructions"]  = myAvg(theTotal.theInstructions);
+  aState.counters["llc-misses"]    = myAvg(theTotal.theLlcMisses);
+  aState.counters["branch-misses"] = myAvg(theTotal.theBranchMisses);
+  aState.counters["ipc"] =
+      theTotal.theCycles == 0 ?
+          0.0 :
+          static_cast<double>(theTotal.theInstructions) / theTotal.theCycles;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,71 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/perfcounters.h"
+
+#include <benchmark/benchmark.h>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Hardware performance counters accumulated in the sections of a
+ * benchmark between start() and stop(), which are reported as user counters
+ * averaged per iteration: cycles, instructions, LLC misses, branch misses,
+ * and instructions per cycle.
+ *
+ * If the counters are not available, e.g., in a virtual machine, then a
+ * warning is printed once and nothing is reported.
+ */
+class BenchPerf final
+{
+ public:
+  BenchPerf();
+
+  //! Start counting.
+  void start();
+
+  //! Stop counting and accumulate the increments since start().
+  void stop();
+
+  //! Add the counters accumulated to the benchmark output.
+  void report(benchmark::State& aState) const;
+
+ private:
+  PerfCounters* const  theCounters;
+  PerfCounters::Sample theStart;
+  PerfCounters::Sample theTotal;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,272 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchtopology.h"
+
+#include "QuantumRouting/networkfactory.h"
+#include "Support/random.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+struct TopologyEntry {
+  std::string theName;
+  std::string theDataset; //!< base name of the files, empty with PPP
+  std::size_t theMu;      //!< average number of nodes, only with PPP
+};
+
+const std::vector<TopologyEntry>& topologyEntries() {
+  static const std::vector<TopologyEntry> myEntries({
+      {"garr", "var-load/graph/garr-0", 0},
+      {"topo-40", "var-net/graph/topo-40-0", 0},
+      {"topo-120", "var-net/graph/topo-120-0", 0},
+      {"topo-200", "var-net/graph/topo-200-0", 0},
+      {"ppp-50", "", 50},
+      {"ppp-100", "", 100},
+      {"ppp-1000", "", 1000},
+      {"ppp-10000", "", 10000},
+      {"ppp-100000", "", 100000},
+  });
+  return myEntries;
+}
+
+// the files contain the vertices as "id,x,y,z,capacity" and the edges as
+// pairs of lines "x,y" separated by an empty line, as saved by
+// CapacityNetwork::toGnuplot(): vertices with the same coordinates are merged
+BenchTopology loadDataset(const TopologyEntry& aEntry) {
+  const std::string myBasename =
+      std::string(BENCHQR_DATA_DIR) + "/" + aEntry.theDataset;
+
+  BenchTopology ret{aEntry.theName, {}, {}};
+
+  std::ifstream myVertices(myBasename + "-vertices.dat");
+  if (not myVertices) {
+    throw std::runtime_error("cannot read from file: " + myBasename +
+                             "-vertices.dat");
+  }
+  std::map<std::string, unsigned long> myIds;
+  std::string                          myLine;
+  while (std::getline(myVertices, myLine)) {
+    std::stringstream myStream(myLine);
+    std::string       myId, myX, myY, myZ;
+    std::getline(myStream, myId, ',');
+    std::getline(myStream, myX, ',');
+    std::getline(myStream, myY, ',');
+    std::getline(myStream, myZ, ',');
+    if (myIds.emplace(myX + "," + myY, ret.theCoordinates.size()).second) {
+      ret.theCoordinates.emplace_back(
+          std::stod(myX), std::stod(myY), std::stod(myZ));
+    }
+  }
+
+  std::ifstream myEdges(myBasename + "-edges.dat");
+  if (not myEdges) {
+    throw std::runtime_error("cannot read from file: " + myBasename +
+                             "-edges.dat");
+  }
+  std::set<std::pair<unsigned long, unsigned long>> myLinks;
+  std::vector<unsigned long>                        myEndpoints;
+  while (std::getline(myEdges, myLine)) {
+    if (myLine.empty()) {
+      continue;
+    }
+    const auto it = myIds.find(myLine);
+    if (it == myIds.end()) {
+      throw std::runtime_error("unknown vertex in " + myBasename +
+                               "-edges.dat: " + myLine);
+    }
+    myEndpoints.emplace_back(it->second);
+    if (myEndpoints.size() == 2) {
+      if (myEndpoints[0] != myEndpoints[1]) {
+        myLinks.emplace(std::min(myEndpoints[0], myEndpoints[1]),
+                        std::max(myEndpoints[0], myEndpoints[1]));
+      }
+      myEndpoints.clear();
+    }
+  }
+
+  support::UniformRv myEprRv(1, 400, 0, 0, 0);
+  ret.theWeights =
+      CapacityNetwork(CapacityNetwork::EdgeVector(myLinks.begin(),
+                                                  myLinks.end()),
+                      myEprRv,
+                      true)
+          .weights();
+  return ret;
+}
+
+BenchTopology makePpp(const TopologyEntry& aEntry) {
+  const auto         myParameters = pppParameters(aEntry.theMu);
+  support::UniformRv myEprRv(1, 400, 0, 0, 0);
+  BenchTopology      ret{aEntry.theName, {}, {}};
+  ret.theWeights = makeCapacityNetworkPpp(myEprRv,
+                                          0,
+                                          myParameters.theMu,
+                                          myParameters.theGridLength,
+                                          myParameters.theThreshold,
+                                          1,
+                                          ret.theCoordinates)
+                       ->weights();
+  return ret;
+}
+
+void addCartesianProduct(benchmark::internal::Benchmark*          aBenchmark,
+                         const std::vector<std::vector<int64_t>>& aArgs,
+                         std::vector<int64_t>&                    aCurrent) {
+  const auto myDepth = aCurrent.size() - 1;
+  if (myDepth == aArgs.size()) {
+    aBenchmark->Args(aCurrent);
+    return;
+  }
+  for (const auto myValue : aArgs[myDepth]) {
+    aCurrent.emplace_back(myValue);
+    addCartesianProduct(aBenchmark, aArgs, aCurrent);
+    aCurrent.pop_back();
+  }
+}
+
+} // namespace
+
+PppParameters pppParameters(const std::size_t aMu) {
+  const double myThreshold = 15000;
+  const double myDegree    = 2 * std::log(static_cast<double>(aMu));
+  return PppParameters{static_cast<double>(aMu),
+                       myThreshold * std::sqrt(M_PI * aMu / myDegree),
+                       myThreshold};
+}
+
+const BenchTopology& benchTopology(const std::size_t aIndex) {
+  static std::map<std::size_t, BenchTopology> myTopologies;
+
+  const auto& myEntries = topologyEntries();
+  if (aIndex >= myEntries.size()) {
+    throw std::runtime_error("invalid topology index: " +
+                             std::to_string(aIndex));
+  }
+  auto it = myTopologies.find(aIndex);
+  if (it == myTopologies.end()) {
+    const auto& myEntry = myEntries[aIndex];
+    it                  = myTopologies
+             .emplace(aIndex,
+                      myEntry.theDataset.empty() ? makePpp(myEntry) :
+                                                   loadDataset(myEntry))
+             .first;
+  }
+  return it->second;
+}
+
+void addTopologies(benchmark::internal::Benchmark*          aBenchmark,
+                   const std::size_t                        aMaxNodes,
+                   const std::vector<std::vector<int64_t>>& aOtherArgs) {
+  const auto& myEntries = topologyEntries();
+  for (std::size_t i = 0; i < myEntries.size(); i++) {
+    if (myEntries[i].theMu > aMaxNodes) {
+      continue;
+    }
+    std::vector<int64_t> myCurrent({static_cast<int64_t>(i)});
+    addCartesianProduct(aBenchmark, aOtherArgs, myCurrent);
+  }
+}
+
+void addPppSizes(benchmark::internal::Benchmark* aBenchmark,
+                 const std::size_t               aMaxNodes) {
+  for (const auto& myEntry : topologyEntries()) {
+    if (myEntry.theDataset.empty() and myEntry.theMu <= aMaxNodes) {
+      aBenchmark->Arg(myEntry.theMu);
+    }
+  }
+}
+
+std::unique_ptr<CapacityNetwork> makeNetwork(const BenchTopology& aTopology) {
+  return std::make_unique<CapacityNetwork>(aTopology.theWeights);
+}
+
+std::string toGraphMl(const BenchTopology& aTopology) {
+  std::stringstream ret;
+  ret << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+         "<key attr.name=\"label\" attr.type=\"string\" for=\"node\" "
+         "id=\"d0\"/>\n"
+         "<key attr.name=\"Latitude\" attr.type=\"double\" for=\"node\" "
+         "id=\"d1\"/>\n"
+         "<key attr.name=\"Longitude\" attr.type=\"double\" for=\"node\" "
+         "id=\"d2\"/>\n"
+         "<key attr.name=\"LinkSpeedRaw\" attr.type=\"double\" for=\"edge\" "
+         "id=\"d3\"/>\n"
+         "<graph edgedefault=\"undirected\">\n";
+  for (std::size_t i = 0; i < aTopology.theCoordinates.size(); i++) {
+    ret << "<node id=\"n" << i << "\"><data key=\"d0\">" << i
+        << "</data><data key=\"d1\">"
+        << std::get<1>(aTopology.theCoordinates[i])
+        << "</data><data key=\"d2\">"
+        << std::get<0>(aTopology.theCoordinates[i]) << "</data></node>\n";
+  }
+  for (const auto& myWeight : aTopology.theWeights) {
+    // the edges are bidirectional, keep only one direction
+    if (std::get<0>(myWeight) < std::get<1>(myWeight)) {
+      ret << "<edge source=\"n" << std::get<0>(myWeight) << "\" target=\"n"
+          << std::get<1>(myWeight) << "\"><data key=\"d3\">"
+          << std::get<2>(myWeight) << "</data></edge>\n";
+    }
+  }
+  ret << "</graph>\n</graphml>\n";
+  return ret.str();
+}
+
+std::vector<std::pair<unsigned long, unsigned long>>
+randomPairs(const BenchTopology& aTopology, const std::size_t aNum) {
+  assert(aTopology.theCoordinates.size() >= 2);
+  support::UniformIntRv<unsigned long> myNodeRv(
+      0, aTopology.theCoordinates.size() - 1, 0, 0, 0);
+  std::vector<std::pair<unsigned long, unsigned long>> ret;
+  while (ret.size() < aNum) {
+    const auto mySrc = myNodeRv();
+    const auto myDst = myNodeRv();
+    if (mySrc != myDst) {
+      ret.emplace_back(mySrc, myDst);
+    }
+  }
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,111 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/qrutils.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+//! A network topology used in the benchmarks.
+struct BenchTopology {
+  std::string                   theName;
+  std::vector<Coordinate>       theCoordinates;
+  CapacityNetwork::WeightVector theWeights; //!< edges with their EPR rates
+};
+
+//! Parameters of a synthetic PPP topology.
+struct PppParameters {
+  double theMu;
+  double theGridLength;
+  double theThreshold;
+};
+
+/**
+ * @brief Return the parameters of a PPP topology with a given average number
+ * of nodes.
+ *
+ * The threshold is fixed, while the grid length is set so that the average
+ * degree grows as 2 log(aMu), which makes the network connected with high
+ * probability at all sizes.
+ */
+PppParameters pppParameters(const std::size_t aMu);
+
+/**
+ * @brief Return the topology with the given index, which is created on first
+ * use and then kept for the other benchmarks.
+ *
+ * The topologies are, in order: the datasets in the directory of the
+ * experiments (garr, topo-40, topo-120, topo-200), then synthetic PPP
+ * topologies with 50 to 100k nodes on average.
+ *
+ * @throw std::runtime_error if the index is invalid or the dataset files
+ * cannot be read
+ */
+const BenchTopology& benchTopology(const std::size_t aIndex);
+
+/**
+ * @brief Add the arguments of a benchmark: the first one is the topology
+ * index, the others are the Cartesian product of aOtherArgs.
+ *
+ * @param aBenchmark the benchmark to be configured
+ * @param aMaxNodes the PPP topologies with more nodes are skipped
+ * @param aOtherArgs the values of the other arguments
+ */
+void addTopologies(benchmark::internal::Benchmark*          aBenchmark,
+                   const std::size_t                        aMaxNodes,
+                   const std::vector<std::vector<int64_t>>& aOtherArgs = {});
+
+//! Add the average number of nodes of the PPP topologies up to aMaxNodes.
+void addPppSizes(benchmark::internal::Benchmark* aBenchmark,
+                 const std::size_t               aMaxNodes);
+
+//! \return a new network with the edges and EPR rates of the topology.
+std::unique_ptr<CapacityNetwork> makeNetwork(const BenchTopology& aTopology);
+
+//! \return the topology in GraphML format, as expected by findLinks().
+std::string toGraphMl(const BenchTopology& aTopology);
+
+//! \return aNum pairs of distinct nodes drawn randomly.
+std::vector<std::pair<unsigned long, unsigned long>>
+randomPairs(const BenchTopology& aTopology, const std::size_t aNum);
+
+} // namespace qr
+} // namespace uiiit
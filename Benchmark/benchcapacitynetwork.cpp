@@ -0,0 +1,252 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchperf.h"
+#include "Benchmark/Details/benchtopology.h"
+#include "QuantumRouting/capacitynetwork.h"
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+namespace uiiit {
+namespace qr {
+
+// route a batch of flows with random end-points on a network with all the
+// capacity available: half of the flows request a rate that sometimes requires
+// pruning edges from the shortest path; the measurement probability is 1
+// because on the long paths of the large topologies almost all the flows
+// would be infeasible otherwise
+void BM_RouteFlows(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  const auto  myNumFlows = static_cast<std::size_t>(aState.range(1));
+  aState.SetLabel(myTopology.theName);
+
+  const auto myPairs = randomPairs(myTopology, myNumFlows);
+  BenchPerf  myPerf;
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    auto myNetwork = makeNetwork(myTopology);
+    std::vector<CapacityNetwork::FlowDescriptor> myFlows;
+    for (std::size_t i = 0; i < myPairs.size(); i++) {
+      myFlows.emplace_back(
+          myPairs[i].first, myPairs[i].second, i % 2 == 0 ? 1.0 : 10.0);
+    }
+    aState.ResumeTiming();
+
+    myPerf.start();
+    myNetwork->route(myFlows);
+    myPerf.stop();
+    benchmark::DoNotOptimize(myFlows.data());
+  }
+  myPerf.report(aState);
+  aState.SetItemsProcessed(aState.iterations() * myNumFlows);
+}
+
+// route a batch of flows that require a minimum end-to-end fidelity, in
+// percent, on a network whose links have random fidelities and swap success
+// probabilities, with the search modes: 0 = shortest paths retried without
+// their smallest capacity edge and checked afterwards, 1 = same but with the
+// paths of highest fidelity, 2 = constrained search; the fraction of admitted
+// flows is reported with the time
+void BM_RouteFlowsConstrained(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  const auto  myMode     = aState.range(1);
+  aState.SetLabel(myTopology.theName);
+
+  const std::size_t myNumFlows    = 100;
+  const double      myMinFidelity = aState.range(2) / 100.0;
+  const auto        myPairs       = randomPairs(myTopology, myNumFlows);
+
+  // the qualities are drawn once so that all the modes share them
+  CapacityNetwork::QualityVector myQualities;
+  support::UniformRv             myFidelityRv(0.95, 1, 0, 0, 0);
+  support::UniformRv             mySwapRv(0.9, 1, 1, 0, 0);
+  for (const auto& myWeight : myTopology.theWeights) {
+    myQualities.emplace_back(std::get<0>(myWeight),
+                             std::get<1>(myWeight),
+                             CapacityNetwork::LinkQuality{myFidelityRv(),
+                                                          mySwapRv()});
+  }
+
+  std::size_t myAdmitted = 0;
+  BenchPerf   myPerf;
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    auto myNetwork = makeNetwork(myTopology);
+    myNetwork->linkQualities(myQualities);
+    std::vector<CapacityNetwork::FlowDescriptor> myFlows;
+    for (std::size_t i = 0; i < myPairs.size(); i++) {
+      myFlows.emplace_back(
+          myPairs[i].first, myPairs[i].second, i % 2 == 0 ? 1.0 : 10.0);
+    }
+    const auto myCheck = [&myNetwork, myMinFidelity](const auto& aFlow) {
+      return myNetwork->pathFidelity(aFlow.theSrc, aFlow.thePath) >=
+             myMinFidelity;
+    };
+    aState.ResumeTiming();
+
+    myPerf.start();
+    if (myMode == 0) {
+      myNetwork->route(myFlows, myCheck);
+    } else if (myMode == 1) {
+      myNetwork->route(
+          myFlows, CapacityNetwork::PathMetric::Fidelity, myCheck);
+    } else {
+      myNetwork->routeConstrained(myFlows, myMinFidelity);
+    }
+    myPerf.stop();
+    benchmark::DoNotOptimize(myFlows.data());
+
+    for (const auto& myFlow : myFlows) {
+      myAdmitted += myFlow.thePath.empty() ? 0 : 1;
+    }
+  }
+  myPerf.report(aState);
+  aState.counters["admitted"] =
+      static_cast<double>(myAdmitted) / (aState.iterations() * myNumFlows);
+  aState.SetItemsProcessed(aState.iterations() * myNumFlows);
+}
+
+// route elastic applications, each with three random peers, with a given
+// number of paths per peer (k) and quantum
+void BM_RouteApps(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  const auto  myK        = static_cast<std::size_t>(aState.range(1));
+  const auto  myQuantum  = static_cast<double>(aState.range(2));
+  aState.SetLabel(myTopology.theName);
+
+  const std::size_t myNumApps  = 10;
+  const std::size_t myNumPeers = 3;
+  const auto        myPairs    = randomPairs(myTopology, myNumApps * myNumPeers);
+  BenchPerf         myPerf;
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    auto myNetwork = makeNetwork(myTopology);
+    myNetwork->measurementProbability(0.9);
+    std::vector<CapacityNetwork::AppDescriptor> myApps;
+    for (std::size_t i = 0; i < myNumApps; i++) {
+      std::vector<unsigned long> myPeers;
+      for (std::size_t j = 0; j < myNumPeers; j++) {
+        // the host is the source of the first pair
+        if (myPairs[i * myNumPeers + j].second !=
+            myPairs[i * myNumPeers].first) {
+          myPeers.emplace_back(myPairs[i * myNumPeers + j].second);
+        }
+      }
+      myApps.emplace_back(myPairs[i * myNumPeers].first, myPeers, 1.0);
+    }
+    aState.ResumeTiming();
+
+    myPerf.start();
+    myNetwork->route(myApps, myQuantum, myK);
+    myPerf.stop();
+    benchmark::DoNotOptimize(myApps.data());
+  }
+  myPerf.report(aState);
+  aState.SetItemsProcessed(aState.iterations() * myNumApps);
+}
+
+// find the nodes reachable from every node, i.e., one Dijkstra per node
+void BM_ReachableNodes(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  aState.SetLabel(myTopology.theName);
+
+  const auto myNetwork = makeNetwork(myTopology);
+  BenchPerf  myPerf;
+  myPerf.start();
+  for (auto _ : aState) {
+    std::size_t myDiameter = 0;
+    auto        myReachable =
+        myNetwork->reachableNodes(1, std::numeric_limits<std::size_t>::max(),
+                                  myDiameter);
+    benchmark::DoNotOptimize(myReachable);
+  }
+  myPerf.stop();
+  myPerf.report(aState);
+  aState.SetItemsProcessed(aState.iterations() * myNetwork->numNodes());
+}
+
+// change the base capacity of all the edges at once, alternating increments
+// and decrements so that the capacities do not drift
+void BM_ApplyCapacityDeltas(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  aState.SetLabel(myTopology.theName);
+
+  auto myNetwork  = makeNetwork(myTopology);
+  auto myIncrease = myNetwork->weights();
+  auto myDecrease = myIncrease;
+  for (std::size_t i = 0; i < myIncrease.size(); i++) {
+    std::get<2>(myIncrease[i]) = 0.5;
+    std::get<2>(myDecrease[i]) = -0.5;
+  }
+  BenchPerf   myPerf;
+  std::size_t myIteration = 0;
+  myPerf.start();
+  for (auto _ : aState) {
+    auto myOverbooked = myNetwork->applyCapacityDeltas(
+        myIteration++ % 2 == 0 ? myIncrease : myDecrease);
+    benchmark::DoNotOptimize(myOverbooked);
+  }
+  myPerf.stop();
+  myPerf.report(aState);
+  aState.SetItemsProcessed(aState.iterations() * myIncrease.size());
+}
+
+BENCHMARK(BM_RouteFlows)
+    ->ArgNames({"topology", "flows"})
+    ->Apply([](auto aBenchmark) { addTopologies(aBenchmark, 100000, {{4}}); })
+    ->Unit(benchmark::kMillisecond);
+
+// topo-120 and topo-200 only
+BENCHMARK(BM_RouteFlowsConstrained)
+    ->ArgNames({"topology", "mode", "fidelity"})
+    ->ArgsProduct({{2, 3}, {0, 1, 2}, {80, 90, 95}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_RouteApps)
+    ->ArgNames({"topology", "k", "quantum"})
+    ->Apply([](auto aBenchmark) {
+      addTopologies(aBenchmark, 1000, {{1, 2, 5, 10}, {1, 10}});
+    })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReachableNodes)
+    ->ArgNames({"topology"})
+    ->Apply([](auto aBenchmark) { addTopologies(aBenchmark, 1000); })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ApplyCapacityDeltas)
+    ->ArgNames({"topology"})
+    ->Apply([](auto aBenchmark) { addTopologies(aBenchmark, 10000); })
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace qr
+} // namespace uiiit
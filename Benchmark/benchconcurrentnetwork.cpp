@@ -0,0 +1,95 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchtopology.h"
+#include "QuantumRouting/concurrentnetwork.h"
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <memory>
+
+namespace uiiit {
+namespace qr {
+
+// admit flows with random end-points from multiple threads on the same
+// network, each thread keeping at most ten flows admitted at a time by
+// releasing the oldest one: on large topologies the flows of different
+// threads mostly use disjoint edges, hence throughput should grow with the
+// number of threads
+void BM_ConcurrentAdmission(benchmark::State& aState) {
+  static std::unique_ptr<ConcurrentNetwork> theNetwork;
+
+  const auto& myTopology = benchTopology(aState.range(0));
+  aState.SetLabel(myTopology.theName);
+
+  // the network is created by the first thread, the others wait for it at
+  // the beginning of the loop
+  const std::size_t myNumFlows = 10000;
+  if (aState.thread_index() == 0) {
+    theNetwork = std::make_unique<ConcurrentNetwork>(myTopology.theWeights);
+  }
+  const auto myPairs =
+      randomPairs(myTopology, myNumFlows * (aState.thread_index() + 1));
+
+  std::deque<CapacityNetwork::FlowDescriptor> myAdmitted;
+  std::size_t                                 i = 0;
+  for (auto _ : aState) {
+    const auto& myPair = myPairs[myNumFlows * aState.thread_index() +
+                                 i++ % myNumFlows];
+    CapacityNetwork::FlowDescriptor myFlow(myPair.first, myPair.second, 1.0);
+    if (theNetwork->admit(myFlow)) {
+      myAdmitted.emplace_back(myFlow);
+    }
+    if (myAdmitted.size() > 10) {
+      theNetwork->release(myAdmitted.front());
+      myAdmitted.pop_front();
+    }
+  }
+  for (const auto& myFlow : myAdmitted) {
+    theNetwork->release(myFlow);
+  }
+  aState.SetItemsProcessed(aState.iterations());
+  if (aState.thread_index() == 0) {
+    aState.counters["conflicts"] =
+        static_cast<double>(theNetwork->numConflicts());
+  }
+}
+
+BENCHMARK(BM_ConcurrentAdmission)
+    ->ArgNames({"topology"})
+    ->Apply([](auto aBenchmark) { addTopologies(aBenchmark, 10000); })
+    ->ThreadRange(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace qr
+} // namespace uiiit
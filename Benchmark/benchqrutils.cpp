@@ -0,0 +1,145 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchperf.h"
+#include "Benchmark/Details/benchtopology.h"
+#include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/poissonpointprocess.h"
+#include "QuantumRouting/qrutils.h"
+#include "Support/random.h"
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+namespace uiiit {
+namespace qr {
+
+// find the links between the nodes of a PPP within the threshold distance
+void BM_FindLinksPpp(benchmark::State& aState) {
+  const auto myParameters = pppParameters(aState.range(0));
+  const auto myCoordinates =
+      PoissonPointProcessGrid(myParameters.theMu,
+                              0,
+                              myParameters.theGridLength,
+                              myParameters.theGridLength)();
+
+  std::size_t myNumLinks = 0;
+  BenchPerf   myPerf;
+  myPerf.start();
+  for (auto _ : aState) {
+    const auto myLinks = findLinks(myCoordinates, myParameters.theThreshold);
+    myNumLinks         = myLinks.size();
+    benchmark::DoNotOptimize(myLinks.data());
+  }
+  myPerf.stop();
+  myPerf.report(aState);
+  aState.counters["links"] = myNumLinks;
+  aState.SetItemsProcessed(aState.iterations() * myCoordinates.size());
+}
+
+// parse a GraphML topology
+void BM_FindLinksGraphMl(benchmark::State& aState) {
+  const auto& myTopology = benchTopology(aState.range(0));
+  aState.SetLabel(myTopology.theName);
+
+  const auto myGraphMl = toGraphMl(myTopology);
+  BenchPerf  myPerf;
+  myPerf.start();
+  for (auto _ : aState) {
+    std::istringstream      myStream(myGraphMl);
+    std::vector<Coordinate> myCoordinates;
+    const auto              myLinks = findLinks(myStream, myCoordinates);
+    benchmark::DoNotOptimize(myLinks.data());
+  }
+  myPerf.stop();
+  myPerf.report(aState);
+  aState.SetBytesProcessed(aState.iterations() * myGraphMl.size());
+}
+
+// create a connected network from a PPP, including the retries
+void BM_MakeCapacityNetworkPpp(benchmark::State& aState) {
+  const auto myParameters = pppParameters(aState.range(0));
+
+  for (auto _ : aState) {
+    support::UniformRv      myEprRv(1, 400, 0, 0, 0);
+    std::vector<Coordinate> myCoordinates;
+    const auto              myNetwork =
+        makeCapacityNetworkPpp(myEprRv,
+                               0,
+                               myParameters.theMu,
+                               myParameters.theGridLength,
+                               myParameters.theThreshold,
+                               1,
+                               myCoordinates);
+    benchmark::DoNotOptimize(myNetwork.get());
+  }
+}
+
+// compute the fidelity through L links
+void BM_FidelitySwapping(benchmark::State& aState) {
+  const auto L = static_cast<unsigned long>(aState.range(0));
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(fidelitySwapping(1, 1, 1, L, 0.99));
+  }
+}
+
+// look up the fidelity through L links in a table
+void BM_FidelityTable(benchmark::State& aState) {
+  const auto          L = static_cast<unsigned long>(aState.range(0));
+  const FidelityTable myTable(1, 1, 1, 0.99, L + 1);
+  for (auto _ : aState) {
+    benchmark::DoNotOptimize(myTable(L));
+  }
+}
+
+BENCHMARK(BM_FindLinksPpp)
+    ->ArgNames({"mu"})
+    ->Apply([](auto aBenchmark) { addPppSizes(aBenchmark, 100000); })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_FindLinksGraphMl)
+    ->ArgNames({"topology"})
+    ->Apply([](auto aBenchmark) { addTopologies(aBenchmark, 100000); })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_MakeCapacityNetworkPpp)
+    ->ArgNames({"mu"})
+    ->Apply([](auto aBenchmark) { addPppSizes(aBenchmark, 100000); })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_FidelitySwapping)->ArgNames({"L"})->RangeMultiplier(2)->Range(1,
+                                                                           64);
+
+BENCHMARK(BM_FidelityTable)->ArgNames({"L"})->RangeMultiplier(2)->Range(1, 64);
+
+} // namespace qr
+} // namespace uiiit
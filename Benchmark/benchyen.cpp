@@ -0,0 +1,97 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Benchmark/Details/benchperf.h"
+#include "Benchmark/Details/benchtopology.h"
+
+#include "yen/yen_ksp.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/properties.hpp>
+
+#include <optional>
+
+namespace uiiit {
+namespace qr {
+
+// find the k-shortest paths between random pairs of nodes, with the same
+// type of graph and hop weights as CapacityNetwork::route() for apps
+void BM_YenKsp(benchmark::State& aState) {
+  using Graph =
+      boost::adjacency_list<boost::listS,
+                            boost::vecS,
+                            boost::bidirectionalS,
+                            boost::no_property,
+                            boost::property<boost::edge_weight_t, double>>;
+
+  const auto& myTopology = benchTopology(aState.range(0));
+  const auto  myK        = static_cast<unsigned>(aState.range(1));
+  aState.SetLabel(myTopology.theName);
+
+  Graph myGraph(myTopology.theCoordinates.size());
+  for (const auto& myWeight : myTopology.theWeights) {
+    boost::add_edge(std::get<0>(myWeight),
+                    std::get<1>(myWeight),
+                    std::get<2>(myWeight),
+                    myGraph);
+  }
+  const auto myIndexMap = boost::get(boost::vertex_index, myGraph);
+
+  const auto  myPairs = randomPairs(myTopology, 64);
+  std::size_t i       = 0;
+  BenchPerf   myPerf;
+  myPerf.start();
+  for (auto _ : aState) {
+    const auto& myPair   = myPairs[i++ % myPairs.size()];
+    auto        myResult = boost::yen_ksp(
+        myGraph,
+        myPair.first,
+        myPair.second,
+        boost::make_static_property_map<Graph::edge_descriptor>(1),
+        myIndexMap,
+        std::optional<unsigned>(myK));
+    benchmark::DoNotOptimize(myResult);
+  }
+  myPerf.stop();
+  myPerf.report(aState);
+}
+
+BENCHMARK(BM_YenKsp)
+    ->ArgNames({"topology", "k"})
+    ->Apply([](auto aBenchmark) {
+      addTopologies(aBenchmark, 10000, {{1, 2, 5, 10}});
+    })
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace qr
+} // namespace uiiit
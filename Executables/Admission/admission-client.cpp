@@ -0,0 +1,236 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/admission.h"
+#include "QuantumRouting/admissionserver.h"
+#include "Support/glograii.h"
+#include "Support/random.h"
+#include "Support/versionutils.h"
+
+#include <boost/program_options.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+namespace {
+
+//! \return the given percentile of the samples, which are reordered.
+double percentile(std::vector<double>& aSamples, const double aPercentile) {
+  if (aSamples.empty()) {
+    return 0;
+  }
+  const auto myRank = static_cast<std::size_t>(
+      std::ceil(aPercentile * static_cast<double>(aSamples.size())));
+  const auto myNth = aSamples.begin() + (myRank > 0 ? myRank - 1 : 0);
+  std::nth_element(aSamples.begin(), myNth, aSamples.end());
+  return *myNth;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  uiiit::support::GlogRaii myGlogRaii(argv[0]);
+
+  std::string mySocketPath;
+  std::size_t myNumNodes;
+  std::size_t myNumFlows;
+  std::size_t myPipeline;
+  std::size_t myMaxActive;
+  double      myMinNetRate;
+  double      myMaxNetRate;
+  std::size_t mySeed;
+
+  po::options_description myDesc("Allowed options");
+  // clang-format off
+  myDesc.add_options()
+    ("help,h", "produce help message")
+    ("version,v", "print the version and quit")
+    ("socket",
+     po::value<std::string>(&mySocketPath)->default_value("admission.sock"),
+     "Path of the Unix domain socket of the admission daemon.")
+    ("num-nodes",
+     po::value<std::size_t>(&myNumNodes)->default_value(0),
+     "Number of nodes in the network, from which the sources and destinations of flows are drawn.")
+    ("num-flows",
+     po::value<std::size_t>(&myNumFlows)->default_value(1000),
+     "Number of flows for which admission is requested.")
+    ("pipeline",
+     po::value<std::size_t>(&myPipeline)->default_value(64),
+     "Maximum number of admission requests waiting for a response.")
+    ("max-active",
+     po::value<std::size_t>(&myMaxActive)->default_value(100),
+     "Maximum number of flows admitted: when exceeded, the oldest flow is released. All the flows are released at the end.")
+    ("rate-min",
+     po::value<double>(&myMinNetRate)->default_value(1),
+     "Min net rate requested, in EPR-pairs/s.")
+    ("rate-max",
+     po::value<double>(&myMaxNetRate)->default_value(10),
+     "Max net rate requested, in EPR-pairs/s.")
+    ("seed",
+     po::value<std::size_t>(&mySeed)->default_value(0),
+     "Seed used to draw the flows.")
+    ;
+  // clang-format on
+
+  try {
+    po::variables_map myVarMap;
+    po::store(po::parse_command_line(argc, argv, myDesc), myVarMap);
+    po::notify(myVarMap);
+
+    if (myVarMap.count("help")) {
+      std::cout << myDesc << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (myVarMap.count("version")) {
+      std::cout << us::version() << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    if (myNumNodes < 2) {
+      throw std::runtime_error("the number of nodes must be at least 2");
+    }
+    if (myPipeline == 0) {
+      throw std::runtime_error("the pipeline depth must be positive");
+    }
+    if (myNumFlows > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::runtime_error("too many flows: " + std::to_string(myNumFlows));
+    }
+
+    us::UniformRv                   myNetRateRv(
+        myMinNetRate, myMaxNetRate, mySeed, 0, 0);
+    us::UniformIntRv<unsigned long> mySrcDstRv(
+        0, myNumNodes - 1, mySeed, 0, 0);
+
+    qr::AdmissionClient myClient(mySocketPath);
+
+    // the admission requests are tagged with the flow index, so that the
+    // round-trip time can be measured
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> mySendTimes(myNumFlows);
+    std::vector<double>            myRtts;
+    std::deque<std::uint64_t>      myActive;
+    myRtts.reserve(myNumFlows);
+    std::size_t myAdmitted    = 0;
+    std::size_t myRejected    = 0;
+    std::size_t myInvalid     = 0;
+    std::size_t myReleased    = 0;
+    std::size_t mySent        = 0;
+    std::size_t myOutstanding = 0;
+
+    const auto myStart = Clock::now();
+    while (mySent < myNumFlows or myOutstanding > 0) {
+      while (myOutstanding < myPipeline and mySent < myNumFlows) {
+        unsigned long mySrc = 0;
+        unsigned long myDst = 0;
+        while (mySrc == myDst) {
+          mySrc = mySrcDstRv();
+          myDst = mySrcDstRv();
+        }
+        mySendTimes[mySent] = Clock::now();
+        myClient.send(qr::AdmissionRequest::admit(
+            static_cast<std::uint32_t>(mySent), mySrc, myDst, myNetRateRv()));
+        ++mySent;
+        ++myOutstanding;
+      }
+
+      const auto myResponse = myClient.receive();
+      --myOutstanding;
+      VLOG(1) << myResponse.toString();
+      if (myResponse.theType == qr::AdmissionType::Release) {
+        ++myReleased;
+        continue;
+      }
+
+      myRtts.emplace_back(std::chrono::duration<double>(
+                              Clock::now() - mySendTimes[myResponse.theTag])
+                              .count());
+      if (myResponse.theStatus == qr::AdmissionStatus::Ok) {
+        ++myAdmitted;
+        myActive.push_back(myResponse.theFlow);
+        if (myActive.size() > myMaxActive) {
+          myClient.send(qr::AdmissionRequest::release(0, myActive.front()));
+          myActive.pop_front();
+          ++myOutstanding;
+        }
+      } else if (myResponse.theStatus == qr::AdmissionStatus::Rejected) {
+        ++myRejected;
+      } else {
+        ++myInvalid;
+      }
+    }
+
+    // release the flows still active
+    for (const auto myFlow : myActive) {
+      myClient.send(qr::AdmissionRequest::release(0, myFlow));
+    }
+    for (std::size_t i = 0; i < myActive.size(); i++) {
+      myClient.receive();
+      ++myReleased;
+    }
+    const auto myDuration =
+        std::chrono::duration<double>(Clock::now() - myStart).count();
+
+    const auto myStats = myClient(qr::AdmissionRequest::stats(0));
+    std::cout << "admitted " << myAdmitted << ", rejected " << myRejected
+              << ", invalid " << myInvalid << ", released " << myReleased
+              << " in " << myDuration << " s ("
+              << (mySent + myReleased) / myDuration << " requests/s)\n"
+              << "round-trip time p50 " << percentile(myRtts, 0.5)
+              << " s, p99 " << percentile(myRtts, 0.99) << " s\n"
+              << "daemon: " << myStats.theNumFlows << " flows admitted, "
+              << myStats.theNumDecisions << " decisions, latency p50 "
+              << myStats.theLatencyP50 << " s, p99 " << myStats.theLatencyP99
+              << " s" << std::endl;
+
+    return EXIT_SUCCESS;
+
+  } catch (const std::exception& aErr) {
+    std::cerr << "Exception caught: " << aErr.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Unknown exception caught" << std::endl;
+  }
+
+  return EXIT_FAILURE;
+}
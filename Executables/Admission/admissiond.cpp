@@ -0,0 +1,273 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/admission.h"
+#include "QuantumRouting/admissionserver.h"
+#include "QuantumRouting/latencyhistogram.h"
+#include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/shmsnapshot.h"
+#include "QuantumRouting/topologycache.h"
+#include "Support/glograii.h"
+#include "Support/random.h"
+#include "Support/split.h"
+#include "Support/versionutils.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace po = boost::program_options;
+namespace qr = uiiit::qr;
+namespace us = uiiit::support;
+
+namespace {
+
+qr::AdmissionServer* theServer = nullptr;
+
+void handleSignal(int) {
+  if (theServer != nullptr) {
+    theServer->stop();
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  uiiit::support::GlogRaii myGlogRaii(argv[0]);
+
+  std::string mySocketPath;
+  std::string myGraphMlFilename;
+  std::string myCacheFilename;
+  std::size_t mySeed;
+  double      myMu;
+  double      myLinkMinEpr;
+  double      myLinkMaxEpr;
+  double      myGridSize;
+  double      myThreshold;
+  double      myLinkProbability;
+  double      myQ;
+  std::string myLatencyFilename;
+  std::string myLatencyRateClassesStr;
+  std::string myShmName;
+
+  po::options_description myDesc("Allowed options");
+  // clang-format off
+  myDesc.add_options()
+    ("help,h", "produce help message")
+    ("version,v", "print the version and quit")
+    ("socket",
+     po::value<std::string>(&mySocketPath)->default_value("admission.sock"),
+     "Path of the Unix domain socket on which requests are served.")
+    ("graphml-file",
+     po::value<std::string>(&myGraphMlFilename)->default_value(""),
+     "Read the network topology from a GraphML file, without the .graphml suffix, as in main-003. If empty, the network topology is drawn from a Poisson point process.")
+    ("topology-cache",
+     po::value<std::string>(&myCacheFilename)->default_value(""),
+     "If this file exists, load the network topology and the link capacities from it, otherwise create the network from the other options and save it to this file.")
+    ("seed",
+     po::value<std::size_t>(&mySeed)->default_value(0),
+     "Seed used to draw the network topology and the link capacities.")
+    ("mu",
+     po::value<double>(&myMu)->default_value(100),
+     "Average number of nodes.")
+    ("link-min-epr",
+     po::value<double>(&myLinkMinEpr)->default_value(1),
+     "Min EPR rate of links.")
+    ("link-max-epr",
+     po::value<double>(&myLinkMaxEpr)->default_value(400),
+     "Max EPR rate of links.")
+    ("grid-size",
+     po::value<double>(&myGridSize)->default_value(60000),
+     "Grid length, in km.")
+    ("threshold",
+     po::value<double>(&myThreshold)->default_value(15000),
+     "Link creation threshold (Euclidean distance), in km.")
+    ("link-probability",
+     po::value<double>(&myLinkProbability)->default_value(1),
+     "Link creation probability.")
+    ("q",
+     po::value<double>(&myQ)->default_value(0.5),
+     "Correct measurement probability.")
+    ("latency-file",
+     po::value<std::string>(&myLatencyFilename)->default_value(""),
+     "Save the percentiles of the wall-clock latency of all the admission and release decisions, in ns, recorded in HDR histograms per class of net rate, to this CSV file upon termination.")
+    ("latency-rate-classes",
+     po::value<std::string>(&myLatencyRateClassesStr)->default_value(""),
+     "Upper bounds of the classes of net rate of the latency histograms, separated by '@', e.g., 1@10 for three classes: up to 1, from 1 to 10, and above 10 EPR-pairs/s.")
+    ("shm-name",
+     po::value<std::string>(&myShmName)->default_value(""),
+     "Publish the residual capacities into the POSIX shared memory object with this name, e.g., /qr-admission, after every round of requests served. If empty, do not publish.")
+    ;
+  // clang-format on
+
+  try {
+    po::variables_map myVarMap;
+    po::store(po::parse_command_line(argc, argv, myDesc), myVarMap);
+    po::notify(myVarMap);
+
+    if (myVarMap.count("help")) {
+      std::cout << myDesc << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (myVarMap.count("version")) {
+      std::cout << us::version() << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    // create the network, or load it from the cache
+    std::unique_ptr<qr::CapacityNetwork> myNetwork;
+    if (not myCacheFilename.empty() and
+        boost::filesystem::exists(myCacheFilename)) {
+      LOG(INFO) << "loading topology from " << myCacheFilename;
+      std::size_t myNumNodes = 0;
+      const auto  myWeights =
+          qr::loadTopologyCache(myCacheFilename, myNumNodes);
+      myNetwork = std::make_unique<qr::CapacityNetwork>(myWeights, myNumNodes);
+
+    } else {
+      us::UniformRv               myLinkEprRv(
+          myLinkMinEpr, myLinkMaxEpr, mySeed, 0, 0);
+      std::vector<qr::Coordinate> myCoordinates;
+      if (myGraphMlFilename.empty()) {
+        myNetwork = qr::makeCapacityNetworkPpp(myLinkEprRv,
+                                               mySeed,
+                                               myMu,
+                                               myGridSize,
+                                               myThreshold,
+                                               myLinkProbability,
+                                               myCoordinates);
+      } else {
+        std::ifstream myGraphMlStream(myGraphMlFilename + ".graphml");
+        if (not myGraphMlStream) {
+          throw std::runtime_error("cannot read from file: " +
+                                   myGraphMlFilename + ".graphml");
+        }
+        myNetwork = qr::makeCapacityNetworkGraphMl(
+            myLinkEprRv, myGraphMlStream, myCoordinates);
+      }
+
+      if (not myCacheFilename.empty()) {
+        LOG(INFO) << "saving topology to " << myCacheFilename;
+        qr::saveTopologyCache(myCacheFilename, *myNetwork);
+      }
+    }
+    myNetwork->measurementProbability(myQ);
+    LOG(INFO) << "network with " << myNetwork->numNodes() << " nodes and "
+              << myNetwork->numEdges() << " edges, total capacity "
+              << myNetwork->totalCapacity() << " EPR-pairs/s";
+
+    // record the latency of the decisions per class of net rate, if needed
+    std::shared_ptr<qr::DecisionLatencies> myLatencies;
+    if (not myLatencyFilename.empty()) {
+      auto myBounds =
+          us::split<std::vector<double>>(myLatencyRateClassesStr, "@");
+      std::sort(myBounds.begin(), myBounds.end());
+      std::vector<std::string> myClasses;
+      for (std::size_t i = 0; i <= myBounds.size(); i++) {
+        std::stringstream myStream;
+        myStream << (i == 0 ? 0 : myBounds[i - 1]) << '-';
+        if (i == myBounds.size()) {
+          myStream << "inf";
+        } else {
+          myStream << myBounds[i];
+        }
+        myClasses.emplace_back(myStream.str());
+      }
+      myLatencies = std::make_shared<qr::DecisionLatencies>(myClasses);
+      myNetwork->latencies(myLatencies, [myBounds](const auto& aFlow) {
+        return static_cast<std::size_t>(
+            std::lower_bound(
+                myBounds.begin(), myBounds.end(), aFlow.theNetRate) -
+            myBounds.begin());
+      });
+    }
+
+    qr::AdmissionController myController(std::move(myNetwork));
+    qr::AdmissionServer     myServer(mySocketPath, myController);
+
+    // publish the residual capacities to external readers, if needed
+    std::unique_ptr<qr::ShmSnapshotWriter> mySnapshotWriter;
+    if (not myShmName.empty()) {
+      mySnapshotWriter = std::make_unique<qr::ShmSnapshotWriter>(
+          myShmName, myController.network().numEdges());
+      mySnapshotWriter->publish(myController.network());
+      myServer.served([&mySnapshotWriter, &myController]() {
+        mySnapshotWriter->publish(myController.network());
+      });
+      LOG(INFO) << "publishing snapshots to " << myShmName;
+    }
+
+    theServer = &myServer;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    LOG(INFO) << "serving requests on " << mySocketPath;
+    myServer.run();
+    theServer = nullptr;
+
+    LOG(INFO) << myServer.numRequests() << " requests served, "
+              << myController.numDecisions() << " decisions taken, "
+              << myController.numFlows()
+              << " flows admitted, decision latency p50 "
+              << myController.latency(0.5) << " s, p99 "
+              << myController.latency(0.99) << " s";
+
+    if (myLatencies) {
+      std::ofstream myLatencyFile(myLatencyFilename);
+      if (not myLatencyFile) {
+        throw std::runtime_error("could not open latency file for writing: " +
+                                 myLatencyFilename);
+      }
+      myLatencies->toCsv(myLatencyFile);
+    }
+
+    return EXIT_SUCCESS;
+
+  } catch (const std::exception& aErr) {
+    std::cerr << "Exception caught: " << aErr.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Unknown exception caught" << std::endl;
+  }
+
+  return EXIT_FAILURE;
+}
@@ -30,12 +30,16 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/flowreader.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/latencyhistogram.h"
 #include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/paramgrid.h"
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/trace.h"
+#include "QuantumRouting/workstealingbatch.h"
 #include "Support/experimentdata.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/stat.h"
 #include "Support/versionutils.h"
@@ -46,6 +50,10 @@ SOFTWARE.
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -73,6 +81,11 @@ struct Parameters {
   double      theMinNetRate;
   double      theMaxNetRate;
   double      theFidelityThreshold;
+  std::string theFlowFilename;    //!< read the flows from this file
+  std::size_t thePoint;           //!< index of the grid point in a sweep
+  bool        theInstrumentation; //!< add timers and counters to the output
+  bool        thePerfCounters;    //!< add hardware counters to the output
+  bool        theMemoryAccounting; //!< add the memory usage to the output
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -104,14 +117,18 @@ struct Parameters {
            "randomly from U["
         << theLinkMinEpr << ',' << theLinkMaxEpr
         << "]; probability of correct BSM " << theQ
-        << " and fidelity of freshly generated pairs " << theFidelityInit
-        << "; there are " << theNumFlows
-        << " application flows requesting admission, with minimum fidelity "
-        << theFidelityThreshold
-        << " and a net EPR requested rate drawn randomly from U["
-        << theMinNetRate << ',' << theMaxNetRate << "]"
-        << ", experiment seed " << theSeed;
-    ;
+        << " and fidelity of freshly generated pairs " << theFidelityInit;
+    if (theFlowFilename.empty()) {
+      myStream
+          << "; there are " << theNumFlows
+          << " application flows requesting admission, with minimum fidelity "
+          << theFidelityThreshold
+          << " and a net EPR requested rate drawn randomly from U["
+          << theMinNetRate << ',' << theMaxNetRate << "]";
+    } else {
+      myStream << "; application flows read from " << theFlowFilename;
+    }
+    myStream << ", experiment seed " << theSeed;
     return myStream.str();
   }
 
@@ -124,6 +141,11 @@ struct Parameters {
              << ',' << theMaxNetRate << ',' << theFidelityThreshold;
     return myStream.str();
   }
+
+  //! \return the expected cost of the experiment, in arbitrary units.
+  double cost() const {
+    return theMu * theNumFlows;
+  }
 };
 
 struct Output {
@@ -146,6 +168,9 @@ struct Output {
   double      theAvgPathSize      = 0;
   double      theAvgFidelity      = 0;
 
+  // only with --instrumentation
+  std::optional<qr::Instrumentation> theInstrumentation;
+
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
         "num-nodes",
@@ -182,6 +207,9 @@ struct Output {
              << theAvgPathSize
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity;
+    if (theInstrumentation.has_value()) {
+      myStream << "; " << theInstrumentation->toString();
+    }
     return myStream.str();
   }
 
@@ -194,13 +222,36 @@ struct Output {
              << theSumGrossRate << ',' << theSumNetRate << ','
              << theAdmissionRate << ',' << theAdmittedFlows << ','
              << theAvgPathSize << ',' << theAvgFidelity;
+    if (theInstrumentation.has_value()) {
+      myStream << ',' << theInstrumentation->toCsv();
+    }
     return myStream.str();
   }
 };
 
 using Data = us::ExperimentData<Parameters, Output>;
 
-void runExperiment(Data& aData, Parameters&& aParameters) {
+//! Latency of the decisions of all the experiments of a grid point.
+struct Latencies {
+  explicit Latencies(const std::vector<std::string>& aClasses)
+      : theMutex()
+      , theLatencies(aClasses) {
+    // noop
+  }
+
+  //! Add the latencies of an experiment. Thread-safe.
+  void merge(const qr::DecisionLatencies& aLatencies) {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theLatencies.merge(aLatencies);
+  }
+
+  std::mutex            theMutex;
+  qr::DecisionLatencies theLatencies;
+};
+
+void runExperiment(Data&        aData,
+                   Parameters&& aParameters,
+                   Latencies*   aLatencies) {
   // fidelity computation parameters
   constexpr double p1  = 1.0;
   constexpr double p2  = 1.0;
@@ -209,6 +260,21 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput;
+  if (myRaii.in().theInstrumentation) {
+    myOutput.theInstrumentation.emplace();
+  }
+  qr::PhaseTimers* myTimers = myOutput.theInstrumentation.has_value() ?
+                                  &myOutput.theInstrumentation->theTimers :
+                                  nullptr;
+  if (myTimers != nullptr and myRaii.in().thePerfCounters) {
+    myTimers->perfCounters(std::make_shared<qr::PerfCounters>());
+  }
+  std::optional<qr::MemoryAccounting> myMemoryAccounting;
+  if (myOutput.theInstrumentation.has_value() and
+      myRaii.in().theMemoryAccounting) {
+    myMemoryAccounting.emplace(
+        myOutput.theInstrumentation->theMemory.emplace());
+  }
 
   // create network
   us::UniformRv myLinkEprRv(myRaii.in().theLinkMinEpr,
@@ -224,8 +290,13 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                  myRaii.in().theGridLength,
                                  myRaii.in().theThreshold,
                                  myRaii.in().theLinkProbability,
-                                 myCoordinates);
+                                 myCoordinates,
+                                 myTimers);
   myNetwork->measurementProbability(myRaii.in().theQ);
+  if (aLatencies != nullptr) {
+    myNetwork->latencies(std::make_shared<qr::DecisionLatencies>(
+        aLatencies->theLatencies.classes()));
+  }
 
   // network properties
   assert(myNetwork.get() != nullptr);
@@ -237,66 +308,128 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   std::tie(myOutput.theMinOutDegree, myOutput.theMaxOutDegree) =
       myNetwork->outDegree();
 
-  // create traffic flows
-  std::vector<qr::CapacityNetwork::FlowDescriptor> myFlows;
-  us::UniformRv                   myNetRateRv(myRaii.in().theMinNetRate,
-                            myRaii.in().theMaxNetRate,
-                            myRaii.in().theSeed,
-                            0,
-                            0);
-  us::UniformIntRv<unsigned long> mySrcDstRv(
-      0, myNetwork->numNodes() - 1, myRaii.in().theSeed, 0, 0);
-  for (std::size_t i = 0; i < myRaii.in().theNumFlows; i++) {
-    unsigned long mySrc = 0;
-    unsigned long myDst = 0;
-    while (mySrc == myDst) {
-      mySrc = mySrcDstRv();
-      myDst = mySrcDstRv();
-    }
-    assert(mySrc != myDst);
-
-    myFlows.emplace_back(mySrc, myDst, myNetRateRv());
-  }
-
-  // route traffic flows
-  myNetwork->route(myFlows, [&myRaii](const auto& aFlow) {
-    assert(not aFlow.thePath.empty());
-    return qr::fidelitySwapping(p1,
-                                p2,
-                                eta,
-                                aFlow.thePath.size() - 1,
-                                myRaii.in().theFidelityInit) >=
-           myRaii.in().theFidelityThreshold;
-  });
+  // fidelity of the paths, by number of links
+  const qr::FidelityTable myFidelityTable(
+      p1, p2, eta, myRaii.in().theFidelityInit, myNetwork->numNodes());
 
   // traffic metrics
-  myOutput.theResidualCapacity = myNetwork->totalCapacity();
   us::SummaryStat myDijkstra;
   us::SummaryStat myGrossRate;
   us::SummaryStat myNetRate;
   us::SummaryStat myAdmissionRate;
   us::SummaryStat myPathSize;
   us::SummaryStat myFidelity;
-  for (const auto& myFlow : myFlows) {
-    myDijkstra(myFlow.theDijsktra);
-    myGrossRate(myFlow.theGrossRate);
-    if (not myFlow.thePath.empty()) {
-      myNetRate(myFlow.theNetRate);
+  const auto      myRecord = [&](const auto& aFlow) {
+    qr::MemoryAccounting::Scope myScope(qr::MemoryUsage::Subsystem::Statistics);
+    myDijkstra(aFlow.theDijsktra);
+    myGrossRate(aFlow.theGrossRate);
+    if (not aFlow.thePath.empty()) {
+      myNetRate(aFlow.theNetRate);
       myAdmissionRate(1);
-      myPathSize(myFlow.thePath.size());
-      myFidelity(qr::fidelitySwapping(
-          p1, p2, eta, myFlow.thePath.size() - 1, myRaii.in().theFidelityInit));
+      myPathSize(aFlow.thePath.size());
+      myFidelity(myFidelityTable(aFlow.thePath.size()));
     } else {
       myAdmissionRate(0);
     }
+  };
+
+  // admit a flow only if the path meets the fidelity threshold
+  const auto myCheck = [&myFidelityTable](const double aFidelityThreshold) {
+    return [&myFidelityTable, aFidelityThreshold](const auto& aFlow) {
+      assert(not aFlow.thePath.empty());
+      return myFidelityTable(aFlow.thePath.size()) >= aFidelityThreshold;
+    };
+  };
+
+  if (myRaii.in().theFlowFilename.empty()) {
+    // create traffic flows
+    std::vector<qr::CapacityNetwork::FlowDescriptor> myFlows;
+    {
+      qr::MemoryAccounting::Scope myMemoryScope(
+          qr::MemoryUsage::Subsystem::Descriptors);
+
+      us::UniformRv                   myNetRateRv(myRaii.in().theMinNetRate,
+                                myRaii.in().theMaxNetRate,
+                                myRaii.in().theSeed,
+                                0,
+                                0);
+      us::UniformIntRv<unsigned long> mySrcDstRv(
+          0, myNetwork->numNodes() - 1, myRaii.in().theSeed, 0, 0);
+      for (std::size_t i = 0; i < myRaii.in().theNumFlows; i++) {
+        unsigned long mySrc = 0;
+        unsigned long myDst = 0;
+        while (mySrc == myDst) {
+          mySrc = mySrcDstRv();
+          myDst = mySrcDstRv();
+        }
+        assert(mySrc != myDst);
+
+        myFlows.emplace_back(mySrc, myDst, myNetRateRv());
+      }
+    }
+
+    // route traffic flows
+    {
+      qr::PhaseTimers::Scope myScope(myTimers,
+                                     qr::PhaseTimers::Phase::Routing);
+      myNetwork->route(myFlows, myCheck(myRaii.in().theFidelityThreshold));
+    }
+
+    qr::PhaseTimers::Scope myScope(myTimers,
+                                   qr::PhaseTimers::Phase::Statistics);
+    for (const auto& myFlow : myFlows) {
+      myRecord(myFlow);
+    }
+
+  } else {
+    // route the traffic flows one by one, as they are read from the file
+    qr::FlowReader  myReader(myRaii.in().theFlowFilename,
+                            myNetwork->numNodes());
+    qr::FlowRequest myRequest;
+    while ((myRaii.in().theNumFlows == 0 or
+            myReader.count() < myRaii.in().theNumFlows) and
+           myReader.next(myRequest)) {
+      std::vector<qr::CapacityNetwork::FlowDescriptor> myFlows;
+      {
+        qr::MemoryAccounting::Scope myMemoryScope(
+            qr::MemoryUsage::Subsystem::Descriptors);
+        myFlows.emplace_back(
+            myRequest.theSrc, myRequest.theDst, myRequest.theNetRate);
+      }
+      {
+        qr::PhaseTimers::Scope myScope(myTimers,
+                                       qr::PhaseTimers::Phase::Routing);
+        myNetwork->route(myFlows, myCheck(myRequest.theFidelityThreshold));
+      }
+      qr::PhaseTimers::Scope myScope(myTimers,
+                                     qr::PhaseTimers::Phase::Statistics);
+      myRecord(myFlows[0]);
+    }
+  }
+
+  {
+    qr::PhaseTimers::Scope      myScope(myTimers,
+                                        qr::PhaseTimers::Phase::Statistics);
+    qr::MemoryAccounting::Scope myMemoryScope(
+        qr::MemoryUsage::Subsystem::Statistics);
+    myOutput.theResidualCapacity = myNetwork->totalCapacity();
+    myOutput.theAvgDijkstraCalls = myDijkstra.mean();
+    myOutput.theSumGrossRate     = myGrossRate.count() * myGrossRate.mean();
+    myOutput.theSumNetRate       = myNetRate.count() * myNetRate.mean();
+    myOutput.theAdmissionRate    = myAdmissionRate.mean();
+    myOutput.theAdmittedFlows =
+        myAdmissionRate.count() * myAdmissionRate.mean();
+    myOutput.theAvgPathSize = myPathSize.mean();
+    myOutput.theAvgFidelity = myFidelity.mean();
   }
-  myOutput.theAvgDijkstraCalls = myDijkstra.mean();
-  myOutput.theSumGrossRate     = myGrossRate.count() * myGrossRate.mean();
-  myOutput.theSumNetRate       = myNetRate.count() * myNetRate.mean();
-  myOutput.theAdmissionRate    = myAdmissionRate.mean();
-  myOutput.theAdmittedFlows = myAdmissionRate.count() * myAdmissionRate.mean();
-  myOutput.theAvgPathSize   = myPathSize.mean();
-  myOutput.theAvgFidelity   = myFidelity.mean();
+  if (myOutput.theInstrumentation.has_value()) {
+    myOutput.theInstrumentation->theCounters = myNetwork->counters();
+  }
+  if (aLatencies != nullptr) {
+    aLatencies->merge(*myNetwork->latencies());
+  }
+
+  myMemoryAccounting.reset();
 
   // save data
   VLOG(1) << "experiment finished\n"
@@ -320,6 +453,13 @@ bool explainOrPrint(const po::variables_map& aVarMap) {
     for (const auto& elem : Output::names()) {
       std::cout << '#' << ++myCol << '\t' << elem << '\n';
     }
+    if (aVarMap.count("instrumentation") == 1) {
+      for (const auto& elem : qr::Instrumentation::names(
+               aVarMap.count("perf-counters") == 1,
+               aVarMap.count("memory-accounting") == 1)) {
+        std::cout << '#' << ++myCol << '\t' << elem << '\n';
+      }
+    }
     std::cout << '#' << ++myCol << "\tduration\n";
     return true;
   }
@@ -331,6 +471,13 @@ bool explainOrPrint(const po::variables_map& aVarMap) {
     for (const auto& elem : Output::names()) {
       std::cout << elem << ',';
     }
+    if (aVarMap.count("instrumentation") == 1) {
+      for (const auto& elem : qr::Instrumentation::names(
+               aVarMap.count("perf-counters") == 1,
+               aVarMap.count("memory-accounting") == 1)) {
+        std::cout << elem << ',';
+      }
+    }
     std::cout << "duration\n";
     return true;
   }
@@ -342,6 +489,8 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myTraceFilename;
+  std::string myLatencyFilename;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
 
@@ -357,6 +506,9 @@ int main(int argc, char* argv[]) {
   double      myQ;
   double      myFidelityInit;
   double      myFidelityThreshold;
+  std::string myFlowFilename;
+
+  std::vector<std::string> mySweepSpecs;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -370,7 +522,10 @@ int main(int argc, char* argv[]) {
      "Number of threads used.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
-     "Output file name.")
+     "Output file name. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("sweep",
+     po::value<std::vector<std::string>>(&mySweepSpecs),
+     "Sweep an option over a list of values NAME=V1,V2,... or a range NAME=START:END:STEP (END included, at most 10000 values). Can be repeated to sweep over the Cartesian product of all the values. The experiments of all the grid points share the same pool of threads.")
     ("seed-start",
      po::value<std::size_t>(&mySeedStart)->default_value(0),
      "First seed used.")
@@ -378,6 +533,15 @@ int main(int argc, char* argv[]) {
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
     ("append", "Append to the output file.")
+    ("perf-counters", "With --instrumentation, also add to the output the hardware performance counters in each phase of the experiment: cycles, instructions, last-level cache misses and branch misses. Only on Linux.")
+    ("memory-accounting", "With --instrumentation, also add to the output the memory used by the experiment: increase of the peak RSS of the process, only meaningful with one thread, peak of the heap allocated, and number of allocations and bytes allocated by subsystem (graph, descriptors, k-shortest paths, statistics, other).")
+    ("trace-file",
+     po::value<std::string>(&myTraceFilename)->default_value(""),
+     "Save the trace of the routing algorithms to this binary file, which can be decoded with Scripts/decode-trace.py. The trace levels compiled in are set with TRACE_LEVEL_DEBUG and TRACE_LEVEL_RELEASE in CMake.")
+    ("latency-file",
+     po::value<std::string>(&myLatencyFilename)->default_value(""),
+     "Save the percentiles of the wall-clock latency of the admission decisions, in ns, recorded in HDR histograms merged over all the experiments, to this CSV file. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("instrumentation", "Add to the output the time spent in each phase of the experiment and the work done by the routing algorithms.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -414,6 +578,9 @@ int main(int argc, char* argv[]) {
     ("fidelity-threshold",
      po::value<double>(&myFidelityThreshold)->default_value(0.95),
      "Fidelity threshold.")
+    ("flow-file",
+     po::value<std::string>(&myFlowFilename)->default_value(""),
+     "Read the flows from a file, in CSV format with lines time,src,dst,net-rate,fidelity-threshold or in binary format (see Scripts/csv-to-flows.py), instead of drawing them randomly. The file is read incrementally and the flows are routed one by one, ignoring the time. With this option --num-flows is the maximum number of flows read, 0 means all, which is the default; --rate-min, --rate-max, and --fidelity-threshold are ignored.")
     ;
   // clang-format on
 
@@ -432,47 +599,152 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
 
+    if (myVarMap.count("perf-counters") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error("--perf-counters requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error(
+          "--memory-accounting requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        not qr::MemoryAccounting::enabled()) {
+      throw std::runtime_error("--memory-accounting requires a build with "
+                               "-DMEMORY_ACCOUNTING=ON");
+    }
+
     if (explainOrPrint(myVarMap)) {
       return EXIT_SUCCESS;
     }
 
-    std::ofstream myFile(myOutputFilename,
-                         myVarMap.count("append") == 1 ? std::ios::app :
-                                                         std::ios::trunc);
-    if (not myFile) {
-      throw std::runtime_error("could not open output file for writing: " +
-                               myOutputFilename);
+    if (not myTraceFilename.empty()) {
+      LOG_IF(WARNING, QR_TRACE_LEVEL == 0)
+          << "tracing requested but not compiled in, the trace will be empty";
+      qr::Trace::enable(true);
     }
 
-    Data myData;
-
-    us::Queue<Parameters> myParameters;
-    for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   myQ,
-                                   myFidelityInit,
-                                   myNumFlows,
-                                   myMinNetRate,
-                                   myMaxNetRate,
-                                   myFidelityThreshold});
+    const qr::ParamGrid myGrid(mySweepSpecs);
+
+    std::vector<std::unique_ptr<Data>>      myData;
+    std::vector<std::ofstream>              myFiles;
+    std::set<std::string>                   myOutputFilenames;
+    std::vector<std::unique_ptr<Latencies>> myLatencies;
+    std::vector<std::ofstream>              myLatencyFiles;
+    std::set<std::string>                   myLatencyFilenames;
+    std::vector<Parameters>                 myParameters;
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      // options set by the grid point take precedence over the command line
+      po::variables_map myPointVarMap;
+      if (myGrid.dimensions() > 0) {
+        po::store(
+            po::command_line_parser(myGrid.args(myPoint)).options(myDesc).run(),
+            myPointVarMap);
+        po::store(po::parse_command_line(argc, argv, myDesc), myPointVarMap);
+        po::notify(myPointVarMap);
+      }
+
+      // all the flows in the file are read unless limited explicitly
+      const auto& myPointOptions =
+          myGrid.dimensions() > 0 ? myPointVarMap : myVarMap;
+      if (not myFlowFilename.empty() and
+          myPointOptions["num-flows"].defaulted()) {
+        myNumFlows = 0;
+      }
+
+      const auto myPointFilename =
+          qr::ParamGrid::filename(myOutputFilename, myGrid.point(myPoint));
+      if (not myOutputFilenames.emplace(myPointFilename).second) {
+        throw std::runtime_error(
+            "the same output file would be used for different grid points, "
+            "add {NAME} placeholders to the output file name: " +
+            myPointFilename);
+      }
+      myFiles.emplace_back(myPointFilename,
+                           myVarMap.count("append") == 1 ? std::ios::app :
+                                                           std::ios::trunc);
+      if (not myFiles.back()) {
+        throw std::runtime_error("could not open output file for writing: " +
+                                 myPointFilename);
+      }
+      myData.emplace_back(std::make_unique<Data>());
+
+      if (not myLatencyFilename.empty()) {
+        const auto myPointLatencyFilename =
+            qr::ParamGrid::filename(myLatencyFilename, myGrid.point(myPoint));
+        if (not myLatencyFilenames.emplace(myPointLatencyFilename).second) {
+          throw std::runtime_error(
+              "the same latency file would be used for different grid "
+              "points, add {NAME} placeholders to the latency file name: " +
+              myPointLatencyFilename);
+        }
+        myLatencyFiles.emplace_back(myPointLatencyFilename);
+        if (not myLatencyFiles.back()) {
+          throw std::runtime_error("could not open latency file for writing: " +
+                                   myPointLatencyFilename);
+        }
+        myLatencies.emplace_back(
+            std::make_unique<Latencies>(std::vector<std::string>({"all"})));
+      }
+
+      for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
+        myParameters.push_back(Parameters{mySeed,
+                                          myMu,
+                                          myGridSize,
+                                          myThreshold,
+                                          myLinkProbability,
+                                          myLinkMinEpr,
+                                          myLinkMaxEpr,
+                                          myQ,
+                                          myFidelityInit,
+                                          myNumFlows,
+                                          myMinNetRate,
+                                          myMaxNetRate,
+                                          myFidelityThreshold,
+                                          myFlowFilename,
+                                          myPoint,
+                                          myVarMap.count("instrumentation") ==
+                                              1,
+                                          myVarMap.count("perf-counters") ==
+                                              1,
+                                          myVarMap.count("memory-accounting") ==
+                                              1});
+      }
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
+
+    qr::WorkStealingBatch<Parameters> myWorkers(
+        myNumThreads,
+        std::move(myParameters),
+        [&myData, &myLatencies](auto&& aParameters) {
+          qr::Trace::registerThread();
+          qr::Trace::experiment(aParameters.thePoint, aParameters.theSeed);
+          const auto myPoint     = aParameters.thePoint;
+          auto&      myPointData = *myData[myPoint];
+          runExperiment(myPointData,
+                        std::move(aParameters),
+                        myLatencies.empty() ? nullptr :
+                                              myLatencies[myPoint].get());
         });
     const auto myExceptions = myWorkers.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
     }
+    for (std::size_t i = 0; i < myWorkers.stats().size(); i++) {
+      LOG(INFO) << "thread #" << i << ": " << myWorkers.stats()[i].toString();
+    }
 
-    myData.toCsv(myFile);
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      myData[myPoint]->toCsv(myFiles[myPoint]);
+      if (not myLatencies.empty()) {
+        myLatencies[myPoint]->theLatencies.toCsv(myLatencyFiles[myPoint]);
+      }
+    }
+
+    if (not myTraceFilename.empty()) {
+      std::ofstream myTraceFile(myTraceFilename, std::ios::binary);
+      qr::Trace::save(myTraceFile);
+    }
 
     return EXIT_SUCCESS;
   } catch (const std::exception& aErr) {
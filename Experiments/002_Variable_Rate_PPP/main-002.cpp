@@ -30,13 +30,15 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/paramgrid.h"
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/trace.h"
+#include "QuantumRouting/workstealingbatch.h"
 #include "Support/experimentdata.h"
 #include "Support/glograii.h"
 #include "Support/jain.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/stat.h"
 #include "Support/versionutils.h"
@@ -49,6 +51,9 @@ SOFTWARE.
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <set>
 #include <iterator>
 #include <sstream>
 #include <stdexcept>
@@ -85,6 +90,10 @@ struct Parameters {
 
   // not part of the experiment
   std::string theDotFile;
+  std::size_t thePoint;           //!< index of the grid point in a sweep
+  bool        theInstrumentation; //!< add timers and counters to the output
+  bool        thePerfCounters;    //!< add hardware counters to the output
+  bool        theMemoryAccounting; //!< add the memory usage to the output
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -153,6 +162,11 @@ struct Parameters {
              << theFidelityThreshold << ',' << theTargetResidual;
     return myStream.str();
   }
+
+  //! \return the expected cost of the experiment, in arbitrary units.
+  double cost() const {
+    return theMu * theNumApps * theK;
+  }
 };
 
 struct Output {
@@ -177,6 +191,9 @@ struct Output {
   double      theFairnessJain     = 0;
   double      theFairnessJitter   = 0;
 
+  // only with --instrumentation
+  std::optional<qr::Instrumentation> theInstrumentation;
+
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
         "num-nodes",
@@ -216,6 +233,9 @@ struct Output {
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity << ", Jain's fairness index " << theFairnessJain
              << ", max rate - min rate " << theFairnessJitter << " EPR-pairs/s";
+    if (theInstrumentation.has_value()) {
+      myStream << "; " << theInstrumentation->toString();
+    }
     return myStream.str();
   }
 
@@ -228,6 +248,9 @@ struct Output {
              << theAvgVisits << ',' << theSumGrossRate << ',' << theSumNetRate
              << ',' << theAvgPathSize << ',' << theAvgFidelity << ','
              << theFairnessJain << ',' << theFairnessJitter;
+    if (theInstrumentation.has_value()) {
+      myStream << ',' << theInstrumentation->toCsv();
+    }
     return myStream.str();
   }
 };
@@ -248,6 +271,22 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   Data::Raii myRaii(aData, std::move(aParameters));
 
   Output myOutput;
+  if (myRaii.in().theInstrumentation) {
+    myOutput.theInstrumentation.emplace();
+  }
+  qr::PhaseTimers* myTimers = myOutput.theInstrumentation.has_value() ?
+                                  &myOutput.theInstrumentation->theTimers :
+                                  nullptr;
+  if (myTimers != nullptr and myRaii.in().thePerfCounters) {
+    myTimers->perfCounters(std::make_shared<qr::PerfCounters>());
+  }
+  std::optional<qr::MemoryAccounting> myMemoryAccounting;
+  if (myOutput.theInstrumentation.has_value() and
+      myRaii.in().theMemoryAccounting) {
+    myMemoryAccounting.emplace(
+        myOutput.theInstrumentation->theMemory.emplace());
+  }
+  qr::WorkCounters myDiscardedCounters;
 
   const auto                           MANY_TRIES = 1000000u;
   std::unique_ptr<qr::CapacityNetwork> myNetwork  = nullptr;
@@ -270,7 +309,8 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                            myRaii.in().theGridLength,
                                            myRaii.in().theThreshold,
                                            myRaii.in().theLinkProbability,
-                                           myCoordinates);
+                                           myCoordinates,
+                                           myTimers);
 
     // network properties
     assert(myNetwork.get() != nullptr);
@@ -283,9 +323,13 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
         myNetwork->outDegree();
 
     // create applications
-    myReachableNodes = myNetwork->reachableNodes(myRaii.in().theDistanceMin,
-                                                 myRaii.in().theDistanceMax,
-                                                 myOutput.theDiameter);
+    {
+      qr::PhaseTimers::Scope myScope(myTimers,
+                                     qr::PhaseTimers::Phase::Diameter);
+      myReachableNodes = myNetwork->reachableNodes(myRaii.in().theDistanceMin,
+                                                   myRaii.in().theDistanceMax,
+                                                   myOutput.theDiameter);
+    }
     const std::size_t myNumPossibleHosts =
         std::count_if(myReachableNodes.begin(),
                       myReachableNodes.end(),
@@ -293,6 +337,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     if (myNumPossibleHosts == 0) {
       VLOG(1) << "graph does not have possible hosts (seed " << mySeed
               << "), trying again";
+      myDiscardedCounters += myNetwork->counters();
       myNetwork.reset();
     }
   }
@@ -302,6 +347,10 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
   }
   myNetwork->measurementProbability(myRaii.in().theQ);
 
+  // fidelity of the paths, by number of links
+  const qr::FidelityTable myFidelityTable(
+      p1, p2, eta, myRaii.in().theFidelityInit, myNetwork->numNodes());
+
   // save to Graphviz
   if (not myRaii.in().theDotFile.empty()) {
     myNetwork->toDot(myRaii.in().theDotFile + "-" +
@@ -320,10 +369,28 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                                  0);
     us::UniformRv myPeerSampleRv(0, 1, myRaii.in().theSeed, 0, 0);
 
+    // admit only the paths meeting the fidelity threshold: the policy also
+    // skips the search of paths towards the peers too far from the hosts, but
+    // it cannot be built with a fidelity of the fresh pairs smaller than 1/4,
+    // in which case the fidelity of every path is checked in the table
+    std::optional<qr::CapacityNetwork::FidelityThresholdPolicy>
+        myFidelityPolicy;
+    if (myRaii.in().theFidelityInit >= 0.25) {
+      myFidelityPolicy.emplace(p1,
+                               p2,
+                               eta,
+                               myRaii.in().theFidelityInit,
+                               myRaii.in().theFidelityThreshold,
+                               myNetwork->numNodes());
+    }
+
     do {
       std::vector<qr::CapacityNetwork::AppDescriptor> mySingleRunApps;
 
       for (std::size_t i = 0; i < myRaii.in().theNumApps; i++) {
+        qr::MemoryAccounting::Scope myMemoryScope(
+            qr::MemoryUsage::Subsystem::Descriptors);
+
         const auto myHost = myHostRv();
         const auto it     = myReachableNodes.find(myHost);
         assert(it != myReachableNodes.end());
@@ -338,19 +405,25 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
       }
 
       // route applications
-      myNetwork->route(mySingleRunApps,
-                       myRaii.in().theQuantum * myRaii.in().theNumApps,
-                       myRaii.in().theK,
-                       [&myRaii](const auto& aPath) {
-                         assert(not aPath.empty());
-                         return qr::fidelitySwapping(
-                                    p1,
-                                    p2,
-                                    eta,
-                                    aPath.size() - 1,
-                                    myRaii.in().theFidelityInit) >=
-                                myRaii.in().theFidelityThreshold;
-                       });
+      {
+        qr::PhaseTimers::Scope myScope(myTimers,
+                                       qr::PhaseTimers::Phase::Routing);
+        if (myFidelityPolicy.has_value()) {
+          myNetwork->route(mySingleRunApps,
+                           myRaii.in().theQuantum * myRaii.in().theNumApps,
+                           myRaii.in().theK,
+                           *myFidelityPolicy);
+        } else {
+          myNetwork->route(mySingleRunApps,
+                           myRaii.in().theQuantum * myRaii.in().theNumApps,
+                           myRaii.in().theK,
+                           [&myRaii, &myFidelityTable](const auto& aPath) {
+                             assert(not aPath.empty());
+                             return myFidelityTable(aPath.size()) >=
+                                    myRaii.in().theFidelityThreshold;
+                           });
+        }
+      }
 
       std::move(mySingleRunApps.begin(),
                 mySingleRunApps.end(),
@@ -360,6 +433,10 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                  (myOutput.theTotalCapacity * myRaii.in().theTargetResidual));
 
     // traffic metrics
+    qr::PhaseTimers::Scope      myScope(myTimers,
+                                        qr::PhaseTimers::Phase::Statistics);
+    qr::MemoryAccounting::Scope myMemoryScope(
+        qr::MemoryUsage::Subsystem::Statistics);
     myOutput.theResidualCapacity = myNetwork->totalCapacity();
     myOutput.theNumApps          = myApps.size();
     us::SummaryStat     myVisits;
@@ -385,11 +462,7 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
             const auto myWeight = myPeer.theNetRate / myHostNetRate;
             myHostPathSize(myWeight * myPeer.theHops.size());
             myHostFidelity(myWeight *
-                           qr::fidelitySwapping(p1,
-                                                p2,
-                                                eta,
-                                                myPeer.theHops.size() - 1,
-                                                myRaii.in().theFidelityInit));
+                           myFidelityTable(myPeer.theHops.size()));
           }
         }
         myPathSize(myHostPathSize.mean() * myHostPathSize.count());
@@ -404,6 +477,12 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
     myOutput.theFairnessJain   = us::jainFairnessIndex(myNetRates);
     myOutput.theFairnessJitter = myNetRate.max() - myNetRate.min();
   }
+  if (myOutput.theInstrumentation.has_value()) {
+    myOutput.theInstrumentation->theCounters = myDiscardedCounters;
+    myOutput.theInstrumentation->theCounters += myNetwork->counters();
+  }
+
+  myMemoryAccounting.reset();
 
   // save data
   VLOG(1) << "experiment finished\n"
@@ -427,6 +506,13 @@ bool explainOrPrint(const po::variables_map& aVarMap) {
     for (const auto& elem : Output::names()) {
       std::cout << '#' << ++myCol << '\t' << elem << '\n';
     }
+    if (aVarMap.count("instrumentation") == 1) {
+      for (const auto& elem : qr::Instrumentation::names(
+               aVarMap.count("perf-counters") == 1,
+               aVarMap.count("memory-accounting") == 1)) {
+        std::cout << '#' << ++myCol << '\t' << elem << '\n';
+      }
+    }
     std::cout << '#' << ++myCol << "\tduration\n";
     return true;
   }
@@ -438,6 +524,13 @@ bool explainOrPrint(const po::variables_map& aVarMap) {
     for (const auto& elem : Output::names()) {
       std::cout << elem << ',';
     }
+    if (aVarMap.count("instrumentation") == 1) {
+      for (const auto& elem : qr::Instrumentation::names(
+               aVarMap.count("perf-counters") == 1,
+               aVarMap.count("memory-accounting") == 1)) {
+        std::cout << elem << ',';
+      }
+    }
     std::cout << "duration\n";
     return true;
   }
@@ -449,6 +542,7 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myTraceFilename;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
 
@@ -471,6 +565,8 @@ int main(int argc, char* argv[]) {
   double      myTargetResidual;
   std::string myDotFile;
 
+  std::vector<std::string> mySweepSpecs;
+
   po::options_description myDesc("Allowed options");
   // clang-format off
   myDesc.add_options()
@@ -486,7 +582,10 @@ int main(int argc, char* argv[]) {
      "Number of threads used.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
-     "Output file name.")
+     "Output file name. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("sweep",
+     po::value<std::vector<std::string>>(&mySweepSpecs),
+     "Sweep an option over a list of values NAME=V1,V2,... or a range NAME=START:END:STEP (END included, at most 10000 values). Can be repeated to sweep over the Cartesian product of all the values. The experiments of all the grid points share the same pool of threads.")
     ("seed-start",
      po::value<std::size_t>(&mySeedStart)->default_value(0),
      "First seed used.")
@@ -494,6 +593,12 @@ int main(int argc, char* argv[]) {
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
     ("append", "Append to the output file.")
+    ("perf-counters", "With --instrumentation, also add to the output the hardware performance counters in each phase of the experiment: cycles, instructions, last-level cache misses and branch misses. Only on Linux.")
+    ("memory-accounting", "With --instrumentation, also add to the output the memory used by the experiment: increase of the peak RSS of the process, only meaningful with one thread, peak of the heap allocated, and number of allocations and bytes allocated by subsystem (graph, descriptors, k-shortest paths, statistics, other).")
+    ("trace-file",
+     po::value<std::string>(&myTraceFilename)->default_value(""),
+     "Save the trace of the routing algorithms to this binary file, which can be decoded with Scripts/decode-trace.py. The trace levels compiled in are set with TRACE_LEVEL_DEBUG and TRACE_LEVEL_RELEASE in CMake.")
+    ("instrumentation", "Add to the output the time spent in each phase of the experiment and the work done by the routing algorithms.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -563,53 +668,119 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
 
+    if (myVarMap.count("perf-counters") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error("--perf-counters requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error(
+          "--memory-accounting requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        not qr::MemoryAccounting::enabled()) {
+      throw std::runtime_error("--memory-accounting requires a build with "
+                               "-DMEMORY_ACCOUNTING=ON");
+    }
+
     if (explainOrPrint(myVarMap)) {
       return EXIT_SUCCESS;
     }
 
-    std::ofstream myFile(myOutputFilename,
-                         myVarMap.count("append") == 1 ? std::ios::app :
-                                                         std::ios::trunc);
-    if (not myFile) {
-      throw std::runtime_error("could not open output file for writing: " +
-                               myOutputFilename);
+    if (not myTraceFilename.empty()) {
+      LOG_IF(WARNING, QR_TRACE_LEVEL == 0)
+          << "tracing requested but not compiled in, the trace will be empty";
+      qr::Trace::enable(true);
     }
 
-    Data myData;
-
-    us::Queue<Parameters> myParameters;
-    for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   myQ,
-                                   myQuantum,
-                                   myK,
-                                   myFidelityInit,
-                                   myNumApps,
-                                   myNumPeersMin,
-                                   myNumPeersMax,
-                                   myDistanceMin,
-                                   myDistanceMax,
-                                   myFidelityThreshold,
-                                   myTargetResidual,
-                                   myDotFile});
+    const qr::ParamGrid myGrid(mySweepSpecs);
+
+    std::vector<std::unique_ptr<Data>> myData;
+    std::vector<std::ofstream>         myFiles;
+    std::set<std::string>              myOutputFilenames;
+    std::vector<Parameters>            myParameters;
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      // options set by the grid point take precedence over the command line
+      if (myGrid.dimensions() > 0) {
+        po::variables_map myPointVarMap;
+        po::store(
+            po::command_line_parser(myGrid.args(myPoint)).options(myDesc).run(),
+            myPointVarMap);
+        po::store(po::parse_command_line(argc, argv, myDesc), myPointVarMap);
+        po::notify(myPointVarMap);
+      }
+
+      const auto myPointFilename =
+          qr::ParamGrid::filename(myOutputFilename, myGrid.point(myPoint));
+      if (not myOutputFilenames.emplace(myPointFilename).second) {
+        throw std::runtime_error(
+            "the same output file would be used for different grid points, "
+            "add {NAME} placeholders to the output file name: " +
+            myPointFilename);
+      }
+      myFiles.emplace_back(myPointFilename,
+                           myVarMap.count("append") == 1 ? std::ios::app :
+                                                           std::ios::trunc);
+      if (not myFiles.back()) {
+        throw std::runtime_error("could not open output file for writing: " +
+                                 myPointFilename);
+      }
+      myData.emplace_back(std::make_unique<Data>());
+
+      for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
+        myParameters.push_back(Parameters{mySeed,
+                                          myMu,
+                                          myGridSize,
+                                          myThreshold,
+                                          myLinkProbability,
+                                          myLinkMinEpr,
+                                          myLinkMaxEpr,
+                                          myQ,
+                                          myQuantum,
+                                          myK,
+                                          myFidelityInit,
+                                          myNumApps,
+                                          myNumPeersMin,
+                                          myNumPeersMax,
+                                          myDistanceMin,
+                                          myDistanceMax,
+                                          myFidelityThreshold,
+                                          myTargetResidual,
+                                          myDotFile,
+                                          myPoint,
+                                          myVarMap.count("instrumentation") ==
+                                              1,
+                                          myVarMap.count("perf-counters") ==
+                                              1,
+                                          myVarMap.count("memory-accounting") ==
+                                              1});
+      }
     }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
+
+    qr::WorkStealingBatch<Parameters> myWorkers(
+        myNumThreads, std::move(myParameters), [&myData](auto&& aParameters) {
+          qr::Trace::registerThread();
+          qr::Trace::experiment(aParameters.thePoint, aParameters.theSeed);
+          auto& myPointData = *myData[aParameters.thePoint];
+          runExperiment(myPointData, std::move(aParameters));
         });
     const auto myExceptions = myWorkers.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
     }
+    for (std::size_t i = 0; i < myWorkers.stats().size(); i++) {
+      LOG(INFO) << "thread #" << i << ": " << myWorkers.stats()[i].toString();
+    }
+
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      myData[myPoint]->toCsv(myFiles[myPoint]);
+    }
 
-    myData.toCsv(myFile);
+    if (not myTraceFilename.empty()) {
+      std::ofstream myTraceFile(myTraceFilename, std::ios::binary);
+      qr::Trace::save(myTraceFile);
+    }
 
     return EXIT_SUCCESS;
   } catch (const std::exception& aErr) {
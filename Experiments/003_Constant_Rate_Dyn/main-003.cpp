@@ -30,12 +30,18 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/flowreader.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/latencyhistogram.h"
+#include "QuantumRouting/lockstepnetwork.h"
 #include "QuantumRouting/networkfactory.h"
+#include "QuantumRouting/paramgrid.h"
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/trace.h"
+#include "QuantumRouting/workload.h"
+#include "QuantumRouting/workstealingbatch.h"
 #include "Support/experimentdata.h"
 #include "Support/glograii.h"
-#include "Support/parallelbatch.h"
-#include "Support/queue.h"
 #include "Support/random.h"
 #include "Support/split.h"
 #include "Support/stat.h"
@@ -48,8 +54,15 @@ SOFTWARE.
 #include <fstream>
 #include <glog/logging.h>
 
+#include <cmath>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -89,6 +102,13 @@ struct Parameters {
 
   // simulation
   std::string theTopoFilename;
+  std::string theRecordFilename;  //!< record the flow arrivals to this file
+  std::string theReplayFilename;  //!< read the flow arrivals from this file
+  std::string theFlowFilename;    //!< read the flow requests from this file
+  std::size_t thePoint;           //!< index of the grid point in a sweep
+  bool        theInstrumentation; //!< add timers and counters to the output
+  bool        thePerfCounters;    //!< add hardware counters to the output
+  bool        theMemoryAccounting; //!< add the memory usage to the output
 
   static const std::vector<std::string>& names() {
     static std::vector<std::string> ret({
@@ -138,6 +158,10 @@ struct Parameters {
         << v2s(theFidelityThresholds) << "}"
         << ", and a net requested rate drawn randomly from {"
         << v2s(theNetRates) << "} EPR pairs/s, experiment seed " << theSeed;
+    if (not theFlowFilename.empty()) {
+      myStream << "; flows read from " << theFlowFilename
+               << " with the average duration above";
+    }
 
     return myStream.str();
   }
@@ -153,18 +177,36 @@ struct Parameters {
              << v2s(theNetRates) << ',' << v2s(theFidelityThresholds);
     return myStream.str();
   }
+
+  //! \return the expected cost of the experiment, in arbitrary units: the
+  //! number of flows times the average number of nodes, which is not known in
+  //! advance with GraphML topologies.
+  double cost() const {
+    return theArrivalRate * theSimDuration *
+           (theGraphMlFilename.empty() ? theMu : 1.0);
+  }
 };
 
 struct Output {
   explicit Output() = default;
 
   explicit Output(const std::vector<double>& aNetRates,
-                  const std::vector<double>& aFidelityThresholds) {
-    resize(aNetRates, aFidelityThresholds);
+                  const std::vector<double>& aFidelityThresholds,
+                  const bool                 aInstrumentation,
+                  const bool                 aPerfCounters,
+                  const bool                 aMemoryAccounting) {
+    resize(aNetRates,
+           aFidelityThresholds,
+           aInstrumentation,
+           aPerfCounters,
+           aMemoryAccounting);
   }
 
   void resize(const std::vector<double>& aNetRates,
-              const std::vector<double>& aFidelityThresholds) {
+              const std::vector<double>& aFidelityThresholds,
+              const bool                 aInstrumentation,
+              const bool                 aPerfCounters,
+              const bool                 aMemoryAccounting) {
     if (aNetRates.empty() or aFidelityThresholds.empty()) {
       throw std::runtime_error("invalid empty set of rates or fidelities");
     }
@@ -205,6 +247,15 @@ struct Output {
         }
       }
     }
+    theInstrumentation.reset();
+    if (aInstrumentation) {
+      theInstrumentation.emplace();
+      const auto& myInstrumentationNames =
+          qr::Instrumentation::names(aPerfCounters, aMemoryAccounting);
+      theNames.insert(theNames.end(),
+                      myInstrumentationNames.begin(),
+                      myInstrumentationNames.end());
+    }
   }
 
   // graph properties
@@ -235,6 +286,9 @@ struct Output {
   };
   std::vector<std::vector<PerClass>> thePerClass;
 
+  // only with --instrumentation
+  std::optional<qr::Instrumentation> theInstrumentation;
+
   std::vector<std::string> theNames;
 
   const std::vector<std::string> names() {
@@ -256,6 +310,9 @@ struct Output {
              << theAvgPathSize
              << ", average fidelity of the end-to-end entangled pair "
              << theAvgFidelity;
+    if (theInstrumentation.has_value()) {
+      myStream << "; " << theInstrumentation->toString();
+    }
     return myStream.str();
   }
 
@@ -282,31 +339,533 @@ struct Output {
         }
       }
     }
+    if (theInstrumentation.has_value()) {
+      myStream << ',' << theInstrumentation->toCsv();
+    }
     return myStream.str();
   }
 };
 
+//! Experiments of the same grid point with consecutive seeds, which are
+//! simulated together in lockstep if there are more than one.
+struct Block {
+  std::vector<Parameters> theParameters;
+
+  double cost() const {
+    double ret = 0;
+    for (const auto& myParameters : theParameters) {
+      ret += myParameters.cost();
+    }
+    return ret;
+  }
+};
+
 using Data = us::ExperimentData<Parameters, Output>;
 
-void runExperiment(Data& aData, Parameters&& aParameters) {
-  // fidelity computation parameters
-  constexpr double p1  = 1.0;
-  constexpr double p2  = 1.0;
-  constexpr double eta = 1.0;
+// fidelity computation parameters
+constexpr double p1  = 1.0;
+constexpr double p2  = 1.0;
+constexpr double eta = 1.0;
+
+/**
+ * @brief Simulation of the arrival and departure of flows in a network, where
+ * the new flows are routed by the caller.
+ *
+ * The flow arrivals are drawn from random variables, which do not depend on
+ * the routing decisions, or they are replayed from a workload file recorded
+ * in a previous simulation, or they are read from a file of flow requests,
+ * in which case only the durations are drawn randomly.
+ */
+class Simulation final
+{
+ public:
+  using FlowDescriptor = qr::CapacityNetwork::FlowDescriptor;
+  //! Restore the capacity of a path: source, path, gross rate.
+  using ReleaseFunction = std::function<void(
+      unsigned long, const std::vector<unsigned long>&, double)>;
+  //! Return the residual capacity of the network.
+  using CapacityFunction = std::function<double()>;
+
+  Simulation(const Parameters&          aParameters,
+             const std::vector<double>& aNodeCapacities,
+             const ReleaseFunction&     aReleaseFunction,
+             const CapacityFunction&    aCapacityFunction)
+      : theParameters(aParameters)
+      , theNodeCapacities(aNodeCapacities)
+      , theReleaseFunction(aReleaseFunction)
+      , theCapacityFunction(aCapacityFunction)
+      , theFidelityTable(
+            p1, p2, eta, aParameters.theFidelityInit, aNodeCapacities.size())
+      , theNow(0)
+      , theResidualCapacity(theNow, aParameters.theWarmup)
+      , theNumActiveFlows(theNow, aParameters.theWarmup)
+      , thePerClassStats(aParameters.theNetRates.size(),
+                         std::vector<PerClassStat>(
+                             aParameters.theFidelityThresholds.size()))
+      , theArrivalRv(aParameters.theArrivalRate, aParameters.theSeed, 0, 0)
+      , theDurationRv(
+            1.0 / aParameters.theFlowDuration, aParameters.theSeed, 1, 0)
+      , theNetRatesRv(
+            0, aParameters.theNetRates.size() - 1, aParameters.theSeed, 2, 0)
+      , theFidelitiesRv(0,
+                        aParameters.theFidelityThresholds.size() - 1,
+                        aParameters.theSeed,
+                        3,
+                        0)
+      , theSrcDstRv(0, 1, aParameters.theSeed, 4, 0)
+      , theNodes(aNodeCapacities.size())
+      , theRecorder(aParameters.theRecordFilename.empty() ?
+                        nullptr :
+                        std::make_unique<qr::WorkloadWriter>(
+                            aParameters.theRecordFilename,
+                            qr::WorkloadHeader::make(
+                                aNodeCapacities.size(),
+                                aParameters.theNetRates.size(),
+                                aParameters.theFidelityThresholds.size(),
+                                aParameters.theSeed)))
+      , theReplay(aParameters.theReplayFilename.empty() ?
+                      nullptr :
+                      std::make_unique<qr::WorkloadReader>(
+                          aParameters.theReplayFilename))
+      , theReplayIndex(0)
+      , theFlowReader(aParameters.theFlowFilename.empty() ?
+                          nullptr :
+                          std::make_unique<qr::FlowReader>(
+                              aParameters.theFlowFilename,
+                              aNodeCapacities.size()))
+      , theArrivalNetRate(0)
+      , theArrivalFidelityThreshold(0)
+      , theEventClass(0) {
+    for (unsigned long i = 0; i < theNodes.size(); ++i) {
+      theNodes[i] = i;
+    }
+    if (theReplay) {
+      theReplay->header().check(aNodeCapacities.size(),
+                                aParameters.theNetRates.size(),
+                                aParameters.theFidelityThresholds.size());
+    }
+    nextArrival();
+    theResidualCapacity(theCapacityFunction());
+    theNumActiveFlows(0);
+  }
 
-  Data::Raii myRaii(aData, std::move(aParameters));
+  /**
+   * @brief Process the departures until the next arrival.
+   *
+   * @param aFlow set to the new flow, if any
+   *
+   * \return true if there is a new flow to be routed, false if the simulation
+   * is finished
+   */
+  bool next(std::optional<FlowDescriptor>& aFlow) {
+    aFlow.reset();
+    while (theNow <= theParameters.theSimDuration) {
+      const auto myEarliestLeave =
+          std::min_element(theAdmittedFlows.begin(),
+                           theAdmittedFlows.end(),
+                           [](const auto& aLhs, const auto& aRhs) {
+                             return aLhs.theLeaveTime < aRhs.theLeaveTime;
+                           });
+
+      if (myEarliestLeave == theAdmittedFlows.end() and
+          not theArrival.has_value()) {
+        break;
+      }
 
-  Output myOutput(myRaii.in().theNetRates, myRaii.in().theFidelityThresholds);
+      if (theArrival.has_value() and
+          (myEarliestLeave == theAdmittedFlows.end() or
+           theArrival->theTime < myEarliestLeave->theLeaveTime)) {
+        theNow        = theArrival->theTime;
+        theEventClass = theArrival->theNetRateId *
+                            theParameters.theFidelityThresholds.size() +
+                        theArrival->theFidelityThresholdId;
+        aFlow.emplace(theArrival->theSrc,
+                      theArrival->theDst,
+                      theArrivalNetRate);
+        return true;
+      }
 
-  // consistency checks
-  if (myRaii.in().theArrivalRate <= 0) {
+      assert(myEarliestLeave != theAdmittedFlows.end());
+      theNow = myEarliestLeave->theLeaveTime;
+      VLOG(3) << "time " << theNow << " an admitted flow leaves";
+
+      // restore the capacity of the path
+      theEventClass = myEarliestLeave->theClass;
+      theReleaseFunction(myEarliestLeave->theSrc,
+                         myEarliestLeave->thePath,
+                         myEarliestLeave->theGrossRate);
+
+      // remove the flow from the list of admitted/active ones
+      theAdmittedFlows.erase(myEarliestLeave);
+
+      // record statistics
+      theResidualCapacity(theCapacityFunction());
+      theNumActiveFlows(theAdmittedFlows.size());
+    }
+    return false;
+  }
+
+  //! \return true if the path of the new flow meets its fidelity threshold.
+  bool check(const FlowDescriptor& aFlow) const {
+    assert(not aFlow.thePath.empty());
+    assert(theArrival.has_value());
+    return theFidelityTable(aFlow.thePath.size()) >=
+           theArrivalFidelityThreshold;
+  }
+
+  /**
+   * @brief Return the class of the flow arriving or leaving in the current
+   * event, i.e., the index of its net rate and fidelity threshold in
+   * row-major order.
+   */
+  std::size_t eventClass() const noexcept {
+    return theEventClass;
+  }
+
+  //! Record the outcome of the routing of the new flow.
+  void routed(const FlowDescriptor& aFlow) {
+    assert(theArrival.has_value());
+    const auto myNetRateId           = theArrival->theNetRateId;
+    const auto myFidelityThresholdId = theArrival->theFidelityThresholdId;
+
+    // retrieve the per-class set of statistics
+    assert(myNetRateId < thePerClassStats.size());
+    assert(myFidelityThresholdId < thePerClassStats[myNetRateId].size());
+    auto& myPerClassStat = thePerClassStats[myNetRateId][myFidelityThresholdId];
+
+    if (aFlow.thePath.empty()) {
+      VLOG(2) << "time " << theNow << " dropped  " << aFlow.toString()
+              << ", fidelity threshold " << theArrivalFidelityThreshold;
+
+      // record global and per-class statistics
+      if (theNow >= theParameters.theWarmup) {
+        theDijkstra(aFlow.theDijsktra);
+        theAdmissionRate(0.0);
+        myPerClassStat.theAdmissionRate(0.0);
+      }
+
+    } else {
+      const auto myLeaveTime = theNow + theArrival->theDuration;
+      VLOG(2) << "time " << theNow << " admitted " << aFlow.toString()
+              << ", fidelity threshold " << theArrivalFidelityThreshold
+              << ", will leave at " << myLeaveTime;
+      assert(aFlow.theGrossRate > 0);
+
+      theAdmittedFlows.emplace_back(AdmittedFlow{aFlow.theSrc,
+                                                 aFlow.thePath,
+                                                 myLeaveTime,
+                                                 aFlow.theGrossRate,
+                                                 theEventClass});
+
+      // time-weighted statistics
+      theResidualCapacity(theCapacityFunction());
+      theNumActiveFlows(theAdmittedFlows.size());
+
+      // time-independent statistics
+      if (theNow >= theParameters.theWarmup) {
+        // global statistics
+        theDijkstra(aFlow.theDijsktra);
+        theGrossRate(aFlow.theGrossRate);
+        theNetRate(aFlow.theNetRate);
+        theAdmissionRate(1.0);
+        thePathSize(aFlow.thePath.size());
+        theFidelity(theFidelityTable(aFlow.thePath.size()));
+        // per-class statistics
+        myPerClassStat.theGrossRate(aFlow.theGrossRate);
+        myPerClassStat.theNetRate(aFlow.theNetRate);
+        myPerClassStat.theAdmissionRate(1.0);
+        myPerClassStat.thePathSize(aFlow.thePath.size());
+      }
+    }
+
+    nextArrival();
+  }
+
+  //! Save the routing properties into the output.
+  void fill(Output& aOutput) {
+    aOutput.theResidualCapacity = theResidualCapacity.mean();
+    aOutput.theNumActiveFlows   = theNumActiveFlows.mean();
+    aOutput.theAvgDijkstraCalls = theDijkstra.mean();
+    aOutput.theGrossRate        = theGrossRate.mean();
+    aOutput.theNetRate          = theNetRate.mean();
+    aOutput.theAdmissionRate    = theAdmissionRate.mean();
+    aOutput.theAvgPathSize      = thePathSize.mean();
+    aOutput.theAvgFidelity      = theFidelity.mean();
+
+    for (std::size_t i = 0; i < thePerClassStats.size(); i++) {
+      for (std::size_t j = 0; j < thePerClassStats[i].size(); j++) {
+        const auto& myStat = thePerClassStats[i][j];
+        assert(i < aOutput.thePerClass.size());
+        assert(j < aOutput.thePerClass[i].size());
+
+        aOutput.thePerClass[i][j].theGrossRate = myStat.theGrossRate.mean();
+        aOutput.thePerClass[i][j].theNetRate   = myStat.theNetRate.mean();
+        aOutput.thePerClass[i][j].theAdmissionRate =
+            myStat.theAdmissionRate.mean();
+        aOutput.thePerClass[i][j].theAvgPathSize = myStat.thePathSize.mean();
+      }
+    }
+  }
+
+ private:
+  /**
+   * @brief Set the next flow arrival, drawn from the random variables or read
+   * from the workload being replayed or the flow requests, and record it if
+   * needed.
+   *
+   * The arrival is reset if there are no more flows to be replayed or read.
+   *
+   * @throw std::runtime_error if the replayed flow is not valid
+   */
+  void nextArrival() {
+    if (theReplay) {
+      if (theReplayIndex == theReplay->size()) {
+        theArrival.reset();
+        return;
+      }
+      // the header has been checked against the network and the classes
+      theArrival = (*theReplay)[theReplayIndex++];
+      if (not theReplay->header().valid(*theArrival)) {
+        throw std::runtime_error("invalid flow in workload file " +
+                                 theParameters.theReplayFilename + ": " +
+                                 theArrival->toString());
+      }
+
+    } else if (theFlowReader) {
+      qr::FlowRequest myRequest;
+      if (not theFlowReader->next(myRequest)) {
+        theArrival.reset();
+        return;
+      }
+      if (myRequest.theSrc >= theNodes.size() or
+          myRequest.theDst >= theNodes.size()) {
+        throw std::runtime_error("invalid flow in file " +
+                                 theParameters.theFlowFilename + ": " +
+                                 myRequest.toString());
+      }
+      theArrival = qr::WorkloadEvent{
+          myRequest.theTime,
+          myRequest.theSrc,
+          myRequest.theDst,
+          closest(theParameters.theNetRates, myRequest.theNetRate),
+          closest(theParameters.theFidelityThresholds,
+                  myRequest.theFidelityThreshold),
+          theDurationRv()};
+      theArrivalNetRate           = myRequest.theNetRate;
+      theArrivalFidelityThreshold = myRequest.theFidelityThreshold;
+      return;
+
+    } else {
+      std::vector<unsigned long> mySrcDstNodes;
+      if (theParameters.theSrcDstPolicy == "uniform") {
+        mySrcDstNodes = us::sample(theNodes, 2, theSrcDstRv);
+      } else if (theParameters.theSrcDstPolicy == "nodecapacities") {
+        mySrcDstNodes =
+            us::sampleWeighted(theNodes, theNodeCapacities, 2, theSrcDstRv);
+      } else {
+        throw std::runtime_error("unknown src/dst policy: " +
+                                 theParameters.theSrcDstPolicy);
+      }
+      assert(mySrcDstNodes.size() == 2);
+      assert(mySrcDstNodes[0] != mySrcDstNodes[1]);
+
+      // the first flow arrives at time 0
+      const auto myTime =
+          theArrival.has_value() ? theArrival->theTime + theArrivalRv() : 0.0;
+      theArrival = qr::WorkloadEvent{
+          myTime,
+          static_cast<std::uint32_t>(mySrcDstNodes[0]),
+          static_cast<std::uint32_t>(mySrcDstNodes[1]),
+          static_cast<std::uint32_t>(theNetRatesRv()),
+          static_cast<std::uint32_t>(theFidelitiesRv()),
+          theDurationRv()};
+      assert(theArrival->theNetRateId < theParameters.theNetRates.size());
+      assert(theArrival->theFidelityThresholdId <
+             theParameters.theFidelityThresholds.size());
+    }
+
+    theArrivalNetRate = theParameters.theNetRates[theArrival->theNetRateId];
+    theArrivalFidelityThreshold =
+        theParameters.theFidelityThresholds[theArrival->theFidelityThresholdId];
+
+    if (theRecorder) {
+      (*theRecorder)(*theArrival);
+    }
+  }
+
+  //! \return the index of the value closest to the given one.
+  static std::uint32_t closest(const std::vector<double>& aValues,
+                               const double               aValue) {
+    assert(not aValues.empty());
+    std::uint32_t ret = 0;
+    for (std::uint32_t i = 1; i < aValues.size(); i++) {
+      if (std::abs(aValues[i] - aValue) < std::abs(aValues[ret] - aValue)) {
+        ret = i;
+      }
+    }
+    return ret;
+  }
+
+  struct PerClassStat {
+    us::SummaryStat theGrossRate;
+    us::SummaryStat theNetRate;
+    us::SummaryStat theAdmissionRate;
+    us::SummaryStat thePathSize;
+  };
+
+  // flows admitted at any time
+  struct AdmittedFlow {
+    unsigned long              theSrc;
+    std::vector<unsigned long> thePath;
+    double                     theLeaveTime;
+    double                     theGrossRate;
+    std::size_t                theClass;
+  };
+
+  const Parameters&         theParameters;
+  const std::vector<double> theNodeCapacities;
+  const ReleaseFunction     theReleaseFunction;
+  const CapacityFunction    theCapacityFunction;
+  const qr::FidelityTable   theFidelityTable;
+
+  // simulated clock
+  double theNow;
+
+  // statistics
+  us::SummaryWeightedStat                theResidualCapacity;
+  us::SummaryWeightedStat                theNumActiveFlows;
+  us::SummaryStat                        theDijkstra;
+  us::SummaryStat                        theGrossRate;
+  us::SummaryStat                        theNetRate;
+  us::SummaryStat                        theAdmissionRate;
+  us::SummaryStat                        thePathSize;
+  us::SummaryStat                        theFidelity;
+  std::vector<std::vector<PerClassStat>> thePerClassStats;
+
+  std::list<AdmittedFlow> theAdmittedFlows;
+
+  // random variables for flow generation
+  us::ExponentialRv             theArrivalRv;
+  us::ExponentialRv             theDurationRv;
+  us::UniformIntRv<std::size_t> theNetRatesRv;
+  us::UniformIntRv<std::size_t> theFidelitiesRv;
+  us::UniformRv                 theSrcDstRv;
+  std::vector<unsigned long>    theNodes;
+
+  // recording and replay of the flow arrivals
+  const std::unique_ptr<qr::WorkloadWriter> theRecorder;
+  const std::unique_ptr<qr::WorkloadReader> theReplay;
+  std::size_t                               theReplayIndex;
+
+  // flow requests read from a file
+  const std::unique_ptr<qr::FlowReader> theFlowReader;
+
+  // next flow arrival, which is also the one being routed between next() and
+  // routed(), if any, with its requirements: with flow requests read from a
+  // file these are not necessarily the values of its classes, which are the
+  // closest ones and are only used for the per-class statistics
+  std::optional<qr::WorkloadEvent> theArrival;
+  double                           theArrivalNetRate;
+  double                           theArrivalFidelityThreshold;
+
+  // class of the flow arriving or leaving in the current event
+  std::size_t theEventClass;
+};
+
+//! Latency of the decisions of all the experiments of a grid point.
+struct Latencies {
+  explicit Latencies(const std::vector<std::string>& aClasses)
+      : theMutex()
+      , theLatencies(aClasses) {
+    // noop
+  }
+
+  //! \return the names of the classes of flows, as in the output.
+  static std::vector<std::string>
+  classes(const std::vector<double>& aNetRates,
+          const std::vector<double>& aFidelityThresholds) {
+    std::vector<std::string> ret;
+    for (const auto myNetRate : aNetRates) {
+      for (const auto myFidelityThreshold : aFidelityThresholds) {
+        ret.emplace_back(std::to_string(myNetRate) + "-" +
+                         std::to_string(myFidelityThreshold));
+      }
+    }
+    return ret;
+  }
+
+  //! Add the latencies of an experiment. Thread-safe.
+  void merge(const qr::DecisionLatencies& aLatencies) {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theLatencies.merge(aLatencies);
+  }
+
+  std::mutex            theMutex;
+  qr::DecisionLatencies theLatencies;
+};
+
+void checkParameters(const Parameters& aParameters) {
+  if (aParameters.theArrivalRate <= 0) {
     throw std::runtime_error("the arrival rate must be positive: " +
-                             std::to_string(myRaii.in().theArrivalRate));
+                             std::to_string(aParameters.theArrivalRate));
   }
-  if (myRaii.in().theFlowDuration <= 0) {
+  if (aParameters.theFlowDuration <= 0) {
     throw std::runtime_error("the flow duration must be positive: " +
-                             std::to_string(myRaii.in().theFlowDuration));
+                             std::to_string(aParameters.theFlowDuration));
   }
+}
+
+void saveNetworkProperties(const Parameters&              aParameters,
+                           const std::vector<qr::Coordinate>& aCoordinates,
+                           qr::CapacityNetwork&           aNetwork,
+                           Output&                        aOutput) {
+  aNetwork.measurementProbability(aParameters.theQ);
+
+  if (not aParameters.theTopoFilename.empty()) {
+    aNetwork.toGnuplot(aParameters.theTopoFilename + "-" +
+                           std::to_string(aParameters.theSeed),
+                       aCoordinates);
+  }
+
+  if (aNetwork.numNodes() < 2) {
+    throw std::runtime_error("the network must have at least "
+                             "two nodes");
+  }
+
+  aOutput.theNumNodes      = aNetwork.numNodes();
+  aOutput.theNumEdges      = aNetwork.numEdges();
+  aOutput.theTotalCapacity = aNetwork.totalCapacity();
+  std::tie(aOutput.theMinInDegree, aOutput.theMaxInDegree) =
+      aNetwork.inDegree();
+  std::tie(aOutput.theMinOutDegree, aOutput.theMaxOutDegree) =
+      aNetwork.outDegree();
+}
+
+void runExperiment(Data&        aData,
+                   Parameters&& aParameters,
+                   Latencies*   aLatencies) {
+  Data::Raii myRaii(aData, std::move(aParameters));
+
+  Output myOutput(myRaii.in().theNetRates,
+                  myRaii.in().theFidelityThresholds,
+                  myRaii.in().theInstrumentation,
+                  myRaii.in().thePerfCounters,
+                  myRaii.in().theMemoryAccounting);
+  qr::PhaseTimers* myTimers = myOutput.theInstrumentation.has_value() ?
+                                  &myOutput.theInstrumentation->theTimers :
+                                  nullptr;
+  if (myTimers != nullptr and myRaii.in().thePerfCounters) {
+    myTimers->perfCounters(std::make_shared<qr::PerfCounters>());
+  }
+  std::optional<qr::MemoryAccounting> myMemoryAccounting;
+  if (myOutput.theInstrumentation.has_value() and
+      myRaii.in().theMemoryAccounting) {
+    myMemoryAccounting.emplace(
+        myOutput.theInstrumentation->theMemory.emplace());
+  }
+
+  // consistency checks
+  checkParameters(myRaii.in());
 
   // open the GraphML file with the network topology, if needed
   const auto myGraphMlStream =
@@ -335,254 +894,196 @@ void runExperiment(Data& aData, Parameters&& aParameters) {
                                      myRaii.in().theGridLength,
                                      myRaii.in().theThreshold,
                                      myRaii.in().theLinkProbability,
-                                     myCoordinates) :
+                                     myCoordinates,
+                                     myTimers) :
           qr::makeCapacityNetworkGraphMl(
-              myLinkEprRv, *myGraphMlStream, myCoordinates);
-  myNetwork->measurementProbability(myRaii.in().theQ);
-
-  if (not myRaii.in().theTopoFilename.empty()) {
-    myNetwork->toGnuplot(myRaii.in().theTopoFilename + "-" +
-                             std::to_string(myRaii.in().theSeed),
-                         myCoordinates);
-  }
-
-  if (myNetwork->numNodes() < 2) {
-    throw std::runtime_error("the network must have at least "
-                             "two nodes");
-  }
-
-  // simulated clock
-  double myNow = 0;
+              myLinkEprRv, *myGraphMlStream, myCoordinates, myTimers);
 
   // network properties
   assert(myNetwork.get() != nullptr);
-  myOutput.theNumNodes      = myNetwork->numNodes();
-  myOutput.theNumEdges      = myNetwork->numEdges();
-  myOutput.theTotalCapacity = myNetwork->totalCapacity();
-  std::tie(myOutput.theMinInDegree, myOutput.theMaxInDegree) =
-      myNetwork->inDegree();
-  std::tie(myOutput.theMinOutDegree, myOutput.theMaxOutDegree) =
-      myNetwork->outDegree();
-  myNetwork->reachableNodes(0, 0, myOutput.theDiameter);
-
-  // prepare statistics data structures
-  struct PerClassStat {
-    us::SummaryStat theGrossRate;
-    us::SummaryStat theNetRate;
-    us::SummaryStat theAdmissionRate;
-    us::SummaryStat thePathSize;
-  };
-  us::SummaryWeightedStat myResidualCapacity(myNow, myRaii.in().theWarmup);
-  us::SummaryWeightedStat myNumActiveFlows(myNow, myRaii.in().theWarmup);
-  us::SummaryStat         myDijkstra;
-  us::SummaryStat         myGrossRate;
-  us::SummaryStat         myNetRate;
-  us::SummaryStat         myAdmissionRate;
-  us::SummaryStat         myPathSize;
-  us::SummaryStat         myFidelity;
-  std::vector<std::vector<std::shared_ptr<PerClassStat>>> myPerClassStats(
-      myRaii.in().theNetRates.size(),
-      std::vector<std::shared_ptr<PerClassStat>>(
-          myRaii.in().theFidelityThresholds.size(), nullptr));
-  for (auto& myElems : myPerClassStats) {
-    for (auto& myStat : myElems) {
-      myStat = std::make_shared<PerClassStat>();
-    }
-  }
-  myResidualCapacity(myNetwork->totalCapacity());
-  myNumActiveFlows(0);
+  saveNetworkProperties(myRaii.in(), myCoordinates, *myNetwork, myOutput);
+  {
+    qr::PhaseTimers::Scope myScope(myTimers, qr::PhaseTimers::Phase::Diameter);
+    myNetwork->reachableNodes(0, 0, myOutput.theDiameter);
+  }
 
-  // flows admitted at any time
-  struct AdmittedFlow {
-    unsigned long              theSrc;
-    std::vector<unsigned long> thePath;
-    double                     theLeaveTime;
-    double                     theGrossRate;
-  };
-  std::list<AdmittedFlow> myAdmittedFlows;
-
-  // prepare random variables for flow
-  // generation
-  us::ExponentialRv myArrivalRv(
-      myRaii.in().theArrivalRate, myRaii.in().theSeed, 0, 0);
-  us::ExponentialRv myDurationRv(
-      1.0 / myRaii.in().theFlowDuration, myRaii.in().theSeed, 1, 0);
-  us::UniformIntRv<std::size_t> myNetRatesRv(
-      0, myRaii.in().theNetRates.size() - 1, myRaii.in().theSeed, 2, 0);
-  us::UniformIntRv<std::size_t> myFidelitiesRv(
-      0,
-      myRaii.in().theFidelityThresholds.size() - 1,
-      myRaii.in().theSeed,
-      3,
-      0);
-  us::UniformRv              mySrcDstRv(0, 1, myRaii.in().theSeed, 4, 0);
-  std::vector<unsigned long> myNodes(myNetwork->numNodes());
-  for (unsigned long i = 0; i < myNodes.size(); ++i) {
-    myNodes[i] = i;
-  }
-  const auto myNodeCapacities = myNetwork->nodeCapacities();
-  assert(myNodeCapacities.size() == myNodes.size());
-
-  // run simulation
-  double myNextArrival = 0;
-  while (myNow <= myRaii.in().theSimDuration) {
-    const auto myEarliestLeave =
-        std::min_element(myAdmittedFlows.begin(),
-                         myAdmittedFlows.end(),
-                         [](const auto& aLhs, const auto& aRhs) {
-                           return aLhs.theLeaveTime < aRhs.theLeaveTime;
+  // run simulation, recording the latency per class of flow if needed
+  Simulation mySimulation(
+      myRaii.in(),
+      myNetwork->nodeCapacities(),
+      [&myNetwork, myTimers](
+          const auto aSrc, const auto& aPath, const auto aGrossRate) {
+        qr::PhaseTimers::Scope myScope(myTimers,
+                                       qr::PhaseTimers::Phase::Routing);
+        myNetwork->addCapacityToPath(aSrc, aPath, aGrossRate);
+      },
+      [&myNetwork, myTimers]() {
+        qr::PhaseTimers::Scope myScope(myTimers,
+                                       qr::PhaseTimers::Phase::Statistics);
+        return myNetwork->totalCapacity();
+      });
+  if (aLatencies != nullptr) {
+    myNetwork->latencies(std::make_shared<qr::DecisionLatencies>(
+                             aLatencies->theLatencies.classes()),
+                         [&mySimulation](const auto&) {
+                           return mySimulation.eventClass();
                          });
+  }
+  std::optional<qr::CapacityNetwork::FlowDescriptor> myFlow;
+  while (mySimulation.next(myFlow)) {
+    // try to admit the new traffic flow
+    std::vector<qr::CapacityNetwork::FlowDescriptor> myFlows;
+    {
+      qr::MemoryAccounting::Scope myMemoryScope(
+          qr::MemoryUsage::Subsystem::Descriptors);
+      myFlows.emplace_back(*myFlow);
+    }
+    {
+      qr::PhaseTimers::Scope myScope(myTimers,
+                                     qr::PhaseTimers::Phase::Routing);
+      myNetwork->route(myFlows, [&mySimulation](const auto& aFlow) {
+        return mySimulation.check(aFlow);
+      });
+    }
+    assert(myFlows.size() == 1);
+
+    // the admitted flows are kept until they leave
+    qr::PhaseTimers::Scope      myScope(myTimers,
+                                        qr::PhaseTimers::Phase::Statistics);
+    qr::MemoryAccounting::Scope myMemoryScope(
+        qr::MemoryUsage::Subsystem::Descriptors);
+    mySimulation.routed(myFlows[0]);
+  }
+  {
+    qr::PhaseTimers::Scope      myScope(myTimers,
+                                        qr::PhaseTimers::Phase::Statistics);
+    qr::MemoryAccounting::Scope myMemoryScope(
+        qr::MemoryUsage::Subsystem::Statistics);
+    mySimulation.fill(myOutput);
+  }
+  if (myOutput.theInstrumentation.has_value()) {
+    myOutput.theInstrumentation->theCounters = myNetwork->counters();
+  }
+  if (aLatencies != nullptr) {
+    aLatencies->merge(*myNetwork->latencies());
+  }
+  myMemoryAccounting.reset();
 
-    if (myEarliestLeave == myAdmittedFlows.end() or
-        myNextArrival < myEarliestLeave->theLeaveTime) {
-      myNow = myNextArrival;
-
-      std::vector<unsigned long> mySrcDstNodes;
-      if (myRaii.in().theSrcDstPolicy == "uniform") {
-        mySrcDstNodes = us::sample(myNodes, 2, mySrcDstRv);
-      } else if (myRaii.in().theSrcDstPolicy == "nodecapacities") {
-        mySrcDstNodes =
-            us::sampleWeighted(myNodes, myNodeCapacities, 2, mySrcDstRv);
-      } else {
-        throw std::runtime_error("unknown src/dst policy: " +
-                                 myRaii.in().theSrcDstPolicy);
-      }
-      assert(mySrcDstNodes.size() == 2);
-      assert(mySrcDstNodes[0] != mySrcDstNodes[1]);
-
-      const auto myNetRateId = myNetRatesRv();
-      assert(myNetRateId < myRaii.in().theNetRates.size());
-      std::vector<qr::CapacityNetwork::FlowDescriptor> myFlows(
-          {{mySrcDstNodes[0],
-            mySrcDstNodes[1],
-            myRaii.in().theNetRates[myNetRateId]}});
-
-      // try to admit the new traffic flow
-      const auto myFidelityThresholdId = myFidelitiesRv();
-      assert(myFidelityThresholdId < myRaii.in().theFidelityThresholds.size());
-      myNetwork->route(
-          myFlows, [&myRaii, myFidelityThresholdId](const auto& aFlow) {
-            assert(not aFlow.thePath.empty());
-            return qr::fidelitySwapping(p1,
-                                        p2,
-                                        eta,
-                                        aFlow.thePath.size() - 1,
-                                        myRaii.in().theFidelityInit) >=
-                   myRaii.in().theFidelityThresholds[myFidelityThresholdId];
-          });
-      assert(myFlows.size() == 1);
-
-      // retrieve the per-class set of
-      // statistics
-      assert(myNetRateId < myPerClassStats.size());
-      assert(myFidelityThresholdId < myPerClassStats[myNetRateId].size());
-      auto& myPerClassStat =
-          myPerClassStats[myNetRateId][myFidelityThresholdId];
-      assert(myPerClassStat.get() != nullptr);
-
-      if (myFlows[0].thePath.empty()) {
-        VLOG(2) << "time " << myNow << " dropped  " << myFlows[0].toString()
-                << ", fidelity threshold "
-                << myRaii.in().theFidelityThresholds[myFidelityThresholdId];
-
-        // record global and per-class
-        // statistics
-        if (myNow >= myRaii.in().theWarmup) {
-          myDijkstra(myFlows[0].theDijsktra);
-          myAdmissionRate(0.0);
-          myPerClassStat->theAdmissionRate(0.0);
-        }
-
-      } else {
-        const auto myLeaveTime = myNow + myDurationRv();
-        VLOG(2) << "time " << myNow << " admitted " << myFlows[0].toString()
-                << ", fidelity threshold "
-                << myRaii.in().theFidelityThresholds[myFidelityThresholdId]
-                << ", will leave at " << myLeaveTime;
-        assert(myFlows[0].theGrossRate > 0);
-
-        myAdmittedFlows.emplace_back(AdmittedFlow{myFlows[0].theSrc,
-                                                  myFlows[0].thePath,
-                                                  myLeaveTime,
-                                                  myFlows[0].theGrossRate});
-
-        // time-weighted statistics
-        myResidualCapacity(myNetwork->totalCapacity());
-        myNumActiveFlows(myAdmittedFlows.size());
-
-        // time-independent statistics
-        if (myNow >= myRaii.in().theWarmup) {
-          // global statistics
-          myDijkstra(myFlows[0].theDijsktra);
-          myGrossRate(myFlows[0].theGrossRate);
-          myNetRate(myFlows[0].theNetRate);
-          myAdmissionRate(1.0);
-          myPathSize(myFlows[0].thePath.size());
-          myFidelity(qr::fidelitySwapping(p1,
-                                          p2,
-                                          eta,
-                                          myFlows[0].thePath.size() - 1,
-                                          myRaii.in().theFidelityInit));
-          // per-class statistics
-          myPerClassStat->theGrossRate(myFlows[0].theGrossRate);
-          myPerClassStat->theNetRate(myFlows[0].theNetRate);
-          myPerClassStat->theAdmissionRate(1.0);
-          myPerClassStat->thePathSize(myFlows[0].thePath.size());
-        }
-      }
-
-      myNextArrival = myNow + myArrivalRv();
-
-    } else {
-      assert(myEarliestLeave != myAdmittedFlows.end());
-      myNow = myEarliestLeave->theLeaveTime;
-      VLOG(3) << "time " << myNow << " an admitted flow leaves";
+  // save data
+  VLOG(1) << "experiment finished\n"
+          << myRaii.in().toString() << '\n'
+          << myOutput.toString();
 
-      // restore the capacity of the path
-      myNetwork->addCapacityToPath(myEarliestLeave->theSrc,
-                                   myEarliestLeave->thePath,
-                                   myEarliestLeave->theGrossRate);
+  myRaii.finish(std::move(myOutput));
+}
 
-      // remove the flow from the list of
-      // admitted/active ones
-      myAdmittedFlows.erase(myEarliestLeave);
+/**
+ * @brief Run experiments with the same parameters but different seeds in
+ * lockstep, i.e., at every step the new flows of all the experiments are
+ * routed together on a network that shares the topology-derived data
+ * structures.
+ *
+ * The results are the same as if the experiments were run separately,
+ * except for the duration, which is that of the whole set of experiments.
+ */
+void runLockstepExperiments(Data& aData, std::vector<Parameters>&& aParameters) {
+  assert(not aParameters.empty());
+  const auto N = aParameters.size();
+
+  std::vector<std::unique_ptr<Data::Raii>> myRaiis;
+  std::vector<Output>                      myOutputs;
+  for (auto& myParameters : aParameters) {
+    checkParameters(myParameters);
+    myRaiis.emplace_back(
+        std::make_unique<Data::Raii>(aData, std::move(myParameters)));
+    myOutputs.emplace_back(myRaiis.back()->in().theNetRates,
+                           myRaiis.back()->in().theFidelityThresholds,
+                           myRaiis.back()->in().theInstrumentation,
+                           myRaiis.back()->in().thePerfCounters,
+                           myRaiis.back()->in().theMemoryAccounting);
+  }
 
-      // record statistics
-      myResidualCapacity(myNetwork->totalCapacity());
-      myNumActiveFlows(myAdmittedFlows.size());
-    }
+  // the topology is the same for all the seeds only if read from a file
+  const auto& myGraphMlFilename = myRaiis.front()->in().theGraphMlFilename;
+  if (myGraphMlFilename.empty()) {
+    throw std::runtime_error(
+        "experiments can be run in lockstep only with a GraphML topology");
+  }
+  std::ifstream myGraphMlStream(myGraphMlFilename + ".graphml");
+  if (not myGraphMlStream) {
+    throw std::runtime_error("cannot read from file: " + myGraphMlFilename +
+                             ".graphml");
+  }
+  std::vector<qr::Coordinate> myCoordinates;
+  const auto myEdges = qr::findLinks(myGraphMlStream, myCoordinates);
+  if (not qr::bigraphConnected(myEdges)) {
+    throw std::runtime_error("The GraphML network is not fully connected");
   }
 
-  myOutput.theResidualCapacity = myResidualCapacity.mean();
-  myOutput.theNumActiveFlows   = myNumActiveFlows.mean();
-  myOutput.theAvgDijkstraCalls = myDijkstra.mean();
-  myOutput.theGrossRate        = myGrossRate.mean();
-  myOutput.theNetRate          = myNetRate.mean();
-  myOutput.theAdmissionRate    = myAdmissionRate.mean();
-  myOutput.theAvgPathSize      = myPathSize.mean();
-  myOutput.theAvgFidelity      = myFidelity.mean();
+  // create one network per seed, only to draw the EPR rates of the links
+  std::vector<qr::CapacityNetwork::WeightVector> myWeights;
+  std::vector<std::vector<double>>               myNodeCapacities;
+  for (std::size_t l = 0; l < N; l++) {
+    const auto&   myParameters = myRaiis[l]->in();
+    us::UniformRv myLinkEprRv(myParameters.theLinkMinEpr,
+                              myParameters.theLinkMaxEpr,
+                              myParameters.theSeed,
+                              0,
+                              0);
+    qr::CapacityNetwork myLaneNetwork(myEdges, myLinkEprRv, true);
+    saveNetworkProperties(
+        myParameters, myCoordinates, myLaneNetwork, myOutputs[l]);
+    myWeights.emplace_back(myLaneNetwork.weights());
+    myNodeCapacities.emplace_back(myLaneNetwork.nodeCapacities());
+  }
+  qr::LockstepNetwork myNetwork(myWeights);
+  myNetwork.measurementProbability(myRaiis.front()->in().theQ);
+  for (auto& myOutput : myOutputs) {
+    myOutput.theDiameter = myNetwork.diameter();
+  }
 
-  for (std::size_t i = 0; i < myPerClassStats.size(); i++) {
-    for (std::size_t j = 0; j < myPerClassStats[i].size(); j++) {
-      auto& myStat = myPerClassStats[i][j];
-      assert(myStat.get() != nullptr);
-      assert(i < myOutput.thePerClass.size());
-      assert(j < myOutput.thePerClass[i].size());
+  // run simulations
+  std::vector<std::unique_ptr<Simulation>> mySimulations;
+  for (std::size_t l = 0; l < N; l++) {
+    mySimulations.emplace_back(std::make_unique<Simulation>(
+        myRaiis[l]->in(),
+        myNodeCapacities[l],
+        [&myNetwork, l](
+            const auto aSrc, const auto& aPath, const auto aGrossRate) {
+          myNetwork.addCapacityToPath(l, aSrc, aPath, aGrossRate);
+        },
+        [&myNetwork, l]() { return myNetwork.totalCapacity(l); }));
+  }
+  std::vector<std::optional<qr::CapacityNetwork::FlowDescriptor>> myFlows(N);
+  while (true) {
+    auto myRunning = false;
+    for (std::size_t l = 0; l < N; l++) {
+      myRunning |= mySimulations[l]->next(myFlows[l]);
+    }
+    if (not myRunning) {
+      break;
+    }
 
-      myOutput.thePerClass[i][j].theGrossRate = myStat->theGrossRate.mean();
-      myOutput.thePerClass[i][j].theNetRate   = myStat->theNetRate.mean();
-      myOutput.thePerClass[i][j].theAdmissionRate =
-          myStat->theAdmissionRate.mean();
-      myOutput.thePerClass[i][j].theAvgPathSize = myStat->thePathSize.mean();
+    // try to admit the new traffic flows
+    myNetwork.route(myFlows,
+                    [&mySimulations](const auto aLane, const auto& aFlow) {
+                      return mySimulations[aLane]->check(aFlow);
+                    });
+    for (std::size_t l = 0; l < N; l++) {
+      if (myFlows[l]) {
+        mySimulations[l]->routed(*myFlows[l]);
+      }
     }
   }
 
   // save data
-  VLOG(1) << "experiment finished\n"
-          << myRaii.in().toString() << '\n'
-          << myOutput.toString();
-
-  myRaii.finish(std::move(myOutput));
+  for (std::size_t l = 0; l < N; l++) {
+    mySimulations[l]->fill(myOutputs[l]);
+    VLOG(1) << "experiment finished\n"
+            << myRaiis[l]->in().toString() << '\n'
+            << myOutputs[l].toString();
+    myRaiis[l]->finish(std::move(myOutputs[l]));
+  }
 }
 
 bool explainOrPrint(const po::variables_map&   aVarMap,
@@ -598,7 +1099,12 @@ bool explainOrPrint(const po::variables_map&   aVarMap,
     for (const auto& elem : Parameters::names()) {
       std::cout << '#' << ++myCol << '\t' << elem << '\n';
     }
-    for (const auto& elem : Output(aNetRates, aFidelityThresholds).names()) {
+    for (const auto& elem : Output(aNetRates,
+                                   aFidelityThresholds,
+                                   aVarMap.count("instrumentation") == 1,
+                                   aVarMap.count("perf-counters") == 1,
+                                   aVarMap.count("memory-accounting") == 1)
+                                .names()) {
       std::cout << '#' << ++myCol << '\t' << elem << '\n';
     }
     std::cout << '#' << ++myCol << "\tduration\n";
@@ -609,7 +1115,12 @@ bool explainOrPrint(const po::variables_map&   aVarMap,
     for (const auto& elem : Parameters::names()) {
       std::cout << elem << ',';
     }
-    for (const auto& elem : Output(aNetRates, aFidelityThresholds).names()) {
+    for (const auto& elem : Output(aNetRates,
+                                   aFidelityThresholds,
+                                   aVarMap.count("instrumentation") == 1,
+                                   aVarMap.count("perf-counters") == 1,
+                                   aVarMap.count("memory-accounting") == 1)
+                                .names()) {
       std::cout << elem << ',';
     }
     std::cout << "duration\n";
@@ -623,8 +1134,11 @@ int main(int argc, char* argv[]) {
 
   std::size_t myNumThreads;
   std::string myOutputFilename;
+  std::string myTraceFilename;
+  std::string myLatencyFilename;
   std::size_t mySeedStart;
   std::size_t mySeedEnd;
+  std::size_t myLockstep;
 
   double      myMu;
   double      myLinkMinEpr;
@@ -643,6 +1157,11 @@ int main(int argc, char* argv[]) {
   double      myArrivalRate;
   double      myFlowDuration;
   std::string myTopoFilename;
+  std::string myRecordFilename;
+  std::string myReplayFilename;
+  std::string myFlowFilename;
+
+  std::vector<std::string> mySweepSpecs;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -656,14 +1175,29 @@ int main(int argc, char* argv[]) {
      "Number of threads used.")
     ("output",
      po::value<std::string>(&myOutputFilename)->default_value("output.csv"),
-     "Output file name.")
+     "Output file name. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("sweep",
+     po::value<std::vector<std::string>>(&mySweepSpecs),
+     "Sweep an option over a list of values NAME=V1,V2,... or a range NAME=START:END:STEP (END included, at most 10000 values). Can be repeated to sweep over the Cartesian product of all the values. The experiments of all the grid points share the same pool of threads.")
     ("seed-start",
      po::value<std::size_t>(&mySeedStart)->default_value(0),
      "First seed used.")
     ("seed-end",
      po::value<std::size_t>(&mySeedEnd)->default_value(1),
     "Next seed after the last one to be used, i.e., the number of simulations is (seed-end - seed-start).")
+    ("lockstep",
+     po::value<std::size_t>(&myLockstep)->default_value(1),
+     "Number of consecutive seeds simulated together in lockstep by the same thread, which share the data structures derived from the network topology. Only possible with a GraphML topology. The duration reported is that of the whole group of seeds.")
     ("append", "Append to the output file.")
+    ("perf-counters", "With --instrumentation, also add to the output the hardware performance counters in each phase of the experiment: cycles, instructions, last-level cache misses and branch misses. Only on Linux.")
+    ("memory-accounting", "With --instrumentation, also add to the output the memory used by the experiment: increase of the peak RSS of the process, only meaningful with one thread, peak of the heap allocated, and number of allocations and bytes allocated by subsystem (graph, descriptors, k-shortest paths, statistics, other).")
+    ("trace-file",
+     po::value<std::string>(&myTraceFilename)->default_value(""),
+     "Save the trace of the routing algorithms to this binary file, which can be decoded with Scripts/decode-trace.py. The trace levels compiled in are set with TRACE_LEVEL_DEBUG and TRACE_LEVEL_RELEASE in CMake.")
+    ("latency-file",
+     po::value<std::string>(&myLatencyFilename)->default_value(""),
+     "Save the percentiles of the wall-clock latency of the admission and release decisions, in ns, recorded in HDR histograms per class of net rate and fidelity threshold merged over all the experiments, to this CSV file. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point. Not possible with --lockstep.")
+    ("instrumentation", "Add to the output the time spent in each phase of the experiment and the work done by the routing algorithms. Not possible with --lockstep.")
     ("mu",
      po::value<double>(&myMu)->default_value(100),
      "Average number of nodes.")
@@ -715,6 +1249,15 @@ int main(int argc, char* argv[]) {
     ("topo-filename",
      po::value<std::string>(&myTopoFilename)->default_value(""),
      "Save the topology to files with the given base name.")
+    ("record-workload",
+     po::value<std::string>(&myRecordFilename)->default_value(""),
+     "Record the flow arrivals of every experiment to a binary file with the given base name, followed by -SEED. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("replay-workload",
+     po::value<std::string>(&myReplayFilename)->default_value(""),
+     "Replay the flow arrivals from the binary files with the given base name, followed by -SEED, recorded with --record-workload, instead of drawing them randomly. With --sweep, every {NAME} is replaced with the value of option NAME at each grid point.")
+    ("flow-file",
+     po::value<std::string>(&myFlowFilename)->default_value(""),
+     "Read the flow arrivals from a file, in CSV format with lines time,src,dst,net-rate,fidelity-threshold or in binary format (see Scripts/csv-to-flows.py), instead of drawing them randomly, except for their durations. The file is read incrementally. The per-class statistics are collected for the closest net rate and fidelity threshold. Not possible with --record-workload or --replay-workload.")
     ;
   // clang-format on
 
@@ -733,68 +1276,224 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
 
-    const auto myNetRates = us::split<std::vector<double>>(myNetRatesStr, "@");
-    if (myNetRates.empty()) {
-      throw std::runtime_error("invalid empty set of net EPR rates");
+    if (myVarMap.count("perf-counters") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error("--perf-counters requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        myVarMap.count("instrumentation") == 0) {
+      throw std::runtime_error(
+          "--memory-accounting requires --instrumentation");
+    }
+    if (myVarMap.count("memory-accounting") == 1 and
+        not qr::MemoryAccounting::enabled()) {
+      throw std::runtime_error("--memory-accounting requires a build with "
+                               "-DMEMORY_ACCOUNTING=ON");
+    }
+
+    if (myLockstep == 0) {
+      throw std::runtime_error("the number of seeds in lockstep must be positive");
+    }
+    if (myLockstep > 1 and myVarMap.count("instrumentation") == 1) {
+      throw std::runtime_error(
+          "cannot specify both --lockstep and --instrumentation");
+    }
+    if (myLockstep > 1 and not myLatencyFilename.empty()) {
+      throw std::runtime_error(
+          "cannot specify both --lockstep and --latency-file");
     }
 
-    const auto myFidelityThresholds =
-        us::split<std::vector<double>>(myFidelityThresholdsStr, "@");
-    if (myFidelityThresholds.empty()) {
-      throw std::runtime_error("invalid empty set of fidelity thresholds");
+    if (not myRecordFilename.empty() and not myReplayFilename.empty()) {
+      throw std::runtime_error(
+          "cannot specify both --record-workload and --replay-workload");
+    }
+    if (not myFlowFilename.empty() and
+        (not myRecordFilename.empty() or not myReplayFilename.empty())) {
+      throw std::runtime_error("cannot specify --flow-file with "
+                               "--record-workload or --replay-workload");
     }
 
-    if (explainOrPrint(myVarMap, myNetRates, myFidelityThresholds)) {
-      return EXIT_SUCCESS;
+    if (not myTraceFilename.empty()) {
+      LOG_IF(WARNING, QR_TRACE_LEVEL == 0)
+          << "tracing requested but not compiled in, the trace will be empty";
+      qr::Trace::enable(true);
+    }
+
+    const qr::ParamGrid myGrid(mySweepSpecs);
+
+    std::vector<std::unique_ptr<Data>>      myData;
+    std::vector<std::ofstream>              myFiles;
+    std::set<std::string>                   myOutputFilenames;
+    std::set<std::string>                   myRecordFilenames;
+    std::vector<std::unique_ptr<Latencies>> myLatencies;
+    std::vector<std::ofstream>              myLatencyFiles;
+    std::set<std::string>                   myLatencyFilenames;
+    std::vector<Block>                      myBlocks;
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      // options set by the grid point take precedence over the command line
+      if (myGrid.dimensions() > 0) {
+        po::variables_map myPointVarMap;
+        po::store(
+            po::command_line_parser(myGrid.args(myPoint)).options(myDesc).run(),
+            myPointVarMap);
+        po::store(po::parse_command_line(argc, argv, myDesc), myPointVarMap);
+        po::notify(myPointVarMap);
+      }
+
+      const auto myNetRates =
+          us::split<std::vector<double>>(myNetRatesStr, "@");
+      if (myNetRates.empty()) {
+        throw std::runtime_error("invalid empty set of net EPR rates");
+      }
+
+      const auto myFidelityThresholds =
+          us::split<std::vector<double>>(myFidelityThresholdsStr, "@");
+      if (myFidelityThresholds.empty()) {
+        throw std::runtime_error("invalid empty set of fidelity thresholds");
+      }
+
+      if (explainOrPrint(myVarMap, myNetRates, myFidelityThresholds)) {
+        return EXIT_SUCCESS;
+      }
+
+      if (myGraphMlFilename.find(",") != std::string::npos) {
+        throw std::runtime_error("the GraphML file name cannot contain ',': " +
+                                 myGraphMlFilename);
+      }
+
+      const auto myPointFilename =
+          qr::ParamGrid::filename(myOutputFilename, myGrid.point(myPoint));
+      if (not myOutputFilenames.emplace(myPointFilename).second) {
+        throw std::runtime_error(
+            "the same output file would be used for different grid points, "
+            "add {NAME} placeholders to the output file name: " +
+            myPointFilename);
+      }
+      myFiles.emplace_back(myPointFilename,
+                           myVarMap.count("append") == 1 ? std::ios::app :
+                                                           std::ios::trunc);
+      if (not myFiles.back()) {
+        throw std::runtime_error("could not open output file for writing: " +
+                                 myPointFilename);
+      }
+      myData.emplace_back(std::make_unique<Data>());
+
+      if (not myLatencyFilename.empty()) {
+        const auto myPointLatencyFilename =
+            qr::ParamGrid::filename(myLatencyFilename, myGrid.point(myPoint));
+        if (not myLatencyFilenames.emplace(myPointLatencyFilename).second) {
+          throw std::runtime_error(
+              "the same latency file would be used for different grid "
+              "points, add {NAME} placeholders to the latency file name: " +
+              myPointLatencyFilename);
+        }
+        myLatencyFiles.emplace_back(myPointLatencyFilename);
+        if (not myLatencyFiles.back()) {
+          throw std::runtime_error("could not open latency file for writing: " +
+                                   myPointLatencyFilename);
+        }
+        myLatencies.emplace_back(std::make_unique<Latencies>(
+            Latencies::classes(myNetRates, myFidelityThresholds)));
+      }
+
+      const auto myPointRecordFilename =
+          qr::ParamGrid::filename(myRecordFilename, myGrid.point(myPoint));
+      if (not myRecordFilename.empty() and
+          not myRecordFilenames.emplace(myPointRecordFilename).second) {
+        throw std::runtime_error(
+            "the same workload files would be recorded for different grid "
+            "points, add {NAME} placeholders to the workload file name: " +
+            myPointRecordFilename);
+      }
+      const auto myPointReplayFilename =
+          qr::ParamGrid::filename(myReplayFilename, myGrid.point(myPoint));
+
+      if (myLockstep > 1 and myGraphMlFilename.empty()) {
+        throw std::runtime_error(
+            "seeds can be simulated in lockstep only with a GraphML topology");
+      }
+
+      for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
+        const auto mySuffix = "-" + std::to_string(mySeed);
+        if ((mySeed - mySeedStart) % myLockstep == 0) {
+          myBlocks.emplace_back();
+        }
+        myBlocks.back().theParameters.push_back(Parameters{mySeed,
+                                          myMu,
+                                          myGridSize,
+                                          myThreshold,
+                                          myLinkProbability,
+                                          myLinkMinEpr,
+                                          myLinkMaxEpr,
+                                          mySrcDstPolicy,
+                                          myGraphMlFilename,
+                                          myQ,
+                                          myFidelityInit,
+                                          mySimDuration,
+                                          myWarmupDuration,
+                                          myArrivalRate,
+                                          myFlowDuration,
+                                          myNetRates,
+                                          myFidelityThresholds,
+                                          myTopoFilename,
+                                          myRecordFilename.empty() ?
+                                              std::string() :
+                                              myPointRecordFilename + mySuffix,
+                                          myReplayFilename.empty() ?
+                                              std::string() :
+                                              myPointReplayFilename + mySuffix,
+                                          myFlowFilename,
+                                          myPoint,
+                                          myVarMap.count("instrumentation") ==
+                                              1,
+                                          myVarMap.count("perf-counters") ==
+                                              1,
+                                          myVarMap.count("memory-accounting") ==
+                                              1});
+      }
     }
 
-    if (myGraphMlFilename.find(",") != std::string::npos) {
-      throw std::runtime_error("the GraphML file name cannot contain ',': " +
-                               myGraphMlFilename);
-    }
-
-    std::ofstream myFile(myOutputFilename,
-                         myVarMap.count("append") == 1 ? std::ios::app :
-                                                         std::ios::trunc);
-    if (not myFile) {
-      throw std::runtime_error("could not open output file for writing: " +
-                               myOutputFilename);
-    }
-
-    Data myData;
-
-    us::Queue<Parameters> myParameters;
-    for (auto mySeed = mySeedStart; mySeed < mySeedEnd; ++mySeed) {
-      myParameters.push(Parameters{mySeed,
-                                   myMu,
-                                   myGridSize,
-                                   myThreshold,
-                                   myLinkProbability,
-                                   myLinkMinEpr,
-                                   myLinkMaxEpr,
-                                   mySrcDstPolicy,
-                                   myGraphMlFilename,
-                                   myQ,
-                                   myFidelityInit,
-                                   mySimDuration,
-                                   myWarmupDuration,
-                                   myArrivalRate,
-                                   myFlowDuration,
-                                   myNetRates,
-                                   myFidelityThresholds,
-                                   myTopoFilename});
-    }
-    us::ParallelBatch<Parameters> myWorkers(
-        myNumThreads, myParameters, [&myData](auto&& aParameters) {
-          runExperiment(myData, std::move(aParameters));
+    qr::WorkStealingBatch<Block> myWorkers(
+        myNumThreads,
+        std::move(myBlocks),
+        [&myData, &myLatencies](auto&& aBlock) {
+          assert(not aBlock.theParameters.empty());
+          // the experiments in lockstep are tagged with the first seed
+          qr::Trace::registerThread();
+          qr::Trace::experiment(aBlock.theParameters.front().thePoint,
+                                aBlock.theParameters.front().theSeed);
+          const auto myPoint     = aBlock.theParameters.front().thePoint;
+          auto&      myPointData = *myData[myPoint];
+          if (aBlock.theParameters.size() == 1) {
+            runExperiment(myPointData,
+                          std::move(aBlock.theParameters.front()),
+                          myLatencies.empty() ? nullptr :
+                                                myLatencies[myPoint].get());
+          } else {
+            runLockstepExperiments(myPointData,
+                                   std::move(aBlock.theParameters));
+          }
         });
     const auto myExceptions = myWorkers.wait();
     LOG_IF(ERROR, not myExceptions.empty()) << "there were exceptions:";
     for (const auto& myException : myExceptions) {
       LOG(ERROR) << myException;
     }
+    for (std::size_t i = 0; i < myWorkers.stats().size(); i++) {
+      LOG(INFO) << "thread #" << i << ": " << myWorkers.stats()[i].toString();
+    }
 
-    myData.toCsv(myFile);
+    for (std::size_t myPoint = 0; myPoint < myGrid.size(); ++myPoint) {
+      myData[myPoint]->toCsv(myFiles[myPoint]);
+      if (not myLatencies.empty()) {
+        myLatencies[myPoint]->theLatencies.toCsv(myLatencyFiles[myPoint]);
+      }
+    }
+
+    if (not myTraceFilename.empty()) {
+      std::ofstream myTraceFile(myTraceFilename, std::ios::binary);
+      qr::Trace::save(myTraceFile);
+    }
 
     return EXIT_SUCCESS;
   } catch (const std::exception& aErr) {
@@ -0,0 +1,369 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/admission.h"
+#include "QuantumRouting/latencyhistogram.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+std::string toString(const AdmissionType aType) {
+  switch (aType) {
+    case AdmissionType::Admit:
+      return "admit";
+    case AdmissionType::Release:
+      return "release";
+    case AdmissionType::Query:
+      return "query";
+    case AdmissionType::Stats:
+      return "stats";
+  }
+  return "unknown";
+}
+
+std::string toString(const AdmissionStatus aStatus) {
+  switch (aStatus) {
+    case AdmissionStatus::Ok:
+      return "ok";
+    case AdmissionStatus::Rejected:
+      return "rejected";
+    case AdmissionStatus::UnknownFlow:
+      return "unknown-flow";
+    case AdmissionStatus::Invalid:
+      return "invalid";
+  }
+  return "unknown";
+}
+
+AdmissionRequest AdmissionRequest::admit(const std::uint32_t aTag,
+                                         const std::uint32_t aSrc,
+                                         const std::uint32_t aDst,
+                                         const double        aNetRate) {
+  return AdmissionRequest{AdmissionType::Admit, aTag, aSrc, aDst, aNetRate, 0};
+}
+
+AdmissionRequest AdmissionRequest::release(const std::uint32_t aTag,
+                                           const std::uint64_t aFlow) {
+  return AdmissionRequest{AdmissionType::Release, aTag, 0, 0, 0, aFlow};
+}
+
+AdmissionRequest AdmissionRequest::query(const std::uint32_t aTag,
+                                         const std::uint64_t aFlow) {
+  return AdmissionRequest{AdmissionType::Query, aTag, 0, 0, 0, aFlow};
+}
+
+AdmissionRequest AdmissionRequest::stats(const std::uint32_t aTag) {
+  return AdmissionRequest{AdmissionType::Stats, aTag, 0, 0, 0, 0};
+}
+
+std::string AdmissionRequest::toString() const {
+  std::stringstream myStream;
+  myStream << qr::toString(theType) << " #" << theTag;
+  if (theType == AdmissionType::Admit) {
+    myStream << ", " << theSrc << " -> " << theDst << ", net rate "
+             << theNetRate;
+  } else if (theType == AdmissionType::Release or
+             theType == AdmissionType::Query) {
+    myStream << ", flow " << theFlow;
+  }
+  return myStream.str();
+}
+
+std::string AdmissionResponse::toString() const {
+  std::stringstream myStream;
+  myStream << qr::toString(theType) << " #" << theTag << ", "
+           << qr::toString(theStatus);
+  if (theType == AdmissionType::Stats) {
+    myStream << ", " << theNumFlows << " flows, " << theNumDecisions
+             << " decisions, latency p50 " << theLatencyP50 << " s, p99 "
+             << theLatencyP99 << " s";
+  } else if (theStatus == AdmissionStatus::Ok) {
+    myStream << ", flow " << theFlow << ", " << theHops << " hops, net rate "
+             << theNetRate << ", gross rate " << theGrossRate;
+  }
+  return myStream.str();
+}
+
+AdmissionController::AdmissionController(
+    std::unique_ptr<CapacityNetwork>&& aNetwork)
+    : theNetwork(std::move(aNetwork))
+    , theFlows()
+    , theNextFlow(0)
+    , theEdgeFlows()
+    , theNumDecisions(0) {
+  if (theNetwork.get() == nullptr) {
+    throw std::runtime_error("invalid null network in admission controller");
+  }
+  if (theNetwork->latencies().get() == nullptr) {
+    theNetwork->latencies(std::make_shared<DecisionLatencies>(
+        std::vector<std::string>({"all"})));
+  }
+}
+
+AdmissionResponse
+AdmissionController::operator()(const AdmissionRequest& aRequest) {
+  switch (aRequest.theType) {
+    case AdmissionType::Admit:
+      return admit(aRequest);
+    case AdmissionType::Release:
+      return release(aRequest);
+    case AdmissionType::Query:
+      return query(aRequest);
+    case AdmissionType::Stats:
+      return stats(aRequest);
+  }
+  return AdmissionResponse{
+      aRequest.theType, aRequest.theTag, AdmissionStatus::Invalid, 0, 0, 0, 0};
+}
+
+double AdmissionController::latency(const double aPercentile) const {
+  if (aPercentile < 0 or aPercentile > 1) {
+    throw std::runtime_error("invalid percentile: " +
+                             std::to_string(aPercentile));
+  }
+  const auto& myLatencies = *theNetwork->latencies();
+  LatencyHistogram myMerged;
+  for (const auto myDecision : {DecisionLatencies::Decision::Admission,
+                                DecisionLatencies::Decision::Release}) {
+    for (std::size_t i = 0; i < myLatencies.classes().size(); i++) {
+      myMerged.merge(myLatencies(myDecision, i));
+    }
+  }
+  return myMerged.percentile(aPercentile) * 1e-9;
+}
+
+std::vector<std::uint64_t> AdmissionController::applyTopologyDeltas(
+    const std::vector<CapacityNetwork::TopologyDelta>& aDeltas) {
+  const auto myOverbooked = theNetwork->applyTopologyDeltas(aDeltas);
+
+  std::set<EdgeKey> myRemoved;
+  for (const auto& myDelta : aDeltas) {
+    if (myDelta.theType == CapacityNetwork::TopologyDelta::Type::RemoveEdge) {
+      myRemoved.emplace(myDelta.theSrc, myDelta.theDst);
+    }
+  }
+  std::map<EdgeKey, double> myExcess;
+  for (const auto& elem : myOverbooked) {
+    myExcess.emplace(EdgeKey(std::get<0>(elem), std::get<1>(elem)),
+                     std::get<2>(elem));
+  }
+
+  // select the flows to be released, first those crossing removed edges and
+  // then the most recent ones on the edges overbooked
+  std::set<std::uint64_t> mySelected;
+  const auto mySelect = [&](const EdgeKey& aEdge, const bool aAll) {
+    const auto it = theEdgeFlows.find(aEdge);
+    if (it == theEdgeFlows.end()) {
+      return;
+    }
+    for (auto jt = it->second.rbegin(); jt != it->second.rend(); ++jt) {
+      if (not aAll and myExcess[aEdge] <= 0) {
+        break;
+      }
+      if (not mySelected.emplace(*jt).second) {
+        continue;
+      }
+      // the capacity of the flow is released on all the edges of its path
+      const auto& myFlow = theFlows.at(*jt);
+      auto        mySrc  = myFlow.theSrc;
+      for (const auto myDst : myFlow.thePath) {
+        const auto kt = myExcess.find(EdgeKey(mySrc, myDst));
+        if (kt != myExcess.end()) {
+          kt->second -= myFlow.theGrossRate;
+        }
+        mySrc = myDst;
+      }
+    }
+  };
+  for (const auto& myEdge : myRemoved) {
+    mySelect(myEdge, true);
+  }
+  for (const auto& elem : myOverbooked) {
+    mySelect(EdgeKey(std::get<0>(elem), std::get<1>(elem)), false);
+  }
+
+  // release the flows selected, except on the removed edges
+  for (const auto myId : mySelected) {
+    const auto it = theFlows.find(myId);
+    assert(it != theFlows.end());
+    const auto& myFlow = it->second;
+
+    auto                       mySrc        = myFlow.theSrc;
+    auto                       mySegmentSrc = myFlow.theSrc;
+    std::vector<unsigned long> mySegment;
+    for (const auto myDst : myFlow.thePath) {
+      if (myRemoved.count(EdgeKey(mySrc, myDst)) > 0) {
+        if (not mySegment.empty()) {
+          theNetwork->addCapacityToPath(
+              mySegmentSrc, mySegment, myFlow.theGrossRate);
+          mySegment.clear();
+        }
+        mySegmentSrc = myDst;
+      } else {
+        mySegment.emplace_back(myDst);
+      }
+      mySrc = myDst;
+    }
+    if (not mySegment.empty()) {
+      theNetwork->addCapacityToPath(
+          mySegmentSrc, mySegment, myFlow.theGrossRate);
+    }
+
+    indexFlow(myId, myFlow, false);
+    theFlows.erase(it);
+  }
+
+  VLOG(1) << aDeltas.size() << " topology changes applied, "
+          << mySelected.size() << " flows released";
+  return std::vector<std::uint64_t>(mySelected.begin(), mySelected.end());
+}
+
+AdmissionResponse AdmissionController::admit(const AdmissionRequest& aRequest) {
+  AdmissionResponse ret{
+      aRequest.theType, aRequest.theTag, AdmissionStatus::Invalid, 0, 0, 0, 0};
+
+  const auto myNumNodes = theNetwork->numNodes();
+  if (aRequest.theSrc >= myNumNodes or aRequest.theDst >= myNumNodes or
+      aRequest.theSrc == aRequest.theDst or not(aRequest.theNetRate > 0)) {
+    VLOG(1) << "invalid request: " << aRequest.toString();
+    return ret;
+  }
+
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows(
+      {{aRequest.theSrc, aRequest.theDst, aRequest.theNetRate}});
+  theNetwork->route(myFlows);
+  assert(myFlows.size() == 1);
+  const auto& myFlow = myFlows[0];
+
+  if (myFlow.thePath.empty()) {
+    ret.theStatus = AdmissionStatus::Rejected;
+  } else {
+    ret.theStatus    = AdmissionStatus::Ok;
+    ret.theHops      = static_cast<std::uint32_t>(myFlow.thePath.size());
+    ret.theFlow      = theNextFlow++;
+    ret.theGrossRate = myFlow.theGrossRate;
+    ret.theNetRate   = myFlow.theNetRate;
+    theFlows.emplace(ret.theFlow, myFlow);
+    indexFlow(ret.theFlow, myFlow, true);
+  }
+  ++theNumDecisions;
+
+  return ret;
+}
+
+AdmissionResponse
+AdmissionController::release(const AdmissionRequest& aRequest) {
+  AdmissionResponse ret{aRequest.theType,
+                        aRequest.theTag,
+                        AdmissionStatus::UnknownFlow,
+                        0,
+                        aRequest.theFlow,
+                        0,
+                        0};
+
+  const auto it = theFlows.find(aRequest.theFlow);
+  if (it == theFlows.end()) {
+    return ret;
+  }
+  const auto& myFlow = it->second;
+  theNetwork->addCapacityToPath(
+      myFlow.theSrc, myFlow.thePath, myFlow.theGrossRate);
+
+  ret.theStatus    = AdmissionStatus::Ok;
+  ret.theHops      = static_cast<std::uint32_t>(myFlow.thePath.size());
+  ret.theGrossRate = myFlow.theGrossRate;
+  ret.theNetRate   = myFlow.theNetRate;
+  indexFlow(it->first, myFlow, false);
+  theFlows.erase(it);
+  ++theNumDecisions;
+
+  return ret;
+}
+
+AdmissionResponse
+AdmissionController::query(const AdmissionRequest& aRequest) const {
+  AdmissionResponse ret{aRequest.theType,
+                        aRequest.theTag,
+                        AdmissionStatus::UnknownFlow,
+                        0,
+                        aRequest.theFlow,
+                        0,
+                        0};
+
+  const auto it = theFlows.find(aRequest.theFlow);
+  if (it != theFlows.end()) {
+    ret.theStatus    = AdmissionStatus::Ok;
+    ret.theHops      = static_cast<std::uint32_t>(it->second.thePath.size());
+    ret.theGrossRate = it->second.theGrossRate;
+    ret.theNetRate   = it->second.theNetRate;
+  }
+  return ret;
+}
+
+AdmissionResponse
+AdmissionController::stats(const AdmissionRequest& aRequest) const {
+  AdmissionResponse ret{
+      aRequest.theType, aRequest.theTag, AdmissionStatus::Ok, 0, 0, 0, 0};
+  ret.theNumFlows     = theFlows.size();
+  ret.theNumDecisions = theNumDecisions;
+  ret.theLatencyP50   = latency(0.5);
+  ret.theLatencyP99   = latency(0.99);
+  return ret;
+}
+
+void AdmissionController::indexFlow(
+    const std::uint64_t                    aFlow,
+    const CapacityNetwork::FlowDescriptor& aDescriptor,
+    const bool                             aAdd) {
+  auto mySrc = aDescriptor.theSrc;
+  for (const auto myDst : aDescriptor.thePath) {
+    if (aAdd) {
+      theEdgeFlows[EdgeKey(mySrc, myDst)].emplace(aFlow);
+    } else {
+      const auto it = theEdgeFlows.find(EdgeKey(mySrc, myDst));
+      assert(it != theEdgeFlows.end());
+      it->second.erase(aFlow);
+      if (it->second.empty()) {
+        theEdgeFlows.erase(it);
+      }
+    }
+    mySrc = myDst;
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
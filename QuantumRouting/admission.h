@@ -0,0 +1,225 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "Support/macros.h"
+
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+//! Type of a request to the admission controller.
+enum class AdmissionType : std::uint32_t {
+  Admit   = 1, //!< route a new flow and reserve its gross rate
+  Release = 2, //!< release the gross rate reserved by an admitted flow
+  Query   = 3, //!< return the path length and rates of an admitted flow
+  Stats   = 4, //!< return the number of flows, decisions and their latency
+};
+
+//! Outcome of a request to the admission controller.
+enum class AdmissionStatus : std::uint32_t {
+  Ok          = 0, //!< request served
+  Rejected    = 1, //!< the flow cannot be admitted with residual capacities
+  UnknownFlow = 2, //!< no admitted flow with the given identifier
+  Invalid     = 3, //!< ill-formed request
+};
+
+std::string toString(const AdmissionType aType);
+std::string toString(const AdmissionStatus aStatus);
+
+/**
+ * @brief Request to the admission controller.
+ *
+ * Requests and responses are exchanged as fixed-size records in native byte
+ * order, hence the protocol is meant to be used only between processes on
+ * the same host.
+ */
+struct AdmissionRequest {
+  AdmissionType theType;    //!< type of the request
+  std::uint32_t theTag;     //!< opaque value copied into the response
+  std::uint32_t theSrc;     //!< Admit only: source node
+  std::uint32_t theDst;     //!< Admit only: destination node
+  double        theNetRate; //!< Admit only: net rate, in EPR-pairs/s
+  std::uint64_t theFlow;    //!< Release and Query only: flow identifier
+
+  static AdmissionRequest admit(const std::uint32_t aTag,
+                                const std::uint32_t aSrc,
+                                const std::uint32_t aDst,
+                                const double        aNetRate);
+  static AdmissionRequest release(const std::uint32_t aTag,
+                                  const std::uint64_t aFlow);
+  static AdmissionRequest query(const std::uint32_t aTag,
+                                const std::uint64_t aFlow);
+  static AdmissionRequest stats(const std::uint32_t aTag);
+
+  std::string toString() const;
+};
+static_assert(sizeof(AdmissionRequest) == 32,
+              "unexpected admission request size");
+
+/**
+ * @brief Response of the admission controller.
+ *
+ * With Admit, Release, and Query the fields of the flow are set, with rates
+ * in EPR-pairs/s, while with Stats those of the state of the admission
+ * controller are set, with latencies in s. The other fields are zero.
+ */
+struct AdmissionResponse {
+  AdmissionType   theType;         //!< type of the request served
+  std::uint32_t   theTag;          //!< copied from the request
+  AdmissionStatus theStatus;       //!< outcome
+  std::uint32_t   theHops;         //!< flow only: path length
+  std::uint64_t   theFlow;         //!< flow only: flow identifier
+  double          theGrossRate;    //!< flow only: gross rate
+  double          theNetRate;      //!< flow only: net rate
+  std::uint64_t   theNumFlows;     //!< Stats only: flows admitted
+  std::uint64_t   theNumDecisions; //!< Stats only: decisions taken
+  double          theLatencyP50;   //!< Stats only: p50 decision latency
+  double          theLatencyP99;   //!< Stats only: p99 decision latency
+
+  std::string toString() const;
+};
+static_assert(sizeof(AdmissionResponse) == 72,
+              "unexpected admission response size");
+
+/**
+ * @brief Online admission control of flows in a capacity network.
+ *
+ * The residual capacities are kept in memory across requests: admitted flows
+ * are routed with CapacityNetwork::route() and their gross rate is reserved
+ * along the path until they are released.
+ *
+ * The latency of the admission and release decisions is recorded by the
+ * network in its DecisionLatencies, see CapacityNetwork::latencies(), which
+ * are created with a single class if the network does not have them already.
+ *
+ * This class is not thread-safe.
+ */
+class AdmissionController final
+{
+  NONCOPYABLE_NONMOVABLE(AdmissionController);
+
+ public:
+  /**
+   * @brief Create an admission controller for the given network.
+   *
+   * @param aNetwork the network, which must be non-null
+   *
+   * @throw std::runtime_error if the network is null
+   */
+  explicit AdmissionController(std::unique_ptr<CapacityNetwork>&& aNetwork);
+
+  //! Serve a request.
+  AdmissionResponse operator()(const AdmissionRequest& aRequest);
+
+  /**
+   * @brief Change the topology or the base capacities of the network,
+   * keeping the flows admitted as long as they fit.
+   *
+   * All the flows crossing a removed edge are released. On every other edge
+   * that cannot accommodate anymore the capacity reserved on it, the flows
+   * crossing it are released starting from the most recently admitted until
+   * the capacity reserved fits again. The cost is proportional to the number
+   * of changes and of flows released.
+   *
+   * @param aDeltas the changes, see CapacityNetwork::applyTopologyDeltas()
+   *
+   * @return the identifiers of the flows released, in increasing order
+   *
+   * @throw std::runtime_error if any of the changes is invalid, in which case
+   * neither the network nor the flows admitted are changed
+   */
+  std::vector<std::uint64_t> applyTopologyDeltas(
+      const std::vector<CapacityNetwork::TopologyDelta>& aDeltas);
+
+  //! \return the network with the current residual capacities.
+  const CapacityNetwork& network() const noexcept {
+    return *theNetwork;
+  }
+
+  //! \return the number of flows currently admitted.
+  std::size_t numFlows() const noexcept {
+    return theFlows.size();
+  }
+
+  //! \return the number of admission and release decisions taken.
+  std::size_t numDecisions() const noexcept {
+    return theNumDecisions;
+  }
+
+  /**
+   * @brief Return a percentile of the decision latency.
+   *
+   * @param aPercentile the percentile, in [0,1]
+   * @return the latency, in s, over all the admission and release decisions
+   * of all the classes, or zero if no decision has been taken yet
+   *
+   * @throw std::runtime_error if the percentile is not in [0,1]
+   */
+  double latency(const double aPercentile) const;
+
+ private:
+  AdmissionResponse admit(const AdmissionRequest& aRequest);
+  AdmissionResponse release(const AdmissionRequest& aRequest);
+  AdmissionResponse query(const AdmissionRequest& aRequest) const;
+  AdmissionResponse stats(const AdmissionRequest& aRequest) const;
+
+  //! Add or remove a flow to/from the index of the flows by edge.
+  void indexFlow(const std::uint64_t                    aFlow,
+                 const CapacityNetwork::FlowDescriptor& aDescriptor,
+                 const bool                             aAdd);
+
+ private:
+  using EdgeKey = std::pair<unsigned long, unsigned long>;
+
+  std::unique_ptr<CapacityNetwork> theNetwork;
+
+  std::unordered_map<std::uint64_t, CapacityNetwork::FlowDescriptor> theFlows;
+  std::uint64_t theNextFlow;
+
+  // identifiers of the flows admitted crossing each edge
+  std::map<EdgeKey, std::set<std::uint64_t>> theEdgeFlows;
+
+  std::size_t theNumDecisions;
+};
+
+} // namespace qr
+} // namespace uiiit
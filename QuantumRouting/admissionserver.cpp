@@ -0,0 +1,341 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/admissionserver.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! Size of the buffer used to receive data with a single system call.
+constexpr std::size_t RECEIVE_SIZE = 65536;
+
+//! A client is not read while it has more than this many bytes to receive.
+constexpr std::size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+std::string errorMessage(const std::string& aAction) {
+  return "cannot " + aAction + " admission socket: " + std::strerror(errno);
+}
+
+sockaddr_un makeAddress(const std::string& aPath) {
+  sockaddr_un ret;
+  std::memset(&ret, 0, sizeof(ret));
+  ret.sun_family = AF_UNIX;
+  if (aPath.empty() or aPath.size() >= sizeof(ret.sun_path)) {
+    throw std::runtime_error("invalid admission socket path: " + aPath);
+  }
+  std::memcpy(ret.sun_path, aPath.c_str(), aPath.size());
+  return ret;
+}
+
+} // namespace
+
+AdmissionServer::Client::Client(const int aFd)
+    : theFd(aFd)
+    , theIn()
+    , theOut() {
+  // noop
+}
+
+AdmissionServer::AdmissionServer(const std::string&   aPath,
+                                 AdmissionController& aController)
+    : thePath(aPath)
+    , theController(aController)
+    , theListenFd(-1)
+    , theStopFds{-1, -1}
+    , theClients()
+    , theNumRequests(0)
+    , theServed() {
+  const auto myAddress = makeAddress(aPath);
+
+  if (::pipe2(theStopFds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    throw std::runtime_error(errorMessage("create pipe for"));
+  }
+
+  theListenFd =
+      ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (theListenFd < 0) {
+    const auto myError = errorMessage("create");
+    ::close(theStopFds[0]);
+    ::close(theStopFds[1]);
+    throw std::runtime_error(myError);
+  }
+
+  ::unlink(thePath.c_str());
+  if (::bind(theListenFd,
+             reinterpret_cast<const sockaddr*>(&myAddress),
+             sizeof(myAddress)) != 0 or
+      ::listen(theListenFd, SOMAXCONN) != 0) {
+    const auto myError = errorMessage("bind");
+    ::close(theListenFd);
+    ::close(theStopFds[0]);
+    ::close(theStopFds[1]);
+    throw std::runtime_error(myError + " (" + thePath + ")");
+  }
+  VLOG(1) << "listening on " << thePath;
+}
+
+AdmissionServer::~AdmissionServer() {
+  for (const auto& myClient : theClients) {
+    ::close(myClient.theFd);
+  }
+  ::close(theListenFd);
+  ::close(theStopFds[0]);
+  ::close(theStopFds[1]);
+  ::unlink(thePath.c_str());
+}
+
+void AdmissionServer::run() {
+  std::vector<pollfd> myFds;
+  while (true) {
+    // the first two descriptors are the stop pipe and the listening socket,
+    // followed by one descriptor per client, in the same order
+    myFds.clear();
+    myFds.push_back(pollfd{theStopFds[0], POLLIN, 0});
+    myFds.push_back(pollfd{theListenFd, POLLIN, 0});
+    for (const auto& myClient : theClients) {
+      short myEvents = 0;
+      if (myClient.theOut.size() < MAX_PENDING_OUTPUT) {
+        myEvents |= POLLIN;
+      }
+      if (not myClient.theOut.empty()) {
+        myEvents |= POLLOUT;
+      }
+      myFds.push_back(pollfd{myClient.theFd, myEvents, 0});
+    }
+
+    if (::poll(myFds.data(), myFds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(errorMessage("poll"));
+    }
+
+    if (myFds[0].revents != 0) {
+      char myByte;
+      while (::read(theStopFds[0], &myByte, 1) > 0) {
+        // drain the pipe so that run() can be called again
+      }
+      return;
+    }
+
+    // serve the clients backwards, so that closed ones can be removed
+    const auto myNumRequests = theNumRequests;
+    for (auto i = theClients.size(); i > 0; i--) {
+      auto&      myClient = theClients[i - 1];
+      const auto myEvents = myFds[i + 1].revents;
+      auto       myOpen   = true;
+      if ((myEvents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+        myOpen = receive(myClient);
+      }
+      if (not myClient.theOut.empty()) {
+        myOpen = transmit(myClient) and myOpen;
+      }
+      if (not myOpen) {
+        VLOG(1) << "connection closed, fd " << myClient.theFd;
+        ::close(myClient.theFd);
+        theClients.erase(theClients.begin() + (i - 1));
+      }
+    }
+    if (theServed and theNumRequests != myNumRequests) {
+      theServed();
+    }
+
+    if ((myFds[1].revents & POLLIN) != 0) {
+      accept();
+    }
+  }
+}
+
+void AdmissionServer::stop() noexcept {
+  const char myByte = 0;
+  [[maybe_unused]] const auto myRet = ::write(theStopFds[1], &myByte, 1);
+}
+
+void AdmissionServer::accept() {
+  while (true) {
+    const auto myFd =
+        ::accept4(theListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (myFd >= 0) {
+      VLOG(1) << "new connection, fd " << myFd;
+      theClients.emplace_back(myFd);
+    } else if (errno == EINTR or errno == ECONNABORTED) {
+      continue;
+    } else if (errno == EAGAIN or errno == EWOULDBLOCK) {
+      return;
+    } else {
+      throw std::runtime_error(errorMessage("accept on"));
+    }
+  }
+}
+
+bool AdmissionServer::receive(Client& aClient) {
+  const auto myOldSize = aClient.theIn.size();
+  aClient.theIn.resize(myOldSize + RECEIVE_SIZE);
+  const auto myRead =
+      ::read(aClient.theFd, aClient.theIn.data() + myOldSize, RECEIVE_SIZE);
+  aClient.theIn.resize(myOldSize + std::max<ssize_t>(myRead, 0));
+  if (myRead < 0 and (errno == EINTR or errno == EAGAIN or
+                      errno == EWOULDBLOCK)) {
+    return true;
+  }
+
+  // serve all the complete requests received, in order
+  const auto myNumRequests = aClient.theIn.size() / sizeof(AdmissionRequest);
+  aClient.theOut.reserve(aClient.theOut.size() +
+                         myNumRequests * sizeof(AdmissionResponse));
+  for (std::size_t i = 0; i < myNumRequests; i++) {
+    AdmissionRequest myRequest;
+    std::memcpy(&myRequest,
+                aClient.theIn.data() + i * sizeof(AdmissionRequest),
+                sizeof(AdmissionRequest));
+    const auto myResponse = theController(myRequest);
+    const auto myBytes    = reinterpret_cast<const char*>(&myResponse);
+    aClient.theOut.insert(
+        aClient.theOut.end(), myBytes, myBytes + sizeof(myResponse));
+  }
+  aClient.theIn.erase(aClient.theIn.begin(),
+                      aClient.theIn.begin() +
+                          myNumRequests * sizeof(AdmissionRequest));
+  theNumRequests += myNumRequests;
+
+  return myRead > 0;
+}
+
+bool AdmissionServer::transmit(Client& aClient) {
+  std::size_t mySent = 0;
+  auto        ret    = true;
+  while (mySent < aClient.theOut.size()) {
+    const auto myRet = ::send(aClient.theFd,
+                              aClient.theOut.data() + mySent,
+                              aClient.theOut.size() - mySent,
+                              MSG_NOSIGNAL);
+    if (myRet >= 0) {
+      mySent += myRet;
+    } else if (errno == EINTR) {
+      continue;
+    } else {
+      ret = errno == EAGAIN or errno == EWOULDBLOCK;
+      break;
+    }
+  }
+  aClient.theOut.erase(aClient.theOut.begin(),
+                       aClient.theOut.begin() + mySent);
+  return ret;
+}
+
+AdmissionClient::AdmissionClient(const std::string& aPath)
+    : theFd(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0))
+    , theOut()
+    , theIn()
+    , theInOffset(0) {
+  if (theFd < 0) {
+    throw std::runtime_error(errorMessage("create"));
+  }
+  const auto myAddress = makeAddress(aPath);
+  if (::connect(theFd,
+                reinterpret_cast<const sockaddr*>(&myAddress),
+                sizeof(myAddress)) != 0) {
+    const auto myError = errorMessage("connect to");
+    ::close(theFd);
+    throw std::runtime_error(myError + " (" + aPath + ")");
+  }
+}
+
+AdmissionClient::~AdmissionClient() {
+  ::close(theFd);
+}
+
+void AdmissionClient::send(const AdmissionRequest& aRequest) {
+  const auto myBytes = reinterpret_cast<const char*>(&aRequest);
+  theOut.insert(theOut.end(), myBytes, myBytes + sizeof(aRequest));
+}
+
+void AdmissionClient::flush() {
+  std::size_t mySent = 0;
+  while (mySent < theOut.size()) {
+    const auto myRet = ::send(
+        theFd, theOut.data() + mySent, theOut.size() - mySent, MSG_NOSIGNAL);
+    if (myRet >= 0) {
+      mySent += myRet;
+    } else if (errno != EINTR) {
+      throw std::runtime_error(errorMessage("send to"));
+    }
+  }
+  theOut.clear();
+}
+
+AdmissionResponse AdmissionClient::receive() {
+  flush();
+
+  // read as many bytes as available, until there is a complete response
+  while (theIn.size() - theInOffset < sizeof(AdmissionResponse)) {
+    theIn.erase(theIn.begin(), theIn.begin() + theInOffset);
+    theInOffset          = 0;
+    const auto myOldSize = theIn.size();
+    theIn.resize(myOldSize + RECEIVE_SIZE);
+    const auto myRet = ::recv(theFd, theIn.data() + myOldSize, RECEIVE_SIZE, 0);
+    theIn.resize(myOldSize + std::max<ssize_t>(myRet, 0));
+    if (myRet == 0) {
+      throw std::runtime_error("admission socket closed by the server");
+    } else if (myRet < 0 and errno != EINTR) {
+      throw std::runtime_error(errorMessage("receive from"));
+    }
+  }
+
+  AdmissionResponse ret;
+  std::memcpy(&ret, theIn.data() + theInOffset, sizeof(ret));
+  theInOffset += sizeof(ret);
+  return ret;
+}
+
+AdmissionResponse
+AdmissionClient::operator()(const AdmissionRequest& aRequest) {
+  send(aRequest);
+  return receive();
+}
+
+} // namespace qr
+} // namespace uiiit
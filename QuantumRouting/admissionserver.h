@@ -0,0 +1,184 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/admission.h"
+#include "Support/macros.h"
+
+#include <cinttypes>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Serve the requests to an admission controller received from clients
+ * over a Unix domain socket.
+ *
+ * Clients send AdmissionRequest records and receive one AdmissionResponse
+ * for each of them, in the same order. Requests can be pipelined: a client
+ * may send many requests without waiting for the responses, which are then
+ * served in batches as soon as they are received.
+ *
+ * All the clients are served in the thread that calls run().
+ */
+class AdmissionServer final
+{
+  NONCOPYABLE_NONMOVABLE(AdmissionServer);
+
+ public:
+  /**
+   * @brief Create the socket and start listening for connections.
+   *
+   * A stale file with the same path is removed.
+   *
+   * @param aPath the path of the Unix domain socket
+   * @param aController the admission controller, which must outlive this
+   * object
+   *
+   * @throw std::runtime_error if the socket cannot be created
+   */
+  explicit AdmissionServer(const std::string&   aPath,
+                           AdmissionController& aController);
+
+  //! Close all the connections and remove the socket file.
+  ~AdmissionServer();
+
+  /**
+   * @brief Serve the clients until stop() is called.
+   *
+   * @throw std::runtime_error if a non-recoverable error occurs
+   */
+  void run();
+
+  /**
+   * @brief Make run() return as soon as possible.
+   *
+   * Can be called from any thread and from a signal handler.
+   */
+  void stop() noexcept;
+
+  //! \return the number of requests served, valid after run() returns.
+  std::size_t numRequests() const noexcept {
+    return theNumRequests;
+  }
+
+  /**
+   * @brief Set a function called by run() after every round in which at
+   * least one request has been served, e.g., to export the residual
+   * capacities.
+   */
+  void served(const std::function<void()>& aFunction) {
+    theServed = aFunction;
+  }
+
+ private:
+  struct Client {
+    explicit Client(const int aFd);
+
+    int               theFd;
+    std::vector<char> theIn;
+    std::vector<char> theOut;
+  };
+
+  //! Accept all the pending connections.
+  void accept();
+
+  //! Read and serve the requests received. \return false if closed.
+  bool receive(Client& aClient);
+
+  //! Write the pending responses. \return false if closed.
+  bool transmit(Client& aClient);
+
+ private:
+  const std::string     thePath;
+  AdmissionController&  theController;
+  int                   theListenFd;
+  int                   theStopFds[2];
+  std::vector<Client>   theClients;
+  std::size_t           theNumRequests;
+  std::function<void()> theServed;
+};
+
+/**
+ * @brief Blocking client of an AdmissionServer.
+ *
+ * Requests are buffered by send() and transmitted with flush(), which allows
+ * to pipeline many requests in a single system call. Since the server stops
+ * reading from clients that do not read their responses, the number of
+ * outstanding requests should be bounded, e.g., to some thousands.
+ */
+class AdmissionClient final
+{
+  NONCOPYABLE_NONMOVABLE(AdmissionClient);
+
+ public:
+  /**
+   * @brief Connect to a server.
+   *
+   * @throw std::runtime_error if the connection cannot be established
+   */
+  explicit AdmissionClient(const std::string& aPath);
+
+  ~AdmissionClient();
+
+  //! Buffer a request, which is transmitted with the next flush().
+  void send(const AdmissionRequest& aRequest);
+
+  /**
+   * @brief Transmit all the buffered requests.
+   *
+   * @throw std::runtime_error if the connection is closed
+   */
+  void flush();
+
+  /**
+   * @brief Wait for the next response, after flushing the buffered requests.
+   *
+   * @throw std::runtime_error if the connection is closed
+   */
+  AdmissionResponse receive();
+
+  //! Send a request and wait for its response.
+  AdmissionResponse operator()(const AdmissionRequest& aRequest);
+
+ private:
+  int               theFd;
+  std::vector<char> theOut;
+  std::vector<char> theIn;
+  std::size_t       theInOffset;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -30,6 +30,10 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/latencyhistogram.h"
+#include "QuantumRouting/memoryaccounting.h"
+#include "QuantumRouting/serialexecutor.h"
+#include "QuantumRouting/trace.h"
 
 #include "Support/tostring.h"
 
@@ -40,21 +44,90 @@ SOFTWARE.
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/graph_utility.hpp>
 #include <boost/graph/properties.hpp>
+#include <boost/graph/reverse_graph.hpp>
 
+#include <boost/property_map/function_property_map.hpp>
 #include <boost/property_map/property_map.hpp>
 #include <glog/logging.h>
 
-#include <glog/vlog_is_on.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
 #include <sstream>
 #include <stdexcept>
 
 namespace uiiit {
 namespace qr {
 
-CapacityNetwork::FlowDescriptor::FlowDescriptor(const unsigned long aSrc,
-                                                const unsigned long aDst,
-                                                const double aNetRate) noexcept
+namespace {
+
+//! Dijkstra visitor counting the vertices settled and edges scanned.
+class CountingVisitor final : public boost::default_dijkstra_visitor
+{
+ public:
+  explicit CountingVisitor(WorkCounters& aCounters)
+      : theCounters(&aCounters) {
+    // noop
+  }
+
+  template <class VERTEX, class GRAPH>
+  void examine_vertex(VERTEX, const GRAPH&) {
+    ++theCounters->theVerticesSettled;
+  }
+
+  template <class EDGE, class GRAPH>
+  void examine_edge(EDGE, const GRAPH&) {
+    ++theCounters->theEdgesScanned;
+  }
+
+ private:
+  WorkCounters* theCounters;
+};
+
+//! Edge predicate of the edges with enough capacity and not excluded.
+template <class GRAPH, class CAPACITY>
+class FeasibleEdge final
+{
+ public:
+  using VertexDescriptor =
+      typename boost::graph_traits<GRAPH>::vertex_descriptor;
+  using Excluded = std::set<std::pair<VertexDescriptor, VertexDescriptor>>;
+
+  FeasibleEdge() = default;
+
+  FeasibleEdge(const GRAPH&    aGraph,
+               const CAPACITY  aMinCapacity,
+               const Excluded& aExcluded)
+      : theGraph(&aGraph)
+      , theMinCapacity(aMinCapacity)
+      , theExcluded(&aExcluded) {
+    // noop
+  }
+
+  bool operator()(
+      const typename boost::graph_traits<GRAPH>::edge_descriptor& aEdge) const {
+    return boost::get(boost::edge_weight, *theGraph, aEdge) >=
+               theMinCapacity and
+           (theExcluded->empty() or
+            theExcluded->count({boost::source(aEdge, *theGraph),
+                                boost::target(aEdge, *theGraph)}) == 0);
+  }
+
+ private:
+  const GRAPH*    theGraph       = nullptr;
+  CAPACITY        theMinCapacity = 0;
+  const Excluded* theExcluded    = nullptr;
+};
+
+} // namespace
+
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor::FlowDescriptor(
+    const Index aSrc, const Index aDst, const Capacity aNetRate) noexcept
     : theSrc(aSrc)
     , theDst(aDst)
     , theNetRate(aNetRate)
@@ -64,13 +137,16 @@ CapacityNetwork::FlowDescriptor::FlowDescriptor(const unsigned long aSrc,
   // noop
 }
 
-void CapacityNetwork::FlowDescriptor::movePathRateFrom(
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor::movePathRateFrom(
     FlowDescriptor& aAnother) {
   std::swap(thePath, aAnother.thePath);
   std::swap(theGrossRate, aAnother.theGrossRate);
 }
 
-std::string CapacityNetwork::FlowDescriptor::toString() const {
+template <class INDEX, class CAPACITY>
+std::string
+BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor::toString() const {
   std::stringstream myStream;
   myStream << "(" << theSrc << "," << theDst << ") [net rate = " << theNetRate
            << ", gross rate " << theGrossRate << "] path = [" << thePath.size()
@@ -83,10 +159,11 @@ std::string CapacityNetwork::FlowDescriptor::toString() const {
   return myStream.str();
 }
 
-CapacityNetwork::AppDescriptor::AppDescriptor(
-    const unsigned long               aHost,
-    const std::vector<unsigned long>& aPeers,
-    const double                      aPriority) noexcept
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::AppDescriptor(
+    const Index               aHost,
+    const std::vector<Index>& aPeers,
+    const double              aPriority) noexcept
     : theHost(aHost)
     , thePeers(aPeers)
     , thePriority(aPriority)
@@ -96,15 +173,18 @@ CapacityNetwork::AppDescriptor::AppDescriptor(
   // noop
 }
 
-CapacityNetwork::AppDescriptor::AppDescriptor::Output::Output(const Path& aPath)
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::Output::Output(
+    const Path& aPath)
     : theHops() {
   for (const auto& myEdge : aPath) {
     theHops.emplace_back(myEdge.m_target);
   }
 }
 
-double CapacityNetwork::AppDescriptor::netRate() const {
-  double ret = 0;
+template <class INDEX, class CAPACITY>
+CAPACITY BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::netRate() const {
+  Capacity ret = 0;
   for (const auto& elem : theAllocated) {
     for (const auto& inner : elem.second) {
       ret += inner.theNetRate;
@@ -113,8 +193,10 @@ double CapacityNetwork::AppDescriptor::netRate() const {
   return ret;
 }
 
-double CapacityNetwork::AppDescriptor::grossRate() const {
-  double ret = 0;
+template <class INDEX, class CAPACITY>
+CAPACITY
+BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::grossRate() const {
+  Capacity ret = 0;
   for (const auto& elem : theAllocated) {
     for (const auto& inner : elem.second) {
       ret += inner.theGrossRate;
@@ -123,7 +205,9 @@ double CapacityNetwork::AppDescriptor::grossRate() const {
   return ret;
 }
 
-std::string CapacityNetwork::AppDescriptor::toString() const {
+template <class INDEX, class CAPACITY>
+std::string
+BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::toString() const {
   std::stringstream myStream;
   myStream << "host " << theHost << ", peers {"
            << ::toString(
@@ -137,13 +221,92 @@ std::string CapacityNetwork::AppDescriptor::toString() const {
   return myStream.str();
 }
 
-CapacityNetwork::CapacityNetwork(
-    const std::vector<std::pair<unsigned long, unsigned long>>& aEdges,
-    support::RealRvInterface&                                   aWeightRv,
-    const bool aMakeBidirectional)
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta
+BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta::addEdge(
+    const Index aSrc, const Index aDst, const Capacity aCapacity) {
+  return TopologyDelta{Type::AddEdge, aSrc, aDst, aCapacity};
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta
+BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta::removeEdge(
+    const Index aSrc, const Index aDst) {
+  return TopologyDelta{Type::RemoveEdge, aSrc, aDst, 0};
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta
+BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta::setCapacity(
+    const Index aSrc, const Index aDst, const Capacity aCapacity) {
+  return TopologyDelta{Type::SetCapacity, aSrc, aDst, aCapacity};
+}
+
+template <class INDEX, class CAPACITY>
+std::string
+BasicCapacityNetwork<INDEX, CAPACITY>::TopologyDelta::toString() const {
+  std::stringstream myStream;
+  switch (theType) {
+    case Type::AddEdge:
+      myStream << "add edge";
+      break;
+    case Type::RemoveEdge:
+      myStream << "remove edge";
+      break;
+    case Type::SetCapacity:
+      myStream << "set capacity of edge";
+      break;
+  }
+  myStream << " (" << theSrc << ',' << theDst << ')';
+  if (theType != Type::RemoveEdge) {
+    myStream << " to " << theCapacity;
+  }
+  return myStream.str();
+}
+
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::FidelityThresholdPolicy::
+    FidelityThresholdPolicy(
+    const double      p1,
+    const double      p2,
+    const double      eta,
+    const double      F,
+    const double      aThreshold,
+    const std::size_t aNumNodes)
+    : theFidelity(p1, p2, eta, F, aNumNodes)
+    , theThreshold(aThreshold)
+    , theMaxHops(std::numeric_limits<std::size_t>::max()) {
+  if (F < 0.25) {
+    throw std::runtime_error(
+        "invalid local entanglement fidelity for a threshold policy: " +
+        std::to_string(F));
+  }
+  for (std::size_t n = 1; n <= aNumNodes; n++) {
+    if (not admissible(n)) {
+      theMaxHops = n - 1;
+      break;
+    }
+  }
+}
+
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::BasicCapacityNetwork(
+    const EdgeVector&         aEdges,
+    support::RealRvInterface& aWeightRv,
+    const bool                aMakeBidirectional)
     : Network()
     , theGraph()
-    , theMeasurementProbability(1) {
+    , theBaseCapacities()
+    , theLinkQualities()
+    , theSwapReliability()
+    , theNodeCapacities()
+    , theMeasurementProbability(1)
+    , theSwapSuccess()
+    , theCounters()
+    , theLatencies()
+    , theLatencyClassFunction()
+    , theExecutorFlag()
+    , theExecutor() {
   std::set<std::string> myFound;
   for (const auto& myEdge : aEdges) {
     if (myFound
@@ -155,28 +318,90 @@ CapacityNetwork::CapacityNetwork(
       continue;
     }
     const auto myWeight = aWeightRv();
-    Utils<Graph>::addEdge(theGraph, myEdge.first, myEdge.second, myWeight);
+    addEdge(myEdge.first, myEdge.second, myWeight);
+    theBaseCapacities.emplace(myEdge, myWeight);
     if (aMakeBidirectional) {
-      Utils<Graph>::addEdge(theGraph, myEdge.second, myEdge.first, myWeight);
+      addEdge(myEdge.second, myEdge.first, myWeight);
+      theBaseCapacities.emplace(std::make_pair(myEdge.second, myEdge.first),
+                                myWeight);
     }
   }
+  theNodeCapacities.resize(boost::num_vertices(theGraph));
+  for (const auto& myNode :
+       boost::make_iterator_range(boost::vertices(theGraph))) {
+    updateNodeCapacity(myNode);
+  }
+  theSwapReliability = PowerTable(1, numNodes());
+  theSwapSuccess     = PowerTable(theMeasurementProbability, numNodes());
 }
 
-CapacityNetwork::CapacityNetwork(const WeightVector& aEdgeWeights)
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::BasicCapacityNetwork(
+    const WeightVector& aEdgeWeights, const std::size_t aNumNodes)
     : Network()
     , theGraph()
-    , theMeasurementProbability(1) {
+    , theBaseCapacities()
+    , theLinkQualities()
+    , theSwapReliability()
+    , theNodeCapacities()
+    , theMeasurementProbability(1)
+    , theSwapSuccess()
+    , theCounters()
+    , theLatencies()
+    , theLatencyClassFunction()
+    , theExecutorFlag()
+    , theExecutor() {
   for (const auto& elem : aEdgeWeights) {
-    Utils<Graph>::addEdge(
-        theGraph, std::get<0>(elem), std::get<1>(elem), std::get<2>(elem));
+    addEdge(std::get<0>(elem), std::get<1>(elem), std::get<2>(elem));
+    theBaseCapacities.emplace(
+        std::make_pair(std::get<0>(elem), std::get<1>(elem)),
+        std::get<2>(elem));
+  }
+  while (boost::num_vertices(theGraph) < aNumNodes) {
+    boost::add_vertex(theGraph);
   }
+  theNodeCapacities.resize(boost::num_vertices(theGraph));
+  for (const auto& myNode :
+       boost::make_iterator_range(boost::vertices(theGraph))) {
+    updateNodeCapacity(myNode);
+  }
+  theSwapReliability = PowerTable(1, numNodes());
+  theSwapSuccess     = PowerTable(theMeasurementProbability, numNodes());
 }
 
-void CapacityNetwork::toDot(const std::string& aFilename) const {
+template <class INDEX, class CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::~BasicCapacityNetwork() {
+  // the tasks pending refer to this object
+  theExecutor.reset();
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::toDot(
+    const std::string& aFilename) const {
   Utils<Graph>::toDot(theGraph, aFilename);
 }
 
-CapacityNetwork::WeightVector CapacityNetwork::weights() const {
+template <class INDEX, class CAPACITY>
+std::unique_ptr<BasicCapacityNetwork<INDEX, CAPACITY>>
+BasicCapacityNetwork<INDEX, CAPACITY>::clone() const {
+  auto ret = std::make_unique<BasicCapacityNetwork>(WeightVector());
+
+  {
+    MemoryAccounting::Scope myGraphScope(MemoryUsage::Subsystem::Graph);
+    ret->theGraph = theGraph;
+  }
+  ret->theBaseCapacities         = theBaseCapacities;
+  ret->theLinkQualities          = theLinkQualities;
+  ret->theSwapReliability        = theSwapReliability;
+  ret->theNodeCapacities         = theNodeCapacities;
+  ret->theMeasurementProbability = theMeasurementProbability;
+  ret->theSwapSuccess            = theSwapSuccess;
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::WeightVector
+BasicCapacityNetwork<INDEX, CAPACITY>::weights() const {
   WeightVector ret;
   const auto   myEdges   = boost::edges(theGraph);
   const auto   myWeights = boost::get(boost::edge_weight, theGraph);
@@ -186,7 +411,8 @@ CapacityNetwork::WeightVector CapacityNetwork::weights() const {
   return ret;
 }
 
-void CapacityNetwork::measurementProbability(
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::measurementProbability(
     const double aMeasurementProbability) {
   if (aMeasurementProbability < 0 or aMeasurementProbability > 1) {
     throw std::runtime_error("Invalid measurement probability: " +
@@ -194,44 +420,177 @@ void CapacityNetwork::measurementProbability(
   }
   VLOG(2) << "measurement probability set to " << aMeasurementProbability;
   theMeasurementProbability = aMeasurementProbability;
+  theSwapSuccess            = PowerTable(theMeasurementProbability, numNodes());
+
+  // the swap success probability of the links whose quality has not been set
+  for (const auto& myEdge :
+       boost::make_iterator_range(boost::edges(theGraph))) {
+    updateLinkCosts(myEdge);
+  }
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::linkQualities(
+    const QualityVector& aQualities) {
+  for (const auto& [mySrc, myDst, myQuality] : aQualities) {
+    if (theBaseCapacities.count({mySrc, myDst}) == 0) {
+      throw std::runtime_error("cannot set the quality of non-existing edge (" +
+                               std::to_string(mySrc) + "," +
+                               std::to_string(myDst) + ")");
+    }
+    if (myQuality.theFidelity <= 0.25 or myQuality.theFidelity > 1) {
+      throw std::runtime_error("invalid link fidelity, not in (1/4, 1]: " +
+                               std::to_string(myQuality.theFidelity));
+    }
+    if (myQuality.theSwapSuccess < 0 or myQuality.theSwapSuccess > 1) {
+      throw std::runtime_error("invalid swap success probability: " +
+                               std::to_string(myQuality.theSwapSuccess));
+    }
+  }
+
+  for (const auto& [mySrc, myDst, myQuality] : aQualities) {
+    theLinkQualities[{mySrc, myDst}] = myQuality;
+    EdgeDescriptor myEdge;
+    auto           myFound = false;
+    std::tie(myEdge, myFound) = boost::edge(mySrc, myDst, theGraph);
+    ++theCounters.theEdgeLookups;
+    if (myFound) {
+      updateLinkCosts(myEdge);
+    }
+  }
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::LinkQuality
+BasicCapacityNetwork<INDEX, CAPACITY>::linkQuality(const Index aSrc,
+                                                   const Index aDst) const {
+  const auto myKey = std::make_pair(aSrc, aDst);
+  if (theBaseCapacities.count(myKey) == 0) {
+    throw std::runtime_error("no link quality for non-existing edge (" +
+                             std::to_string(aSrc) + "," +
+                             std::to_string(aDst) + ")");
+  }
+  const auto it = theLinkQualities.find(myKey);
+  if (it == theLinkQualities.end()) {
+    return LinkQuality{1, theMeasurementProbability};
+  }
+  return it->second;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::swapReliability(const double p1,
+                                                            const double p2,
+                                                            const double eta) {
+  if (p1 <= 0 or p1 > 1 or p2 <= 0 or p2 > 1 or eta < 0.5 or eta > 1) {
+    throw std::runtime_error("invalid swap reliability: p1 = " +
+                             std::to_string(p1) + ", p2 = " +
+                             std::to_string(p2) +
+                             ", eta = " + std::to_string(eta));
+  }
+  theSwapReliability =
+      PowerTable(p1 * p1 * p2 * (4 * eta * eta - 1) / 3.0, numNodes());
+}
+
+template <class INDEX, class CAPACITY>
+double BasicCapacityNetwork<INDEX, CAPACITY>::pathFidelity(
+    const VertexDescriptor aSrc, const std::vector<Index>& aPath) const {
+  WorkCounters myCounters;
+  return pathFidelity(aSrc, aPath, myCounters);
+}
+
+template <class INDEX, class CAPACITY>
+double BasicCapacityNetwork<INDEX, CAPACITY>::pathFidelity(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    WorkCounters&             aCounters) const {
+  if (aPath.empty()) {
+    throw std::runtime_error("cannot compute the fidelity of an empty path");
+  }
+  double myProduct = 1;
+  auto   mySrc     = aSrc;
+  for (const auto myDst : aPath) {
+    myProduct *= linkCosts(mySrc, myDst, aCounters).theFidelityFactor;
+    mySrc = myDst;
+  }
+  return 1.0 / 4.0 +
+         3.0 / 4.0 * theSwapReliability(aPath.size() - 1) * myProduct;
+}
+
+template <class INDEX, class CAPACITY>
+double BasicCapacityNetwork<INDEX, CAPACITY>::pathSwapSuccess(
+    const VertexDescriptor aSrc, const std::vector<Index>& aPath) const {
+  WorkCounters myCounters;
+  return pathSwapSuccess(aSrc, aPath, myCounters);
 }
 
-std::size_t CapacityNetwork::numNodes() const {
+template <class INDEX, class CAPACITY>
+double BasicCapacityNetwork<INDEX, CAPACITY>::pathSwapSuccess(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    WorkCounters&             aCounters) const {
+  double ret   = 1;
+  auto   mySrc = aSrc;
+  for (std::size_t i = 0; i < aPath.size(); i++) {
+    const auto mySwapSuccess =
+        linkCosts(mySrc, aPath[i], aCounters).theSwapSuccess;
+    if (i > 0) {
+      ret *= mySwapSuccess;
+    }
+    mySrc = aPath[i];
+  }
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+std::size_t BasicCapacityNetwork<INDEX, CAPACITY>::numNodes() const {
   return boost::num_vertices(theGraph);
 }
 
-std::size_t CapacityNetwork::numEdges() const {
+template <class INDEX, class CAPACITY>
+std::size_t BasicCapacityNetwork<INDEX, CAPACITY>::numEdges() const {
   return boost::num_edges(theGraph);
 }
 
-std::pair<std::size_t, std::size_t> CapacityNetwork::inDegree() const {
+template <class INDEX, class CAPACITY>
+std::pair<std::size_t, std::size_t>
+BasicCapacityNetwork<INDEX, CAPACITY>::inDegree() const {
   return minMaxVertexProp(
-      [](Graph::vertex_descriptor aVertex, const Graph& aGraph) {
+      [](VertexDescriptor aVertex, const Graph& aGraph) {
         return boost::in_degree(aVertex, aGraph);
       });
 }
 
-std::pair<std::size_t, std::size_t> CapacityNetwork::outDegree() const {
+template <class INDEX, class CAPACITY>
+std::pair<std::size_t, std::size_t>
+BasicCapacityNetwork<INDEX, CAPACITY>::outDegree() const {
   return minMaxVertexProp(
-      [](Graph::vertex_descriptor aVertex, const Graph& aGraph) {
+      [](VertexDescriptor aVertex, const Graph& aGraph) {
         return boost::out_degree(aVertex, aGraph);
       });
 }
 
-double CapacityNetwork::totalCapacity() const {
-  const auto myEdges   = boost::edges(theGraph);
-  const auto myWeights = boost::get(boost::edge_weight, theGraph);
-  double     ret       = 0;
-  for (auto it = myEdges.first; it != myEdges.second; ++it) {
-    ret += myWeights[*it];
-  }
-  return ret;
+template <class INDEX, class CAPACITY>
+CAPACITY BasicCapacityNetwork<INDEX, CAPACITY>::totalCapacity() const {
+  return std::accumulate(
+      theNodeCapacities.begin(), theNodeCapacities.end(), Capacity(0));
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::ReachableNodes
+BasicCapacityNetwork<INDEX, CAPACITY>::reachableNodes(
+    const std::size_t aMinHops,
+    const std::size_t aMaxHops,
+    std::size_t&      aDiameter) {
+  return reachableNodes(aMinHops, aMaxHops, aDiameter, theCounters);
 }
 
-std::map<unsigned long, std::set<unsigned long>>
-CapacityNetwork::reachableNodes(const std::size_t aMinHops,
-                                const std::size_t aMaxHops,
-                                std::size_t&      aDiameter) const {
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::ReachableNodes
+BasicCapacityNetwork<INDEX, CAPACITY>::reachableNodes(
+    const std::size_t aMinHops,
+    const std::size_t aMaxHops,
+    std::size_t&      aDiameter,
+    WorkCounters&     aCounters) const {
   if (aMinHops > aMaxHops) {
     throw std::runtime_error(
         "Invalid min distance (" + std::to_string(aMinHops) +
@@ -242,24 +601,25 @@ CapacityNetwork::reachableNodes(const std::size_t aMinHops,
   std::vector<VertexDescriptor> myDistances(V);
 
   aDiameter = 0;
-  std::map<unsigned long, std::set<unsigned long>> ret;
-  boost::graph_traits<Graph>::vertex_iterator      it, end;
+  ReachableNodes                                       ret;
+  typename boost::graph_traits<Graph>::vertex_iterator it, end;
   for (std::tie(it, end) = vertices(theGraph); it != end; ++it) {
     boost::dijkstra_shortest_paths(
         theGraph,
         *it,
         boost::weight_map(
-            boost::make_static_property_map<Graph::edge_descriptor>(1))
+            boost::make_static_property_map<EdgeDescriptor>(1))
             .distance_map(boost::make_iterator_property_map(
-                myDistances.data(), get(boost::vertex_index, theGraph))));
+                myDistances.data(), get(boost::vertex_index, theGraph)))
+            .visitor(CountingVisitor(aCounters)));
 
-    auto myEmplaceRet = ret.emplace(*it, std::set<unsigned long>());
+    auto myEmplaceRet = ret.emplace(*it, std::set<Index>());
     assert(myEmplaceRet.second);
-    for (unsigned long i = 0; i < V; i++) {
+    for (VertexDescriptor i = 0; i < V; i++) {
       if (*it != i and
-          myDistances[i] != std::numeric_limits<unsigned long>::max()) {
+          myDistances[i] != std::numeric_limits<VertexDescriptor>::max()) {
         aDiameter = std::max(aDiameter, myDistances[i]);
-        VLOG(2) << *it << "->" << i << ": " << myDistances[i];
+        QR_TRACE(2, ReachableNode, *it, i, myDistances[i], 0);
         if (myDistances[i] >= aMinHops and myDistances[i] <= aMaxHops) {
           myEmplaceRet.first->second.emplace(i);
         }
@@ -269,114 +629,278 @@ CapacityNetwork::reachableNodes(const std::size_t aMinHops,
   return ret;
 }
 
-void CapacityNetwork::route(std::vector<FlowDescriptor>& aFlows,
-                            const FlowCheckFunction&     aCheckFunction) {
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::route(
+    std::vector<FlowDescriptor>& aFlows,
+    const FlowCheckFunction&     aCheckFunction) {
+  route<FlowCheckFunction>(aFlows, aCheckFunction);
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::route(
+    std::vector<FlowDescriptor>& aFlows,
+    const PathMetric             aMetric,
+    const FlowCheckFunction&     aCheckFunction) {
+  // the buffers are shared by all the flows
+  std::vector<double>           myDistances;
+  std::vector<VertexDescriptor> myPredecessors;
+
+  routeFlows(aFlows, [&](FlowDescriptor& aFlow) {
+    findWeightedPath(
+        aFlow, aMetric, aCheckFunction, myDistances, myPredecessors);
+  });
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::routeConstrained(
+    std::vector<FlowDescriptor>& aFlows,
+    const double                 aMinFidelity,
+    const std::size_t            aMaxLabels) {
+  if (aMinFidelity < 0 or aMinFidelity > 1) {
+    throw std::runtime_error("invalid minimum fidelity: " +
+                             std::to_string(aMinFidelity));
+  }
+  if (aMaxLabels == 0) {
+    throw std::runtime_error("invalid maximum number of labels: 0");
+  }
+
+  // the labels are shared by all the flows
+  LabelWorkspace myWorkspace;
+
+  routeFlows(aFlows, [&](FlowDescriptor& aFlow) {
+    findConstrainedPath(aFlow, aMinFidelity, aMaxLabels, myWorkspace);
+  });
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor
+BasicCapacityNetwork<INDEX, CAPACITY>::probe(
+    const FlowDescriptor&    aFlow,
+    const FlowCheckFunction& aCheckFunction) const {
+  return probe<FlowCheckFunction>(aFlow, aCheckFunction);
+}
+
+template <class INDEX, class CAPACITY>
+std::vector<typename BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor>
+BasicCapacityNetwork<INDEX, CAPACITY>::probe(
+    const std::vector<AppDescriptor>& aApps,
+    const double                      aQuantum,
+    const std::size_t                 aK,
+    const AppCheckFunction&           aCheckFunction) const {
+  // the allocation to the apps removes the edges whose capacity is exhausted,
+  // hence it is done on a private copy of the network
+  const auto myCopy = clone();
+  auto       ret    = aApps;
+  myCopy->route(ret, aQuantum, aK, aCheckFunction);
+
+  // the paths not used refer to the edges of the copy
+  for (auto& myApp : ret) {
+    myApp.theRemainingPaths.clear();
+  }
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::checkFlow(
+    const FlowDescriptor& aFlow) const {
   const auto V = boost::num_vertices(theGraph);
+  if (boost::vertex(aFlow.theSrc, theGraph) >= V) {
+    throw std::runtime_error("invalid source node in flow: " +
+                             std::to_string(aFlow.theSrc));
+  }
+  if (boost::vertex(aFlow.theDst, theGraph) >= V) {
+    throw std::runtime_error("invalid destination node in flow: " +
+                             std::to_string(aFlow.theDst));
+  }
+  if (aFlow.theSrc == aFlow.theDst) {
+    throw std::runtime_error("invalid flow: from " +
+                             std::to_string(aFlow.theSrc) + " to itself");
+  }
+  if (aFlow.theNetRate <= 0) {
+    throw std::runtime_error("invalid nonpositive capacity request in flow: " +
+                             std::to_string(aFlow.theNetRate));
+  }
+}
 
-  // pre-condition checks
-  for (const auto& myFlow : aFlows) {
-    assert(myFlow.thePath.empty());
-    assert(myFlow.theGrossRate == 0);
-    assert(myFlow.theDijsktra == 0);
+template <class INDEX, class CAPACITY>
+const std::vector<
+    typename BasicCapacityNetwork<INDEX, CAPACITY>::VertexDescriptor>&
+BasicCapacityNetwork<INDEX, CAPACITY>::shortestPathTree(
+    const VertexDescriptor      aSrc,
+    const std::optional<Graph>& aGraph,
+    SearchWorkspace&            aWorkspace,
+    WorkCounters&               aCounters) const {
+  const auto V = boost::num_vertices(theGraph);
+  aWorkspace.theDistances.resize(V);
+  aWorkspace.thePredecessors.resize(V);
 
-    if (boost::vertex(myFlow.theSrc, theGraph) >= V) {
-      throw std::runtime_error("invalid source node in flow: " +
-                               std::to_string(myFlow.theSrc));
-    }
-    if (boost::vertex(myFlow.theDst, theGraph) >= V) {
-      throw std::runtime_error("invalid destination node in flow: " +
-                               std::to_string(myFlow.theDst));
-    }
-    if (myFlow.theSrc == myFlow.theDst) {
-      throw std::runtime_error("invalid flow: from " +
-                               std::to_string(myFlow.theSrc) + " to itself");
-    }
-    if (myFlow.theNetRate <= 0) {
-      throw std::runtime_error(
-          "invalid nonpositive capacity request in flow: " +
-          std::to_string(myFlow.theNetRate));
+  const auto myShortestPaths = [&](const Graph&                   aGraph,
+                                   std::vector<VertexDescriptor>& aPreds) {
+    boost::dijkstra_shortest_paths(
+        aGraph,
+        aSrc,
+        boost::predecessor_map(aPreds.data())
+            .weight_map(
+                boost::make_static_property_map<EdgeDescriptor>(1))
+            .distance_map(boost::make_iterator_property_map(
+                aWorkspace.theDistances.data(),
+                get(boost::vertex_index, aGraph)))
+            .visitor(CountingVisitor(aCounters)));
+  };
+
+  if (aGraph.has_value()) {
+    myShortestPaths(*aGraph, aWorkspace.thePredecessors);
+    return aWorkspace.thePredecessors;
+  }
+
+  // the full topology is not modified while searching (only the capacities
+  // are): the shortest path trees found are then shared by all the flows with
+  // the same source using the same workspace, up to a bounded number of trees
+  // kept at the same time
+  const auto myMaxTrees =
+      std::max<std::size_t>(1, (1u << 22) / std::max<std::size_t>(1, V));
+
+  auto it = aWorkspace.theTrees.find(aSrc);
+  if (it == aWorkspace.theTrees.end()) {
+    if (aWorkspace.theTrees.size() >= myMaxTrees) {
+      aWorkspace.theTrees.clear();
     }
+    it = aWorkspace.theTrees.emplace(aSrc, std::vector<VertexDescriptor>(V))
+             .first;
+    myShortestPaths(theGraph, it->second);
   }
+  return it->second;
+}
 
-  std::vector<VertexDescriptor> myDistances(V);
-  std::vector<VertexDescriptor> myPredecessors(V);
-
-  for (auto& myFlow : aFlows) {
-    assert(myFlow.thePath.empty());
-    assert(myFlow.theGrossRate == 0);
-    VLOG(2) << "flow " << myFlow.toString();
-
-    auto myFoundOrDisconnected = false;
-    auto myCopiedGraph         = theGraph;
-
-    // loop until either there is no path from the source to the destination
-    // or we find a candidate that can satisfy the flow requirements
-    while (not myFoundOrDisconnected) {
-      myFlow.theDijsktra++;
-      boost::dijkstra_shortest_paths(
-          myCopiedGraph,
-          myFlow.theSrc,
-          boost::predecessor_map(myPredecessors.data())
-              .weight_map(
-                  boost::make_static_property_map<Graph::edge_descriptor>(1))
-              .distance_map(boost::make_iterator_property_map(
-                  myDistances.data(),
-                  get(boost::vertex_index, myCopiedGraph))));
-
-      if (myPredecessors[myFlow.theDst] == myFlow.theDst) {
-        myFoundOrDisconnected = true; // disconnected
-
-      } else {
-        // there is at least one path from source to destination
-        HopsFinder     myHopsFinder(myPredecessors, myFlow.theSrc);
-        FlowDescriptor myCandidate(myFlow);
-        myHopsFinder(myCandidate.thePath, myFlow.theDst);
-        assert(not myCandidate.thePath.empty());
-        myCandidate.theGrossRate =
-            toGrossRate(myCandidate.theNetRate, myCandidate.thePath.size());
-        VLOG(2) << "candidate " << myCandidate.toString();
-
-        // if the flow is not admissible because of the external function
-        // we assume there is no need to continue the search, otherwise
-        // we check that the gross EPR rate is feasible along the path
-        // selected
-        if (not aCheckFunction(myCandidate)) {
-          myFoundOrDisconnected = true;
-
-        } else if (checkCapacity(myCandidate.theSrc,
-                                 myCandidate.thePath,
-                                 myCandidate.theGrossRate,
-                                 myCopiedGraph)) {
-          // flow is admissible on the shortest path, break from loop
-          myFoundOrDisconnected = true;
-          myFlow.movePathRateFrom(myCandidate);
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::findWeightedPath(
+    FlowDescriptor&                aFlow,
+    const PathMetric               aMetric,
+    const FlowCheckFunction&       aCheckFunction,
+    std::vector<double>&           aDistances,
+    std::vector<VertexDescriptor>& aPredecessors) {
+  const auto V = boost::num_vertices(theGraph);
+  aDistances.resize(V);
+  aPredecessors.resize(V);
+
+  // the first edge of a path has no swap at its source
+  const auto mySrc              = aFlow.theSrc;
+  const auto mySwapFidelityCost = -std::log(theSwapReliability.base());
+  const auto myCost             = [&](const EdgeDescriptor& aEdge) {
+    const auto& myCosts = theGraph[aEdge];
+    const auto  myFirst = boost::source(aEdge, theGraph) == mySrc;
+    if (aMetric == PathMetric::Fidelity) {
+      return myCosts.theFidelityCost + (myFirst ? 0.0 : mySwapFidelityCost);
+    }
+    return myFirst ? 0.0 : myCosts.theSwapCost;
+  };
+
+  // the edges with capacity smaller than the net rate cannot be used, since
+  // the gross rate is not smaller, nor those excluded during the search
+  std::set<std::pair<VertexDescriptor, VertexDescriptor>> myExcluded;
+  const auto myFiltered = boost::make_filtered_graph(
+      theGraph,
+      FeasibleEdge<Graph, Capacity>(theGraph, aFlow.theNetRate, myExcluded));
+
+  // loop until either there is no path from the source to the destination
+  // or we find a candidate that can satisfy the flow requirements
+  while (true) {
+    aFlow.theDijsktra++;
+    boost::dijkstra_shortest_paths(
+        myFiltered,
+        mySrc,
+        boost::predecessor_map(aPredecessors.data())
+            .weight_map(
+                boost::make_function_property_map<EdgeDescriptor, double>(
+                    myCost))
+            .distance_map(boost::make_iterator_property_map(
+                aDistances.data(), get(boost::vertex_index, theGraph)))
+            .visitor(CountingVisitor(theCounters)));
 
-        } else {
-          // flow not admissible on the shortest path, remove the edge with
-          // smallest capacity along the path and try again
-          removeSmallestCapacityEdge(
-              myCandidate.theSrc, myCandidate.thePath, myCopiedGraph);
-        }
-      }
+    if (aPredecessors[aFlow.theDst] == aFlow.theDst) {
+      return; // disconnected
     }
 
-    if (myFlow.thePath.empty()) {
-      VLOG(2) << "flow rejected " << myFlow.toString();
+    HopsFinder     myHopsFinder(aPredecessors, mySrc);
+    FlowDescriptor myCandidate(aFlow);
+    myHopsFinder(myCandidate.thePath, aFlow.theDst);
+    assert(not myCandidate.thePath.empty());
+    myCandidate.theGrossRate =
+        myCandidate.theNetRate /
+        pathSwapSuccess(mySrc, myCandidate.thePath, theCounters);
+    QR_TRACE(2,
+             FlowCandidate,
+             myCandidate.theSrc,
+             myCandidate.theDst,
+             myCandidate.thePath.size(),
+             myCandidate.theGrossRate);
+
+    if (not aCheckFunction(myCandidate)) {
+      return;
+    }
+    if (checkCapacity(myCandidate.theSrc,
+                      myCandidate.thePath,
+                      myCandidate.theGrossRate,
+                      theGraph,
+                      theCounters)) {
+      aFlow.movePathRateFrom(myCandidate);
+      return;
+    }
 
-    } else {
-      VLOG(2) << "flow admitted " << myFlow.toString();
-      // flow admissible: remove the gross capacity from the edges along the
-      // path and then move to the next flow in the list
-      removeCapacityFromPath(
-          myFlow.theSrc, myFlow.thePath, myFlow.theGrossRate, theGraph);
+    // exclude the edge with smallest capacity along the path and try again
+    auto   myPrev        = mySrc;
+    auto   myExcludedKey = std::make_pair(mySrc, myCandidate.thePath.front());
+    double myMinCapacity = std::numeric_limits<double>::max();
+    for (const auto myNext : myCandidate.thePath) {
+      const auto myEdge = boost::edge(myPrev, myNext, theGraph).first;
+      ++theCounters.theEdgeLookups;
+      const auto myCapacity = boost::get(boost::edge_weight, theGraph, myEdge);
+      if (myCapacity < myMinCapacity) {
+        myMinCapacity = myCapacity;
+        myExcludedKey = std::make_pair(myPrev, myNext);
+      }
+      myPrev = myNext;
     }
+    QR_TRACE(2,
+             FlowEdgeRemoved,
+             myExcludedKey.first,
+             myExcludedKey.second,
+             0,
+             myMinCapacity);
+    myExcluded.emplace(myExcludedKey);
   }
 }
 
-void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
-                            const double                aQuantum,
-                            const std::size_t           aK,
-                            const AppCheckFunction&     aCheckFunction) {
+template <class INDEX, class CAPACITY>
+std::vector<typename BasicCapacityNetwork<INDEX, CAPACITY>::VertexDescriptor>
+BasicCapacityNetwork<INDEX, CAPACITY>::hopDistances(
+    const VertexDescriptor aSrc, WorkCounters& aCounters) const {
+  std::vector<VertexDescriptor> ret(boost::num_vertices(theGraph));
+  boost::dijkstra_shortest_paths(
+      theGraph,
+      aSrc,
+      boost::weight_map(
+          boost::make_static_property_map<EdgeDescriptor>(1))
+          .distance_map(boost::make_iterator_property_map(
+              ret.data(), get(boost::vertex_index, theGraph)))
+          .visitor(CountingVisitor(aCounters)));
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::route(
+    std::vector<AppDescriptor>& aApps,
+    const double                aQuantum,
+    const std::size_t           aK,
+    const AppCheckFunction&     aCheckFunction) {
+  route<AppCheckFunction>(aApps, aQuantum, aK, aCheckFunction);
+}
+
+template <class INDEX, class CAPACITY>
+std::vector<double> BasicCapacityNetwork<INDEX, CAPACITY>::checkApps(
+    const std::vector<AppDescriptor>& aApps,
+    const double                      aQuantum,
+    const std::size_t                 aK) const {
   if (aK == 0) {
     throw std::runtime_error("invalid k: cannot be null");
   }
@@ -421,39 +945,34 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
   for (size_t i = 0; i < aApps.size(); i++) {
     myQuanta[i] = aQuantum * aApps[i].thePriority / mySumPriorities;
   }
+  return myQuanta;
+}
 
-  // for each app, find k-shortest paths towards each peer using Yen's
-  // algorithm
-  auto myIndexMap = boost::get(boost::vertex_index, theGraph);
-  for (auto& myApp : aApps) {
-    for (const auto& myPeer : myApp.thePeers) {
-      auto myResult = boost::yen_ksp(
-          theGraph,
-          myApp.theHost,
-          myPeer,
-          boost::make_static_property_map<Graph::edge_descriptor>(1),
-          myIndexMap,
-          aK);
-      for (auto& elem : myResult) {
-        const auto myValid = aCheckFunction(elem.second);
-        VLOG(2) << myApp.theHost << " -> " << myPeer << ": "
-                << (myValid ? "valid" : "invalid") << " path found ["
-                << elem.first << "] {"
-                << ::toString(elem.second,
-                              ",",
-                              [](const auto& aEdge) {
-                                return std::to_string(aEdge.m_target);
-                              })
-                << "}";
-        if (myValid) {
-          auto myRes = myApp.theRemainingPaths.emplace(
-              elem.first, std::list<AppDescriptor::Path>());
-          myRes.first->second.emplace_back(std::move(elem.second));
-        }
-      }
-    }
+template <class INDEX, class CAPACITY>
+std::list<typename BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor::Path>
+BasicCapacityNetwork<INDEX, CAPACITY>::kShortestPaths(
+    const VertexDescriptor aHost,
+    const VertexDescriptor aPeer,
+    const std::size_t      aK,
+    WorkCounters&          aCounters) const {
+  ++aCounters.theKspSearches;
+  auto myResult =
+      boost::yen_ksp(theGraph,
+                     aHost,
+                     aPeer,
+                     boost::make_static_property_map<EdgeDescriptor>(1),
+                     boost::get(boost::vertex_index, theGraph),
+                     aK);
+  std::list<typename AppDescriptor::Path> ret;
+  for (auto& elem : myResult) {
+    ret.emplace_back(std::move(elem.second));
   }
+  return ret;
+}
 
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::allocateApps(
+    std::vector<AppDescriptor>& aApps, const std::vector<double>& aQuanta) {
   // do the allocation using weighted round-robin
   std::list<std::size_t> myActiveApps;
   for (std::size_t i = 0; i < aApps.size(); i++) {
@@ -464,8 +983,8 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
   }
   auto myCurAppIt = myActiveApps.begin();
   while (not myActiveApps.empty()) {
-    auto  myResidualCapacity = myQuanta[*myCurAppIt];
-    auto& myCurApp           = aApps[*myCurAppIt];
+    Capacity myResidualCapacity = aQuanta[*myCurAppIt];
+    auto&    myCurApp           = aApps[*myCurAppIt];
 
     // loop until there are valid paths and capacity to be allocated
     while (not myCurApp.theRemainingPaths.empty() and myResidualCapacity > 0) {
@@ -474,23 +993,20 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
       // select the first of the shortest paths of the current app
       const auto& myCandidate =
           myCurApp.theRemainingPaths.begin()->second.front();
-      VLOG(2) << "host " << myCurApp.theHost << ", path {"
-              << ::toString(myCandidate,
-                            ",",
-                            [](const auto& aEdge) {
-                              return std::to_string(aEdge.m_target);
-                            })
-              << "}";
 
       // check that all the edges still exist and find that with less capacity
-      auto   myValidPath   = true;
-      double myMinCapacity = std::numeric_limits<double>::max();
+      auto     myValidPath   = true;
+      Capacity myMinCapacity = std::numeric_limits<Capacity>::max();
       for (const auto& elem : myCandidate) {
         EdgeDescriptor myEdge;
         bool           myFound;
         std::tie(myEdge, myFound) =
             boost::edge(elem.m_source, elem.m_target, theGraph);
-        if (not myFound) {
+        ++theCounters.theEdgeLookups;
+        if (not myFound or
+            boost::get(boost::edge_weight, theGraph, myEdge) < 0) {
+          // the edge has been removed or its base capacity has been reduced
+          // below the capacity reserved
           myValidPath = false;
           break;
         }
@@ -500,13 +1016,19 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
 
       // remove the path if it is not available anymore
       if (not myValidPath) {
+        QR_TRACE(2,
+                 AppPathExpired,
+                 myCurApp.theHost,
+                 myCandidate.back().m_target,
+                 myCandidate.size(),
+                 0);
         myCurApp.theRemainingPaths.begin()->second.pop_front();
         if (myCurApp.theRemainingPaths.begin()->second.empty()) {
           // no more same-length paths, remove entry from theRemainingPaths
           myCurApp.theRemainingPaths.erase(myCurApp.theRemainingPaths.begin());
           if (myCurApp.theRemainingPaths.empty()) {
             // no more feasible paths at all: remove this app from active set
-            VLOG(2) << "removing app host " << myCurApp.theHost;
+            QR_TRACE(1, AppRemoved, myCurApp.theHost, 0, 0, 0);
             myCurAppIt = myActiveApps.erase(myCurAppIt);
           }
         }
@@ -524,27 +1046,28 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
                myAllocatedGross);
         auto& myWeight = boost::get(boost::edge_weight, theGraph, elem) -=
             myAllocatedGross;
+        const auto mySrc = elem.m_source;
         if (myWeight == 0) {
-          VLOG(2) << "removing edge (" << elem.m_source << "," << elem.m_target
-                  << ")";
+          QR_TRACE(2, AppEdgeRemoved, elem.m_source, elem.m_target, 0, 0);
           boost::remove_edge(elem, theGraph);
+          updateNodeCapacity(mySrc);
+        } else {
+          updateNodeCapacity(mySrc, -myAllocatedGross);
         }
       }
 
       // add the allocation to the path
-      AppDescriptor::Output myOutput(myCandidate);
-      VLOG(2) << "allocated gross capacity " << myAllocatedGross
-              << " EPR-pairs/s for host " << myCurApp.theHost << " towards "
-              << myOutput.theHops.back() << " along path {"
-              << ::toString(
-                     myOutput.theHops,
-                     ",",
-                     [](const auto& aHop) { return std::to_string(aHop); })
-              << "}, residual capacity " << myResidualCapacity;
+      typename AppDescriptor::Output myOutput(myCandidate);
       assert(not myOutput.theHops.empty());
+      QR_TRACE(2,
+               AppAllocated,
+               myCurApp.theHost,
+               myOutput.theHops.back(),
+               myOutput.theHops.size(),
+               myAllocatedGross);
       auto it = myCurApp.theAllocated.emplace(
           myOutput.theHops.back(),
-          std::vector<AppDescriptor::Output>({myOutput}));
+          std::vector<typename AppDescriptor::Output>({myOutput}));
 
       for (auto& elem : it.first->second) {
         if (elem.theHops == myOutput.theHops) {
@@ -562,29 +1085,302 @@ void CapacityNetwork::route(std::vector<AppDescriptor>& aApps,
   }
 }
 
-void CapacityNetwork::addCapacityToPath(
-    const VertexDescriptor               aSrc,
-    const std::vector<VertexDescriptor>& aPath,
-    const double                         aCapacity) {
-  removeCapacityFromPath(aSrc, aPath, -aCapacity, theGraph);
+template <class INDEX, class CAPACITY>
+std::future<typename BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor>
+BasicCapacityNetwork<INDEX, CAPACITY>::submit(
+    const FlowDescriptor& aFlow, const FlowCheckFunction& aCheckFunction) {
+  return executor().submit(
+      [this,
+       myFlow = FlowDescriptor(aFlow.theSrc, aFlow.theDst, aFlow.theNetRate),
+       aCheckFunction]() {
+        std::vector<FlowDescriptor> myFlows({myFlow});
+        route(myFlows, aCheckFunction);
+        return myFlows.front();
+      });
 }
 
-std::vector<double> CapacityNetwork::nodeCapacities() const {
-  std::vector<double> ret(boost::num_vertices(theGraph), 0);
-  for (const auto& myNode :
-       boost::make_iterator_range(boost::vertices(theGraph))) {
-    double myCapacity = 0;
+template <class INDEX, class CAPACITY>
+std::future<
+    std::vector<typename BasicCapacityNetwork<INDEX, CAPACITY>::AppDescriptor>>
+BasicCapacityNetwork<INDEX, CAPACITY>::submit(
+    std::vector<AppDescriptor>&& aApps,
+    const double                 aQuantum,
+    const std::size_t            aK,
+    const AppCheckFunction&      aCheckFunction) {
+  return executor().submit([this,
+                            myApps = std::move(aApps),
+                            aQuantum,
+                            aK,
+                            aCheckFunction]() mutable {
+    route(myApps, aQuantum, aK, aCheckFunction);
+    return std::move(myApps);
+  });
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::drain() {
+  executor().wait();
+}
+
+template <class INDEX, class CAPACITY>
+SerialExecutor& BasicCapacityNetwork<INDEX, CAPACITY>::executor() {
+  std::call_once(theExecutorFlag, [this]() {
+    theExecutor = std::make_unique<SerialExecutor>();
+  });
+  return *theExecutor;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::recordAdmission(
+    const FlowDescriptor&                       aFlow,
+    const std::chrono::steady_clock::time_point aStart) {
+  assert(theLatencies.get() != nullptr);
+  theLatencies->record(DecisionLatencies::Decision::Admission,
+                       theLatencyClassFunction(aFlow),
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - aStart)
+                           .count());
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::addCapacityToPath(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    const Capacity            aCapacity) {
+  if (theLatencies.get() == nullptr) {
+    removeCapacityFromPath(aSrc, aPath, -aCapacity);
+    return;
+  }
+
+  const auto myStart = std::chrono::steady_clock::now();
+  removeCapacityFromPath(aSrc, aPath, -aCapacity);
+  const auto myElapsed = std::chrono::steady_clock::now() - myStart;
+
+  FlowDescriptor myFlow(aSrc,
+                        aPath.empty() ? aSrc : aPath.back(),
+                        toNetRate(aCapacity, aPath.size()));
+  myFlow.thePath      = aPath;
+  myFlow.theGrossRate = aCapacity;
+  theLatencies->record(
+      DecisionLatencies::Decision::Release,
+      theLatencyClassFunction(myFlow),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(myElapsed).count());
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::WeightVector
+BasicCapacityNetwork<INDEX, CAPACITY>::applyTopologyDeltas(
+    const std::vector<TopologyDelta>& aDeltas) {
+  // validate all the changes before applying any of them
+  const auto                         V = boost::num_vertices(theGraph);
+  std::set<typename BaseCapacities::key_type> myChanged;
+  for (const auto& myDelta : aDeltas) {
+    if (myDelta.theSrc >= V or myDelta.theDst >= V or
+        myDelta.theSrc == myDelta.theDst) {
+      throw std::runtime_error("invalid edge in topology change: " +
+                               myDelta.toString());
+    }
+    if (myDelta.theType != TopologyDelta::Type::RemoveEdge and
+        not(myDelta.theCapacity >= 0)) {
+      throw std::runtime_error(
+          "invalid negative capacity in topology change: " +
+          myDelta.toString());
+    }
+    const auto myKey = std::make_pair(myDelta.theSrc, myDelta.theDst);
+    if (not myChanged.emplace(myKey).second) {
+      throw std::runtime_error("edge changed multiple times: " +
+                               myDelta.toString());
+    }
+    const auto myExisting = theBaseCapacities.count(myKey) > 0;
+    if (myDelta.theType == TopologyDelta::Type::AddEdge and myExisting) {
+      throw std::runtime_error("edge already existing in topology change: " +
+                               myDelta.toString());
+    }
+    if (myDelta.theType != TopologyDelta::Type::AddEdge and not myExisting) {
+      throw std::runtime_error("edge not existing in topology change: " +
+                               myDelta.toString());
+    }
+  }
+
+  WeightVector ret;
+  auto         myWeights = boost::get(boost::edge_weight, theGraph);
+  for (const auto& myDelta : aDeltas) {
+    const auto myKey = std::make_pair(myDelta.theSrc, myDelta.theDst);
+
+    if (myDelta.theType == TopologyDelta::Type::AddEdge) {
+      addEdge(myDelta.theSrc, myDelta.theDst, myDelta.theCapacity);
+      theBaseCapacities.emplace(myKey, myDelta.theCapacity);
+      updateNodeCapacity(myDelta.theSrc, myDelta.theCapacity);
+      continue;
+    }
+
+    // the edge may be missing from the graph if its capacity has been
+    // exhausted by elastic applications
+    EdgeDescriptor myEdge;
+    auto           myFound = false;
+    std::tie(myEdge, myFound) =
+        boost::edge(myDelta.theSrc, myDelta.theDst, theGraph);
+    ++theCounters.theEdgeLookups;
+    const auto myBase     = theBaseCapacities.find(myKey);
+    const auto myResidual = myFound ? myWeights[myEdge] : Capacity(0);
+
+    if (myDelta.theType == TopologyDelta::Type::RemoveEdge) {
+      const auto myReserved = myBase->second - myResidual;
+      if (myReserved > 0) {
+        ret.emplace_back(myDelta.theSrc, myDelta.theDst, myReserved);
+      }
+      if (myFound) {
+        boost::remove_edge(myEdge, theGraph);
+      }
+      theBaseCapacities.erase(myBase);
+      theLinkQualities.erase(myKey);
+      updateNodeCapacity(myDelta.theSrc);
+
+    } else {
+      assert(myDelta.theType == TopologyDelta::Type::SetCapacity);
+      const auto myNewResidual =
+          myResidual + myDelta.theCapacity - myBase->second;
+      if (myNewResidual < 0) {
+        ret.emplace_back(myDelta.theSrc, myDelta.theDst, -myNewResidual);
+      }
+      if (myFound) {
+        myWeights[myEdge] = myNewResidual;
+      } else if (myNewResidual != 0) {
+        addEdge(myDelta.theSrc, myDelta.theDst, myNewResidual);
+      }
+      myBase->second = myDelta.theCapacity;
+      updateNodeCapacity(myDelta.theSrc, myNewResidual - myResidual);
+    }
+  }
+
+  VLOG(1) << aDeltas.size() << " topology changes applied, " << ret.size()
+          << " edges overbooked";
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::WeightVector
+BasicCapacityNetwork<INDEX, CAPACITY>::applyCapacityDeltas(
+    const WeightVector& aDeltas) {
+  // sort the changes by edge and merge those of the same edge, while
+  // checking that they are valid before applying any of them
+  std::vector<std::size_t> myOrder(aDeltas.size());
+  std::iota(myOrder.begin(), myOrder.end(), 0);
+  std::stable_sort(myOrder.begin(),
+                   myOrder.end(),
+                   [&aDeltas](const auto lhs, const auto rhs) {
+                     return std::tie(std::get<0>(aDeltas[lhs]),
+                                     std::get<1>(aDeltas[lhs])) <
+                            std::tie(std::get<0>(aDeltas[rhs]),
+                                     std::get<1>(aDeltas[rhs]));
+                   });
+  std::vector<std::pair<typename BaseCapacities::iterator, Capacity>> myChanges;
+  myChanges.reserve(aDeltas.size());
+  for (const auto i : myOrder) {
+    const auto myKey =
+        std::make_pair(std::get<0>(aDeltas[i]), std::get<1>(aDeltas[i]));
+    if (not myChanges.empty() and myChanges.back().first->first == myKey) {
+      myChanges.back().second += std::get<2>(aDeltas[i]);
+      continue;
+    }
+    const auto it = theBaseCapacities.find(myKey);
+    if (it == theBaseCapacities.end()) {
+      throw std::runtime_error("edge not existing in capacity change: (" +
+                               std::to_string(myKey.first) + "," +
+                               std::to_string(myKey.second) + ")");
+    }
+    myChanges.emplace_back(it, std::get<2>(aDeltas[i]));
+  }
+  for (const auto& myChange : myChanges) {
+    if (not(myChange.first->second + myChange.second >= 0)) {
+      throw std::runtime_error(
+          "invalid negative capacity in capacity change: (" +
+          std::to_string(myChange.first->first.first) + "," +
+          std::to_string(myChange.first->first.second) + ") to " +
+          std::to_string(myChange.first->second + myChange.second));
+    }
+  }
+
+  // apply the changes of the edges with the same source node at once
+  WeightVector          ret;
+  auto                  myWeights = boost::get(boost::edge_weight, theGraph);
+  std::vector<Capacity> myResiduals;
+  std::vector<bool>     myFound;
+  for (std::size_t i = 0; i < myChanges.size();) {
+    const auto mySrc = myChanges[i].first->first.first;
+    auto       j     = i + 1;
+    while (j < myChanges.size() and myChanges[j].first->first.first == mySrc) {
+      ++j;
+    }
+
+    // the changes in [i, j) are sorted by destination node
+    const auto myDst = [](const auto& aChange) {
+      return aChange.first->first.second;
+    };
+    Capacity myNodeDelta = 0;
+    myResiduals.assign(j - i, 0);
+    myFound.assign(j - i, false);
     for (const auto& myEdge :
-         boost::make_iterator_range(boost::out_edges(myNode, theGraph))) {
-      myCapacity += boost::get(boost::edge_weight, theGraph, myEdge);
+         boost::make_iterator_range(boost::out_edges(mySrc, theGraph))) {
+      const auto myTarget = boost::target(myEdge, theGraph);
+      const auto it       = std::lower_bound(
+          myChanges.begin() + i,
+          myChanges.begin() + j,
+          myTarget,
+          [&myDst](const auto& aChange, const auto aTarget) {
+            return myDst(aChange) < aTarget;
+          });
+      const auto k = static_cast<std::size_t>(it - myChanges.begin()) - i;
+      if (i + k == j or myDst(*it) != myTarget or myFound[k]) {
+        continue;
+      }
+      ++theCounters.theEdgeLookups;
+      myFound[k]     = true;
+      myResiduals[k] = myWeights[myEdge] += it->second;
+    }
+
+    for (auto k = i; k < j; k++) {
+      auto myResidual = myResiduals[k - i];
+      if (not myFound[k - i]) {
+        // the edge is missing from the graph if its capacity has been
+        // exhausted by elastic applications
+        myResidual = myChanges[k].second;
+        if (myResidual != 0) {
+          addEdge(mySrc, myDst(myChanges[k]), myResidual);
+        }
+      }
+      myChanges[k].first->second += myChanges[k].second;
+      myNodeDelta += myChanges[k].second;
+      if (myResidual < 0) {
+        ret.emplace_back(mySrc, myDst(myChanges[k]), -myResidual);
+      }
     }
-    assert(myNode < ret.size());
-    ret[myNode] = myCapacity;
+    updateNodeCapacity(mySrc, myNodeDelta);
+    i = j;
   }
+
+  VLOG(1) << aDeltas.size() << " capacity changes applied to "
+          << myChanges.size() << " edges, " << ret.size()
+          << " edges overbooked";
   return ret;
 }
 
-void CapacityNetwork::toGnuplot(
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::latencies(
+    const std::shared_ptr<DecisionLatencies>& aLatencies,
+    const LatencyClassFunction&               aClassFunction) {
+  theLatencies            = aLatencies;
+  theLatencyClassFunction = aClassFunction;
+}
+
+template <class INDEX, class CAPACITY>
+std::vector<CAPACITY>
+BasicCapacityNetwork<INDEX, CAPACITY>::nodeCapacities() const {
+  return theNodeCapacities;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::toGnuplot(
     const std::string&             aFilename,
     const std::vector<Coordinate>& aCoordinates) const {
   if (boost::num_vertices(theGraph) == 0 or aFilename.empty()) {
@@ -619,10 +1415,13 @@ void CapacityNetwork::toGnuplot(
   }
 }
 
-bool CapacityNetwork::checkCapacity(const VertexDescriptor               aSrc,
-                                    const std::vector<VertexDescriptor>& aPath,
-                                    const double aCapacity,
-                                    const Graph& aGraph) {
+template <class INDEX, class CAPACITY>
+bool BasicCapacityNetwork<INDEX, CAPACITY>::checkCapacity(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    const Capacity            aCapacity,
+    const Graph&              aGraph,
+    WorkCounters&             aCounters) const {
   auto mySrc = aSrc;
   for (std::size_t i = 0; i < aPath.size(); i++) {
     auto myDst = aPath[i];
@@ -630,6 +1429,7 @@ bool CapacityNetwork::checkCapacity(const VertexDescriptor               aSrc,
     EdgeDescriptor        myEdge;
     [[maybe_unused]] auto myFound = false;
     std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, aGraph);
+    ++aCounters.theEdgeLookups;
     assert(myFound);
     if (boost::get(boost::edge_weight, aGraph, myEdge) < aCapacity) {
       return false;
@@ -641,10 +1441,12 @@ bool CapacityNetwork::checkCapacity(const VertexDescriptor               aSrc,
   return true;
 }
 
-void CapacityNetwork::removeSmallestCapacityEdge(
-    const VertexDescriptor               aSrc,
-    const std::vector<VertexDescriptor>& aPath,
-    Graph&                               aGraph) {
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::removeSmallestCapacityEdge(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    Graph&                    aGraph,
+    WorkCounters&             aCounters) const {
   auto           mySrc = aSrc;
   EdgeDescriptor mySmallestCapacityEdge;
   double         mySmallestCapacity = std::numeric_limits<double>::max();
@@ -654,6 +1456,7 @@ void CapacityNetwork::removeSmallestCapacityEdge(
     EdgeDescriptor        myEdge;
     [[maybe_unused]] auto myFound = false;
     std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, aGraph);
+    ++aCounters.theEdgeLookups;
     assert(myFound);
     const auto myCapacity = boost::get(boost::edge_weight, aGraph, myEdge);
     if (myCapacity < mySmallestCapacity) {
@@ -664,70 +1467,329 @@ void CapacityNetwork::removeSmallestCapacityEdge(
     // move to the next edge
     mySrc = myDst;
   }
+  QR_TRACE(2,
+           FlowEdgeRemoved,
+           mySmallestCapacityEdge.m_source,
+           mySmallestCapacityEdge.m_target,
+           0,
+           mySmallestCapacity);
   boost::remove_edge(mySmallestCapacityEdge, aGraph);
 }
 
-void CapacityNetwork::removeCapacityFromPath(
-    const VertexDescriptor               aSrc,
-    const std::vector<VertexDescriptor>& aPath,
-    const double                         aCapacity,
-    Graph&                               aGraph) {
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::removeCapacityFromPath(
+    const VertexDescriptor    aSrc,
+    const std::vector<Index>& aPath,
+    const Capacity            aCapacity) {
   auto mySrc     = aSrc;
-  auto myWeights = boost::get(boost::edge_weight, aGraph);
+  auto myWeights = boost::get(boost::edge_weight, theGraph);
   for (std::size_t i = 0; i < aPath.size(); i++) {
     auto myDst = aPath[i];
 
     EdgeDescriptor        myEdge;
     [[maybe_unused]] auto myFound = false;
-    std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, aGraph);
+    std::tie(myEdge, myFound)     = boost::edge(mySrc, myDst, theGraph);
+    ++theCounters.theEdgeLookups;
     if (not myFound) {
       throw std::runtime_error("edge not in the graph: " + toString(myEdge));
     }
-    if (myWeights[myEdge] < aCapacity) {
+    if (aCapacity > 0 and myWeights[myEdge] < aCapacity) {
       throw std::runtime_error(
           "cannot remove capacity " + std::to_string(aCapacity) + " > " +
           std::to_string(myWeights[myEdge]) + " for edge " + toString(myEdge));
     }
     myWeights[myEdge] -= aCapacity;
+    updateNodeCapacity(mySrc, -aCapacity);
 
     // move to the next edge
     mySrc = myDst;
   }
 }
 
-std::pair<std::size_t, std::size_t> CapacityNetwork::minMaxVertexProp(
-    const std::function<std::size_t(Graph::vertex_descriptor, const Graph&)>&
-        aPropFunctor) const {
-  auto        myRange = boost::vertices(theGraph);
-  std::size_t myMin   = std::numeric_limits<std::size_t>::max();
-  std::size_t myMax   = 0;
-  for (auto it = myRange.first; it != myRange.second; ++it) {
-    const auto myCur = aPropFunctor(*it, theGraph);
-    if (myCur < myMin) {
-      myMin = myCur;
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::findConstrainedPath(
+    FlowDescriptor&   aFlow,
+    const double      aMinFidelity,
+    const std::size_t aMaxLabels,
+    LabelWorkspace&   aWorkspace) {
+  static constexpr auto NONE = std::numeric_limits<std::size_t>::max();
+  // slack on the constraints of partial paths, which are checked on costs
+  // accumulated in the log domain, while the exact values are checked on
+  // the complete paths
+  static constexpr double EPSILON = 1e-9;
+
+  static constexpr auto INF = std::numeric_limits<double>::infinity();
+
+  const auto V         = boost::num_vertices(theGraph);
+  auto&      myLabels  = aWorkspace.theLabels;
+  auto&      myFronts  = aWorkspace.theFronts;
+  auto&      mySettled = aWorkspace.theSettled;
+  myLabels.clear();
+  myFronts.resize(V);
+  for (auto& myFront : myFronts) {
+    myFront.clear();
+  }
+  mySettled.assign(V, false);
+
+  // the first edge of a path has no swap at its source
+  const auto mySrc              = aFlow.theSrc;
+  const auto mySwapFidelityCost = -std::log(theSwapReliability.base());
+  const auto myMaxFidelityCost =
+      aMinFidelity <= 0.25 ? INF : -std::log((aMinFidelity - 0.25) / 0.75);
+
+  // lower bounds of the costs to reach the destination from every vertex
+  // after the source, on the edges with capacity not smaller than the net
+  // rate, which are infinite if the destination is not reachable
+  const auto myReverse = boost::make_reverse_graph(theGraph);
+  using ReverseEdge =
+      typename boost::graph_traits<decltype(myReverse)>::edge_descriptor;
+  const auto myBound = [&](std::vector<double>& aBounds, auto&& aCost) {
+    aBounds.resize(V);
+    aFlow.theDijsktra++;
+    boost::dijkstra_shortest_paths(
+        myReverse,
+        aFlow.theDst,
+        boost::weight_map(
+            boost::make_function_property_map<ReverseEdge, double>(
+                [&](const ReverseEdge& aEdge) {
+                  return boost::get(boost::edge_weight, myReverse, aEdge) <
+                                 aFlow.theNetRate ?
+                             INF :
+                             aCost(myReverse[aEdge]);
+                }))
+            .distance_map(boost::make_iterator_property_map(
+                aBounds.data(), get(boost::vertex_index, theGraph)))
+            .distance_inf(INF)
+            .visitor(CountingVisitor(theCounters)));
+  };
+  auto& myHopBounds      = aWorkspace.theHopBounds;
+  auto& mySwapBounds     = aWorkspace.theSwapBounds;
+  auto& myFidelityBounds = aWorkspace.theFidelityBounds;
+  myBound(myHopBounds, [](const LinkCosts&) { return 1.0; });
+  myBound(mySwapBounds,
+          [](const LinkCosts& aCosts) { return aCosts.theSwapCost; });
+  myBound(myFidelityBounds, [mySwapFidelityCost](const LinkCosts& aCosts) {
+    return aCosts.theFidelityCost + mySwapFidelityCost;
+  });
+
+  // labels are extracted by increasing lower bound of the number of hops of
+  // the complete path, then swap cost
+  using Entry = std::tuple<double, double, std::size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> myQueue;
+
+  const auto myDominates = [](const Label& aLhs, const Label& aRhs) {
+    return aLhs.theHops <= aRhs.theHops and
+           aLhs.theSwapCost <= aRhs.theSwapCost and
+           aLhs.theFidelityCost <= aRhs.theFidelityCost and
+           aLhs.theCapacity >= aRhs.theCapacity;
+  };
+  // set when the maximum number of labels is exceeded
+  auto       myCapped = false;
+  const auto myInsert = [&](const Label& aLabel) {
+    if (myLabels.size() >= aMaxLabels) {
+      myCapped = true;
+      return;
+    }
+    auto& myFront = myFronts[aLabel.theVertex];
+    for (const auto myIndex : myFront) {
+      if (myDominates(myLabels[myIndex], aLabel)) {
+        return;
+      }
+    }
+    myFront.erase(std::remove_if(myFront.begin(),
+                                 myFront.end(),
+                                 [&](const std::size_t aIndex) {
+                                   auto& myOther = myLabels[aIndex];
+                                   myOther.theDominated =
+                                       myDominates(aLabel, myOther);
+                                   return myOther.theDominated;
+                                 }),
+                  myFront.end());
+    myFront.emplace_back(myLabels.size());
+    myQueue.emplace(aLabel.theHops + myHopBounds[aLabel.theVertex],
+                    aLabel.theSwapCost,
+                    myLabels.size());
+    myLabels.emplace_back(aLabel);
+  };
+
+  aFlow.theDijsktra++;
+  myInsert(Label{mySrc,
+                 NONE,
+                 0,
+                 0,
+                 0,
+                 std::numeric_limits<Capacity>::infinity(),
+                 false});
+
+  while (not myQueue.empty() and not myCapped) {
+    const auto myIndex = std::get<2>(myQueue.top());
+    myQueue.pop();
+    if (myLabels[myIndex].theDominated) {
+      continue;
+    }
+    ++theCounters.theLabelsExpanded;
+    if (not mySettled[myLabels[myIndex].theVertex]) {
+      mySettled[myLabels[myIndex].theVertex] = true;
+      ++theCounters.theVerticesSettled;
+    }
+
+    // copy, since new labels may be added to the workspace
+    const auto myLabel = myLabels[myIndex];
+
+    if (myLabel.theVertex == aFlow.theDst) {
+      FlowDescriptor myCandidate(aFlow);
+      for (auto i = myIndex; myLabels[i].theParent != NONE;
+           i      = myLabels[i].theParent) {
+        myCandidate.thePath.emplace_back(myLabels[i].theVertex);
+      }
+      std::reverse(myCandidate.thePath.begin(), myCandidate.thePath.end());
+      myCandidate.theGrossRate =
+          myCandidate.theNetRate /
+          pathSwapSuccess(mySrc, myCandidate.thePath, theCounters);
+      QR_TRACE(2,
+               FlowCandidate,
+               myCandidate.theSrc,
+               myCandidate.theDst,
+               myCandidate.thePath.size(),
+               myCandidate.theGrossRate);
+
+      if (pathFidelity(mySrc, myCandidate.thePath, theCounters) >=
+              aMinFidelity and
+          checkCapacity(myCandidate.theSrc,
+                        myCandidate.thePath,
+                        myCandidate.theGrossRate,
+                        theGraph,
+                        theCounters)) {
+        aFlow.movePathRateFrom(myCandidate);
+        return;
+      }
+      continue;
     }
-    if (myCur > myMax) {
-      myMax = myCur;
+
+    const auto myFirst = myLabel.theParent == NONE;
+    for (const auto& myEdge : boost::make_iterator_range(
+             boost::out_edges(myLabel.theVertex, theGraph))) {
+      ++theCounters.theEdgesScanned;
+      const auto myCapacity = boost::get(boost::edge_weight, theGraph, myEdge);
+      if (myCapacity < aFlow.theNetRate) {
+        continue;
+      }
+      const auto& myCosts = theGraph[myEdge];
+      const Label myNext{
+          boost::target(myEdge, theGraph),
+          myIndex,
+          myLabel.theHops + 1,
+          myLabel.theSwapCost + (myFirst ? 0.0 : myCosts.theSwapCost),
+          myLabel.theFidelityCost + myCosts.theFidelityCost +
+              (myFirst ? 0.0 : mySwapFidelityCost),
+          std::min(myLabel.theCapacity, myCapacity),
+          false};
+
+      // the costs only increase and the capacity only decreases when a path
+      // is extended, hence the constraints are checked on the partial path
+      // plus the lower bound of the costs of the rest of the path
+      const auto myVertex = myNext.theVertex;
+      if (myNext.theFidelityCost + myFidelityBounds[myVertex] >
+              myMaxFidelityCost + EPSILON or
+          myNext.theCapacity <
+              aFlow.theNetRate *
+                  std::exp(myNext.theSwapCost + mySwapBounds[myVertex]) *
+                  (1 - EPSILON)) {
+        continue;
+      }
+      myInsert(myNext);
+    }
+  }
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::addEdge(
+    const VertexDescriptor aSrc,
+    const VertexDescriptor aDst,
+    const Capacity         aWeight) {
+  updateLinkCosts(Utils<Graph>::addEdge(theGraph, aSrc, aDst, aWeight));
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::updateLinkCosts(
+    const EdgeDescriptor& aEdge) {
+  const auto it = theLinkQualities.find(
+      {boost::source(aEdge, theGraph), boost::target(aEdge, theGraph)});
+  auto& myCosts = theGraph[aEdge];
+  if (it == theLinkQualities.end()) {
+    myCosts.theFidelityFactor = 1;
+    myCosts.theSwapSuccess    = theMeasurementProbability;
+  } else {
+    myCosts.theFidelityFactor = (4 * it->second.theFidelity - 1) / 3.0;
+    myCosts.theSwapSuccess    = it->second.theSwapSuccess;
+  }
+  myCosts.theFidelityCost = -std::log(myCosts.theFidelityFactor);
+  myCosts.theSwapCost     = -std::log(myCosts.theSwapSuccess);
+}
+
+template <class INDEX, class CAPACITY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::LinkCosts
+BasicCapacityNetwork<INDEX, CAPACITY>::linkCosts(
+    const Index aSrc, const Index aDst, WorkCounters& aCounters) const {
+  if (aSrc < numNodes() and aDst < numNodes()) {
+    EdgeDescriptor myEdge;
+    auto           myFound = false;
+    std::tie(myEdge, myFound) = boost::edge(aSrc, aDst, theGraph);
+    ++aCounters.theEdgeLookups;
+    if (myFound) {
+      return theGraph[myEdge];
     }
   }
-  return {myMin, myMax};
+  const auto myQuality = linkQuality(aSrc, aDst);
+  LinkCosts  ret;
+  ret.theFidelityFactor = (4 * myQuality.theFidelity - 1) / 3.0;
+  ret.theSwapSuccess    = myQuality.theSwapSuccess;
+  ret.theFidelityCost   = -std::log(ret.theFidelityFactor);
+  ret.theSwapCost       = -std::log(ret.theSwapSuccess);
+  return ret;
 }
 
-double CapacityNetwork::toGrossRate(const double      aNetRate,
-                                    const std::size_t aNumEdges) const {
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::updateNodeCapacity(
+    const VertexDescriptor aNode) {
+  // the capacity is recomputed rather than updated with the difference, which
+  // also discards the rounding errors accumulated by the updates
+  Capacity myCapacity = 0;
+  for (const auto& myEdge :
+       boost::make_iterator_range(boost::out_edges(aNode, theGraph))) {
+    myCapacity += boost::get(boost::edge_weight, theGraph, myEdge);
+  }
+  assert(aNode < theNodeCapacities.size());
+  theNodeCapacities[aNode] = myCapacity;
+}
+
+template <class INDEX, class CAPACITY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::updateNodeCapacity(
+    const VertexDescriptor aNode, const Capacity aDelta) {
+  assert(aNode < theNodeCapacities.size());
+  theNodeCapacities[aNode] += aDelta;
+}
+
+template <class INDEX, class CAPACITY>
+CAPACITY BasicCapacityNetwork<INDEX, CAPACITY>::toGrossRate(
+    const Capacity aNetRate, const std::size_t aNumEdges) const {
   if (aNumEdges <= 1) {
     return aNetRate;
   }
-  return aNetRate / std::pow(theMeasurementProbability, aNumEdges - 1);
+  return aNetRate / theSwapSuccess(aNumEdges - 1);
 }
 
-double CapacityNetwork::toNetRate(const double      aGrossRate,
-                                  const std::size_t aNumEdges) const {
+template <class INDEX, class CAPACITY>
+CAPACITY BasicCapacityNetwork<INDEX, CAPACITY>::toNetRate(
+    const Capacity aGrossRate, const std::size_t aNumEdges) const {
   if (aNumEdges <= 1) {
     return aGrossRate;
   }
-  return aGrossRate * std::pow(theMeasurementProbability, aNumEdges - 1);
+  return aGrossRate * theSwapSuccess(aNumEdges - 1);
 }
 
+template class BasicCapacityNetwork<unsigned long, double>;
+template class BasicCapacityNetwork<std::uint32_t, float>;
+
 } // namespace qr
 } // namespace uiiit
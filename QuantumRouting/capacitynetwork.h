@@ -31,8 +31,11 @@ SOFTWARE.
 
 #pragma once
 
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/memoryaccounting.h"
 #include "QuantumRouting/network.h"
 #include "QuantumRouting/qrutils.h"
+#include "QuantumRouting/trace.h"
 #include "Support/random.h"
 
 #include <boost/graph/adjacency_list.hpp>
@@ -42,18 +45,44 @@ SOFTWARE.
 #include <boost/graph/properties.hpp>
 #include <boost/property_map/property_map.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <functional>
+#include <future>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace uiiit {
 namespace qr {
 
+class DecisionLatencies;
+class SerialExecutor;
+
+namespace detail {
+
+//! True if T has a member function maxHops() const returning a number.
+template <class T, class = void>
+struct HasMaxHops : std::false_type {};
+
+template <class T>
+struct HasMaxHops<
+    T,
+    std::void_t<decltype(std::size_t(std::declval<const T&>().maxHops()))>>
+    : std::true_type {};
+
+} // namespace detail
+
 /**
  * @brief A quantum network where edges are characterized by their capacity
  * only, in terms of EPR pairs that can be generated by per second.
@@ -70,85 +99,245 @@ namespace qr {
  * - apps: they are characterized by a host node and a number of peers, as well
  * as a numeric priority; they represent elastic applications, e.g., for
  * distributed quantum computing
+ *
+ * The identifiers of the vertices and the capacities, including the rates of
+ * the flows and apps, have the given types in the edges and descriptors,
+ * which can be made smaller than the defaults of CapacityNetwork to reduce
+ * the memory footprint with very large topologies. The probabilities,
+ * fidelities, and costs are always double. Only the instantiations declared
+ * below are available.
+ *
+ * @tparam INDEX the type of the vertex identifiers, an unsigned integer
+ * @tparam CAPACITY the type of the capacities, a floating point number
  */
-class CapacityNetwork final : public Network
+template <class INDEX, class CAPACITY>
+class BasicCapacityNetwork final : public Network
 {
+  static_assert(std::is_integral_v<INDEX> and std::is_unsigned_v<INDEX>,
+                "vertex identifiers must be unsigned integers");
+  static_assert(std::is_floating_point_v<CAPACITY>,
+                "capacities must be floating point numbers");
+
  public:
-  using Graph =
-      boost::adjacency_list<boost::listS,
-                            boost::vecS,
-                            boost::bidirectionalS,
-                            boost::no_property,
-                            boost::property<boost::edge_weight_t, double>,
-                            boost::no_property,
-                            boost::listS>;
-  using VertexDescriptor = boost::graph_traits<Graph>::vertex_descriptor;
-  using EdgeDescriptor   = boost::graph_traits<Graph>::edge_descriptor;
+  using Index    = INDEX;    //!< type of the vertex identifiers
+  using Capacity = CAPACITY; //!< type of the capacities and rates
+
+  /**
+   * @brief Costs of an edge derived from its LinkQuality, stored in the graph:
+   * the additive costs in the log domain for the weighted routing of flows,
+   * and the multiplicative factors for the metrics of paths.
+   */
+  struct LinkCosts {
+    double theFidelityCost   = 0; //!< -log((4F - 1) / 3)
+    double theSwapCost       = 0; //!< -log(swap success probability)
+    double theFidelityFactor = 1; //!< (4F - 1) / 3
+    double theSwapSuccess    = 1; //!< swap success probability
+  };
+
+  using Graph = boost::adjacency_list<
+      boost::listS,
+      boost::vecS,
+      boost::bidirectionalS,
+      boost::no_property,
+      boost::property<boost::edge_weight_t, Capacity, LinkCosts>,
+      boost::no_property,
+      boost::listS>;
+  using VertexDescriptor =
+      typename boost::graph_traits<Graph>::vertex_descriptor;
+  using EdgeDescriptor = typename boost::graph_traits<Graph>::edge_descriptor;
 
   struct FlowDescriptor {
-    FlowDescriptor(const unsigned long aSrc,
-                   const unsigned long aDst,
-                   const double        aNetRate) noexcept;
+    FlowDescriptor(const Index    aSrc,
+                   const Index    aDst,
+                   const Capacity aNetRate) noexcept;
 
     void movePathRateFrom(FlowDescriptor& aAnother);
 
     // input
-    const unsigned long theSrc;     //!< the source vertex
-    const unsigned long theDst;     //!< the destination vertex
-    const double        theNetRate; //!< in EPR/s
+    const Index    theSrc;     //!< the source vertex
+    const Index    theDst;     //!< the destination vertex
+    const Capacity theNetRate; //!< in EPR/s
 
     // output
-    std::vector<unsigned long> thePath;      //!< hops not including src
-    double                     theGrossRate; //!< in EPR/s
-    std::size_t                theDijsktra;  //!< number of times called
+    std::vector<Index> thePath;      //!< hops not including src
+    Capacity           theGrossRate; //!< in EPR/s
+    std::size_t        theDijsktra;  //!< number of times called
 
     std::string toString() const;
   };
 
   struct AppDescriptor {
     using Path = std::list<EdgeDescriptor>;
-    using Hops = std::vector<unsigned long>;
+    using Hops = std::vector<Index>;
 
-    AppDescriptor(const unsigned long               aHost,
-                  const std::vector<unsigned long>& aPeers,
-                  const double                      aPriority) noexcept;
+    AppDescriptor(const Index               aHost,
+                  const std::vector<Index>& aPeers,
+                  const double              aPriority) noexcept;
 
     // input
-    const unsigned long theHost; //!< the vertex that hosts the computation
-    const std::vector<unsigned long>
-                 thePeers;    //!< the possible entanglement peers
-    const double thePriority; //! weight
+    const Index theHost; //!< the vertex that hosts the computation
+    const std::vector<Index> thePeers;    //!< the possible entanglement peers
+    const double             thePriority; //! weight
 
     // working variables
-    std::map<unsigned long, std::list<Path>> theRemainingPaths;
+    std::map<Index, std::list<Path>> theRemainingPaths;
 
     // output
     struct Output {
       explicit Output(const Path& aPath);
 
-      Hops   theHops;
-      double theNetRate   = 0; //!< in EPR-pairs/s
-      double theGrossRate = 0; //!< in EPR-pairs/s
+      Hops     theHops;
+      Capacity theNetRate   = 0; //!< in EPR-pairs/s
+      Capacity theGrossRate = 0; //!< in EPR-pairs/s
     };
-    std::map<unsigned long, std::vector<Output>>
-                theAllocated; //!< key: destination
-    std::size_t theVisits;    //!< number of visits
+    std::map<Index, std::vector<Output>> theAllocated; //!< key: destination
+    std::size_t                          theVisits;    //!< number of visits
 
-    double      netRate() const;
-    double      grossRate() const;
+    Capacity    netRate() const;
+    Capacity    grossRate() const;
     std::string toString() const;
   };
 
+  //! Change of the topology or of the base capacity of an edge.
+  struct TopologyDelta {
+    enum class Type {
+      AddEdge     = 0, //!< add a new edge with given base capacity
+      RemoveEdge  = 1, //!< remove an existing edge
+      SetCapacity = 2, //!< change the base capacity of an existing edge
+    };
+
+    static TopologyDelta addEdge(const Index    aSrc,
+                                 const Index    aDst,
+                                 const Capacity aCapacity);
+    static TopologyDelta removeEdge(const Index aSrc, const Index aDst);
+    static TopologyDelta setCapacity(const Index    aSrc,
+                                     const Index    aDst,
+                                     const Capacity aCapacity);
+
+    Type     theType;     //!< type of change
+    Index    theSrc;      //!< the source vertex of the edge
+    Index    theDst;      //!< the destination vertex of the edge
+    Capacity theCapacity; //!< the new base capacity, in EPR/s
+
+    std::string toString() const;
+  };
+
+  /**
+   * @brief Check policy admitting only the paths with at most a given number
+   * of edges.
+   *
+   * Can be used both for flows and applications.
+   */
+  struct MaxHopsPolicy {
+    constexpr explicit MaxHopsPolicy(const std::size_t aMaxHops) noexcept
+        : theMaxHops(aMaxHops) {
+      // noop
+    }
+
+    constexpr std::size_t maxHops() const noexcept {
+      return theMaxHops;
+    }
+    bool operator()(const FlowDescriptor& aFlow) const noexcept {
+      return aFlow.thePath.size() <= theMaxHops;
+    }
+    bool operator()(const typename AppDescriptor::Path& aPath) const noexcept {
+      return aPath.size() <= theMaxHops;
+    }
+
+    std::size_t theMaxHops; //!< maximum number of edges of a path
+  };
+
+  /**
+   * @brief Check policy admitting only the paths whose fidelity, as given by
+   * fidelitySwapping(), is not smaller than a threshold.
+   *
+   * Can be used both for flows and applications.
+   *
+   * The fidelity does not increase with the number of links if F >= 1/4,
+   * which is assumed, hence this policy is equivalent to a maximum number of
+   * edges computed upon construction.
+   */
+  struct FidelityThresholdPolicy {
+    /**
+     * @brief Create a policy for the given parameters.
+     *
+     * See fidelitySwapping() for the meaning of p1, p2, eta, and F.
+     *
+     * @param aThreshold the minimum fidelity admitted
+     * @param aNumNodes the number of nodes of the network, which bounds the
+     * length of the paths
+     */
+    FidelityThresholdPolicy(const double      p1,
+                            const double      p2,
+                            const double      eta,
+                            const double      F,
+                            const double      aThreshold,
+                            const std::size_t aNumNodes);
+
+    std::size_t maxHops() const noexcept {
+      return theMaxHops;
+    }
+    //! \return the fidelity of a path with the given number of edges.
+    double fidelity(const std::size_t aNumEdges) const {
+      return theFidelity(aNumEdges);
+    }
+    bool operator()(const FlowDescriptor& aFlow) const {
+      return admissible(aFlow.thePath.size());
+    }
+    bool operator()(const typename AppDescriptor::Path& aPath) const {
+      return admissible(aPath.size());
+    }
+
+   private:
+    bool admissible(const std::size_t aNumEdges) const {
+      return aNumEdges > 0 and fidelity(aNumEdges) >= theThreshold;
+    }
+
+   private:
+    FidelityTable theFidelity;
+    double        theThreshold;
+    std::size_t   theMaxHops;
+  };
+
+  /**
+   * @brief Quality of a link, which may differ from one link to another.
+   *
+   * The links whose quality has not been set have fidelity 1 and swap success
+   * probability equal to the measurement probability.
+   */
+  struct LinkQuality {
+    //! fidelity of the entangled pairs generated on the link, in (1/4, 1]
+    double theFidelity;
+    //! success probability, in [0, 1], of the swap done at the source of the
+    //! link when this is not the first one of the path
+    double theSwapSuccess;
+
+    bool operator==(const LinkQuality& aOther) const noexcept {
+      return theFidelity == aOther.theFidelity and
+             theSwapSuccess == aOther.theSwapSuccess;
+    }
+  };
+
+  //! Metric optimized by the weighted routing of flows.
+  enum class PathMetric {
+    GrossRate = 0, //!< max product of the swap success probabilities
+    Fidelity  = 1, //!< max end-to-end fidelity
+  };
+
   using FlowCheckFunction = std::function<bool(const FlowDescriptor&)>;
-  using AppCheckFunction  = std::function<bool(const AppDescriptor::Path&)>;
+  using AppCheckFunction =
+      std::function<bool(const typename AppDescriptor::Path&)>;
+  using LatencyClassFunction =
+      std::function<std::size_t(const FlowDescriptor&)>;
 
   // vector of (src, dst)
-  using EdgeVector = std::vector<std::pair<unsigned long, unsigned long>>;
+  using EdgeVector = std::vector<std::pair<Index, Index>>;
   // vector of (src, dst, weight)
-  using WeightVector =
-      std::vector<std::tuple<unsigned long, unsigned long, double>>;
+  using WeightVector = std::vector<std::tuple<Index, Index, Capacity>>;
+  // vector of (src, dst, quality)
+  using QualityVector = std::vector<std::tuple<Index, Index, LinkQuality>>;
   // map of host -> { peers }
-  using ReachableNodes = std::map<unsigned long, std::set<unsigned long>>;
+  using ReachableNodes = std::map<Index, std::set<Index>>;
 
   /**
    * @brief Create a network with given links and assign random weights
@@ -160,9 +349,9 @@ class CapacityNetwork final : public Network
    * @param aMakeBidirectional If true then for each pair (A,B) two edges are
    * added A->B and B->A, with the same weight.
    */
-  explicit CapacityNetwork(const EdgeVector&         aEdges,
-                           support::RealRvInterface& aWeightRv,
-                           const bool                aMakeBidirectional);
+  explicit BasicCapacityNetwork(const EdgeVector&         aEdges,
+                                support::RealRvInterface& aWeightRv,
+                                const bool                aMakeBidirectional);
 
   /**
    * @brief Create a network with given links and weights
@@ -171,12 +360,21 @@ class CapacityNetwork final : public Network
    *
    * @param aEdgeWeights The unidirectional edges and weights of the network
    * (src, dst, w).
+   * @param aNumNodes The minimum number of nodes, which is larger than the
+   * largest node in aEdgeWeights only if there are isolated nodes.
    */
-  explicit CapacityNetwork(const WeightVector& aEdgeWeights);
+  explicit BasicCapacityNetwork(const WeightVector& aEdgeWeights,
+                                const std::size_t   aNumNodes = 0);
+
+  //! Serve all the asynchronous requests pending, if any.
+  ~BasicCapacityNetwork();
 
   /**
    * @brief Set the measurement probability.
    *
+   * The powers of the measurement probability used to convert between gross
+   * and net rates are precomputed for all the path lengths possible.
+   *
    * @param aMeasurementProbability the new measurement probability
    *
    * @throw std::runtime_error if the measurement probability is not in [0,1]
@@ -188,6 +386,78 @@ class CapacityNetwork final : public Network
     return theMeasurementProbability;
   }
 
+  /**
+   * @brief Return the powers of the measurement probability, indexed by the
+   * number of swaps, i.e., the path length in edges minus one.
+   */
+  const PowerTable& swapSuccess() const noexcept {
+    return theSwapSuccess;
+  }
+
+  /**
+   * @brief Set the quality of the given links.
+   *
+   * @param aQualities the links, as (src, dst, quality)
+   *
+   * @throw std::runtime_error if a link does not exist or its quality is out
+   * of range, in which case none of the qualities is set
+   */
+  void linkQualities(const QualityVector& aQualities);
+
+  /**
+   * @brief Return the quality of a link.
+   *
+   * @throw std::runtime_error if the link does not exist
+   */
+  LinkQuality linkQuality(const Index aSrc, const Index aDst) const;
+
+  /**
+   * @brief Set the reliability of the operations of the swaps, which is the
+   * same at all the nodes.
+   *
+   * See fidelitySwapping() for the meaning of the parameters, which are all 1
+   * by default.
+   *
+   * @throw std::runtime_error if a parameter is out of range
+   */
+  void swapReliability(const double p1, const double p2, const double eta);
+
+  /**
+   * @brief Return the end-to-end fidelity of a path, with the qualities of
+   * its links.
+   *
+   * With all the links of the same fidelity F this is the same as
+   * fidelitySwapping() with F, the swap reliability of this network, and L
+   * equal to the number of edges of the path, as in FidelityThresholdPolicy.
+   *
+   * The work done is not counted, so that the method can be called
+   * concurrently, e.g., by the check functions passed to probe().
+   *
+   * @throw std::runtime_error if an edge of the path does not exist
+   */
+  double pathFidelity(const VertexDescriptor    aSrc,
+                      const std::vector<Index>& aPath) const;
+
+  /**
+   * @brief Return the probability that all the swaps along a path succeed,
+   * i.e., the ratio between net and gross rate, with the qualities of its
+   * links.
+   *
+   * As pathFidelity(), the work done is not counted.
+   *
+   * @throw std::runtime_error if an edge of the path does not exist
+   */
+  double pathSwapSuccess(const VertexDescriptor    aSrc,
+                         const std::vector<Index>& aPath) const;
+
+  /**
+   * @brief Return a copy of this network, with the same graph, capacities and
+   * measurement probability, but with all the work counters reset.
+   *
+   * The copy takes the same routing decisions as this network.
+   */
+  std::unique_ptr<BasicCapacityNetwork> clone() const;
+
   //! \return the number of nodes.
   std::size_t numNodes() const;
 
@@ -200,8 +470,8 @@ class CapacityNetwork final : public Network
   //! \return the min-max out-degree of the graph.
   std::pair<std::size_t, std::size_t> outDegree() const;
 
-  //! \return the total EPR capacity across all the edges.
-  double totalCapacity() const;
+  //! \return the total EPR capacity across all the edges, in O(num nodes).
+  Capacity totalCapacity() const;
 
   //! Save to a dot file.
   void toDot(const std::string& aFilename) const;
@@ -209,17 +479,43 @@ class CapacityNetwork final : public Network
   //! \return the current weights, one per element in the return vector.
   WeightVector weights() const;
 
+  /**
+   * @brief Call a function for every edge, in the same order as weights(),
+   * without copying them.
+   *
+   * @param aFunction the function called with the source, destination, and
+   * current weight of every edge
+   */
+  template <class FUNCTION>
+  void forEachEdge(FUNCTION&& aFunction) const {
+    const auto myWeights = boost::get(boost::edge_weight, theGraph);
+    for (const auto& myEdge :
+         boost::make_iterator_range(boost::edges(theGraph))) {
+      aFunction(myEdge.m_source, myEdge.m_target, myWeights[myEdge]);
+    }
+  }
+
   /**
    * @brief For each node, find the reachable nodes with min/max distance.
    *
    * @param aMinHops The minimum distance, in hops.
    * @param aMaxHops The maximum distance, in hops.
    * @param aDiameter Return the network diameter, in hops.
-   * @return std::map<unsigned long, std::set<unsigned long>>
+   * @return std::map<Index, std::set<Index>>
    */
   ReachableNodes reachableNodes(const std::size_t aMinHops,
                                 const std::size_t aMaxHops,
-                                std::size_t&      aDiameter) const;
+                                std::size_t&      aDiameter);
+
+  /**
+   * @brief Same as above, but the work done is added to the given counters
+   * instead of those of this network, so that the method can be called
+   * concurrently by multiple threads.
+   */
+  ReachableNodes reachableNodes(const std::size_t aMinHops,
+                                const std::size_t aMaxHops,
+                                std::size_t&      aDiameter,
+                                WorkCounters&     aCounters) const;
 
   /**
    * @brief Route the given flows in this network starting with current
@@ -243,6 +539,85 @@ class CapacityNetwork final : public Network
         return true;
       });
 
+  /**
+   * @brief Route the given flows with a check policy known at compile time.
+   *
+   * Same as route() with a check function, which is a thin wrapper around
+   * this one, but the policy is not called through a std::function.
+   *
+   * If the policy has a member function maxHops(), no path longer than
+   * the value returned, in edges, is considered admissible: the candidate
+   * paths exceeding it are discarded without calling the policy.
+   *
+   * @param aFlows the flows to be routed (admitted flows are modified)
+   * @param aPolicy any callable returning true if the flow is feasible
+   */
+  template <class CHECK_POLICY>
+  void route(std::vector<FlowDescriptor>& aFlows, const CHECK_POLICY& aPolicy);
+
+  /**
+   * @brief Route the given flows along the paths that optimize a metric
+   * depending on the qualities of the links.
+   *
+   * The qualities are turned into additive costs in the log domain, hence
+   * every candidate path is found with a single weighted shortest path
+   * search, considering only the edges with capacity not smaller than the net
+   * rate of the flow. The gross rate is the net rate divided by the swap
+   * success probability of the path, see pathSwapSuccess(). If the gross rate
+   * is not feasible along the path, the edge with the smallest capacity is
+   * excluded and the search is repeated, as with route().
+   *
+   * @param aFlows the flows to be routed (admitted flows are modified)
+   * @param aMetric the metric to be optimized
+   * @param aCheckFunction same as in route()
+   *
+   * @throw std::runtime_error if aFlows contain an ill-formed request, in which
+   * case we guarantee that the internal state is not changed
+   */
+  void route(
+      std::vector<FlowDescriptor>& aFlows,
+      const PathMetric             aMetric,
+      const FlowCheckFunction&     aCheckFunction = [](const auto&) {
+        return true;
+      });
+
+  /**
+   * @brief Route the given flows along the shortest paths, in hops, that meet
+   * both a minimum end-to-end fidelity and the capacity required by their
+   * gross rate, with the qualities of the links.
+   *
+   * Unlike route() with a check function on the fidelity, which rejects the
+   * flow if the path found does not meet it, the constraints are enforced
+   * during the search, which is a resource-constrained shortest path problem
+   * solved exactly by label setting. Every partial path from the source is a
+   * label with its length and its swap, fidelity, and capacity resources. A
+   * label is discarded if it is dominated by another label at the same
+   * vertex or if it cannot meet a constraint even along the cheapest
+   * continuation to the destination. The labels are extended in order of
+   * their length plus the minimum number of hops to the destination, as in
+   * A*. The lower bounds of the hops and costs to the destination are found
+   * with shortest path searches backwards from it. Among the paths with the
+   * same length the one with the smallest gross rate is selected.
+   *
+   * The number of labels may grow exponentially with the size of the
+   * network, hence it is bounded: a flow whose search creates more labels
+   * than the maximum is rejected, even if a feasible path exists.
+   *
+   * Each flow counts four Dijkstra searches: three backwards for the lower
+   * bounds and the label setting itself.
+   *
+   * @param aFlows the flows to be routed (admitted flows are modified)
+   * @param aMinFidelity the minimum end-to-end fidelity, see pathFidelity()
+   * @param aMaxLabels the maximum number of labels of the search of a flow
+   *
+   * @throw std::runtime_error if aFlows contain an ill-formed request, the
+   * minimum fidelity is not in [0, 1], or the maximum number of labels is
+   * zero, in which case we guarantee that the internal state is not changed
+   */
+  void routeConstrained(std::vector<FlowDescriptor>& aFlows,
+                        const double                 aMinFidelity,
+                        const std::size_t            aMaxLabels = 1000000);
+
   /**
    * @brief Route the given elastic applications in the network.
    *
@@ -264,6 +639,114 @@ class CapacityNetwork final : public Network
         return true;
       });
 
+  /**
+   * @brief Route the given elastic applications with a check policy known at
+   * compile time.
+   *
+   * Same as route() with a check function, which is a thin wrapper around
+   * this one, but the policy is not called through a std::function.
+   *
+   * If the policy has a member function maxHops(), then the k-shortest paths
+   * are not searched towards the peers that are farther than the value
+   * returned, in edges, from the host.
+   */
+  template <class CHECK_POLICY>
+  void route(std::vector<AppDescriptor>& aApps,
+             const double                aQuantum,
+             const std::size_t           aK,
+             const CHECK_POLICY&         aPolicy);
+
+  /**
+   * @brief Find the path that route() would assign to a flow if it were
+   * requested now, without changing the capacities or the work counters.
+   *
+   * Any number of threads can probe the same network concurrently, each
+   * using its own search buffers, as long as no other thread changes the
+   * network at the same time.
+   *
+   * @param aFlow the flow to be probed
+   * @param aCheckFunction same as in route()
+   * @return a copy of aFlow with the path and gross rate set if the flow is
+   * admissible, otherwise with an empty path
+   *
+   * @throw std::runtime_error if aFlow is ill-formed
+   */
+  FlowDescriptor probe(
+      const FlowDescriptor&    aFlow,
+      const FlowCheckFunction& aCheckFunction = [](const auto&) {
+        return true;
+      }) const;
+
+  //! Same as probe() of a flow, with a check policy known at compile time.
+  template <class CHECK_POLICY>
+  FlowDescriptor probe(const FlowDescriptor& aFlow,
+                       const CHECK_POLICY&   aPolicy) const;
+
+  /**
+   * @brief Find the allocation that route() would assign to the given
+   * elastic applications if they were requested now, without changing the
+   * capacities or the work counters.
+   *
+   * The allocation is done on a private copy of the network, hence the same
+   * thread-safety guarantees as for the probe of a flow apply. The paths not
+   * used are not returned.
+   *
+   * @return a copy of aApps with the allocations of route()
+   *
+   * @throw std::runtime_error if aApps contain an ill-formed request
+   */
+  std::vector<AppDescriptor> probe(
+      const std::vector<AppDescriptor>& aApps,
+      const double                      aQuantum,
+      const std::size_t                 aK,
+      const AppCheckFunction&           aCheckFunction = [](const auto&) {
+        return true;
+      }) const;
+
+  /**
+   * @brief Route a flow asynchronously.
+   *
+   * The asynchronous requests are served one at a time, in the order in which
+   * they are submitted, by an executor owned by this network, which is
+   * started upon the first request, also if concurrent submit() calls are
+   * made by different threads. The other member functions must not be
+   * called until all the requests submitted have been served, e.g., after
+   * drain() has returned.
+   *
+   * @param aFlow the flow to be routed, of which only the source,
+   * destination, and net rate are used
+   * @param aCheckFunction the check function passed to route()
+   *
+   * \return a future with the flow routed as if by route(), whose path is
+   * empty if it has not been admitted, or which holds the exception thrown
+   * by route() if the flow is ill-formed
+   */
+  std::future<FlowDescriptor> submit(
+      const FlowDescriptor&    aFlow,
+      const FlowCheckFunction& aCheckFunction = [](const auto&) {
+        return true;
+      });
+
+  /**
+   * @brief Route elastic applications asynchronously.
+   *
+   * Same as submit() of a flow, but the applications are routed as if by
+   * route() with the given parameters.
+   *
+   * \return a future with the applications routed, or which holds the
+   * exception thrown by route() if the request is ill-formed
+   */
+  std::future<std::vector<AppDescriptor>> submit(
+      std::vector<AppDescriptor>&& aApps,
+      const double                 aQuantum,
+      const std::size_t            aK,
+      const AppCheckFunction&      aCheckFunction = [](const auto&) {
+        return true;
+      });
+
+  //! Wait until all the asynchronous requests submitted have been served.
+  void drain();
+
   /**
    * @brief Add capacity on all the edges along a given path from a source node.
    *
@@ -274,16 +757,70 @@ class CapacityNetwork final : public Network
    * @throw std::runtime_error if one of the edges in the path does not exist in
    * the graph
    */
-  void addCapacityToPath(const VertexDescriptor               aSrc,
-                         const std::vector<VertexDescriptor>& aPath,
-                         const double                         aCapacity);
+  void addCapacityToPath(const VertexDescriptor    aSrc,
+                         const std::vector<Index>& aPath,
+                         const Capacity            aCapacity);
+
+  /**
+   * @brief Change the topology or the base capacities of the network,
+   * without losing the capacity reserved so far.
+   *
+   * The base capacity of an edge is that set when it is created, either by
+   * the constructor or by a change, and the capacity reserved is the
+   * difference between the base capacity and the residual one. When the base
+   * capacity of an edge changes, the capacity reserved is carried over, i.e.,
+   * the residual capacity changes by the same amount as the base capacity:
+   * if the base capacity becomes smaller than the capacity reserved, the
+   * residual capacity becomes negative and no more capacity can be removed
+   * from the edge until enough capacity is added back along the paths that
+   * cross it. When an edge is removed, the capacity reserved on it is lost.
+   *
+   * The cost is proportional to the number of changes, i.e., it does not
+   * depend on the size of the network.
+   *
+   * @param aDeltas the changes, each of a different edge between existing
+   * nodes
+   *
+   * @return the edges that cannot accommodate the capacity reserved on them
+   * anymore, with the capacity in excess, including the removed edges on
+   * which some capacity was reserved
+   *
+   * @throw std::runtime_error if any of the changes is invalid, in which case
+   * none of them is applied
+   */
+  WeightVector applyTopologyDeltas(const std::vector<TopologyDelta>& aDeltas);
+
+  /**
+   * @brief Change the base capacities of many edges at once, e.g., to follow
+   * the EPR generation rates measured on the links.
+   *
+   * The residual capacity of every edge changes by the same amount as its
+   * base capacity, as with applyTopologyDeltas(). The changes are sorted by
+   * edge, so that the outgoing edges of every node are scanned only once and
+   * its capacity is updated only once, whatever the number of changes of its
+   * edges.
+   *
+   * @param aDeltas the changes, as (src, dst, difference of base capacity),
+   * where the same edge may appear multiple times
+   *
+   * @return the edges that cannot accommodate the capacity reserved on them
+   * anymore, with the capacity in excess, sorted by edge
+   *
+   * @throw std::runtime_error if an edge does not exist or its base capacity
+   * would become negative, in which case none of the changes is applied
+   */
+  WeightVector applyCapacityDeltas(const WeightVector& aDeltas);
+
   /**
    * @brief Return the capacity for each node, defined as the sum of the
    * capacity of all its outgoing edges.
    *
-   * @return std::vector<double> The capacity value for each node index.
+   * The capacities are kept up to date whenever the capacity of an edge
+   * changes, hence this method only copies them.
+   *
+   * @return The capacity value for each node index.
    */
-  std::vector<double> nodeCapacities() const;
+  std::vector<Capacity> nodeCapacities() const;
 
   /**
    * @brief Save the nodes and vertices of the graph to two files that can be
@@ -295,7 +832,40 @@ class CapacityNetwork final : public Network
   void toGnuplot(const std::string&             aFilename,
                  const std::vector<Coordinate>& aCoordinates) const;
 
+  //! \return the work done by the routing algorithms since creation.
+  const WorkCounters& counters() const noexcept {
+    return theCounters;
+  }
+
+  /**
+   * @brief Record the wall-clock latency of every admission decision taken
+   * by route() on a flow, and of every release by addCapacityToPath().
+   *
+   * @param aLatencies where to record the latencies, nullptr to disable
+   * @param aClassFunction return the class of a flow in aLatencies; upon
+   * release the flow has only the source, destination, net rate, path, and
+   * gross rate set
+   */
+  void latencies(
+      const std::shared_ptr<DecisionLatencies>& aLatencies,
+      const LatencyClassFunction& aClassFunction = [](const auto&) {
+        return std::size_t(0);
+      });
+
+  //! \return the latencies recorded, or nullptr if disabled.
+  const std::shared_ptr<DecisionLatencies>& latencies() const noexcept {
+    return theLatencies;
+  }
+
  private:
+  //! \return the executor of submit(), started once by the first caller.
+  SerialExecutor& executor();
+
+  //! Record the latency of the admission decision on a flow started at the
+  //! given time, see latencies().
+  void recordAdmission(const FlowDescriptor&                       aFlow,
+                       const std::chrono::steady_clock::time_point aStart);
+
   struct HopsFinder {
     HopsFinder(const std::vector<VertexDescriptor>& aPredecessors,
                const VertexDescriptor               aSource)
@@ -303,8 +873,7 @@ class CapacityNetwork final : public Network
         , theSource(aSource) {
       // noop
     }
-    void operator()(std::vector<VertexDescriptor>& aHops,
-                    const VertexDescriptor         aNext) {
+    void operator()(std::vector<Index>& aHops, const VertexDescriptor aNext) {
       if (aNext == theSource) {
         return;
       }
@@ -315,35 +884,431 @@ class CapacityNetwork final : public Network
     const VertexDescriptor               theSource;
   };
 
-  static bool checkCapacity(const VertexDescriptor               aSrc,
-                            const std::vector<VertexDescriptor>& aPath,
-                            const double                         aCapacity,
-                            const Graph&                         aGraph);
+  //! Scratch state of the path search of flows.
+  struct SearchWorkspace {
+    std::vector<VertexDescriptor> theDistances;
+    std::vector<VertexDescriptor> thePredecessors;
+    // shortest path trees on the full topology, by source
+    std::map<VertexDescriptor, std::vector<VertexDescriptor>> theTrees;
+  };
 
-  static void
-  removeSmallestCapacityEdge(const VertexDescriptor               aSrc,
-                             const std::vector<VertexDescriptor>& aPath,
-                             Graph&                               aGraph);
+  //! Partial path of the constrained search, see routeConstrained().
+  struct Label {
+    VertexDescriptor theVertex;
+    std::size_t      theParent;       //!< index of the previous label
+    std::size_t      theHops;         //!< number of edges
+    double           theSwapCost;     //!< -log of the swap success probability
+    double           theFidelityCost; //!< -log of the fidelity term
+    Capacity         theCapacity;     //!< minimum capacity of the edges
+    bool             theDominated;    //!< true if dominated after insertion
+  };
 
-  static void removeCapacityFromPath(const VertexDescriptor               aSrc,
-                                     const std::vector<VertexDescriptor>& aPath,
-                                     const double aCapacity,
-                                     Graph&       aGraph);
+  //! Scratch state of the constrained search of flows.
+  struct LabelWorkspace {
+    std::vector<Label> theLabels;
+    // indices of the labels not dominated, by vertex
+    std::vector<std::vector<std::size_t>> theFronts;
+    // true if at least one label of the vertex has been expanded
+    std::vector<bool> theSettled;
+    // lower bounds of the costs from every vertex to the destination
+    std::vector<double> theHopBounds;
+    std::vector<double> theSwapBounds;
+    std::vector<double> theFidelityBounds;
+  };
+
+  //! @throw std::runtime_error if the flow is ill-formed.
+  void checkFlow(const FlowDescriptor& aFlow) const;
+
+  /**
+   * @brief Route the given flows one by one, searching the path of each with
+   * the given function, which is called with the flow descriptor and sets
+   * its path and gross rate if the flow is admissible.
+   */
+  template <class FINDER>
+  void routeFlows(std::vector<FlowDescriptor>& aFlows, FINDER&& aFinder);
 
-  std::pair<std::size_t, std::size_t> minMaxVertexProp(
-      const std::function<std::size_t(Graph::vertex_descriptor, const Graph&)>&
-          aPropFunctor) const;
+  /**
+   * @brief Search a path for the flow with the current capacities, which are
+   * not changed.
+   *
+   * If the flow is admissible its path and gross rate are set.
+   */
+  template <class CHECK_POLICY>
+  void findPath(FlowDescriptor&     aFlow,
+                const CHECK_POLICY& aPolicy,
+                SearchWorkspace&    aWorkspace,
+                WorkCounters&       aCounters) const;
+
+  /**
+   * @brief Return the shortest path tree, in hops, from a source.
+   *
+   * The tree is searched on the graph given, if any, otherwise it is taken
+   * from the cache of trees on the full topology in the workspace.
+   *
+   * \return the predecessors of every vertex in the tree
+   */
+  const std::vector<VertexDescriptor>&
+  shortestPathTree(const VertexDescriptor      aSrc,
+                   const std::optional<Graph>& aGraph,
+                   SearchWorkspace&            aWorkspace,
+                   WorkCounters&               aCounters) const;
+
+  //! \return the distances, in hops, from a source to every vertex.
+  std::vector<VertexDescriptor> hopDistances(const VertexDescriptor aSrc,
+                                             WorkCounters& aCounters) const;
+
+  /**
+   * @brief Check the routing parameters of elastic applications.
+   *
+   * \return the quantum of every application, proportional to its priority
+   *
+   * @throw std::runtime_error if a parameter or application is ill-formed
+   */
+  std::vector<double> checkApps(const std::vector<AppDescriptor>& aApps,
+                                const double                      aQuantum,
+                                const std::size_t                 aK) const;
+
+  //! \return the k-shortest paths, in hops, from a host to a peer.
+  std::list<typename AppDescriptor::Path>
+  kShortestPaths(const VertexDescriptor aHost,
+                 const VertexDescriptor aPeer,
+                 const std::size_t      aK,
+                 WorkCounters&          aCounters) const;
+
+  /**
+   * @brief Allocate the capacity to the applications with the paths found,
+   * using weighted round-robin with the given quanta.
+   */
+  void allocateApps(std::vector<AppDescriptor>& aApps,
+                    const std::vector<double>&  aQuanta);
+
+  bool checkCapacity(const VertexDescriptor    aSrc,
+                     const std::vector<Index>& aPath,
+                     const Capacity            aCapacity,
+                     const Graph&              aGraph,
+                     WorkCounters&             aCounters) const;
+
+  void removeSmallestCapacityEdge(const VertexDescriptor    aSrc,
+                                  const std::vector<Index>& aPath,
+                                  Graph&                    aGraph,
+                                  WorkCounters&             aCounters) const;
+
+  void removeCapacityFromPath(const VertexDescriptor    aSrc,
+                              const std::vector<Index>& aPath,
+                              const Capacity            aCapacity);
+
+  //! Add an edge to the graph, with the costs of its link quality.
+  void addEdge(const VertexDescriptor aSrc,
+               const VertexDescriptor aDst,
+               const Capacity         aWeight);
+
+  //! Recompute the costs of an edge from the quality of its link.
+  void updateLinkCosts(const EdgeDescriptor& aEdge);
+
+  //! Search a path for the flow optimizing a metric, see route().
+  void findWeightedPath(FlowDescriptor&                aFlow,
+                        const PathMetric               aMetric,
+                        const FlowCheckFunction&       aCheckFunction,
+                        std::vector<double>&           aDistances,
+                        std::vector<VertexDescriptor>& aPredecessors);
+
+  //! Search a path for the flow meeting the constraints, see
+  //! routeConstrained().
+  void findConstrainedPath(FlowDescriptor&   aFlow,
+                           const double      aMinFidelity,
+                           const std::size_t aMaxLabels,
+                           LabelWorkspace&   aWorkspace);
+
+  //! \return the costs of an existing link, from the graph or, if the edge
+  //! has been removed because its capacity is exhausted, from its quality.
+  LinkCosts linkCosts(const Index   aSrc,
+                      const Index   aDst,
+                      WorkCounters& aCounters) const;
+
+  //! Same as pathFidelity(), with the work added to the given counters.
+  double pathFidelity(const VertexDescriptor    aSrc,
+                      const std::vector<Index>& aPath,
+                      WorkCounters&             aCounters) const;
+
+  //! Same as pathSwapSuccess(), with the work added to the given counters.
+  double pathSwapSuccess(const VertexDescriptor    aSrc,
+                         const std::vector<Index>& aPath,
+                         WorkCounters&             aCounters) const;
+
+  //! Recompute the cached capacity of a node from its outgoing edges, which
+  //! is needed only when one of them is removed.
+  void updateNodeCapacity(const VertexDescriptor aNode);
+
+  //! Update the cached capacity of a node with the capacity added to (if
+  //! positive) or removed from (if negative) one of its outgoing edges.
+  void updateNodeCapacity(const VertexDescriptor aNode, const Capacity aDelta);
+
+  template <class FUNCTION>
+  std::pair<std::size_t, std::size_t>
+  minMaxVertexProp(FUNCTION&& aPropFunctor) const {
+    std::size_t myMin = std::numeric_limits<std::size_t>::max();
+    std::size_t myMax = 0;
+    for (const auto& myVertex :
+         boost::make_iterator_range(boost::vertices(theGraph))) {
+      const std::size_t myCur = aPropFunctor(myVertex, theGraph);
+      myMin                   = std::min(myMin, myCur);
+      myMax                   = std::max(myMax, myCur);
+    }
+    return {myMin, myMax};
+  }
 
   //! \return the gross rate for a given path length, in num of edges.
-  double toGrossRate(const double aNetRate, const std::size_t aNumEdges) const;
+  Capacity toGrossRate(const Capacity    aNetRate,
+                       const std::size_t aNumEdges) const;
 
   //! \return the net rate for a given path length, in num of edges.
-  double toNetRate(const double aGrossRate, const std::size_t aNumEdges) const;
+  Capacity toNetRate(const Capacity    aGrossRate,
+                     const std::size_t aNumEdges) const;
 
  private:
-  Graph  theGraph;
-  double theMeasurementProbability;
+  // base capacity of the edges, by (src, dst)
+  using BaseCapacities = std::map<std::pair<Index, Index>, Capacity>;
+  // qualities of the links set, by (src, dst)
+  using LinkQualities = std::map<std::pair<Index, Index>, LinkQuality>;
+
+  Graph                              theGraph;
+  BaseCapacities                     theBaseCapacities;
+  LinkQualities                      theLinkQualities;
+  //! powers of p1^2 p2 (4 eta^2 - 1) / 3, see fidelitySwapping().
+  PowerTable                         theSwapReliability;
+  std::vector<Capacity>              theNodeCapacities;
+  double                             theMeasurementProbability;
+  //! powers of the measurement probability, by number of swaps.
+  PowerTable                         theSwapSuccess;
+  WorkCounters                       theCounters;
+  std::shared_ptr<DecisionLatencies> theLatencies;
+  LatencyClassFunction               theLatencyClassFunction;
+  std::once_flag                     theExecutorFlag;
+  std::unique_ptr<SerialExecutor>    theExecutor;
 };
 
+//! Network with the vertex identifiers and capacities used so far.
+using CapacityNetwork = BasicCapacityNetwork<unsigned long, double>;
+
+//! Network with 32-bit vertex identifiers and single-precision capacities.
+using CompactCapacityNetwork = BasicCapacityNetwork<std::uint32_t, float>;
+
+// both are instantiated in capacitynetwork.cpp
+extern template class BasicCapacityNetwork<unsigned long, double>;
+extern template class BasicCapacityNetwork<std::uint32_t, float>;
+
+template <class INDEX, class CAPACITY>
+template <class CHECK_POLICY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::route(
+    std::vector<FlowDescriptor>& aFlows, const CHECK_POLICY& aPolicy) {
+  // the scratch state, including the shortest path trees on the full
+  // topology, is shared by all the flows
+  SearchWorkspace myWorkspace;
+
+  routeFlows(aFlows, [&](FlowDescriptor& aFlow) {
+    findPath(aFlow, aPolicy, myWorkspace, theCounters);
+  });
+}
+
+template <class INDEX, class CAPACITY>
+template <class FINDER>
+void BasicCapacityNetwork<INDEX, CAPACITY>::routeFlows(
+    std::vector<FlowDescriptor>& aFlows, FINDER&& aFinder) {
+  // pre-condition checks
+  for (const auto& myFlow : aFlows) {
+    assert(myFlow.thePath.empty());
+    assert(myFlow.theGrossRate == 0);
+    assert(myFlow.theDijsktra == 0);
+    checkFlow(myFlow);
+  }
+
+  // a single scope for all the flows, to keep its cost out of the searches
+  MemoryAccounting::Scope myScope(MemoryUsage::Subsystem::Descriptors);
+  for (auto& myFlow : aFlows) {
+    assert(myFlow.thePath.empty());
+    assert(myFlow.theGrossRate == 0);
+
+    const auto myStart = theLatencies.get() == nullptr ?
+                             std::chrono::steady_clock::time_point() :
+                             std::chrono::steady_clock::now();
+
+    aFinder(myFlow);
+
+    if (myFlow.thePath.empty()) {
+      QR_TRACE(1,
+               FlowRejected,
+               myFlow.theSrc,
+               myFlow.theDst,
+               myFlow.theDijsktra,
+               myFlow.theNetRate);
+
+    } else {
+      QR_TRACE(1,
+               FlowAdmitted,
+               myFlow.theSrc,
+               myFlow.theDst,
+               myFlow.thePath.size(),
+               myFlow.theGrossRate);
+      // flow admissible: remove the gross capacity from the edges along the
+      // path and then move to the next flow in the list
+      removeCapacityFromPath(
+          myFlow.theSrc, myFlow.thePath, myFlow.theGrossRate);
+    }
+
+    if (theLatencies.get() != nullptr) {
+      recordAdmission(myFlow, myStart);
+    }
+  }
+}
+
+template <class INDEX, class CAPACITY>
+template <class CHECK_POLICY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::route(
+    std::vector<AppDescriptor>& aApps,
+    const double                aQuantum,
+    const std::size_t           aK,
+    const CHECK_POLICY&         aPolicy) {
+  const auto myQuanta = checkApps(aApps, aQuantum, aK);
+
+  // for each app, find k-shortest paths towards each peer using Yen's
+  // algorithm
+  MemoryAccounting::Scope myScope(MemoryUsage::Subsystem::Paths);
+  for (auto& myApp : aApps) {
+    // with a bound on the path length skip the peers too far from the host
+    std::vector<VertexDescriptor> myDistances;
+    if constexpr (detail::HasMaxHops<CHECK_POLICY>::value) {
+      myDistances = hopDistances(myApp.theHost, theCounters);
+    }
+
+    for (const auto& myPeer : myApp.thePeers) {
+      if constexpr (detail::HasMaxHops<CHECK_POLICY>::value) {
+        if (myDistances[myPeer] > aPolicy.maxHops()) {
+          continue;
+        }
+      }
+      for (auto& myPath : kShortestPaths(myApp.theHost, myPeer, aK, theCounters)) {
+        const auto myValid = aPolicy(myPath);
+        QR_TRACE(2,
+                 AppPathFound,
+                 myApp.theHost,
+                 myPeer,
+                 myPath.size(),
+                 myValid ? 1 : 0);
+        if (myValid) {
+          auto myRes = myApp.theRemainingPaths.emplace(
+              myPath.size(), std::list<typename AppDescriptor::Path>());
+          myRes.first->second.emplace_back(std::move(myPath));
+        }
+      }
+    }
+  }
+
+  allocateApps(aApps, myQuanta);
+}
+
+template <class INDEX, class CAPACITY>
+template <class CHECK_POLICY>
+typename BasicCapacityNetwork<INDEX, CAPACITY>::FlowDescriptor
+BasicCapacityNetwork<INDEX, CAPACITY>::probe(
+    const FlowDescriptor& aFlow, const CHECK_POLICY& aPolicy) const {
+  checkFlow(aFlow);
+
+  // the buffers are reused by the probes of the same thread, but not the
+  // shortest path trees, since the topology may have changed since the last
+  // probe or this thread may be probing another network
+  thread_local SearchWorkspace myWorkspace;
+  myWorkspace.theTrees.clear();
+
+  FlowDescriptor ret(aFlow.theSrc, aFlow.theDst, aFlow.theNetRate);
+  WorkCounters   myCounters;
+  findPath(ret, aPolicy, myWorkspace, myCounters);
+  return ret;
+}
+
+template <class INDEX, class CAPACITY>
+template <class CHECK_POLICY>
+void BasicCapacityNetwork<INDEX, CAPACITY>::findPath(
+    FlowDescriptor&     aFlow,
+    const CHECK_POLICY& aPolicy,
+    SearchWorkspace&    aWorkspace,
+    WorkCounters&       aCounters) const {
+  // the graph is copied only if an edge has to be removed
+  auto                 myFoundOrDisconnected = false;
+  std::optional<Graph> myCopiedGraph;
+
+  // loop until either there is no path from the source to the destination
+  // or we find a candidate that can satisfy the flow requirements
+  while (not myFoundOrDisconnected) {
+    aFlow.theDijsktra++;
+    const auto& myPreds =
+        shortestPathTree(aFlow.theSrc, myCopiedGraph, aWorkspace, aCounters);
+    const auto& myGraph =
+        myCopiedGraph.has_value() ? *myCopiedGraph : theGraph;
+
+    if (myPreds[aFlow.theDst] == aFlow.theDst) {
+      myFoundOrDisconnected = true; // disconnected
+      continue;
+    }
+
+    // with a bound on the path length, stop if the shortest path exceeds it,
+    // since removing edges cannot make the next candidates shorter
+    if constexpr (detail::HasMaxHops<CHECK_POLICY>::value) {
+      std::size_t myHops = 1;
+      for (auto v = myPreds[aFlow.theDst];
+           v != aFlow.theSrc and myHops <= aPolicy.maxHops();
+           v = myPreds[v]) {
+        ++myHops;
+      }
+      if (myHops > aPolicy.maxHops()) {
+        myFoundOrDisconnected = true;
+        continue;
+      }
+    }
+
+    // there is at least one path from source to destination
+    HopsFinder     myHopsFinder(myPreds, aFlow.theSrc);
+    FlowDescriptor myCandidate(aFlow);
+    myHopsFinder(myCandidate.thePath, aFlow.theDst);
+    assert(not myCandidate.thePath.empty());
+    myCandidate.theGrossRate =
+        toGrossRate(myCandidate.theNetRate, myCandidate.thePath.size());
+    QR_TRACE(2,
+             FlowCandidate,
+             myCandidate.theSrc,
+             myCandidate.theDst,
+             myCandidate.thePath.size(),
+             myCandidate.theGrossRate);
+
+    // if the flow is not admissible because of the check policy we assume
+    // there is no need to continue the search, otherwise we check that the
+    // gross EPR rate is feasible along the path selected
+    if (not aPolicy(myCandidate)) {
+      myFoundOrDisconnected = true;
+
+    } else if (checkCapacity(myCandidate.theSrc,
+                             myCandidate.thePath,
+                             myCandidate.theGrossRate,
+                             myGraph,
+                             aCounters)) {
+      // flow is admissible on the shortest path, break from loop
+      myFoundOrDisconnected = true;
+      aFlow.movePathRateFrom(myCandidate);
+
+    } else {
+      // flow not admissible on the shortest path, remove the edge with
+      // smallest capacity along the path and try again
+      if (not myCopiedGraph.has_value()) {
+        MemoryAccounting::Scope myGraphScope(MemoryUsage::Subsystem::Graph);
+        myCopiedGraph.emplace(theGraph);
+        ++aCounters.theGraphCopies;
+      }
+      removeSmallestCapacityEdge(myCandidate.theSrc,
+                                 myCandidate.thePath,
+                                 *myCopiedGraph,
+                                 aCounters);
+    }
+  }
+}
+
 } // namespace qr
 } // namespace uiiit
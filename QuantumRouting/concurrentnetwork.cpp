@@ -0,0 +1,347 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/concurrentnetwork.h"
+#include "QuantumRouting/trace.h"
+
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/graph/filtered_graph.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+//! Working variables of a thread, kept to avoid memory allocations.
+struct ConcurrentNetwork::Workspace {
+  //! Set the sizes and start a new search, where no edges are removed.
+  void reset(const std::size_t aNumNodes, const std::size_t aNumEdges) {
+    theDistances.resize(aNumNodes);
+    thePredecessors.resize(aNumNodes);
+    if (theRemoved.size() < aNumEdges) {
+      theRemoved.resize(aNumEdges, 0);
+    }
+    if (++theStamp == 0) {
+      std::fill(theRemoved.begin(), theRemoved.end(), 0);
+      theStamp = 1;
+    }
+  }
+
+  bool removed(const std::size_t aEdge) const {
+    return theRemoved[aEdge] == theStamp;
+  }
+
+  void remove(const std::size_t aEdge) {
+    theRemoved[aEdge] = theStamp;
+  }
+
+  std::vector<VertexDescriptor> theDistances;
+  std::vector<VertexDescriptor> thePredecessors;
+  std::vector<std::size_t>      theEdges;
+  //! an edge is removed if its value is equal to the current stamp.
+  std::vector<std::uint32_t> theRemoved;
+  std::uint32_t              theStamp = 0;
+};
+
+namespace {
+
+//! Filter out the edges that have been removed in the current search.
+template <class WORKSPACE, class INDEX>
+struct EdgeFilter {
+  EdgeFilter() = default;
+  EdgeFilter(const WORKSPACE& aWorkspace, const INDEX aIndex)
+      : theWorkspace(&aWorkspace)
+      , theIndex(aIndex) {
+    // noop
+  }
+
+  template <class EDGE>
+  bool operator()(const EDGE& aEdge) const {
+    return not theWorkspace->removed(boost::get(theIndex, aEdge));
+  }
+
+  const WORKSPACE* theWorkspace = nullptr;
+  INDEX            theIndex;
+};
+
+} // namespace
+
+ConcurrentNetwork::ConcurrentNetwork(
+    const CapacityNetwork::WeightVector& aEdgeWeights)
+    : Network()
+    , theGraph()
+    , theCapacities(new std::atomic<double>[aEdgeWeights.size()])
+    , theMeasurementProbability(1)
+    , theSwapSuccess()
+    , theConflicts(0) {
+  unsigned long myNumNodes = 0;
+  for (const auto& elem : aEdgeWeights) {
+    myNumNodes = std::max(
+        myNumNodes, std::max(std::get<0>(elem), std::get<1>(elem)) + 1);
+  }
+  theGraph = Graph(myNumNodes);
+  for (std::size_t e = 0; e < aEdgeWeights.size(); e++) {
+    const auto mySrc = std::get<0>(aEdgeWeights[e]);
+    const auto myDst = std::get<1>(aEdgeWeights[e]);
+    if (boost::edge(mySrc, myDst, theGraph).second) {
+      throw std::runtime_error("duplicate edge in concurrent network: (" +
+                               std::to_string(mySrc) + "," +
+                               std::to_string(myDst) + ")");
+    }
+    boost::add_edge(mySrc, myDst, e, theGraph);
+    theCapacities[e].store(std::get<2>(aEdgeWeights[e]),
+                           std::memory_order_relaxed);
+  }
+}
+
+void ConcurrentNetwork::measurementProbability(
+    const double aMeasurementProbability) {
+  if (aMeasurementProbability < 0 or aMeasurementProbability > 1) {
+    throw std::runtime_error("Invalid measurement probability: " +
+                             std::to_string(aMeasurementProbability));
+  }
+  theMeasurementProbability = aMeasurementProbability;
+  theSwapSuccess            = PowerTable(theMeasurementProbability, numNodes());
+}
+
+std::size_t ConcurrentNetwork::numNodes() const {
+  return boost::num_vertices(theGraph);
+}
+
+std::size_t ConcurrentNetwork::numEdges() const {
+  return boost::num_edges(theGraph);
+}
+
+double ConcurrentNetwork::totalCapacity() const {
+  double ret = 0;
+  for (std::size_t e = 0; e < numEdges(); e++) {
+    ret += theCapacities[e].load(std::memory_order_relaxed);
+  }
+  return ret;
+}
+
+CapacityNetwork::WeightVector ConcurrentNetwork::weights() const {
+  CapacityNetwork::WeightVector ret(numEdges());
+  for (const auto& myEdge :
+       boost::make_iterator_range(boost::edges(theGraph))) {
+    const auto e        = boost::get(boost::edge_index, theGraph, myEdge);
+    std::get<0>(ret[e]) = boost::source(myEdge, theGraph);
+    std::get<1>(ret[e]) = boost::target(myEdge, theGraph);
+    std::get<2>(ret[e]) = theCapacities[e].load(std::memory_order_relaxed);
+  }
+  return ret;
+}
+
+bool ConcurrentNetwork::admit(FlowDescriptor&          aFlow,
+                              const FlowCheckFunction& aCheckFunction) {
+  const auto V = boost::num_vertices(theGraph);
+
+  // pre-condition checks
+  assert(aFlow.thePath.empty());
+  assert(aFlow.theGrossRate == 0);
+  if (aFlow.theSrc >= V) {
+    throw std::runtime_error("invalid source node in flow: " +
+                             std::to_string(aFlow.theSrc));
+  }
+  if (aFlow.theDst >= V) {
+    throw std::runtime_error("invalid destination node in flow: " +
+                             std::to_string(aFlow.theDst));
+  }
+  if (aFlow.theSrc == aFlow.theDst) {
+    throw std::runtime_error("invalid flow: from " +
+                             std::to_string(aFlow.theSrc) + " to itself");
+  }
+  if (aFlow.theNetRate <= 0) {
+    throw std::runtime_error("invalid nonpositive capacity request in flow: " +
+                             std::to_string(aFlow.theNetRate));
+  }
+
+  static thread_local Workspace myWorkspace;
+  myWorkspace.reset(V, numEdges());
+  auto& myEdges = myWorkspace.theEdges;
+
+  // same procedure as CapacityNetwork::route(), where the edges removed
+  // are marked in the workspace of this thread instead of being deleted from
+  // a copy of the graph
+  while (true) {
+    aFlow.theDijsktra++;
+    FlowDescriptor myCandidate(aFlow);
+    shortestPath(aFlow.theSrc, aFlow.theDst, myWorkspace, myCandidate.thePath);
+    myCandidate.theGrossRate =
+        toGrossRate(myCandidate.theNetRate, myCandidate.thePath.size());
+    if (myCandidate.thePath.empty() or not aCheckFunction(myCandidate)) {
+      QR_TRACE(1,
+               FlowRejected,
+               aFlow.theSrc,
+               aFlow.theDst,
+               aFlow.theDijsktra,
+               aFlow.theNetRate);
+      return false;
+    }
+
+    myEdges.clear();
+    auto mySrc = aFlow.theSrc;
+    for (const auto myDst : myCandidate.thePath) {
+      myEdges.emplace_back(edgeId(mySrc, myDst));
+      mySrc = myDst;
+    }
+
+    // find the edge with smallest capacity along the path: if the flow fits
+    // then try to reserve its gross rate, which fails only if another thread
+    // has reserved capacity on some of the edges since they have been read
+    auto   myRemovedEdge      = myEdges.front();
+    double mySmallestCapacity = std::numeric_limits<double>::max();
+    for (const auto e : myEdges) {
+      const auto myCapacity = theCapacities[e].load(std::memory_order_relaxed);
+      if (myCapacity < mySmallestCapacity) {
+        mySmallestCapacity = myCapacity;
+        myRemovedEdge      = e;
+      }
+    }
+    if (mySmallestCapacity >= myCandidate.theGrossRate) {
+      const auto myFailed = reserve(myEdges, myCandidate.theGrossRate);
+      if (myFailed == myEdges.size()) {
+        QR_TRACE(1,
+                 FlowAdmitted,
+                 aFlow.theSrc,
+                 aFlow.theDst,
+                 myCandidate.thePath.size(),
+                 myCandidate.theGrossRate);
+        aFlow.movePathRateFrom(myCandidate);
+        return true;
+      }
+      theConflicts.fetch_add(1, std::memory_order_relaxed);
+      myRemovedEdge = myEdges[myFailed];
+    }
+    myWorkspace.remove(myRemovedEdge);
+  }
+}
+
+void ConcurrentNetwork::release(const FlowDescriptor& aFlow) {
+  std::vector<std::size_t> myEdges;
+  myEdges.reserve(aFlow.thePath.size());
+  auto mySrc = aFlow.theSrc;
+  for (const auto myDst : aFlow.thePath) {
+    myEdges.emplace_back(edgeId(mySrc, myDst));
+    mySrc = myDst;
+  }
+  add(myEdges, myEdges.size(), aFlow.theGrossRate);
+}
+
+std::size_t ConcurrentNetwork::edgeId(const unsigned long aSrc,
+                                      const unsigned long aDst) const {
+  if (aSrc < boost::num_vertices(theGraph)) {
+    for (const auto& myEdge :
+         boost::make_iterator_range(boost::out_edges(aSrc, theGraph))) {
+      if (boost::target(myEdge, theGraph) == aDst) {
+        return boost::get(boost::edge_index, theGraph, myEdge);
+      }
+    }
+  }
+  throw std::runtime_error("edge not in the graph: (" + std::to_string(aSrc) +
+                           "," + std::to_string(aDst) + ")");
+}
+
+void ConcurrentNetwork::shortestPath(const unsigned long         aSrc,
+                                     const unsigned long         aDst,
+                                     Workspace&                  aWorkspace,
+                                     std::vector<unsigned long>& aPath) const {
+  using Index  = boost::property_map<Graph, boost::edge_index_t>::const_type;
+  using Filter = EdgeFilter<Workspace, Index>;
+  const boost::filtered_graph<Graph, Filter> myGraph(
+      theGraph, Filter(aWorkspace, boost::get(boost::edge_index, theGraph)));
+  auto& myPredecessors = aWorkspace.thePredecessors;
+  boost::dijkstra_shortest_paths(
+      myGraph,
+      aSrc,
+      boost::predecessor_map(myPredecessors.data())
+          .weight_map(boost::make_static_property_map<EdgeDescriptor>(1))
+          .distance_map(boost::make_iterator_property_map(
+              aWorkspace.theDistances.data(),
+              get(boost::vertex_index, theGraph))));
+
+  aPath.clear();
+  if (myPredecessors[aDst] == aDst) {
+    return; // disconnected
+  }
+  for (auto myCur = aDst; myCur != aSrc; myCur = myPredecessors[myCur]) {
+    aPath.emplace_back(myCur);
+  }
+  std::reverse(aPath.begin(), aPath.end());
+}
+
+std::size_t ConcurrentNetwork::reserve(const std::vector<std::size_t>& aEdges,
+                                       const double aCapacity) {
+  // the capacity of an edge is never read together with that of another
+  // edge, hence relaxed ordering is enough to never reserve more capacity
+  // than available on any edge
+  for (std::size_t i = 0; i < aEdges.size(); i++) {
+    auto& myCapacity = theCapacities[aEdges[i]];
+    auto  myCurrent  = myCapacity.load(std::memory_order_relaxed);
+    do {
+      if (myCurrent < aCapacity) {
+        add(aEdges, i, aCapacity); // roll back
+        return i;
+      }
+    } while (not myCapacity.compare_exchange_weak(
+        myCurrent, myCurrent - aCapacity, std::memory_order_relaxed));
+  }
+  return aEdges.size();
+}
+
+void ConcurrentNetwork::add(const std::vector<std::size_t>& aEdges,
+                            const std::size_t               aNum,
+                            const double                    aCapacity) {
+  assert(aNum <= aEdges.size());
+  for (std::size_t i = 0; i < aNum; i++) {
+    auto& myCapacity = theCapacities[aEdges[i]];
+    auto  myCurrent  = myCapacity.load(std::memory_order_relaxed);
+    while (not myCapacity.compare_exchange_weak(
+        myCurrent, myCurrent + aCapacity, std::memory_order_relaxed)) {
+      // retry with the updated value
+    }
+  }
+}
+
+double ConcurrentNetwork::toGrossRate(const double      aNetRate,
+                                      const std::size_t aNumEdges) const {
+  if (aNumEdges <= 1) {
+    return aNetRate;
+  }
+  return aNetRate / theSwapSuccess(aNumEdges - 1);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,192 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/network.h"
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief A quantum network in which flows can be admitted and released
+ * concurrently by multiple threads.
+ *
+ * The topology cannot be changed after creation, hence the path search runs
+ * on the graph without any synchronization, while the capacity of each edge
+ * is an atomic variable. When a path is found whose edges all have enough
+ * residual capacity, the gross rate is reserved edge by edge with
+ * compare-and-swap: if another thread has reserved capacity on one of the
+ * edges in the meanwhile, so that the flow does not fit anymore, the partial
+ * reservations are rolled back and the search continues as if the edge had
+ * not enough capacity in the first place.
+ *
+ * Without concurrency, the flows are routed exactly as with
+ * CapacityNetwork::route().
+ */
+class ConcurrentNetwork final : public Network
+{
+ public:
+  using FlowDescriptor    = CapacityNetwork::FlowDescriptor;
+  using FlowCheckFunction = CapacityNetwork::FlowCheckFunction;
+
+  /**
+   * @brief Create a network with given links and capacities.
+   *
+   * The default measurement probability is 1.
+   *
+   * @param aEdgeWeights The unidirectional edges and weights of the network
+   * (src, dst, w).
+   *
+   * @throw std::runtime_error if there are duplicate edges
+   */
+  explicit ConcurrentNetwork(const CapacityNetwork::WeightVector& aEdgeWeights);
+
+  /**
+   * @brief Set the measurement probability.
+   *
+   * Not thread-safe: it must be called before admitting flows.
+   *
+   * @throw std::runtime_error if the measurement probability is not in [0,1]
+   */
+  void measurementProbability(const double aMeasurementProbability);
+
+  //! \return the measurement probability.
+  double measurementProbability() const noexcept {
+    return theMeasurementProbability;
+  }
+
+  //! \return the number of nodes.
+  std::size_t numNodes() const;
+
+  //! \return the number of edges.
+  std::size_t numEdges() const;
+
+  //! \return the total EPR capacity across all the edges, not a snapshot.
+  double totalCapacity() const;
+
+  //! \return the current weights, not a snapshot.
+  CapacityNetwork::WeightVector weights() const;
+
+  /**
+   * @brief Route a flow starting with the current capacities.
+   *
+   * Can be called concurrently by multiple threads, also with release().
+   *
+   * @param aFlow the flow to be routed, which is updated with the routing info
+   * if admitted
+   * @param aCheckFunction the flow is considered feasible only if this
+   * function returns true, otherwise it is inadmissible; the default is to
+   * always accept the flow
+   * @return true if the flow has been admitted
+   *
+   * @throw std::runtime_error if the flow is ill-formed, in which case the
+   * capacities are not changed
+   */
+  bool admit(
+      FlowDescriptor&          aFlow,
+      const FlowCheckFunction& aCheckFunction = [](const auto&) {
+        return true;
+      });
+
+  /**
+   * @brief Release the gross rate reserved by a flow that has been admitted.
+   *
+   * Can be called concurrently by multiple threads, also with admit().
+   *
+   * @throw std::runtime_error if one of the edges in the path does not exist
+   */
+  void release(const FlowDescriptor& aFlow);
+
+  //! \return the number of reservations rolled back because of contention.
+  std::size_t numConflicts() const noexcept {
+    return theConflicts.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using Graph =
+      boost::adjacency_list<boost::vecS,
+                            boost::vecS,
+                            boost::directedS,
+                            boost::no_property,
+                            boost::property<boost::edge_index_t, std::size_t>>;
+  using VertexDescriptor = boost::graph_traits<Graph>::vertex_descriptor;
+  using EdgeDescriptor   = boost::graph_traits<Graph>::edge_descriptor;
+
+  struct Workspace;
+
+  //! \return the edge identifier, or throw if the edge does not exist.
+  std::size_t edgeId(const unsigned long aSrc, const unsigned long aDst) const;
+
+  //! Find the shortest path without the removed edges, empty if none.
+  void shortestPath(const unsigned long         aSrc,
+                    const unsigned long         aDst,
+                    Workspace&                  aWorkspace,
+                    std::vector<unsigned long>& aPath) const;
+
+  /**
+   * @brief Reserve a capacity on all the given edges, or none of them.
+   *
+   * @return the position of the edge without enough capacity, or the number
+   * of edges if the reservation succeeded
+   */
+  std::size_t reserve(const std::vector<std::size_t>& aEdges,
+                      const double                    aCapacity);
+
+  //! Add a capacity on the first aNum given edges.
+  void add(const std::vector<std::size_t>& aEdges,
+           const std::size_t               aNum,
+           const double                    aCapacity);
+
+  double toGrossRate(const double aNetRate, const std::size_t aNumEdges) const;
+
+ private:
+  Graph theGraph;
+  //! residual capacities, indexed by edge identifier.
+  std::unique_ptr<std::atomic<double>[]> theCapacities;
+  double                                 theMeasurementProbability;
+  PowerTable                             theSwapSuccess;
+  std::atomic<std::size_t>               theConflicts;
+};
+
+} // namespace qr
+} // namespace uiiit
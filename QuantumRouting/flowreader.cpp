@@ -0,0 +1,199 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/flowreader.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+const char MAGIC[] = "QRFLOWS1";
+
+//! Parse a number followed by the given terminator, advancing the pointer.
+template <class T>
+bool parse(const char*& aPtr, const char aTerminator, T& aValue) {
+  char* myEnd = nullptr;
+  errno       = 0;
+  if constexpr (std::is_floating_point_v<T>) {
+    aValue = std::strtod(aPtr, &myEnd);
+  } else {
+    const auto myValue = std::strtoul(aPtr, &myEnd, 10);
+    if (*aPtr == '-' or myValue > std::numeric_limits<T>::max()) {
+      return false;
+    }
+    aValue = static_cast<T>(myValue);
+  }
+  if (myEnd == aPtr or errno != 0 or *myEnd != aTerminator) {
+    return false;
+  }
+  aPtr = myEnd + 1;
+  return true;
+}
+
+} // namespace
+
+bool FlowRequest::operator==(const FlowRequest& aOther) const noexcept {
+  return theTime == aOther.theTime and theSrc == aOther.theSrc and
+         theDst == aOther.theDst and theNetRate == aOther.theNetRate and
+         theFidelityThreshold == aOther.theFidelityThreshold;
+}
+
+std::string FlowRequest::toString() const {
+  std::stringstream myStream;
+  myStream << "time " << theTime << ", " << theSrc << " -> " << theDst
+           << ", net rate " << theNetRate << ", fidelity threshold "
+           << theFidelityThreshold;
+  return myStream.str();
+}
+
+FlowReader::FlowReader(const std::string& aFilename,
+                       const std::size_t  aNumNodes,
+                       const std::size_t  aBufferSize)
+    : theFilename(aFilename)
+    , theNumNodes(aNumNodes)
+    , theStream(aFilename, std::ios::binary)
+    , theBinary(false)
+    , theBuffer()
+    , theBufferPos(0)
+    , theLine()
+    , theLineNumber(0)
+    , theCount(0)
+    , theLastTime(0) {
+  if (not theStream) {
+    throw std::runtime_error("cannot read flows from file: " + aFilename);
+  }
+  if (aBufferSize == 0) {
+    throw std::runtime_error("invalid null buffer size to read flows");
+  }
+
+  char myMagic[sizeof(MAGIC) - 1];
+  theStream.read(myMagic, sizeof(myMagic));
+  theBinary = theStream.gcount() == sizeof(myMagic) and
+              std::memcmp(myMagic, MAGIC, sizeof(myMagic)) == 0;
+  if (theBinary) {
+    theBuffer.reserve(aBufferSize);
+  } else {
+    theStream.clear();
+    theStream.seekg(0);
+  }
+}
+
+bool FlowReader::next(FlowRequest& aRequest) {
+  if (not(theBinary ? nextBinary(aRequest) : nextCsv(aRequest))) {
+    return false;
+  }
+  ++theCount;
+
+  if (not(aRequest.theTime >= theLastTime)) {
+    error("flow arrives before the previous one: " + aRequest.toString());
+  }
+  if (aRequest.theSrc >= theNumNodes or aRequest.theDst >= theNumNodes) {
+    error("node out of range in a network with " +
+          std::to_string(theNumNodes) + " nodes: " + aRequest.toString());
+  }
+  if (aRequest.theSrc == aRequest.theDst) {
+    error("flow from a node to itself: " + aRequest.toString());
+  }
+  if (not(aRequest.theNetRate > 0)) {
+    error("invalid nonpositive net rate: " + aRequest.toString());
+  }
+  if (not(aRequest.theFidelityThreshold >= 0 and
+          aRequest.theFidelityThreshold <= 1)) {
+    error("invalid fidelity threshold: " + aRequest.toString());
+  }
+  theLastTime = aRequest.theTime;
+  return true;
+}
+
+bool FlowReader::nextBinary(FlowRequest& aRequest) {
+  if (theBufferPos == theBuffer.size()) {
+    theBuffer.resize(theBuffer.capacity());
+    theStream.read(reinterpret_cast<char*>(theBuffer.data()),
+                   theBuffer.size() * sizeof(FlowRequest));
+    const auto myBytes = static_cast<std::size_t>(theStream.gcount());
+    if (myBytes % sizeof(FlowRequest) != 0) {
+      error("truncated flow request");
+    }
+    theBuffer.resize(myBytes / sizeof(FlowRequest));
+    theBufferPos = 0;
+    if (theBuffer.empty()) {
+      return false;
+    }
+  }
+  aRequest = theBuffer[theBufferPos++];
+  return true;
+}
+
+bool FlowReader::nextCsv(FlowRequest& aRequest) {
+  while (std::getline(theStream, theLine)) {
+    ++theLineNumber;
+    if (not theLine.empty() and theLine.back() == '\r') {
+      theLine.pop_back();
+    }
+    if (theLine.empty() or theLine[0] == '#' or
+        (theLineNumber == 1 and
+         not std::isdigit(static_cast<unsigned char>(theLine[0])))) {
+      continue;
+    }
+
+    const char* myPtr = theLine.c_str();
+    if (not parse(myPtr, ',', aRequest.theTime) or
+        not parse(myPtr, ',', aRequest.theSrc) or
+        not parse(myPtr, ',', aRequest.theDst) or
+        not parse(myPtr, ',', aRequest.theNetRate) or
+        not parse(myPtr, '\0', aRequest.theFidelityThreshold)) {
+      error("invalid flow request: " + theLine);
+    }
+    return true;
+  }
+  return false;
+}
+
+void FlowReader::error(const std::string& aWhat) const {
+  throw std::runtime_error(
+      theFilename + ":" +
+      (theBinary ? "request " + std::to_string(theCount) :
+                   "line " + std::to_string(theLineNumber)) +
+      ": " + aWhat);
+}
+
+} // namespace qr
+} // namespace uiiit
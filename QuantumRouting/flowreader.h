@@ -0,0 +1,127 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <cinttypes>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+//! Request of a new flow, e.g., from a production log.
+struct FlowRequest {
+  double        theTime;              //!< arrival time
+  std::uint32_t theSrc;               //!< source node
+  std::uint32_t theDst;               //!< destination node
+  double        theNetRate;           //!< net rate requested, in EPR pairs/s
+  double        theFidelityThreshold; //!< minimum end-to-end fidelity
+
+  bool operator==(const FlowRequest& aOther) const noexcept;
+
+  std::string toString() const;
+};
+static_assert(sizeof(FlowRequest) == 32, "unexpected flow request size");
+
+/**
+ * @brief Read flow requests incrementally from a file, so that the memory
+ * used does not depend on the size of the file.
+ *
+ * Two formats are supported, detected automatically:
+ * - binary: magic "QRFLOWS1" (8 bytes) followed by FlowRequest records, in
+ *   native byte order
+ * - CSV: one request per line as time,src,dst,net-rate,fidelity-threshold;
+ *   empty lines and lines beginning with '#' are ignored, as well as the first
+ *   line if it does not begin with a digit, i.e., a header
+ *
+ * The requests must be sorted by non-decreasing time.
+ */
+class FlowReader final
+{
+  NONCOPYABLE_NONMOVABLE(FlowReader);
+
+ public:
+  /**
+   * @brief Open the file and detect its format.
+   *
+   * @param aFilename the name of the input file
+   * @param aNumNodes the number of nodes of the network, which must be
+   * greater than the source and destination of all the requests
+   * @param aBufferSize the number of records read at once in binary format
+   *
+   * @throw std::runtime_error if the file cannot be read
+   */
+  explicit FlowReader(const std::string& aFilename,
+                      const std::size_t  aNumNodes,
+                      const std::size_t  aBufferSize = 4096);
+
+  /**
+   * @brief Read the next request.
+   *
+   * @param aRequest set to the request read, if any
+   *
+   * \return true if a request has been read, false at the end of the file
+   *
+   * @throw std::runtime_error if the request is not valid
+   */
+  bool next(FlowRequest& aRequest);
+
+  //! \return the number of requests read so far.
+  std::size_t count() const noexcept {
+    return theCount;
+  }
+
+ private:
+  bool nextBinary(FlowRequest& aRequest);
+  bool nextCsv(FlowRequest& aRequest);
+
+  //! @throw std::runtime_error with the file name and position.
+  [[noreturn]] void error(const std::string& aWhat) const;
+
+ private:
+  const std::string        theFilename;
+  const std::size_t        theNumNodes;
+  std::ifstream            theStream;
+  bool                     theBinary;
+  std::vector<FlowRequest> theBuffer;
+  std::size_t              theBufferPos;
+  std::string              theLine;
+  std::size_t              theLineNumber;
+  std::size_t              theCount;
+  double                   theLastTime;
+};
+
+} // namespace qr
+} // namespace uiiit
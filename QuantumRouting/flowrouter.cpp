@@ -0,0 +1,249 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/flowrouter.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <thread>
+
+namespace uiiit {
+namespace qr {
+
+FlowRouter::Request::Request(const FlowDescriptor& aFlow, const bool aRelease)
+    : theFlow(aFlow)
+    , theRelease(aRelease)
+    , theAdmitted()
+    , theReleased() {
+  // noop
+}
+
+FlowRouter::FlowRouter(std::unique_ptr<CapacityNetwork>&& aNetwork,
+                       const std::size_t                  aMaxBatch,
+                       const FlowCheckFunction&           aCheckFunction,
+                       const bool                         aSnapshots)
+    : theMaxBatch(aMaxBatch)
+    , theCheckFunction(aCheckFunction)
+    , theNetwork(std::move(aNetwork))
+    , theQueue()
+    , theSnapshots()
+    , theSleeping(false)
+    , theStopping(false)
+    , thePushing(0)
+    , theMutex()
+    , theCondition()
+    , theNumRequests(0)
+    , theNumBatches(0)
+    , theWriter() {
+  if (theNetwork.get() == nullptr) {
+    throw std::runtime_error("cannot create a flow router without a network");
+  }
+  if (theMaxBatch == 0) {
+    throw std::runtime_error("invalid null maximum batch size");
+  }
+  if (aSnapshots) {
+    theSnapshots =
+        std::make_unique<Rcu<CapacityNetwork>>(theNetwork->clone());
+  }
+  theWriter = std::thread([this]() { loop(); });
+}
+
+FlowRouter::~FlowRouter() {
+  stop();
+}
+
+std::future<FlowRouter::FlowDescriptor>
+FlowRouter::submit(const FlowDescriptor& aFlow) {
+  Request myRequest(
+      FlowDescriptor(aFlow.theSrc, aFlow.theDst, aFlow.theNetRate), false);
+  auto ret = myRequest.theAdmitted.get_future();
+  push(std::move(myRequest));
+  return ret;
+}
+
+std::future<void> FlowRouter::release(const FlowDescriptor& aFlow) {
+  Request myRequest(aFlow, true);
+  auto    ret = myRequest.theReleased.get_future();
+  push(std::move(myRequest));
+  return ret;
+}
+
+std::unique_ptr<Rcu<CapacityNetwork>::Reader> FlowRouter::reader() {
+  if (theSnapshots.get() == nullptr) {
+    throw std::runtime_error("the snapshots of the network are not enabled");
+  }
+  return theSnapshots->reader();
+}
+
+std::unique_ptr<CapacityNetwork> FlowRouter::stop() {
+  if (not theWriter.joinable()) {
+    return nullptr;
+  }
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theStopping.store(true);
+  }
+  theCondition.notify_one();
+  theWriter.join();
+  return std::move(theNetwork);
+}
+
+void FlowRouter::push(Request&& aRequest) {
+  // announce the push before checking the flag: if the writer finds no
+  // push in progress after stop() then the request is rejected here or it is
+  // already in the queue when the writer drains it for the last time
+  thePushing.fetch_add(1);
+  if (theStopping.load()) {
+    thePushing.fetch_sub(1);
+    throw std::runtime_error("cannot enqueue requests in a stopped router");
+  }
+  theQueue.push(std::move(aRequest));
+  thePushing.fetch_sub(1);
+
+  // pairs with the fence in loop(): either the writer finds the request in
+  // the queue or we find that the writer is about to sleep
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (theSleeping.load(std::memory_order_relaxed) and
+      theSleeping.exchange(false)) {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theCondition.notify_one();
+  }
+}
+
+void FlowRouter::loop() {
+  std::vector<Request> myBatch;
+  myBatch.reserve(theMaxBatch);
+  while (true) {
+    // read before draining, so that all the requests enqueued before stop()
+    // are found in the queue, including those of the push() in progress
+    const auto myStopping = theStopping.load();
+    const auto myLast     = myStopping and thePushing.load() == 0;
+    while (myBatch.size() < theMaxBatch) {
+      auto myRequest = theQueue.pop();
+      if (not myRequest.has_value()) {
+        break;
+      }
+      myBatch.emplace_back(std::move(*myRequest));
+    }
+
+    if (not myBatch.empty()) {
+      serve(myBatch);
+      myBatch.clear();
+      if (theSnapshots) {
+        theSnapshots->publish(theNetwork->clone());
+      }
+      continue;
+    }
+
+    if (myLast) {
+      break;
+    }
+    if (myStopping) {
+      // wait for the push() in progress to enqueue or reject their requests
+      std::this_thread::yield();
+      continue;
+    }
+
+    // announce that we are about to sleep, then look at the queue again
+    // before actually waiting
+    if (not theSleeping.load(std::memory_order_relaxed)) {
+      theSleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      continue;
+    }
+    std::unique_lock<std::mutex> myLock(theMutex);
+    theCondition.wait(myLock, [this]() {
+      return not theSleeping.load() or theStopping.load();
+    });
+    theSleeping.store(false, std::memory_order_relaxed);
+  }
+}
+
+void FlowRouter::serve(std::vector<Request>& aBatch) {
+  assert(not aBatch.empty());
+  auto it = aBatch.begin();
+  while (it != aBatch.end()) {
+    if (it->theRelease) {
+      try {
+        theNetwork->addCapacityToPath(
+            it->theFlow.theSrc, it->theFlow.thePath, it->theFlow.theGrossRate);
+        it->theReleased.set_value();
+      } catch (...) {
+        it->theReleased.set_exception(std::current_exception());
+      }
+      ++it;
+
+    } else {
+      auto myEnd = it;
+      while (myEnd != aBatch.end() and not myEnd->theRelease) {
+        ++myEnd;
+      }
+      admit(it, myEnd);
+      it = myEnd;
+    }
+  }
+  theNumRequests.fetch_add(aBatch.size(), std::memory_order_relaxed);
+  theNumBatches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FlowRouter::admit(std::vector<Request>::iterator aBegin,
+                       std::vector<Request>::iterator aEnd) {
+  std::vector<FlowDescriptor> myFlows;
+  myFlows.reserve(aEnd - aBegin);
+  for (auto it = aBegin; it != aEnd; ++it) {
+    myFlows.emplace_back(it->theFlow);
+  }
+
+  try {
+    theNetwork->route(myFlows, theCheckFunction);
+  } catch (...) {
+    // route() does not change the network if a flow is ill-formed: retry
+    // the flows one by one to find out which requests have to fail
+    for (auto it = aBegin; it != aEnd; ++it) {
+      std::vector<FlowDescriptor> mySingle({it->theFlow});
+      try {
+        theNetwork->route(mySingle, theCheckFunction);
+        it->theAdmitted.set_value(mySingle.front());
+      } catch (...) {
+        it->theAdmitted.set_exception(std::current_exception());
+      }
+    }
+    return;
+  }
+
+  auto myFlow = myFlows.begin();
+  for (auto it = aBegin; it != aEnd; ++it, ++myFlow) {
+    it->theAdmitted.set_value(*myFlow);
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,206 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/mpscqueue.h"
+#include "QuantumRouting/rcu.h"
+#include "Support/macros.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Route flows submitted by many threads in a network modified by a
+ * single writer thread.
+ *
+ * Admission and release requests are appended by the clients to a lock-free
+ * ingress queue, from which the writer drains them in batches of up to a
+ * given size. The consecutive admission requests in a batch are routed with
+ * a single call to CapacityNetwork::route(), which shares its scratch state
+ * and the shortest path trees among all the flows, while the releases are
+ * applied in between, so that the outcome is the same as if all the
+ * requests were served one by one in the order in which they were enqueued.
+ * Each request is completed by fulfilling the future returned to the client.
+ *
+ * Larger batches amortize the cost of waking up the writer and of the path
+ * searches over more flows, which increases the throughput, at the expense
+ * of the latency of the first requests in the batch when the load is high.
+ *
+ * Optionally, the writer publishes a copy of the network after every batch,
+ * with Rcu, so that any number of threads can query consistent snapshots of
+ * the residual capacities, e.g., for monitoring, without locks and without
+ * stalling the writer. The copy costs O(V + E) per batch.
+ */
+class FlowRouter final
+{
+  NONCOPYABLE_NONMOVABLE(FlowRouter);
+
+ public:
+  using FlowDescriptor    = CapacityNetwork::FlowDescriptor;
+  using FlowCheckFunction = CapacityNetwork::FlowCheckFunction;
+
+  /**
+   * @brief Start the writer thread.
+   *
+   * @param aNetwork the network in which flows are routed
+   * @param aMaxBatch the maximum number of requests served in a batch
+   * @param aCheckFunction the check function passed to route()
+   * @param aSnapshots true to publish a snapshot of the network after every
+   * batch, see reader()
+   *
+   * @throw std::runtime_error if the network is null or aMaxBatch is zero
+   */
+  explicit FlowRouter(
+      std::unique_ptr<CapacityNetwork>&& aNetwork,
+      const std::size_t                  aMaxBatch,
+      const FlowCheckFunction&           aCheckFunction = [](const auto&) {
+        return true;
+      },
+      const bool aSnapshots = false);
+
+  //! Serve all the pending requests, then terminate the writer thread.
+  ~FlowRouter();
+
+  /**
+   * @brief Request the admission of a flow. Can be called by any thread.
+   *
+   * @param aFlow the flow to be admitted, of which only the source,
+   * destination, and net rate are used
+   *
+   * \return a future with the flow routed, whose path is empty if it has not
+   * been admitted, or which holds the exception thrown by route() if the flow
+   * is ill-formed
+   *
+   * @throw std::runtime_error if the router has been stopped
+   */
+  std::future<FlowDescriptor> submit(const FlowDescriptor& aFlow);
+
+  /**
+   * @brief Request the release of a flow previously admitted. Can be called
+   * by any thread.
+   *
+   * @param aFlow the flow as returned by the future of submit()
+   *
+   * \return a future that is ready when the capacity has been returned to
+   * the network, or which holds the exception thrown if the path does not
+   * exist
+   *
+   * @throw std::runtime_error if the router has been stopped
+   */
+  std::future<void> release(const FlowDescriptor& aFlow);
+
+  /**
+   * @brief Serve all the pending requests and terminate the writer thread.
+   *
+   * The requests submitted concurrently are either served or rejected with
+   * an exception. Must not be called concurrently with itself.
+   *
+   * \return the network, with the capacity of the flows admitted and not
+   * released reserved, or nullptr if already stopped.
+   */
+  std::unique_ptr<CapacityNetwork> stop();
+
+  /**
+   * @brief Register a reader of the snapshots of the network. Can be called
+   * by any thread.
+   *
+   * The version 0 of the snapshots is the network upon construction, then a
+   * new version is published after every batch served. The reader must be
+   * destroyed before this object.
+   *
+   * @throw std::runtime_error if the snapshots are not enabled or there are
+   * too many readers
+   */
+  std::unique_ptr<Rcu<CapacityNetwork>::Reader> reader();
+
+  //! \return the number of requests served so far.
+  std::size_t numRequests() const noexcept {
+    return theNumRequests.load(std::memory_order_relaxed);
+  }
+
+  //! \return the number of batches served so far.
+  std::size_t numBatches() const noexcept {
+    return theNumBatches.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Request {
+    explicit Request(const FlowDescriptor& aFlow, const bool aRelease);
+
+    FlowDescriptor               theFlow;
+    bool                         theRelease;
+    std::promise<FlowDescriptor> theAdmitted;
+    std::promise<void>           theReleased;
+  };
+
+  //! Enqueue a request and wake up the writer, if needed.
+  void push(Request&& aRequest);
+
+  //! Body of the writer thread.
+  void loop();
+
+  //! Serve a batch of requests.
+  void serve(std::vector<Request>& aBatch);
+
+  //! Route the admission requests in [aBegin, aEnd).
+  void admit(std::vector<Request>::iterator aBegin,
+             std::vector<Request>::iterator aEnd);
+
+ private:
+  const std::size_t                     theMaxBatch;
+  const FlowCheckFunction               theCheckFunction;
+  std::unique_ptr<CapacityNetwork>      theNetwork;
+  MpscQueue<Request>                    theQueue;
+  std::unique_ptr<Rcu<CapacityNetwork>> theSnapshots; //!< null if disabled
+
+  std::atomic<bool>        theSleeping;
+  std::atomic<bool>        theStopping;
+  std::atomic<std::size_t> thePushing; //!< number of push() in progress
+  std::mutex               theMutex;
+  std::condition_variable  theCondition;
+  std::atomic<std::size_t> theNumRequests;
+  std::atomic<std::size_t> theNumBatches;
+  std::thread              theWriter;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,194 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/instrumentation.h"
+
+#include <sstream>
+
+namespace uiiit {
+namespace qr {
+
+WorkCounters& WorkCounters::operator+=(const WorkCounters& aOther) noexcept {
+  theVerticesSettled += aOther.theVerticesSettled;
+  theEdgesScanned += aOther.theEdgesScanned;
+  theGraphCopies += aOther.theGraphCopies;
+  theKspSearches += aOther.theKspSearches;
+  theEdgeLookups += aOther.theEdgeLookups;
+  theLabelsExpanded += aOther.theLabelsExpanded;
+  return *this;
+}
+
+const std::vector<std::string>& WorkCounters::names() {
+  static const std::vector<std::string> ret({
+      "vertices-settled",
+      "edges-scanned",
+      "graph-copies",
+      "ksp-searches",
+      "edge-lookups",
+      "labels-expanded",
+  });
+  return ret;
+}
+
+std::string WorkCounters::toString() const {
+  std::stringstream myStream;
+  myStream << theVerticesSettled << " vertices settled, " << theEdgesScanned
+           << " edges scanned, " << theGraphCopies << " graph copies, "
+           << theKspSearches << " k-shortest path searches, "
+           << theEdgeLookups << " edge lookups, " << theLabelsExpanded
+           << " labels expanded";
+  return myStream.str();
+}
+
+std::string WorkCounters::toCsv() const {
+  std::stringstream myStream;
+  myStream << theVerticesSettled << ',' << theEdgesScanned << ','
+           << theGraphCopies << ',' << theKspSearches << ','
+           << theEdgeLookups << ',' << theLabelsExpanded;
+  return myStream.str();
+}
+
+PhaseTimers::Scope::Scope(PhaseTimers* aTimers, const Phase aPhase)
+    : theTimers(aTimers)
+    , thePhase(aPhase)
+    , theStartSample(aTimers == nullptr or not aTimers->hasPerfCounters() ?
+                         PerfCounters::Sample() :
+                         aTimers->thePerfCounters->read())
+    , theStart(aTimers == nullptr ? std::chrono::steady_clock::time_point() :
+                                    std::chrono::steady_clock::now()) {
+  // noop
+}
+
+PhaseTimers::Scope::~Scope() {
+  if (theTimers != nullptr) {
+    theTimers->add(thePhase,
+                   std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - theStart)
+                       .count());
+    if (theTimers->hasPerfCounters()) {
+      theTimers->theSamples[static_cast<std::size_t>(thePhase)] +=
+          theTimers->thePerfCounters->read() - theStartSample;
+    }
+  }
+}
+
+const std::vector<std::string>& PhaseTimers::names(const bool aPerfCounters) {
+  static const std::vector<std::string> myPhases({
+      "topology",
+      "connectivity",
+      "diameter",
+      "routing",
+      "statistics",
+  });
+  static const std::vector<std::string> ret = [] {
+    std::vector<std::string> myNames;
+    for (const auto& myPhase : myPhases) {
+      myNames.emplace_back("time-" + myPhase);
+    }
+    return myNames;
+  }();
+  static const std::vector<std::string> retPerf = [] {
+    auto myNames = ret;
+    for (const auto& myPhase : myPhases) {
+      for (const auto& myCounter : PerfCounters::Sample::names()) {
+        myNames.emplace_back(myCounter + "-" + myPhase);
+      }
+    }
+    return myNames;
+  }();
+  return aPerfCounters ? retPerf : ret;
+}
+
+std::string PhaseTimers::toString() const {
+  std::stringstream myStream;
+  myStream << "topology " << theElapsed[0] << " s, connectivity "
+           << theElapsed[1] << " s, diameter " << theElapsed[2]
+           << " s, routing " << theElapsed[3] << " s, statistics "
+           << theElapsed[4] << " s";
+  if (hasPerfCounters()) {
+    for (std::size_t i = 0; i < NUM_PHASES; i++) {
+      myStream << "; " << names()[i].substr(5) << ' '
+               << theSamples[i].toString();
+    }
+  }
+  return myStream.str();
+}
+
+std::string PhaseTimers::toCsv() const {
+  std::stringstream myStream;
+  for (std::size_t i = 0; i < NUM_PHASES; i++) {
+    myStream << (i == 0 ? "" : ",") << theElapsed[i];
+  }
+  if (hasPerfCounters()) {
+    for (const auto& mySample : theSamples) {
+      myStream << ',' << mySample.toCsv();
+    }
+  }
+  return myStream.str();
+}
+
+const std::vector<std::string>&
+Instrumentation::names(const bool aPerfCounters, const bool aMemory) {
+  static const auto myMakeNames = [](const bool aWithPerfCounters,
+                                     const bool aWithMemory) {
+    auto myNames = PhaseTimers::names(aWithPerfCounters);
+    myNames.insert(myNames.end(),
+                   WorkCounters::names().begin(),
+                   WorkCounters::names().end());
+    if (aWithMemory) {
+      myNames.insert(myNames.end(),
+                     MemoryUsage::names().begin(),
+                     MemoryUsage::names().end());
+    }
+    return myNames;
+  };
+  static const std::array<std::vector<std::string>, 4> ret{{
+      myMakeNames(false, false),
+      myMakeNames(true, false),
+      myMakeNames(false, true),
+      myMakeNames(true, true),
+  }};
+  return ret[(aPerfCounters ? 1 : 0) + (aMemory ? 2 : 0)];
+}
+
+std::string Instrumentation::toString() const {
+  return "time spent: " + theTimers.toString() +
+         "; work done: " + theCounters.toString() +
+         (theMemory.has_value() ? "; memory: " + theMemory->toString() : "");
+}
+
+std::string Instrumentation::toCsv() const {
+  return theTimers.toCsv() + ',' + theCounters.toCsv() +
+         (theMemory.has_value() ? ',' + theMemory->toCsv() : "");
+}
+
+} // namespace qr
+} // namespace uiiit
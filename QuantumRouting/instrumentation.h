@@ -0,0 +1,182 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/memoryaccounting.h"
+#include "QuantumRouting/perfcounters.h"
+#include "Support/macros.h"
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Counters of the work done by the routing algorithms.
+ *
+ * The counters are only incremented, they can be reset by assigning a
+ * default-constructed object.
+ */
+struct WorkCounters {
+  std::size_t theVerticesSettled = 0; //!< vertices extracted by Dijkstra
+  std::size_t theEdgesScanned    = 0; //!< edges examined by Dijkstra
+  std::size_t theGraphCopies     = 0; //!< copies of the whole graph
+  std::size_t theKspSearches     = 0; //!< searches of k-shortest paths
+  std::size_t theEdgeLookups     = 0; //!< edges looked up from end-points
+  std::size_t theLabelsExpanded  = 0; //!< labels of the constrained search
+
+  WorkCounters& operator+=(const WorkCounters& aOther) noexcept;
+
+  //! \return the names of the counters, in the same order as toCsv().
+  static const std::vector<std::string>& names();
+
+  std::string toString() const;
+  std::string toCsv() const;
+};
+
+/**
+ * @brief Wall-clock time spent in the phases of an experiment and,
+ * optionally, the hardware performance counters.
+ *
+ * The time is accumulated with Scope objects, which measure the time between
+ * their creation and destruction.
+ */
+class PhaseTimers final
+{
+ public:
+  enum class Phase : std::size_t {
+    Topology     = 0, //!< creation of the network
+    Connectivity = 1, //!< check that the network is connected
+    Diameter     = 2, //!< computation of the distances between nodes
+    Routing      = 3, //!< admission and release of flows and apps
+    Statistics   = 4, //!< collection of the output metrics
+  };
+  static constexpr std::size_t NUM_PHASES = 5;
+
+  /**
+   * @brief Add the time elapsed, and the performance counters increments if
+   * enabled, during its lifetime to a phase.
+   *
+   * If the timers are null then the scope does nothing.
+   */
+  class Scope final
+  {
+    NONCOPYABLE_NONMOVABLE(Scope);
+
+   public:
+    Scope(PhaseTimers* aTimers, const Phase aPhase);
+    ~Scope();
+
+   private:
+    PhaseTimers* const                          theTimers;
+    const Phase                                 thePhase;
+    const PerfCounters::Sample                  theStartSample;
+    const std::chrono::steady_clock::time_point theStart;
+  };
+
+  /**
+   * @brief Also accumulate the performance counters in the scopes.
+   *
+   * @param aPerfCounters the counters, which must belong to the thread where
+   * the scopes are created
+   */
+  void perfCounters(const std::shared_ptr<PerfCounters>& aPerfCounters) {
+    thePerfCounters = aPerfCounters;
+  }
+
+  //! \return true if the performance counters are accumulated.
+  bool hasPerfCounters() const noexcept {
+    return static_cast<bool>(thePerfCounters);
+  }
+
+  //! \return the performance counters accumulated in a phase.
+  const PerfCounters::Sample& sample(const Phase aPhase) const noexcept {
+    return theSamples[static_cast<std::size_t>(aPhase)];
+  }
+
+  //! \return the time accumulated in a phase, in seconds.
+  double elapsed(const Phase aPhase) const noexcept {
+    return theElapsed[static_cast<std::size_t>(aPhase)];
+  }
+
+  //! Add time to a phase, in seconds.
+  void add(const Phase aPhase, const double aElapsed) noexcept {
+    theElapsed[static_cast<std::size_t>(aPhase)] += aElapsed;
+  }
+
+  /**
+   * @brief Return the names of the CSV columns, in the same order as toCsv().
+   *
+   * @param aPerfCounters true if the performance counters are accumulated
+   */
+  static const std::vector<std::string>&
+  names(const bool aPerfCounters = false);
+
+  std::string toString() const;
+  std::string toCsv() const;
+
+ private:
+  std::array<double, NUM_PHASES>               theElapsed = {};
+  std::array<PerfCounters::Sample, NUM_PHASES> theSamples = {};
+  std::shared_ptr<PerfCounters>                thePerfCounters;
+};
+
+/**
+ * @brief Phase timers and work counters of an experiment and, optionally, its
+ * memory usage.
+ */
+struct Instrumentation {
+  PhaseTimers                theTimers;
+  WorkCounters               theCounters;
+  std::optional<MemoryUsage> theMemory;
+
+  /**
+   * @brief Return the names of the CSV columns, in the same order as toCsv().
+   *
+   * @param aPerfCounters true if the performance counters are accumulated
+   * @param aMemory true if the memory usage is measured
+   */
+  static const std::vector<std::string>&
+  names(const bool aPerfCounters = false, const bool aMemory = false);
+
+  std::string toString() const;
+  std::string toCsv() const;
+};
+
+} // namespace qr
+} // namespace uiiit
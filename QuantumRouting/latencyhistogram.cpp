@@ -0,0 +1,223 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/latencyhistogram.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+LatencyHistogram::LatencyHistogram(const unsigned aSubBucketBits)
+    : theSubBucketBits(aSubBucketBits)
+    , theCounters()
+    , theCount(0)
+    , theMin(std::numeric_limits<std::uint64_t>::max())
+    , theMax(0)
+    , theSum(0) {
+  if (aSubBucketBits < 1 or aSubBucketBits > 16) {
+    throw std::runtime_error("invalid number of sub-bucket bits: " +
+                             std::to_string(aSubBucketBits));
+  }
+  // 2^B exact values, then 64-B groups of 2^(B-1) buckets
+  theCounters.resize((1ull << aSubBucketBits) +
+                     (64 - aSubBucketBits) * (1ull << (aSubBucketBits - 1)));
+}
+
+void LatencyHistogram::record(const std::uint64_t aValue,
+                              const std::uint64_t aCount) {
+  if (aCount == 0) {
+    return;
+  }
+  theCounters[index(aValue)] += aCount;
+  theCount += aCount;
+  theMin = std::min(theMin, aValue);
+  theMax = std::max(theMax, aValue);
+  theSum += static_cast<double>(aValue) * aCount;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& aOther) {
+  if (aOther.theSubBucketBits != theSubBucketBits) {
+    throw std::runtime_error(
+        "cannot merge histograms with a different number of sub-bucket bits");
+  }
+  for (std::size_t i = 0; i < theCounters.size(); i++) {
+    theCounters[i] += aOther.theCounters[i];
+  }
+  theCount += aOther.theCount;
+  theMin = std::min(theMin, aOther.theMin);
+  theMax = std::max(theMax, aOther.theMax);
+  theSum += aOther.theSum;
+}
+
+double LatencyHistogram::mean() const noexcept {
+  return theCount == 0 ? 0 : theSum / theCount;
+}
+
+std::uint64_t LatencyHistogram::percentile(const double aPercentile) const {
+  if (aPercentile < 0 or aPercentile > 1) {
+    throw std::runtime_error("invalid percentile: " +
+                             std::to_string(aPercentile));
+  }
+  if (theCount == 0) {
+    return 0;
+  }
+
+  // nearest rank, starting from 1
+  const auto myRank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(std::ceil(aPercentile * theCount)));
+  std::uint64_t myCumulative = 0;
+  for (std::size_t i = 0; i < theCounters.size(); i++) {
+    myCumulative += theCounters[i];
+    if (myCumulative >= myRank) {
+      return std::min(highest(i), theMax);
+    }
+  }
+  assert(false);
+  return theMax;
+}
+
+std::size_t LatencyHistogram::index(const std::uint64_t aValue) const noexcept {
+  const auto myExact = 1ull << theSubBucketBits;
+  if (aValue < myExact) {
+    return aValue;
+  }
+  const auto myHalf  = myExact >> 1;
+  const auto myMsb   = 63u - __builtin_clzll(aValue);
+  const auto myShift = myMsb - (theSubBucketBits - 1);
+  assert(myShift >= 1);
+  const auto mySub = aValue >> myShift;
+  assert(mySub >= myHalf and mySub < myExact);
+  return myExact + (myShift - 1) * myHalf + (mySub - myHalf);
+}
+
+std::uint64_t
+LatencyHistogram::highest(const std::size_t aIndex) const noexcept {
+  const auto myExact = 1ull << theSubBucketBits;
+  if (aIndex < myExact) {
+    return aIndex;
+  }
+  const auto myHalf  = myExact >> 1;
+  const auto myShift = (aIndex - myExact) / myHalf + 1;
+  const auto mySub   = myHalf + (aIndex - myExact) % myHalf;
+  if (mySub + 1 == myExact and myShift + theSubBucketBits == 64) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  return ((mySub + 1) << myShift) - 1;
+}
+
+DecisionLatencies::DecisionLatencies(const std::vector<std::string>& aClasses)
+    : theClasses(aClasses)
+    , theHistograms(2 * aClasses.size()) {
+  if (aClasses.empty()) {
+    throw std::runtime_error("invalid empty set of latency classes");
+  }
+}
+
+void DecisionLatencies::record(const Decision      aDecision,
+                               const std::size_t   aClass,
+                               const std::uint64_t aNanoseconds) {
+  if (aClass >= theClasses.size()) {
+    throw std::runtime_error("invalid latency class: " +
+                             std::to_string(aClass));
+  }
+  theHistograms[static_cast<std::size_t>(aDecision) * theClasses.size() +
+                aClass]
+      .record(aNanoseconds);
+}
+
+const LatencyHistogram&
+DecisionLatencies::operator()(const Decision    aDecision,
+                              const std::size_t aClass) const {
+  if (aClass >= theClasses.size()) {
+    throw std::runtime_error("invalid latency class: " +
+                             std::to_string(aClass));
+  }
+  return theHistograms[static_cast<std::size_t>(aDecision) *
+                           theClasses.size() +
+                       aClass];
+}
+
+void DecisionLatencies::merge(const DecisionLatencies& aOther) {
+  if (aOther.theClasses != theClasses) {
+    throw std::runtime_error(
+        "cannot merge decision latencies with different classes");
+  }
+  for (std::size_t i = 0; i < theHistograms.size(); i++) {
+    theHistograms[i].merge(aOther.theHistograms[i]);
+  }
+}
+
+void DecisionLatencies::toCsv(std::ostream& aStream) const {
+  const auto myLine = [&aStream](const Decision          aDecision,
+                                 const std::string&      aClass,
+                                 const LatencyHistogram& aHistogram) {
+    aStream << toString(aDecision) << ',' << aClass << ','
+            << aHistogram.count() << ',' << aHistogram.min() << ','
+            << aHistogram.mean() << ',' << aHistogram.percentile(0.5) << ','
+            << aHistogram.percentile(0.9) << ','
+            << aHistogram.percentile(0.99) << ','
+            << aHistogram.percentile(0.999) << ','
+            << aHistogram.percentile(0.9999) << ',' << aHistogram.max()
+            << '\n';
+  };
+
+  aStream << "decision,class,count,min-ns,mean-ns,p50-ns,p90-ns,p99-ns,"
+             "p999-ns,p9999-ns,max-ns\n";
+  for (const auto myDecision : {Decision::Admission, Decision::Release}) {
+    LatencyHistogram myAll;
+    for (std::size_t i = 0; i < theClasses.size(); i++) {
+      const auto& myHistogram = (*this)(myDecision, i);
+      myLine(myDecision, theClasses[i], myHistogram);
+      myAll.merge(myHistogram);
+    }
+    if (theClasses.size() > 1) {
+      myLine(myDecision, "all", myAll);
+    }
+  }
+}
+
+std::string DecisionLatencies::toString(const Decision aDecision) {
+  switch (aDecision) {
+    case Decision::Admission:
+      return "admission";
+    case Decision::Release:
+      return "release";
+  }
+  return "unknown";
+}
+
+} // namespace qr
+} // namespace uiiit
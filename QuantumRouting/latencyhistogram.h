@@ -0,0 +1,192 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Histogram of latency values with bounded relative error over the
+ * whole range of 64-bit integers, as in HDR histograms.
+ *
+ * The values smaller than 2^B, where B is the number of sub-bucket bits, are
+ * counted exactly. The larger values are counted in buckets that double in
+ * size every 2^(B-1) buckets, hence the relative error of any value returned
+ * is at most 2^-(B-1), e.g., less than 1.6% with the default 7 bits, with a
+ * fixed memory footprint that does not depend on the values recorded.
+ */
+class LatencyHistogram final
+{
+ public:
+  /**
+   * @brief Create an empty histogram.
+   *
+   * @param aSubBucketBits the number of sub-bucket bits
+   *
+   * @throw std::runtime_error if the number of bits is not in [1, 16]
+   */
+  explicit LatencyHistogram(const unsigned aSubBucketBits = 7);
+
+  //! Record a value a given number of times.
+  void record(const std::uint64_t aValue, const std::uint64_t aCount = 1);
+
+  /**
+   * @brief Add all the values recorded in another histogram.
+   *
+   * @throw std::runtime_error if the two histograms have a different number
+   * of sub-bucket bits
+   */
+  void merge(const LatencyHistogram& aOther);
+
+  //! \return the number of values recorded.
+  std::uint64_t count() const noexcept {
+    return theCount;
+  }
+
+  //! \return the minimum value recorded, or 0 if empty.
+  std::uint64_t min() const noexcept {
+    return theCount == 0 ? 0 : theMin;
+  }
+
+  //! \return the maximum value recorded, or 0 if empty.
+  std::uint64_t max() const noexcept {
+    return theMax;
+  }
+
+  //! \return the average of the values recorded, or 0 if empty.
+  double mean() const noexcept;
+
+  /**
+   * @brief Return a percentile of the values recorded.
+   *
+   * @param aPercentile the percentile, in [0,1]
+   *
+   * \return the highest value equivalent to the one with the given rank, or
+   * 0 if empty
+   *
+   * @throw std::runtime_error if the percentile is not in [0,1]
+   */
+  std::uint64_t percentile(const double aPercentile) const;
+
+  //! \return the number of counters, which depends only on the bits.
+  std::size_t size() const noexcept {
+    return theCounters.size();
+  }
+
+ private:
+  std::size_t   index(const std::uint64_t aValue) const noexcept;
+  std::uint64_t highest(const std::size_t aIndex) const noexcept;
+
+ private:
+  unsigned                   theSubBucketBits;
+  std::vector<std::uint64_t> theCounters;
+  std::uint64_t              theCount;
+  std::uint64_t              theMin;
+  std::uint64_t              theMax;
+  double                     theSum;
+};
+
+/**
+ * @brief Latency histograms of the admission and release decisions, one per
+ * class of flows, in ns.
+ */
+class DecisionLatencies final
+{
+ public:
+  enum class Decision : std::size_t {
+    Admission = 0,
+    Release   = 1,
+  };
+
+  /**
+   * @brief Create empty histograms for the given classes.
+   *
+   * @param aClasses the names of the classes, which must not contain commas
+   *
+   * @throw std::runtime_error if there are no classes
+   */
+  explicit DecisionLatencies(const std::vector<std::string>& aClasses);
+
+  /**
+   * @brief Record the latency of a decision.
+   *
+   * @param aDecision the type of decision
+   * @param aClass the index of the class of the flow
+   * @param aNanoseconds the latency, in ns
+   *
+   * @throw std::runtime_error if the class does not exist
+   */
+  void record(const Decision      aDecision,
+              const std::size_t   aClass,
+              const std::uint64_t aNanoseconds);
+
+  //! \return the histogram of a given decision type and class.
+  const LatencyHistogram& operator()(const Decision    aDecision,
+                                     const std::size_t aClass) const;
+
+  //! \return the names of the classes.
+  const std::vector<std::string>& classes() const noexcept {
+    return theClasses;
+  }
+
+  /**
+   * @brief Add all the latencies recorded in another object.
+   *
+   * @throw std::runtime_error if the classes are not the same
+   */
+  void merge(const DecisionLatencies& aOther);
+
+  /**
+   * @brief Save the percentiles of all the histograms in CSV format, with a
+   * header line.
+   *
+   * There is one line for every decision type and class, plus one line for
+   * every decision type with class "all" if there are multiple classes.
+   */
+  void toCsv(std::ostream& aStream) const;
+
+  //! \return the name of a decision type.
+  static std::string toString(const Decision aDecision);
+
+ private:
+  std::vector<std::string>      theClasses;
+  std::vector<LatencyHistogram> theHistograms; // by decision, then class
+};
+
+} // namespace qr
+} // namespace uiiit
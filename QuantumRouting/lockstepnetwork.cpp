@@ -0,0 +1,465 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/lockstepnetwork.h"
+#include "QuantumRouting/trace.h"
+
+#include <boost/graph/breadth_first_search.hpp>
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/graph/filtered_graph.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! Filter out the edges that have been removed in a lane.
+template <class INDEX>
+struct EdgeFilter {
+  EdgeFilter() = default;
+  EdgeFilter(const std::vector<bool>& aRemoved, const INDEX aIndex)
+      : theRemoved(&aRemoved)
+      , theIndex(aIndex) {
+    // noop
+  }
+
+  template <class EDGE>
+  bool operator()(const EDGE& aEdge) const {
+    return not(*theRemoved)[boost::get(theIndex, aEdge)];
+  }
+
+  const std::vector<bool>* theRemoved = nullptr;
+  INDEX                    theIndex;
+};
+
+} // namespace
+
+LockstepNetwork::LockstepNetwork(
+    const std::vector<CapacityNetwork::WeightVector>& aLaneWeights)
+    : Network()
+    , theNumLanes(aLaneWeights.size())
+    , theGraph()
+    , theEdges()
+    , theCapacities()
+    , theDiameter(0)
+    , thePaths()
+    , theMeasurementProbability(1)
+    , theSwapSuccess()
+    , theDistances()
+    , thePredecessors() {
+  if (theNumLanes == 0) {
+    throw std::runtime_error("cannot create a lockstep network without lanes");
+  }
+
+  // the topology is taken from the first lane
+  const auto& myReference = aLaneWeights.front();
+  unsigned long myNumNodes = 0;
+  for (const auto& elem : myReference) {
+    myNumNodes = std::max(
+        myNumNodes, std::max(std::get<0>(elem), std::get<1>(elem)) + 1);
+  }
+  theGraph = Graph(myNumNodes);
+  for (std::size_t e = 0; e < myReference.size(); e++) {
+    const auto mySrc = std::get<0>(myReference[e]);
+    const auto myDst = std::get<1>(myReference[e]);
+    if (boost::edge(mySrc, myDst, theGraph).second) {
+      throw std::runtime_error("duplicate edge in lockstep network: (" +
+                               std::to_string(mySrc) + "," +
+                               std::to_string(myDst) + ")");
+    }
+    boost::add_edge(mySrc, myDst, e, theGraph);
+    theEdges.emplace_back(mySrc, myDst);
+  }
+
+  // the capacities of all the lanes for the same edge are contiguous
+  theCapacities.resize(theEdges.size() * theNumLanes);
+  for (std::size_t l = 0; l < theNumLanes; l++) {
+    const auto& myWeights = aLaneWeights[l];
+    if (myWeights.size() != theEdges.size()) {
+      throw std::runtime_error(
+          "lane " + std::to_string(l) + " has " +
+          std::to_string(myWeights.size()) + " edges instead of " +
+          std::to_string(theEdges.size()));
+    }
+    for (std::size_t e = 0; e < theEdges.size(); e++) {
+      if (std::get<0>(myWeights[e]) != theEdges[e].first or
+          std::get<1>(myWeights[e]) != theEdges[e].second) {
+        throw std::runtime_error("lane " + std::to_string(l) +
+                                 " has a different topology at edge #" +
+                                 std::to_string(e));
+      }
+      capacity(e, l) = std::get<2>(myWeights[e]);
+    }
+  }
+
+  // diameter via one BFS per source, without keeping the distances
+  const auto               V = boost::num_vertices(theGraph);
+  std::vector<std::size_t> myHops;
+  theDistances.resize(V);
+  thePredecessors.resize(V);
+  for (std::size_t s = 0; s < V; s++) {
+    hops(s, myHops);
+    theDiameter = std::max(theDiameter,
+                           *std::max_element(myHops.begin(), myHops.end()));
+  }
+}
+
+void LockstepNetwork::measurementProbability(
+    const double aMeasurementProbability) {
+  if (aMeasurementProbability < 0 or aMeasurementProbability > 1) {
+    throw std::runtime_error("Invalid measurement probability: " +
+                             std::to_string(aMeasurementProbability));
+  }
+  theMeasurementProbability = aMeasurementProbability;
+  theSwapSuccess            = PowerTable(theMeasurementProbability, numNodes());
+}
+
+std::size_t LockstepNetwork::numNodes() const {
+  return boost::num_vertices(theGraph);
+}
+
+std::size_t LockstepNetwork::numEdges() const {
+  return theEdges.size();
+}
+
+std::size_t LockstepNetwork::hops(const unsigned long aSrc,
+                                  const unsigned long aDst) const {
+  const auto V = boost::num_vertices(theGraph);
+  if (aSrc >= V or aDst >= V) {
+    throw std::runtime_error("invalid nodes: " + std::to_string(aSrc) + "," +
+                             std::to_string(aDst));
+  }
+  std::vector<std::size_t> myHops;
+  hops(aSrc, myHops);
+  return myHops[aDst];
+}
+
+std::vector<double> LockstepNetwork::totalCapacity() const {
+  std::vector<double> ret(theNumLanes, 0);
+  const auto*         myCapacity = theCapacities.data();
+  for (std::size_t e = 0; e < theEdges.size(); e++) {
+    for (std::size_t l = 0; l < theNumLanes; l++) {
+      ret[l] += myCapacity[l];
+    }
+    myCapacity += theNumLanes;
+  }
+  return ret;
+}
+
+double LockstepNetwork::totalCapacity(const std::size_t aLane) const {
+  if (aLane >= theNumLanes) {
+    throw std::runtime_error("invalid lane: " + std::to_string(aLane));
+  }
+  double ret = 0;
+  for (std::size_t e = 0; e < theEdges.size(); e++) {
+    ret += capacity(e, aLane);
+  }
+  return ret;
+}
+
+std::vector<double>
+LockstepNetwork::nodeCapacities(const std::size_t aLane) const {
+  if (aLane >= theNumLanes) {
+    throw std::runtime_error("invalid lane: " + std::to_string(aLane));
+  }
+  std::vector<double> ret(boost::num_vertices(theGraph), 0);
+  for (std::size_t e = 0; e < theEdges.size(); e++) {
+    ret[theEdges[e].first] += capacity(e, aLane);
+  }
+  return ret;
+}
+
+void LockstepNetwork::route(std::vector<std::optional<FlowDescriptor>>& aFlows,
+                            const LaneCheckFunction& aCheckFunction) {
+  const auto V = boost::num_vertices(theGraph);
+
+  // pre-condition checks
+  if (aFlows.size() != theNumLanes) {
+    throw std::runtime_error("invalid number of flows (" +
+                             std::to_string(aFlows.size()) + ") for " +
+                             std::to_string(theNumLanes) + " lanes");
+  }
+  for (const auto& myFlow : aFlows) {
+    if (not myFlow) {
+      continue;
+    }
+    assert(myFlow->thePath.empty());
+    assert(myFlow->theGrossRate == 0);
+    assert(myFlow->theDijsktra == 0);
+
+    if (myFlow->theSrc >= V) {
+      throw std::runtime_error("invalid source node in flow: " +
+                               std::to_string(myFlow->theSrc));
+    }
+    if (myFlow->theDst >= V) {
+      throw std::runtime_error("invalid destination node in flow: " +
+                               std::to_string(myFlow->theDst));
+    }
+    if (myFlow->theSrc == myFlow->theDst) {
+      throw std::runtime_error("invalid flow: from " +
+                               std::to_string(myFlow->theSrc) + " to itself");
+    }
+    if (myFlow->theNetRate <= 0) {
+      throw std::runtime_error(
+          "invalid nonpositive capacity request in flow: " +
+          std::to_string(myFlow->theNetRate));
+    }
+  }
+
+  // group the lanes by (src, dst), which share the first candidate path
+  std::map<std::pair<unsigned long, unsigned long>, std::vector<std::size_t>>
+      myGroups;
+  for (std::size_t l = 0; l < theNumLanes; l++) {
+    if (aFlows[l]) {
+      myGroups[{aFlows[l]->theSrc, aFlows[l]->theDst}].emplace_back(l);
+    }
+  }
+
+  std::vector<std::size_t> myFeasible;
+  std::vector<double>      myGrossRates;
+  std::vector<bool>        myAdmitted;
+  for (const auto& myGroup : myGroups) {
+    const auto& myLanes = myGroup.second;
+
+    // the first candidate is the same for all the lanes and it is
+    // equivalent to one Dijkstra call
+    const auto& myPath =
+        shortestPath(myGroup.first.first, myGroup.first.second);
+    for (const auto l : myLanes) {
+      aFlows[l]->theDijsktra++;
+    }
+    if (myPath.empty()) {
+      continue; // disconnected
+    }
+    const auto myPathEdges = edgeIds(myGroup.first.first, myPath);
+
+    // discard the lanes not admissible because of the external function
+    myFeasible.clear();
+    myGrossRates.clear();
+    for (const auto l : myLanes) {
+      FlowDescriptor myCandidate(*aFlows[l]);
+      myCandidate.thePath = myPath;
+      myCandidate.theGrossRate =
+          toGrossRate(myCandidate.theNetRate, myPath.size());
+      if (aCheckFunction(l, myCandidate)) {
+        myFeasible.emplace_back(l);
+        myGrossRates.emplace_back(myCandidate.theGrossRate);
+      }
+    }
+
+    // check the capacity of the edges on the path in all the lanes at once
+    myAdmitted.assign(myFeasible.size(), true);
+    for (const auto e : myPathEdges) {
+      const auto* myCapacities = &theCapacities[e * theNumLanes];
+      for (std::size_t i = 0; i < myFeasible.size(); i++) {
+        myAdmitted[i] =
+            myAdmitted[i] and
+            myCapacities[myFeasible[i]] >= myGrossRates[i];
+      }
+    }
+
+    for (std::size_t i = 0; i < myFeasible.size(); i++) {
+      const auto l     = myFeasible[i];
+      auto&      myFlow = *aFlows[l];
+      if (myAdmitted[i]) {
+        myFlow.thePath      = myPath;
+        myFlow.theGrossRate = myGrossRates[i];
+        for (const auto e : myPathEdges) {
+          capacity(e, l) -= myFlow.theGrossRate;
+        }
+      } else {
+        routeLane(l, myFlow, myPathEdges, aCheckFunction);
+      }
+    }
+  }
+}
+
+void LockstepNetwork::addCapacityToPath(const std::size_t   aLane,
+                                        const unsigned long aSrc,
+                                        const std::vector<unsigned long>& aPath,
+                                        const double aCapacity) {
+  if (aLane >= theNumLanes) {
+    throw std::runtime_error("invalid lane: " + std::to_string(aLane));
+  }
+  for (const auto e : edgeIds(aSrc, aPath)) {
+    capacity(e, aLane) += aCapacity;
+  }
+}
+
+void LockstepNetwork::hops(const unsigned long      aSrc,
+                           std::vector<std::size_t>& aHops) const {
+  aHops.assign(boost::num_vertices(theGraph), 0);
+  boost::breadth_first_search(
+      theGraph,
+      aSrc,
+      boost::visitor(boost::make_bfs_visitor(boost::record_distances(
+          boost::make_iterator_property_map(
+              aHops.begin(), get(boost::vertex_index, theGraph)),
+          boost::on_tree_edge()))));
+}
+
+std::size_t LockstepNetwork::edgeId(const unsigned long aSrc,
+                                    const unsigned long aDst) const {
+  if (aSrc < boost::num_vertices(theGraph)) {
+    for (const auto& myEdge :
+         boost::make_iterator_range(boost::out_edges(aSrc, theGraph))) {
+      if (boost::target(myEdge, theGraph) == aDst) {
+        return boost::get(boost::edge_index, theGraph, myEdge);
+      }
+    }
+  }
+  throw std::runtime_error("edge not in the graph: (" + std::to_string(aSrc) +
+                           "," + std::to_string(aDst) + ")");
+}
+
+std::vector<std::size_t>
+LockstepNetwork::edgeIds(const unsigned long               aSrc,
+                         const std::vector<unsigned long>& aPath) const {
+  std::vector<std::size_t> ret;
+  ret.reserve(aPath.size());
+  auto mySrc = aSrc;
+  for (const auto myDst : aPath) {
+    ret.emplace_back(edgeId(mySrc, myDst));
+    mySrc = myDst;
+  }
+  return ret;
+}
+
+const std::vector<unsigned long>&
+LockstepNetwork::shortestPath(const unsigned long aSrc,
+                              const unsigned long aDst) {
+  const auto myKey = std::make_pair(aSrc, aDst);
+  auto       it    = thePaths.find(myKey);
+  if (it == thePaths.end()) {
+    it = thePaths.emplace(myKey, std::vector<unsigned long>()).first;
+    shortestPath(aSrc, aDst, std::vector<bool>(theEdges.size()), it->second);
+  }
+  return it->second;
+}
+
+void LockstepNetwork::shortestPath(const unsigned long         aSrc,
+                                   const unsigned long         aDst,
+                                   const std::vector<bool>&    aRemoved,
+                                   std::vector<unsigned long>& aPath) {
+  // same search as in CapacityNetwork::route(), where the removed edges
+  // are filtered out instead of being deleted from a copy of the graph
+  using Index = boost::property_map<Graph, boost::edge_index_t>::type;
+  const boost::filtered_graph<Graph, EdgeFilter<Index>> myGraph(
+      theGraph,
+      EdgeFilter<Index>(aRemoved, boost::get(boost::edge_index, theGraph)));
+  boost::dijkstra_shortest_paths(
+      myGraph,
+      aSrc,
+      boost::predecessor_map(thePredecessors.data())
+          .weight_map(boost::make_static_property_map<EdgeDescriptor>(1))
+          .distance_map(boost::make_iterator_property_map(
+              theDistances.data(), get(boost::vertex_index, theGraph))));
+
+  aPath.clear();
+  if (thePredecessors[aDst] == aDst) {
+    return; // disconnected
+  }
+  for (auto myCur = aDst; myCur != aSrc; myCur = thePredecessors[myCur]) {
+    aPath.emplace_back(myCur);
+  }
+  std::reverse(aPath.begin(), aPath.end());
+}
+
+void LockstepNetwork::routeLane(const std::size_t        aLane,
+                                FlowDescriptor&          aFlow,
+                                std::vector<std::size_t> aPathEdges,
+                                const LaneCheckFunction& aCheckFunction) {
+  std::vector<bool> myRemoved(theEdges.size(), false);
+  while (true) {
+    // remove the edge with smallest capacity along the last path
+    auto   mySmallestCapacityEdge = aPathEdges.front();
+    double mySmallestCapacity     = std::numeric_limits<double>::max();
+    for (const auto e : aPathEdges) {
+      if (capacity(e, aLane) < mySmallestCapacity) {
+        mySmallestCapacity     = capacity(e, aLane);
+        mySmallestCapacityEdge = e;
+      }
+    }
+    myRemoved[mySmallestCapacityEdge] = true;
+
+    aFlow.theDijsktra++;
+    FlowDescriptor myCandidate(aFlow);
+    shortestPath(aFlow.theSrc, aFlow.theDst, myRemoved, myCandidate.thePath);
+    if (myCandidate.thePath.empty()) {
+      return; // disconnected
+    }
+    myCandidate.theGrossRate =
+        toGrossRate(myCandidate.theNetRate, myCandidate.thePath.size());
+    QR_TRACE(2,
+             LaneCandidate,
+             aLane,
+             myCandidate.theSrc,
+             myCandidate.thePath.size(),
+             myCandidate.theGrossRate);
+
+    if (not aCheckFunction(aLane, myCandidate)) {
+      return;
+    }
+
+    aPathEdges = edgeIds(aFlow.theSrc, myCandidate.thePath);
+    auto myFeasible = true;
+    for (const auto e : aPathEdges) {
+      if (capacity(e, aLane) < myCandidate.theGrossRate) {
+        myFeasible = false;
+        break;
+      }
+    }
+    if (myFeasible) {
+      for (const auto e : aPathEdges) {
+        capacity(e, aLane) -= myCandidate.theGrossRate;
+      }
+      aFlow.movePathRateFrom(myCandidate);
+      return;
+    }
+  }
+}
+
+double LockstepNetwork::toGrossRate(const double      aNetRate,
+                                    const std::size_t aNumEdges) const {
+  if (aNumEdges <= 1) {
+    return aNetRate;
+  }
+  return aNetRate / theSwapSuccess(aNumEdges - 1);
+}
+
+} // namespace qr
+} // namespace uiiit
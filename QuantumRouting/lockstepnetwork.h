@@ -0,0 +1,237 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/network.h"
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief A set of quantum networks with the same topology but different edge
+ * capacities, e.g., replications of an experiment with different seeds, which
+ * are routed together in lockstep.
+ *
+ * Each replication is called a lane. All the topology-derived data structures
+ * are shared by the lanes: the adjacency lists and the shortest path between
+ * every pair of nodes found so far. The capacities are stored edge by edge,
+ * with the values of all the lanes contiguous, so that the operations on the
+ * same edge across lanes are vectorised.
+ *
+ * The routing of flows follows exactly the same procedure as
+ * CapacityNetwork::route(), hence the decisions taken in each lane are the
+ * same as those of a CapacityNetwork with the same edges and capacities,
+ * provided that the outgoing edges of every node are in the same order,
+ * which breaks the ties between paths with the same number of hops: this is
+ * the case if the lanes are built from CapacityNetwork::weights().
+ */
+class LockstepNetwork final : public Network
+{
+ public:
+  using FlowDescriptor = CapacityNetwork::FlowDescriptor;
+
+  //! The flow of a given lane is feasible only if this function returns true.
+  using LaneCheckFunction =
+      std::function<bool(const std::size_t, const FlowDescriptor&)>;
+
+  /**
+   * @brief Create a network with the given edges and per-lane weights.
+   *
+   * The default measurement probability is 1.
+   *
+   * @param aLaneWeights The unidirectional edges and weights of the network
+   * (src, dst, w), one element per lane; the edges must be the same, and in
+   * the same order, in all the lanes. The outgoing edges of every node are
+   * visited in the order in which they appear.
+   *
+   * @throw std::runtime_error if there are no lanes or the edges are not the
+   * same in all the lanes
+   */
+  explicit LockstepNetwork(
+      const std::vector<CapacityNetwork::WeightVector>& aLaneWeights);
+
+  /**
+   * @brief Set the measurement probability, which is the same for all lanes.
+   *
+   * @throw std::runtime_error if the measurement probability is not in [0,1]
+   */
+  void measurementProbability(const double aMeasurementProbability);
+
+  //! \return the measurement probability.
+  double measurementProbability() const noexcept {
+    return theMeasurementProbability;
+  }
+
+  //! \return the number of lanes.
+  std::size_t numLanes() const noexcept {
+    return theNumLanes;
+  }
+
+  //! \return the number of nodes.
+  std::size_t numNodes() const;
+
+  //! \return the number of edges.
+  std::size_t numEdges() const;
+
+  /**
+   * @brief Return the distance between two nodes, in hops.
+   *
+   * The distance is found by a breadth-first search from the source, i.e.,
+   * it is not stored for all the pairs of nodes.
+   *
+   * @return the number of hops, or 0 if not reachable.
+   *
+   * @throw std::runtime_error if the nodes are invalid
+   */
+  std::size_t hops(const unsigned long aSrc, const unsigned long aDst) const;
+
+  //! \return the network diameter, in hops.
+  std::size_t diameter() const noexcept {
+    return theDiameter;
+  }
+
+  //! \return the total EPR capacity across all the edges, one per lane.
+  std::vector<double> totalCapacity() const;
+
+  //! \return the total EPR capacity across all the edges of a lane.
+  double totalCapacity(const std::size_t aLane) const;
+
+  //! \return the capacity of the outgoing edges of each node in a lane.
+  std::vector<double> nodeCapacities(const std::size_t aLane) const;
+
+  /**
+   * @brief Route at most one flow per lane.
+   *
+   * Within each lane, the flow is routed as with CapacityNetwork::route().
+   *
+   * @param aFlows the flows to be routed, one per lane: lanes without a flow
+   * are left unchanged (admitted flows are modified)
+   * @param aCheckFunction the flow of a lane is considered feasible only if
+   * this function returns true
+   *
+   * @throw std::runtime_error if the number of flows is different from the
+   * number of lanes or if there is an ill-formed request, in which case we
+   * guarantee that the internal state is not changed
+   */
+  void route(
+      std::vector<std::optional<FlowDescriptor>>& aFlows,
+      const LaneCheckFunction&                    aCheckFunction =
+          [](const auto, const auto&) { return true; });
+
+  /**
+   * @brief Add capacity on all the edges along a given path in a lane.
+   *
+   * @throw std::runtime_error if the lane is invalid or one of the edges in
+   * the path does not exist
+   */
+  void addCapacityToPath(const std::size_t                 aLane,
+                         const unsigned long               aSrc,
+                         const std::vector<unsigned long>& aPath,
+                         const double                      aCapacity);
+
+ private:
+  using Graph =
+      boost::adjacency_list<boost::vecS,
+                            boost::vecS,
+                            boost::directedS,
+                            boost::no_property,
+                            boost::property<boost::edge_index_t, std::size_t>>;
+  using VertexDescriptor = boost::graph_traits<Graph>::vertex_descriptor;
+  using EdgeDescriptor   = boost::graph_traits<Graph>::edge_descriptor;
+
+  //! Fill the hop distances from a node to all the others, 0 if unreachable.
+  void hops(const unsigned long aSrc, std::vector<std::size_t>& aHops) const;
+
+  //! \return the edge identifier, or throw if the edge does not exist.
+  std::size_t edgeId(const unsigned long aSrc, const unsigned long aDst) const;
+
+  //! \return the edge identifiers along a path.
+  std::vector<std::size_t>
+  edgeIds(const unsigned long aSrc, const std::vector<unsigned long>& aPath) const;
+
+  //! \return the shortest path with all edges, possibly cached.
+  const std::vector<unsigned long>& shortestPath(const unsigned long aSrc,
+                                                 const unsigned long aDst);
+
+  //! Find the shortest path without the removed edges, empty if none.
+  void shortestPath(const unsigned long         aSrc,
+                    const unsigned long         aDst,
+                    const std::vector<bool>&    aRemoved,
+                    std::vector<unsigned long>& aPath);
+
+  //! Route the flow of a lane in which the shortest path is not feasible.
+  void routeLane(const std::size_t        aLane,
+                 FlowDescriptor&          aFlow,
+                 std::vector<std::size_t> aPathEdges,
+                 const LaneCheckFunction& aCheckFunction);
+
+  double& capacity(const std::size_t aEdge, const std::size_t aLane) {
+    return theCapacities[aEdge * theNumLanes + aLane];
+  }
+  double capacity(const std::size_t aEdge, const std::size_t aLane) const {
+    return theCapacities[aEdge * theNumLanes + aLane];
+  }
+
+  double toGrossRate(const double aNetRate, const std::size_t aNumEdges) const;
+
+ private:
+  const std::size_t theNumLanes;
+  Graph             theGraph;
+  //! (src, dst) of each edge, indexed by the edge identifier.
+  std::vector<std::pair<unsigned long, unsigned long>> theEdges;
+  //! capacities of all the lanes, indexed by edge identifier then lane.
+  std::vector<double> theCapacities;
+  std::size_t theDiameter;
+  //! shortest paths found so far, key: (src, dst).
+  std::map<std::pair<unsigned long, unsigned long>, std::vector<unsigned long>>
+             thePaths;
+  double     theMeasurementProbability;
+  PowerTable theSwapSuccess;
+
+  // working variables, kept to avoid memory allocations
+  std::vector<VertexDescriptor> theDistances;
+  std::vector<VertexDescriptor> thePredecessors;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,206 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/memoryaccounting.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! Accounting state of a thread, which must be trivial so that it can be
+//! accessed by the operators new and delete at any time.
+struct ThreadState {
+  MemoryUsage*           theUsage;
+  MemoryUsage::Subsystem theSubsystem;
+  std::int64_t           theLive; //!< bytes allocated and not yet freed
+};
+
+thread_local ThreadState theThreadState{
+    nullptr, MemoryUsage::Subsystem::Other, 0};
+
+//! Set when the global operators new and delete are replaced.
+bool theEnabled = false;
+
+//! \return the size of the block allocated, or the size requested if it is
+//! not known.
+std::int64_t blockSize(void* aPtr, const std::size_t aSize) noexcept {
+#ifdef __GLIBC__
+  (void)aSize;
+  return static_cast<std::int64_t>(malloc_usable_size(aPtr));
+#else
+  (void)aPtr;
+  return static_cast<std::int64_t>(aSize);
+#endif
+}
+
+std::int64_t peakRss() {
+  struct rusage myUsage;
+  if (getrusage(RUSAGE_SELF, &myUsage) != 0) {
+    return 0;
+  }
+  return myUsage.ru_maxrss;
+}
+
+} // namespace
+
+const std::vector<std::string>& MemoryUsage::names() {
+  static const std::vector<std::string> ret({
+      "rss-peak-delta",
+      "heap-peak",
+      "allocs-graph",
+      "bytes-graph",
+      "allocs-descriptors",
+      "bytes-descriptors",
+      "allocs-paths",
+      "bytes-paths",
+      "allocs-statistics",
+      "bytes-statistics",
+      "allocs-other",
+      "bytes-other",
+  });
+  return ret;
+}
+
+std::string MemoryUsage::toString() const {
+  std::stringstream myStream;
+  myStream << "peak RSS increase " << theRssPeakDelta << " KiB, heap peak "
+           << theHeapPeak << " bytes";
+  for (std::size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+    myStream << ", " << names()[2 + 2 * i].substr(7) << ' '
+             << theAllocations[i] << " allocations (" << theBytes[i]
+             << " bytes)";
+  }
+  return myStream.str();
+}
+
+std::string MemoryUsage::toCsv() const {
+  std::stringstream myStream;
+  myStream << theRssPeakDelta << ',' << theHeapPeak;
+  for (std::size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+    myStream << ',' << theAllocations[i] << ',' << theBytes[i];
+  }
+  return myStream.str();
+}
+
+MemoryAccounting::Scope::Scope(const MemoryUsage::Subsystem aSubsystem) noexcept
+    : thePrevious(theThreadState.theSubsystem) {
+  theThreadState.theSubsystem = aSubsystem;
+}
+
+MemoryAccounting::Scope::~Scope() {
+  theThreadState.theSubsystem = thePrevious;
+}
+
+MemoryAccounting::MemoryAccounting(MemoryUsage& aUsage)
+    : theUsage(aUsage)
+    , theStartRss(peakRss()) {
+  if (not theEnabled) {
+    throw std::runtime_error("memory accounting not enabled: the executable "
+                             "must be linked with the memory hooks");
+  }
+  if (theThreadState.theUsage != nullptr) {
+    throw std::runtime_error(
+        "memory accounting already active in the calling thread");
+  }
+  theThreadState.theUsage = &theUsage;
+  theThreadState.theLive  = 0;
+}
+
+MemoryAccounting::~MemoryAccounting() {
+  theThreadState.theUsage = nullptr;
+  theUsage.theRssPeakDelta += peakRss() - theStartRss;
+}
+
+bool MemoryAccounting::enable() noexcept {
+  theEnabled = true;
+  return true;
+}
+
+bool MemoryAccounting::enabled() noexcept {
+  return theEnabled;
+}
+
+void* MemoryAccounting::allocate(std::size_t aSize) {
+  if (aSize == 0) {
+    aSize = 1;
+  }
+  void* ret = nullptr;
+  while ((ret = std::malloc(aSize)) == nullptr) {
+    const auto myHandler = std::get_new_handler();
+    if (myHandler == nullptr) {
+      throw std::bad_alloc();
+    }
+    myHandler();
+  }
+
+  auto& myState = theThreadState;
+  if (myState.theUsage != nullptr) {
+    const auto mySubsystem = static_cast<std::size_t>(myState.theSubsystem);
+    const auto mySize      = blockSize(ret, aSize);
+    ++myState.theUsage->theAllocations[mySubsystem];
+    myState.theUsage->theBytes[mySubsystem] += mySize;
+#ifdef __GLIBC__
+    // the size of the blocks freed is only known with the GNU C library
+    myState.theLive += mySize;
+    if (myState.theLive > myState.theUsage->theHeapPeak) {
+      myState.theUsage->theHeapPeak = myState.theLive;
+    }
+#endif
+  }
+  return ret;
+}
+
+void MemoryAccounting::deallocate(void* aPtr) noexcept {
+  auto& myState = theThreadState;
+  if (myState.theUsage != nullptr and aPtr != nullptr) {
+    // the block may have been allocated before the accounting started, or by
+    // another thread, in which case it was not counted
+    myState.theLive = std::max<std::int64_t>(
+        0, myState.theLive - blockSize(aPtr, 0));
+  }
+  std::free(aPtr);
+}
+
+} // namespace qr
+} // namespace uiiit
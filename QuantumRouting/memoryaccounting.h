@@ -0,0 +1,151 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <array>
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Memory used by an experiment, as measured by MemoryAccounting.
+ */
+struct MemoryUsage {
+  //! Subsystems to which the allocations are attributed.
+  enum class Subsystem : std::size_t {
+    Graph       = 0, //!< network graphs, incl. the copies made to route flows
+    Descriptors = 1, //!< flows and apps
+    Paths       = 2, //!< k-shortest paths searched
+    Statistics  = 3, //!< output metrics
+    Other       = 4, //!< anything else
+  };
+  static constexpr std::size_t NUM_SUBSYSTEMS = 5;
+
+  //! Increase of the peak resident set size of the process, in KiB.
+  std::int64_t theRssPeakDelta = 0;
+  //! Peak of the bytes allocated and not yet freed by the thread.
+  std::int64_t theHeapPeak = 0;
+  //! Number of allocations per subsystem.
+  std::array<std::uint64_t, NUM_SUBSYSTEMS> theAllocations = {};
+  //! Bytes allocated per subsystem, in the same unit as the heap peak.
+  std::array<std::uint64_t, NUM_SUBSYSTEMS> theBytes = {};
+
+  //! \return the names of the CSV columns, in the same order as toCsv().
+  static const std::vector<std::string>& names();
+
+  std::string toString() const;
+  std::string toCsv() const;
+};
+
+/**
+ * @brief Account the memory allocated by the calling thread with the global
+ * operator new during the lifetime of this object.
+ *
+ * The accounting is only available in the executables that opt in by
+ * compiling memoryhooks.cpp, which replaces the global operators new and
+ * delete, so that every allocation is attributed to the subsystem set by the
+ * innermost Scope in the calling thread, or to MemoryUsage::Subsystem::Other.
+ * The overhead is negligible when no accounting is active in the thread.
+ *
+ * With the GNU C library the bytes are those of the blocks returned by
+ * malloc(), otherwise they are those requested. The blocks freed during the
+ * accounting that were allocated before it started, or by another thread,
+ * are ignored by the heap peak, which never goes below zero. The heap peak
+ * is only measured with the GNU C library.
+ *
+ * The peak RSS is that of the whole process, hence its increase is only
+ * meaningful when a single experiment runs at a time.
+ */
+class MemoryAccounting final
+{
+  NONCOPYABLE_NONMOVABLE(MemoryAccounting);
+
+ public:
+  /**
+   * @brief Attribute to a subsystem the allocations done in the calling
+   * thread during the lifetime of this object.
+   *
+   * If there is no accounting active then the scope does nothing.
+   */
+  class Scope final
+  {
+    NONCOPYABLE_NONMOVABLE(Scope);
+
+   public:
+    explicit Scope(const MemoryUsage::Subsystem aSubsystem) noexcept;
+    ~Scope();
+
+   private:
+    const MemoryUsage::Subsystem thePrevious;
+  };
+
+  /**
+   * @brief Start accounting the memory allocated by the calling thread.
+   *
+   * @param aUsage where to accumulate the allocations, which must outlive
+   * this object
+   *
+   * @throw std::runtime_error if the accounting is already active in the
+   * calling thread, or if the executable does not replace the global
+   * operators new and delete, see enabled()
+   */
+  explicit MemoryAccounting(MemoryUsage& aUsage);
+
+  //! Stop accounting and save the peaks.
+  ~MemoryAccounting();
+
+  //! \return true if the global operators new and delete are replaced.
+  static bool enabled() noexcept;
+
+  //
+  // only meant to be called by the replacements in memoryhooks.cpp
+  //
+
+  //! Record that the global operators are replaced. \return true.
+  static bool enable() noexcept;
+  //! Allocate with malloc() and account the block allocated.
+  static void* allocate(std::size_t aSize);
+  //! Free a block allocated by allocate().
+  static void deallocate(void* aPtr) noexcept;
+
+ private:
+  MemoryUsage&       theUsage;
+  const std::int64_t theStartRss;
+};
+
+} // namespace qr
+} // namespace uiiit
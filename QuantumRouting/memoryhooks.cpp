@@ -0,0 +1,98 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//
+// Replacement of the global allocation and deallocation functions, except
+// those with an alignment, which are left to the standard library, so that
+// the allocations can be counted by MemoryAccounting.
+//
+// This file is not part of the library: it must be compiled into the
+// executables that use the memory accounting, since the replacements take
+// over all the allocations of the process.
+//
+
+#include "QuantumRouting/memoryaccounting.h"
+
+#include <new>
+
+namespace {
+
+const bool theMemoryHooks = uiiit::qr::MemoryAccounting::enable();
+
+} // namespace
+
+void* operator new(std::size_t aSize) {
+  return uiiit::qr::MemoryAccounting::allocate(aSize);
+}
+
+void* operator new[](std::size_t aSize) {
+  return uiiit::qr::MemoryAccounting::allocate(aSize);
+}
+
+void* operator new(std::size_t aSize, const std::nothrow_t&) noexcept {
+  try {
+    return uiiit::qr::MemoryAccounting::allocate(aSize);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t aSize, const std::nothrow_t&) noexcept {
+  try {
+    return uiiit::qr::MemoryAccounting::allocate(aSize);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* aPtr) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
+
+void operator delete[](void* aPtr) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
+
+void operator delete(void* aPtr, std::size_t) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
+
+void operator delete[](void* aPtr, std::size_t) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
+
+void operator delete(void* aPtr, const std::nothrow_t&) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
+
+void operator delete[](void* aPtr, const std::nothrow_t&) noexcept {
+  uiiit::qr::MemoryAccounting::deallocate(aPtr);
+}
@@ -0,0 +1,116 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Unbounded lock-free queue with many producers and one consumer.
+ *
+ * The producers append an element with a single atomic exchange on the head
+ * of an intrusive linked list, while the consumer follows the links from the
+ * tail, which is never accessed by the producers. An element pushed is
+ * visible to the consumer only after the producer has linked it, hence
+ * pop() may return nothing for a short time while a push is in progress: the
+ * caller must not assume that the queue is empty until all the producers
+ * have returned from push().
+ *
+ * @tparam T the type of the elements, which must be move-constructible.
+ */
+template <class T>
+class MpscQueue final
+{
+  NONCOPYABLE_NONMOVABLE(MpscQueue);
+
+  struct Node {
+    std::atomic<Node*> theNext{nullptr};
+    std::optional<T>   theValue;
+  };
+
+ public:
+  MpscQueue()
+      : theHead(new Node())
+      , theTail(theHead.load(std::memory_order_relaxed)) {
+    // noop
+  }
+
+  ~MpscQueue() {
+    while (theTail != nullptr) {
+      auto myNext = theTail->theNext.load(std::memory_order_relaxed);
+      delete theTail;
+      theTail = myNext;
+    }
+  }
+
+  //! Add an element at the end of the queue. Can be called by any thread.
+  void push(T&& aValue) {
+    auto myNode = new Node();
+    myNode->theValue.emplace(std::move(aValue));
+    auto myPrev = theHead.exchange(myNode, std::memory_order_acq_rel);
+    myPrev->theNext.store(myNode, std::memory_order_release);
+  }
+
+  /**
+   * @brief Remove the element at the front of the queue.
+   *
+   * Must be called only by the consumer thread.
+   *
+   * \return the element removed, or nothing if there are no elements ready.
+   */
+  std::optional<T> pop() {
+    auto myNext = theTail->theNext.load(std::memory_order_acquire);
+    if (myNext == nullptr) {
+      return std::nullopt;
+    }
+    std::optional<T> ret(std::move(myNext->theValue));
+    myNext->theValue.reset();
+    delete theTail;
+    theTail = myNext;
+    return ret;
+  }
+
+ private:
+  // the last node pushed, modified by the producers
+  alignas(64) std::atomic<Node*> theHead;
+  // the node before the front of the queue, modified by the consumer only
+  alignas(64) Node* theTail;
+};
+
+} // namespace qr
+} // namespace uiiit
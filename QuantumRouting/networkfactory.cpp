@@ -31,6 +31,7 @@ SOFTWARE.
 
 #include "QuantumRouting/networkfactory.h"
 
+#include "QuantumRouting/memoryaccounting.h"
 #include "QuantumRouting/poissonpointprocess.h"
 #include "QuantumRouting/qrutils.h"
 #include "Support/random.h"
@@ -39,30 +40,62 @@ SOFTWARE.
 
 #include <exception>
 #include <fstream>
+#include <limits>
 #include <stdexcept>
 
 namespace uiiit {
 namespace qr {
 
-std::unique_ptr<CapacityNetwork>
+namespace {
+
+//! \return the edges with the vertex identifiers of the given network type.
+template <class NETWORK>
+typename NETWORK::EdgeVector
+networkEdges(const std::vector<std::pair<unsigned long, unsigned long>>& aEdges,
+             const std::size_t aNumNodes) {
+  using Index = typename NETWORK::Index;
+  if (aNumNodes > 0 and aNumNodes - 1 > std::numeric_limits<Index>::max()) {
+    throw std::runtime_error("Too many nodes for the network index type: " +
+                             std::to_string(aNumNodes));
+  }
+  return typename NETWORK::EdgeVector(aEdges.begin(), aEdges.end());
+}
+
+} // namespace
+
+template <class NETWORK>
+std::unique_ptr<NETWORK>
 makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
                        const std::size_t         aSeed,
                        const double              aMu,
                        const double              aGridLength,
                        const double              aThreshold,
                        const double              aLinkProbability,
-                       std::vector<Coordinate>&  aCoordinates) {
-  const auto MANY_TRIES = 1000000u;
+                       std::vector<Coordinate>&  aCoordinates,
+                       PhaseTimers*              aTimers) {
+  MemoryAccounting::Scope myMemoryScope(MemoryUsage::Subsystem::Graph);
+  const auto              MANY_TRIES = 1000000u;
 
   auto myPppSeed = aSeed;
   for (unsigned myTry = 0; myTry < MANY_TRIES; myTry++) {
-    auto myCoordinates =
-        PoissonPointProcessGrid(aMu, myPppSeed, aGridLength, aGridLength)();
-    const auto myEdges =
-        findLinks(myCoordinates, aThreshold, aLinkProbability, aSeed);
-    if (qr::bigraphConnected(myEdges)) {
+    std::vector<Coordinate>    myCoordinates;
+    CapacityNetwork::EdgeVector myEdges;
+    {
+      PhaseTimers::Scope myScope(aTimers, PhaseTimers::Phase::Topology);
+      myCoordinates =
+          PoissonPointProcessGrid(aMu, myPppSeed, aGridLength, aGridLength)();
+      myEdges = findLinks(myCoordinates, aThreshold, aLinkProbability, aSeed);
+    }
+    auto myConnected = false;
+    {
+      PhaseTimers::Scope myScope(aTimers, PhaseTimers::Phase::Connectivity);
+      myConnected = qr::bigraphConnected(myEdges);
+    }
+    if (myConnected) {
+      PhaseTimers::Scope myScope(aTimers, PhaseTimers::Phase::Topology);
       myCoordinates.swap(aCoordinates);
-      return std::make_unique<qr::CapacityNetwork>(myEdges, aEprRv, true);
+      return std::make_unique<NETWORK>(
+          networkEdges<NETWORK>(myEdges, aCoordinates.size()), aEprRv, true);
 
     } else {
       VLOG(1) << "graph with seed " << myPppSeed << " not connected, try again";
@@ -74,20 +107,53 @@ makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
                            std::to_string(MANY_TRIES) + " tries");
 }
 
-std::unique_ptr<CapacityNetwork>
+template <class NETWORK>
+std::unique_ptr<NETWORK>
 makeCapacityNetworkGraphMl(support::RealRvInterface& aEprRv,
                            std::ifstream&            aGraphMl,
-                           std::vector<Coordinate>&  aCoordinates) {
-  const auto myEdges = findLinks(aGraphMl, aCoordinates);
+                           std::vector<Coordinate>&  aCoordinates,
+                           PhaseTimers*              aTimers) {
+  MemoryAccounting::Scope myMemoryScope(MemoryUsage::Subsystem::Graph);
+  const auto              myEdges = findLinks(aGraphMl, aCoordinates);
   for (const auto& myEdge : myEdges) {
     VLOG(2) << '(' << myEdge.first << ',' << myEdge.second << ')';
   }
   if (qr::bigraphConnected(myEdges)) {
-    return std::make_unique<qr::CapacityNetwork>(myEdges, aEprRv, true);
+    return std::make_unique<NETWORK>(
+        networkEdges<NETWORK>(myEdges, aCoordinates.size()), aEprRv, true);
   }
 
   throw std::runtime_error("The GraphML network is not fully connected");
 }
 
+template std::unique_ptr<CapacityNetwork>
+makeCapacityNetworkPpp<CapacityNetwork>(support::RealRvInterface&,
+                                        const std::size_t,
+                                        const double,
+                                        const double,
+                                        const double,
+                                        const double,
+                                        std::vector<Coordinate>&,
+                                        PhaseTimers*);
+template std::unique_ptr<CompactCapacityNetwork>
+makeCapacityNetworkPpp<CompactCapacityNetwork>(support::RealRvInterface&,
+                                               const std::size_t,
+                                               const double,
+                                               const double,
+                                               const double,
+                                               const double,
+                                               std::vector<Coordinate>&,
+                                               PhaseTimers*);
+template std::unique_ptr<CapacityNetwork>
+makeCapacityNetworkGraphMl<CapacityNetwork>(support::RealRvInterface&,
+                                            std::ifstream&,
+                                            std::vector<Coordinate>&,
+                                            PhaseTimers*);
+template std::unique_ptr<CompactCapacityNetwork>
+makeCapacityNetworkGraphMl<CompactCapacityNetwork>(support::RealRvInterface&,
+                                                   std::ifstream&,
+                                                   std::vector<Coordinate>&,
+                                                   PhaseTimers*);
+
 } // namespace qr
 } // namespace uiiit
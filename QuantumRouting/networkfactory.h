@@ -32,6 +32,7 @@ SOFTWARE.
 #pragma once
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/instrumentation.h"
 #include "QuantumRouting/qrutils.h"
 
 #include <iostream>
@@ -40,19 +41,36 @@ SOFTWARE.
 namespace uiiit {
 namespace qr {
 
-std::unique_ptr<CapacityNetwork>
+/**
+ * @brief Create a connected network from a Poisson point process.
+ *
+ * If aTimers is not null then the time spent to create the topology and to
+ * check its connectivity is added to the respective phases.
+ *
+ * @tparam NETWORK the type of the network created, which is instantiated for
+ * CapacityNetwork and CompactCapacityNetwork
+ *
+ * @throw std::runtime_error if the vertex identifiers do not fit the index
+ * type of the network
+ */
+template <class NETWORK = CapacityNetwork>
+std::unique_ptr<NETWORK>
 makeCapacityNetworkPpp(support::RealRvInterface& aEprRv,
                        const std::size_t         aSeed,
                        const double              aMu,
                        const double              aGridLength,
                        const double              aThreshold,
                        const double              aLinkProbability,
-                       std::vector<Coordinate>&  aCoordinates);
+                       std::vector<Coordinate>&  aCoordinates,
+                       PhaseTimers*              aTimers = nullptr);
 
-std::unique_ptr<CapacityNetwork>
+//! Create a network from a GraphML file, see makeCapacityNetworkPpp().
+template <class NETWORK = CapacityNetwork>
+std::unique_ptr<NETWORK>
 makeCapacityNetworkGraphMl(support::RealRvInterface& aEprRv,
                            std::ifstream&            aGraphMl,
-                           std::vector<Coordinate>&  aCoordinates);
+                           std::vector<Coordinate>&  aCoordinates,
+                           PhaseTimers*              aTimers = nullptr);
 
 } // namespace qr
 } // namespace uiiit
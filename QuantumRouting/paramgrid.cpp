@@ -0,0 +1,177 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/paramgrid.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+ParamGrid::ParamGrid(const std::vector<std::string>& aSpecs)
+    : theDimensions() {
+  std::set<std::string> myNames;
+  for (const auto& mySpec : aSpecs) {
+    const auto myPos = mySpec.find('=');
+    if (myPos == std::string::npos or myPos == 0) {
+      throw std::runtime_error("invalid grid specification: " + mySpec);
+    }
+    const auto myName = mySpec.substr(0, myPos);
+    if (not myNames.emplace(myName).second) {
+      throw std::runtime_error("duplicate name in grid specification: " +
+                               myName);
+    }
+    theDimensions.emplace_back(myName, parseValues(mySpec.substr(myPos + 1)));
+    if (theDimensions.back().second.empty()) {
+      throw std::runtime_error("no values in grid specification: " + mySpec);
+    }
+  }
+}
+
+std::size_t ParamGrid::size() const noexcept {
+  std::size_t ret = 1;
+  for (const auto& myDimension : theDimensions) {
+    ret *= myDimension.second.size();
+  }
+  return ret;
+}
+
+ParamGrid::Point ParamGrid::point(const std::size_t aIndex) const {
+  if (aIndex >= size()) {
+    throw std::out_of_range("invalid grid point index " +
+                            std::to_string(aIndex) + " (size " +
+                            std::to_string(size()) + ")");
+  }
+  Point ret(theDimensions.size());
+  auto  myResidual = aIndex;
+  for (std::size_t i = theDimensions.size(); i > 0; i--) {
+    const auto& myValues = theDimensions[i - 1].second;
+    ret[i - 1] = {theDimensions[i - 1].first,
+                  myValues[myResidual % myValues.size()]};
+    myResidual /= myValues.size();
+  }
+  return ret;
+}
+
+std::vector<std::string> ParamGrid::args(const std::size_t aIndex) const {
+  std::vector<std::string> ret;
+  for (const auto& elem : point(aIndex)) {
+    ret.emplace_back("--" + elem.first);
+    ret.emplace_back(elem.second);
+  }
+  return ret;
+}
+
+std::string ParamGrid::filename(const std::string& aPattern,
+                                const Point&       aPoint) {
+  auto ret = aPattern;
+  for (const auto& elem : aPoint) {
+    boost::replace_all(ret, "{" + elem.first + "}", elem.second);
+  }
+  return ret;
+}
+
+std::vector<std::string> ParamGrid::parseValues(const std::string& aValues) {
+  std::vector<std::string> ret;
+
+  if (aValues.find(':') == std::string::npos) {
+    boost::split(ret, aValues, boost::is_any_of(","));
+    for (const auto& myValue : ret) {
+      if (myValue.empty()) {
+        throw std::runtime_error("empty value in list: " + aValues);
+      }
+    }
+    return ret;
+  }
+
+  std::vector<std::string> myTokens;
+  boost::split(myTokens, aValues, boost::is_any_of(":"));
+  if (myTokens.size() != 3) {
+    throw std::runtime_error("invalid range, expected START:END:STEP: " +
+                             aValues);
+  }
+  double myStart, myEnd, myStep;
+  try {
+    myStart = std::stod(myTokens[0]);
+    myEnd   = std::stod(myTokens[1]);
+    myStep  = std::stod(myTokens[2]);
+  } catch (const std::exception&) {
+    throw std::runtime_error("invalid non-numeric range: " + aValues);
+  }
+  if (not std::isfinite(myStart) or not std::isfinite(myEnd) or
+      not std::isfinite(myStep)) {
+    throw std::runtime_error("invalid non-finite range: " + aValues);
+  }
+  if (myStep <= 0 or myEnd < myStart) {
+    throw std::runtime_error("invalid range: " + aValues);
+  }
+
+  // compute the values from the start to avoid accumulating rounding errors
+  const auto mySteps = std::floor((myEnd - myStart) / myStep + 1e-9);
+  if (not(mySteps < MAX_RANGE_VALUES)) {
+    throw std::runtime_error("too many values in range, at most " +
+                             std::to_string(MAX_RANGE_VALUES) +
+                             " allowed: " + aValues);
+  }
+  const auto myNumSteps = static_cast<std::size_t>(mySteps);
+
+  // integral ranges are printed as integers, e.g., 1000000 rather than 1e+06,
+  // and the others with enough digits to parse back the values specified but
+  // without the rounding errors of the steps, e.g., 0.3 rather than
+  // 0.30000000000000004
+  static constexpr double MAX_INTEGRAL = 9007199254740992.0; // 2^53
+  const auto myIntegral = std::trunc(myStart) == myStart and
+                          std::trunc(myStep) == myStep and
+                          std::abs(myStart) <= MAX_INTEGRAL and
+                          std::abs(myEnd) <= MAX_INTEGRAL;
+  for (std::size_t i = 0; i <= myNumSteps; i++) {
+    const auto        myValue = myStart + i * myStep;
+    std::stringstream myStream;
+    if (myIntegral) {
+      myStream << std::llround(myValue);
+    } else {
+      myStream << std::setprecision(std::numeric_limits<double>::digits10)
+               << myValue;
+    }
+    ret.emplace_back(myStream.str());
+  }
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
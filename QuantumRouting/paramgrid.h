@@ -0,0 +1,122 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Cartesian grid of command-line option values, used to run a
+ * parameter sweep within a single process.
+ *
+ * Each dimension is specified as NAME=VALUES, where NAME is the long name of a
+ * command-line option and VALUES is either a comma-separated list of values,
+ * e.g., arrival-rate=1,5,10, or a range START:END:STEP with END included,
+ * e.g., mu=40:200:20, of finite numbers and with at most MAX_RANGE_VALUES
+ * values.
+ *
+ * The points of the grid are enumerated with the last dimension varying
+ * fastest. A grid without dimensions has exactly one point, which is empty.
+ */
+class ParamGrid final
+{
+ public:
+  //! The (name, value) pairs of a grid point, one per dimension.
+  using Point = std::vector<std::pair<std::string, std::string>>;
+
+  //! Maximum number of values of a range START:END:STEP.
+  static constexpr std::size_t MAX_RANGE_VALUES = 10000;
+
+  /**
+   * @brief Create a grid from the given dimension specifications.
+   *
+   * @param aSpecs The specifications, one per dimension.
+   *
+   * @throw std::runtime_error if a specification is ill-formed or the same
+   * name appears more than once
+   */
+  explicit ParamGrid(const std::vector<std::string>& aSpecs);
+
+  //! \return the number of points in the grid.
+  std::size_t size() const noexcept;
+
+  //! \return the number of dimensions of the grid.
+  std::size_t dimensions() const noexcept {
+    return theDimensions.size();
+  }
+
+  /**
+   * @brief Return a point of the grid.
+   *
+   * @param aIndex The index of the point, in [0, size()).
+   *
+   * @throw std::out_of_range if aIndex is not smaller than size()
+   */
+  Point point(const std::size_t aIndex) const;
+
+  /**
+   * @brief Return a point of the grid as command-line arguments.
+   *
+   * @param aIndex The index of the point, in [0, size()).
+   * @return the list of arguments: --NAME VALUE for each dimension.
+   *
+   * @throw std::out_of_range if aIndex is not smaller than size()
+   */
+  std::vector<std::string> args(const std::size_t aIndex) const;
+
+  /**
+   * @brief Expand a file name pattern at a given grid point.
+   *
+   * Every occurrence of {NAME} in the pattern is replaced with the value
+   * of the corresponding dimension at the given point.
+   *
+   * @param aPattern The file name pattern.
+   * @param aPoint The grid point.
+   * @return the expanded file name.
+   */
+  static std::string filename(const std::string& aPattern,
+                              const Point&       aPoint);
+
+ private:
+  static std::vector<std::string> parseValues(const std::string& aValues);
+
+ private:
+  std::vector<std::pair<std::string, std::vector<std::string>>> theDimensions;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,185 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/perfcounters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace uiiit {
+namespace qr {
+
+PerfCounters::Sample&
+PerfCounters::Sample::operator+=(const Sample& aOther) noexcept {
+  theCycles += aOther.theCycles;
+  theInstructions += aOther.theInstructions;
+  theLlcMisses += aOther.theLlcMisses;
+  theBranchMisses += aOther.theBranchMisses;
+  return *this;
+}
+
+PerfCounters::Sample
+PerfCounters::Sample::operator-(const Sample& aOther) const noexcept {
+  Sample ret;
+  ret.theCycles       = theCycles - aOther.theCycles;
+  ret.theInstructions = theInstructions - aOther.theInstructions;
+  ret.theLlcMisses    = theLlcMisses - aOther.theLlcMisses;
+  ret.theBranchMisses = theBranchMisses - aOther.theBranchMisses;
+  return ret;
+}
+
+const std::vector<std::string>& PerfCounters::Sample::names() {
+  static const std::vector<std::string> ret({
+      "cycles",
+      "instructions",
+      "llc-misses",
+      "branch-misses",
+  });
+  return ret;
+}
+
+std::string PerfCounters::Sample::toString() const {
+  std::stringstream myStream;
+  myStream << theCycles << " cycles, " << theInstructions << " instructions, "
+           << theLlcMisses << " LLC misses, " << theBranchMisses
+           << " branch misses";
+  return myStream.str();
+}
+
+std::string PerfCounters::Sample::toCsv() const {
+  std::stringstream myStream;
+  myStream << theCycles << ',' << theInstructions << ',' << theLlcMisses << ','
+           << theBranchMisses;
+  return myStream.str();
+}
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters()
+    : theFds() {
+  static const std::array<std::uint64_t, NUM_COUNTERS> myConfigs({
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  });
+  theFds.fill(-1);
+  for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+    perf_event_attr myAttr;
+    std::memset(&myAttr, 0, sizeof(myAttr));
+    myAttr.size           = sizeof(myAttr);
+    myAttr.type           = PERF_TYPE_HARDWARE;
+    myAttr.config         = myConfigs[i];
+    myAttr.exclude_kernel = 1;
+    myAttr.exclude_hv     = 1;
+    myAttr.read_format    = PERF_FORMAT_GROUP |
+                         PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this thread, any CPU, the first counter is the group leader
+    theFds[i] = static_cast<int>(
+        ::syscall(SYS_perf_event_open, &myAttr, 0, -1, theFds[0], 0));
+    if (theFds[i] < 0) {
+      const auto myErrno = errno;
+      for (std::size_t j = 0; j < i; j++) {
+        ::close(theFds[j]);
+      }
+      throw std::runtime_error(
+          "cannot open the hardware performance counter " +
+          Sample::names()[i] + ": " + std::strerror(myErrno) +
+          " (check /proc/sys/kernel/perf_event_paranoid)");
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (const auto myFd : theFds) {
+    ::close(myFd);
+  }
+}
+
+PerfCounters::Sample PerfCounters::read() const {
+  // layout with PERF_FORMAT_GROUP: nr, time enabled, time running, values
+  std::array<std::uint64_t, 3 + NUM_COUNTERS> myBuffer;
+  const auto myRead = ::read(theFds[0], myBuffer.data(), sizeof(myBuffer));
+  if (myRead != static_cast<ssize_t>(sizeof(myBuffer)) or
+      myBuffer[0] != NUM_COUNTERS) {
+    throw std::runtime_error("cannot read the hardware performance counters");
+  }
+
+  // scale the values if the group has been multiplexed
+  const auto myEnabled = myBuffer[1];
+  const auto myRunning = myBuffer[2];
+  const auto myScale   = [myEnabled, myRunning](const std::uint64_t aValue) {
+    if (myRunning == 0 or myRunning == myEnabled) {
+      return aValue;
+    }
+    return static_cast<std::uint64_t>(static_cast<double>(aValue) *
+                                      myEnabled / myRunning);
+  };
+
+  Sample ret;
+  ret.theCycles       = myScale(myBuffer[3]);
+  ret.theInstructions = myScale(myBuffer[4]);
+  ret.theLlcMisses    = myScale(myBuffer[5]);
+  ret.theBranchMisses = myScale(myBuffer[6]);
+  return ret;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+    : theFds() {
+  throw std::runtime_error(
+      "hardware performance counters are only supported on Linux");
+}
+
+PerfCounters::~PerfCounters() {
+  // noop
+}
+
+PerfCounters::Sample PerfCounters::read() const {
+  return Sample();
+}
+
+#endif
+
+} // namespace qr
+} // namespace uiiit
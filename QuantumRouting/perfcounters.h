@@ -0,0 +1,97 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <array>
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Hardware performance counters of the calling thread, read through
+ * the Linux perf_event_open interface.
+ *
+ * The counters are opened as a group, so that they are always scheduled
+ * together, and they count only in user space. If the kernel multiplexes the
+ * hardware then the values are scaled by the fraction of time the group was
+ * actually counting.
+ */
+class PerfCounters final
+{
+  NONCOPYABLE_NONMOVABLE(PerfCounters);
+
+ public:
+  //! Counter values, either absolute or a difference between two readings.
+  struct Sample {
+    std::uint64_t theCycles       = 0;
+    std::uint64_t theInstructions = 0;
+    std::uint64_t theLlcMisses    = 0; //!< last-level cache misses
+    std::uint64_t theBranchMisses = 0; //!< mispredicted branches
+
+    Sample& operator+=(const Sample& aOther) noexcept;
+    Sample  operator-(const Sample& aOther) const noexcept;
+
+    //! \return the names of the counters, in the same order as toCsv().
+    static const std::vector<std::string>& names();
+
+    std::string toString() const;
+    std::string toCsv() const;
+  };
+
+  /**
+   * @brief Open the counters for the calling thread, which start counting
+   * immediately.
+   *
+   * @throw std::runtime_error if the counters cannot be opened, e.g., because
+   * the platform is not Linux, the CPU does not expose them to the virtual
+   * machine or /proc/sys/kernel/perf_event_paranoid does not allow it
+   */
+  PerfCounters();
+
+  ~PerfCounters();
+
+  //! \return the current values of the counters.
+  Sample read() const;
+
+ private:
+  static constexpr std::size_t NUM_COUNTERS = 4;
+
+  std::array<int, NUM_COUNTERS> theFds;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -200,5 +200,36 @@ double fidelitySwapping(const double        p1,
              std::pow((4.0 * F - 1.0) / 3.0, L);
 }
 
+PowerTable::PowerTable(const double aBase, const std::size_t aSize)
+    : theBase(aBase)
+    , theValues(aSize) {
+  for (std::size_t i = 0; i < aSize; i++) {
+    theValues[i] = compute(i);
+  }
+}
+
+double PowerTable::compute(const std::size_t aExponent) const {
+  return std::pow(theBase, aExponent);
+}
+
+FidelityTable::FidelityTable(const double      p1,
+                             const double      p2,
+                             const double      eta,
+                             const double      F,
+                             const std::size_t aSize)
+    : theP1(p1)
+    , theP2(p2)
+    , theEta(eta)
+    , theF(F)
+    , theValues(aSize) {
+  for (std::size_t i = 0; i < aSize; i++) {
+    theValues[i] = compute(i);
+  }
+}
+
+double FidelityTable::compute(const unsigned long L) const {
+  return fidelitySwapping(theP1, theP2, theEta, L, theF);
+}
+
 } // namespace qr
 } // namespace uiiit
\ No newline at end of file
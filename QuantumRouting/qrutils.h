@@ -32,6 +32,7 @@ SOFTWARE.
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -93,14 +94,15 @@ bool bigraphConnected(
 
 /**
  * @brief Return the fidelity of a pair of entangled qubits through L
- * neighboring links, each performing entanglement swapping, without considering
- * decoherence and depolarization impairments, see:
+ * neighboring links, with entanglement swapping at the L - 1 intermediate
+ * nodes, without considering decoherence and depolarization impairments, see:
  * https://arxiv.org/abs/quant-ph/9803056
  *
  * @param p1 the reliability on one-qubit operations
  * @param p2 the reliability of two-qubit operations
  * @param eta the probability of a wrong measurement
- * @param L the number of intermediate nodes, i.e., swaps
+ * @param L the number of links, i.e., edges of the path: with 0 or 1 the
+ * result is F
  * @param F the local entanglement fidelity
  * @return the resulting fidelity in [0,1]
  *
@@ -113,5 +115,93 @@ double fidelitySwapping(const double        p1,
                         const unsigned long L,
                         const double        F);
 
+/**
+ * @brief Table of the powers of a base, indexed by the exponent.
+ *
+ * The values are computed once with std::pow, hence a lookup returns exactly
+ * the same result. Exponents beyond the size of the table are computed on the
+ * fly.
+ */
+class PowerTable final
+{
+ public:
+  /**
+   * @brief Create a table with the given base.
+   *
+   * @param aBase the base of the powers
+   * @param aSize the number of exponents precomputed, from 0 to aSize - 1
+   */
+  explicit PowerTable(const double aBase = 1, const std::size_t aSize = 0);
+
+  //! \return the base raised to the given exponent.
+  double operator()(const std::size_t aExponent) const {
+    return aExponent < theValues.size() ? theValues[aExponent] :
+                                          compute(aExponent);
+  }
+
+  //! \return the base of the powers.
+  double base() const noexcept {
+    return theBase;
+  }
+
+  //! \return the number of exponents precomputed.
+  std::size_t size() const noexcept {
+    return theValues.size();
+  }
+
+ private:
+  double compute(const std::size_t aExponent) const;
+
+ private:
+  double              theBase;
+  std::vector<double> theValues;
+};
+
+/**
+ * @brief Table of the fidelity obtained with fidelitySwapping() for given
+ * p1, p2, eta, and F, indexed by the number of links L.
+ *
+ * The values are computed once with fidelitySwapping(), hence a lookup returns
+ * exactly the same result. Numbers of links beyond the size of the table are
+ * computed on the fly.
+ */
+class FidelityTable final
+{
+ public:
+  /**
+   * @brief Create a table for the given parameters.
+   *
+   * See fidelitySwapping() for the meaning of p1, p2, eta, and F.
+   *
+   * @param aSize the number of links precomputed, from 0 to aSize - 1: with
+   * a network of N nodes no path has more than N - 1 links
+   */
+  FidelityTable(const double      p1,
+                const double      p2,
+                const double      eta,
+                const double      F,
+                const std::size_t aSize);
+
+  //! \return the fidelity through L links.
+  double operator()(const unsigned long L) const {
+    return L < theValues.size() ? theValues[L] : compute(L);
+  }
+
+  //! \return the number of links precomputed.
+  std::size_t size() const noexcept {
+    return theValues.size();
+  }
+
+ private:
+  double compute(const unsigned long L) const;
+
+ private:
+  double              theP1;
+  double              theP2;
+  double              theEta;
+  double              theF;
+  std::vector<double> theValues;
+};
+
 } // namespace qr
 } // namespace uiiit
\ No newline at end of file
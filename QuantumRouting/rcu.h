@@ -0,0 +1,256 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Read-copy-update of an object with one writer and many readers,
+ * with epoch-based reclamation of the old versions.
+ *
+ * The writer publishes new immutable versions of the object, e.g., snapshots
+ * of a network taken while admitting and releasing flows, which replace the
+ * current one. The readers access the current version without locks: each
+ * reader announces the global epoch in its own slot when entering a read
+ * section, and an old version is deleted only when all the readers in a read
+ * section have announced an epoch later than the one in which it has been
+ * replaced.
+ *
+ * Readers never wait for the writer, and the writer never waits for readers:
+ * a reader that stays in a read section for long only delays the
+ * reclamation of the versions replaced in the meanwhile.
+ *
+ * @tparam T the type of the object published.
+ */
+template <class T>
+class Rcu final
+{
+  NONCOPYABLE_NONMOVABLE(Rcu);
+
+  //! A version of the object.
+  struct Node {
+    std::unique_ptr<const T> theValue;
+    std::uint64_t            theVersion;
+  };
+
+  //! Epoch announced by a reader, zero if not in a read section.
+  struct alignas(64) Slot {
+    std::atomic<bool>          theUsed{false};
+    std::atomic<std::uint64_t> theEpoch{0};
+  };
+
+ public:
+  class Reader;
+
+  //! A read section, in which the version read cannot be deleted.
+  class Guard final
+  {
+    NONCOPYABLE_NONMOVABLE(Guard);
+
+   public:
+    explicit Guard(Reader& aReader)
+        : theSlot(aReader.theSlot)
+        , theNode(nullptr) {
+      assert(theSlot.theEpoch.load(std::memory_order_relaxed) == 0);
+      // the epoch must be visible to the writer before the object is read
+      theSlot.theEpoch.store(aReader.theRcu.theEpoch.load());
+      theNode = aReader.theRcu.theCurrent.load();
+    }
+
+    ~Guard() {
+      theSlot.theEpoch.store(0, std::memory_order_release);
+    }
+
+    const T& operator*() const noexcept {
+      return *theNode->theValue;
+    }
+    const T* operator->() const noexcept {
+      return theNode->theValue.get();
+    }
+
+    //! \return the version read, starting from 0 for the initial object.
+    std::uint64_t version() const noexcept {
+      return theNode->theVersion;
+    }
+
+   private:
+    Slot&       theSlot;
+    const Node* theNode;
+  };
+
+  /**
+   * @brief A registered reader, which can be used by one thread at a time to
+   * enter read sections, one at a time.
+   */
+  class Reader final
+  {
+    NONCOPYABLE_NONMOVABLE(Reader);
+    friend class Guard;
+
+   public:
+    explicit Reader(Rcu& aRcu, Slot& aSlot)
+        : theRcu(aRcu)
+        , theSlot(aSlot) {
+      // noop
+    }
+
+    ~Reader() {
+      theSlot.theUsed.store(false, std::memory_order_release);
+    }
+
+    //! \return a new read section on the current version.
+    Guard read() {
+      return Guard(*this);
+    }
+
+   private:
+    Rcu&  theRcu;
+    Slot& theSlot;
+  };
+
+  /**
+   * @brief Create with an initial version of the object.
+   *
+   * @param aValue the initial version, must be non-null
+   * @param aMaxReaders the maximum number of readers registered at a time
+   *
+   * @throw std::runtime_error if the initial version is null
+   */
+  explicit Rcu(std::unique_ptr<const T>&& aValue,
+               const std::size_t          aMaxReaders = 64)
+      : theMaxReaders(aMaxReaders)
+      , theSlots(new Slot[aMaxReaders])
+      , theEpoch(1)
+      , theCurrent(new Node{std::move(aValue), 0})
+      , theRetired() {
+    if (theCurrent.load()->theValue.get() == nullptr) {
+      delete theCurrent.load();
+      throw std::runtime_error("invalid null initial value");
+    }
+  }
+
+  //! All the readers must have been destroyed.
+  ~Rcu() {
+    delete theCurrent.load();
+    for (const auto& myRetired : theRetired) {
+      delete myRetired.second;
+    }
+  }
+
+  /**
+   * @brief Register a new reader, can be called by any thread.
+   *
+   * @throw std::runtime_error if there are already the maximum number of
+   * readers registered
+   */
+  std::unique_ptr<Reader> reader() {
+    for (std::size_t i = 0; i < theMaxReaders; i++) {
+      auto myUsed = false;
+      if (theSlots[i].theUsed.compare_exchange_strong(myUsed, true)) {
+        return std::make_unique<Reader>(*this, theSlots[i]);
+      }
+    }
+    throw std::runtime_error("too many readers: " +
+                             std::to_string(theMaxReaders));
+  }
+
+  /**
+   * @brief Replace the current version of the object, writer only.
+   *
+   * The old versions that are not being read anymore are deleted.
+   *
+   * @return the version published
+   *
+   * @throw std::runtime_error if the new version is null
+   */
+  std::uint64_t publish(std::unique_ptr<const T>&& aValue) {
+    if (aValue.get() == nullptr) {
+      throw std::runtime_error("invalid null value");
+    }
+    const auto myVersion = theCurrent.load()->theVersion + 1;
+    const auto myOld =
+        theCurrent.exchange(new Node{std::move(aValue), myVersion});
+
+    // a reader that announces a later epoch reads the new version
+    theRetired.emplace_back(theEpoch.fetch_add(1), myOld);
+    reclaim();
+    return myVersion;
+  }
+
+  /**
+   * @brief Delete the old versions that are not being read, writer only.
+   *
+   * @return the number of old versions that are still kept
+   */
+  std::size_t reclaim() {
+    auto myMinEpoch = std::numeric_limits<std::uint64_t>::max();
+    for (std::size_t i = 0; i < theMaxReaders; i++) {
+      const auto myEpoch = theSlots[i].theEpoch.load();
+      if (myEpoch != 0 and myEpoch < myMinEpoch) {
+        myMinEpoch = myEpoch;
+      }
+    }
+    while (not theRetired.empty() and theRetired.front().first < myMinEpoch) {
+      delete theRetired.front().second;
+      theRetired.pop_front();
+    }
+    return theRetired.size();
+  }
+
+  //! \return the current version, writer only.
+  const T& current() const noexcept {
+    return *theCurrent.load(std::memory_order_relaxed)->theValue;
+  }
+
+ private:
+  const std::size_t          theMaxReaders;
+  std::unique_ptr<Slot[]>    theSlots;
+  std::atomic<std::uint64_t> theEpoch;
+  std::atomic<Node*>         theCurrent;
+  //! versions replaced, with the epoch in which this happened, oldest first.
+  std::deque<std::pair<std::uint64_t, Node*>> theRetired;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,85 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/serialexecutor.h"
+
+namespace uiiit {
+namespace qr {
+
+SerialExecutor::SerialExecutor()
+    : theMutex()
+    , theCondition()
+    , theTasks()
+    , theStopping(false)
+    , theThread() {
+  theThread = std::thread([this]() { loop(); });
+}
+
+SerialExecutor::~SerialExecutor() {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theStopping = true;
+  }
+  theCondition.notify_one();
+  theThread.join();
+}
+
+void SerialExecutor::wait() {
+  submit([]() {}).wait();
+}
+
+void SerialExecutor::post(Task&& aTask) {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theTasks.emplace_back(std::move(aTask));
+  }
+  theCondition.notify_one();
+}
+
+void SerialExecutor::loop() {
+  while (true) {
+    Task myTask;
+    {
+      std::unique_lock<std::mutex> myLock(theMutex);
+      theCondition.wait(
+          myLock, [this]() { return theStopping or not theTasks.empty(); });
+      if (theTasks.empty()) {
+        break;
+      }
+      myTask = std::move(theTasks.front());
+      theTasks.pop_front();
+    }
+    myTask();
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,104 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Execute tasks one at a time, in the order in which they are
+ * submitted, in a dedicated thread.
+ *
+ * The thread is started upon construction. Upon destruction all the tasks
+ * pending are executed before the thread is terminated.
+ */
+class SerialExecutor final
+{
+  NONCOPYABLE_NONMOVABLE(SerialExecutor);
+
+ public:
+  using Task = std::function<void()>;
+
+  SerialExecutor();
+
+  ~SerialExecutor();
+
+  /**
+   * @brief Enqueue a task for execution. Can be called by any thread.
+   *
+   * @param aFunction the function to be executed
+   *
+   * \return a future with the value returned by the function, or which holds
+   * the exception thrown by it.
+   */
+  template <class FUNCTION>
+  std::future<std::invoke_result_t<FUNCTION>> submit(FUNCTION&& aFunction) {
+    // std::function requires a copyable callable, but the task is not
+    auto myTask = std::make_shared<
+        std::packaged_task<std::invoke_result_t<FUNCTION>()>>(
+        std::forward<FUNCTION>(aFunction));
+    auto ret = myTask->get_future();
+    post([myTask]() { (*myTask)(); });
+    return ret;
+  }
+
+  //! Wait until all the tasks submitted so far have been executed. Must not
+  //! be called by a task.
+  void wait();
+
+ private:
+  void post(Task&& aTask);
+
+  void loop();
+
+ private:
+  std::mutex              theMutex;
+  std::condition_variable theCondition;
+  std::deque<Task>        theTasks;
+  bool                    theStopping;
+  std::thread             theThread;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,300 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/shmsnapshot.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+//! Identifies the shared memory objects created by ShmSnapshotWriter.
+constexpr std::uint64_t SNAPSHOT_MAGIC = 0x71722d736e617031; // "qr-snap1"
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free and
+                  std::atomic<double>::is_always_lock_free,
+              "shared memory snapshots require lock-free atomics");
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t) and
+                  sizeof(std::atomic<double>) == sizeof(double),
+              "unexpected size of atomic types");
+
+/**
+ * Layout of the shared memory object: the header is followed by the edges,
+ * as pairs of (src, dst), and then by the capacities, one per edge.
+ *
+ * All the fields but the constant ones are atomics accessed with relaxed
+ * memory order, their consistency being guaranteed by the sequence number,
+ * which is odd while a snapshot is being written.
+ */
+struct Header {
+  std::uint64_t              theMagic;
+  std::uint64_t              theMaxEdges;
+  std::atomic<std::uint64_t> theSequence;
+  std::atomic<std::uint64_t> theVersion;
+  std::atomic<std::uint64_t> theTopologyVersion;
+  std::atomic<std::uint64_t> theNumNodes;
+  std::atomic<std::uint64_t> theNumEdges;
+};
+
+std::size_t segmentSize(const std::size_t aMaxEdges) {
+  return sizeof(Header) + aMaxEdges * 2 * sizeof(std::atomic<std::uint64_t>) +
+         aMaxEdges * sizeof(std::atomic<double>);
+}
+
+std::atomic<std::uint64_t>* edges(void* aAddress) {
+  return reinterpret_cast<std::atomic<std::uint64_t>*>(
+      static_cast<char*>(aAddress) + sizeof(Header));
+}
+
+std::atomic<double>* capacities(void* aAddress, const std::size_t aMaxEdges) {
+  return reinterpret_cast<std::atomic<double>*>(
+      static_cast<char*>(aAddress) + sizeof(Header) +
+      aMaxEdges * 2 * sizeof(std::atomic<std::uint64_t>));
+}
+
+std::string errorMessage(const std::string& aAction,
+                         const std::string& aName) {
+  return "cannot " + aAction + " shared memory snapshot " + aName + ": " +
+         std::strerror(errno);
+}
+
+} // namespace
+
+ShmSnapshotWriter::ShmSnapshotWriter(const std::string& aName,
+                                     const std::size_t  aMaxEdges)
+    : theName(aName)
+    , theMaxEdges(aMaxEdges)
+    , theSize(segmentSize(aMaxEdges))
+    , theAddress(nullptr)
+    , theEdges() {
+  // an existing object is never replaced, since it may belong to another
+  // writer still running
+  const auto myFd =
+      ::shm_open(theName.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (myFd < 0 and errno == EEXIST) {
+    throw std::runtime_error(
+        "cannot create shared memory snapshot " + theName +
+        ": it already exists, remove it if no other writer is running");
+  }
+  if (myFd < 0) {
+    throw std::runtime_error(errorMessage("create", theName));
+  }
+  if (::ftruncate(myFd, static_cast<off_t>(theSize)) != 0) {
+    const auto myError = errorMessage("resize", theName);
+    ::close(myFd);
+    ::shm_unlink(theName.c_str());
+    throw std::runtime_error(myError);
+  }
+  theAddress =
+      ::mmap(nullptr, theSize, PROT_READ | PROT_WRITE, MAP_SHARED, myFd, 0);
+  ::close(myFd);
+  if (theAddress == MAP_FAILED) {
+    const auto myError = errorMessage("map", theName);
+    ::shm_unlink(theName.c_str());
+    throw std::runtime_error(myError);
+  }
+
+  // the object is zero-filled upon creation, which is a valid state for the
+  // atomics, hence only the constant fields have to be set
+  auto& myHeader       = *new (theAddress) Header();
+  myHeader.theMaxEdges = theMaxEdges;
+  std::atomic_thread_fence(std::memory_order_release);
+  myHeader.theMagic = SNAPSHOT_MAGIC;
+  VLOG(1) << "shared memory snapshot " << theName << " created, " << theSize
+          << " bytes";
+}
+
+ShmSnapshotWriter::~ShmSnapshotWriter() {
+  ::munmap(theAddress, theSize);
+  ::shm_unlink(theName.c_str());
+}
+
+std::uint64_t ShmSnapshotWriter::publish(const CapacityNetwork& aNetwork) {
+  const auto myNumEdges = aNetwork.numEdges();
+  if (myNumEdges > theMaxEdges) {
+    throw std::runtime_error("too many edges for shared memory snapshot " +
+                             theName + ": " + std::to_string(myNumEdges) +
+                             " > " + std::to_string(theMaxEdges));
+  }
+
+  auto&      myHeader     = *static_cast<Header*>(theAddress);
+  const auto myEdges      = edges(theAddress);
+  const auto myCapacities = capacities(theAddress, theMaxEdges);
+
+  // odd sequence number: the readers retry until it becomes even again
+  const auto mySequence = myHeader.theSequence.load(std::memory_order_relaxed);
+  myHeader.theSequence.store(mySequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto myTopologyChanged = mySequence == 0 or myNumEdges != theEdges.size();
+  std::size_t i = 0;
+  theEdges.resize(myNumEdges);
+  aNetwork.forEachEdge([&](const unsigned long aSrc,
+                           const unsigned long aDst,
+                           const double        aCapacity) {
+    auto& myEdge = theEdges[i];
+    if (myTopologyChanged or myEdge.first != aSrc or myEdge.second != aDst) {
+      myTopologyChanged = true;
+      myEdge            = std::make_pair(aSrc, aDst);
+      myEdges[2 * i].store(aSrc, std::memory_order_relaxed);
+      myEdges[2 * i + 1].store(aDst, std::memory_order_relaxed);
+    }
+    myCapacities[i].store(aCapacity, std::memory_order_relaxed);
+    ++i;
+  });
+  assert(i == myNumEdges);
+
+  if (myTopologyChanged) {
+    myHeader.theTopologyVersion.fetch_add(1, std::memory_order_relaxed);
+    myHeader.theNumNodes.store(aNetwork.numNodes(), std::memory_order_relaxed);
+    myHeader.theNumEdges.store(myNumEdges, std::memory_order_relaxed);
+  }
+  const auto ret = myHeader.theVersion.load(std::memory_order_relaxed) + 1;
+  myHeader.theVersion.store(ret, std::memory_order_relaxed);
+
+  myHeader.theSequence.store(mySequence + 2, std::memory_order_release);
+  return ret;
+}
+
+ShmSnapshotReader::ShmSnapshotReader(const std::string& aName)
+    : theSize(0)
+    , theAddress(nullptr) {
+  const auto myFd = ::shm_open(aName.c_str(), O_RDONLY, 0);
+  if (myFd < 0) {
+    throw std::runtime_error(errorMessage("open", aName));
+  }
+  struct stat myStat;
+  if (::fstat(myFd, &myStat) != 0) {
+    const auto myError = errorMessage("stat", aName);
+    ::close(myFd);
+    throw std::runtime_error(myError);
+  }
+  theSize = static_cast<std::size_t>(myStat.st_size);
+  if (theSize < sizeof(Header)) {
+    ::close(myFd);
+    throw std::runtime_error("invalid shared memory snapshot " + aName);
+  }
+  theAddress = ::mmap(nullptr, theSize, PROT_READ, MAP_SHARED, myFd, 0);
+  ::close(myFd);
+  if (theAddress == MAP_FAILED) {
+    throw std::runtime_error(errorMessage("map", aName));
+  }
+
+  const auto& myHeader = *static_cast<const Header*>(theAddress);
+  if (myHeader.theMagic != SNAPSHOT_MAGIC or
+      segmentSize(myHeader.theMaxEdges) != theSize) {
+    ::munmap(theAddress, theSize);
+    throw std::runtime_error("invalid shared memory snapshot " + aName);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+ShmSnapshotReader::~ShmSnapshotReader() {
+  ::munmap(theAddress, theSize);
+}
+
+bool ShmSnapshotReader::read(Snapshot& aSnapshot) const {
+  const auto& myHeader     = *static_cast<const Header*>(theAddress);
+  const auto  myMaxEdges   = myHeader.theMaxEdges;
+  const auto  myEdges      = edges(theAddress);
+  const auto  myCapacities = capacities(theAddress, myMaxEdges);
+
+  while (true) {
+    const auto mySequence = myHeader.theSequence.load(std::memory_order_acquire);
+    if (mySequence == 0) {
+      return false;
+    }
+    if (mySequence % 2 == 1) {
+      std::this_thread::yield(); // being written
+      continue;
+    }
+
+    const auto myVersion = myHeader.theVersion.load(std::memory_order_relaxed);
+    const auto myTopologyVersion =
+        myHeader.theTopologyVersion.load(std::memory_order_relaxed);
+    const auto myNumNodes = myHeader.theNumNodes.load(std::memory_order_relaxed);
+    const auto myNumEdges = myHeader.theNumEdges.load(std::memory_order_relaxed);
+    if (myNumEdges > myMaxEdges) {
+      std::this_thread::yield(); // torn read
+      continue;
+    }
+
+    // the edges copied may be inconsistent if the read fails, but in this
+    // case the topology version of aSnapshot is not updated, so they will be
+    // copied again at the next attempt
+    const auto myCopyEdges = myTopologyVersion != aSnapshot.theTopologyVersion;
+    if (myCopyEdges) {
+      aSnapshot.theEdges.resize(myNumEdges);
+      for (std::size_t i = 0; i < myNumEdges; i++) {
+        aSnapshot.theEdges[i] = std::make_pair(
+            myEdges[2 * i].load(std::memory_order_relaxed),
+            myEdges[2 * i + 1].load(std::memory_order_relaxed));
+      }
+    }
+    aSnapshot.theCapacities.resize(myNumEdges);
+    for (std::size_t i = 0; i < myNumEdges; i++) {
+      aSnapshot.theCapacities[i] =
+          myCapacities[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (myHeader.theSequence.load(std::memory_order_relaxed) == mySequence) {
+      aSnapshot.theVersion         = myVersion;
+      aSnapshot.theTopologyVersion = myTopologyVersion;
+      aSnapshot.theNumNodes        = myNumNodes;
+      return true;
+    }
+    std::this_thread::yield();
+  }
+}
+
+std::uint64_t ShmSnapshotReader::version() const noexcept {
+  return static_cast<const Header*>(theAddress)->theVersion.load(
+      std::memory_order_acquire);
+}
+
+} // namespace qr
+} // namespace uiiit
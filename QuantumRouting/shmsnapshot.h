@@ -0,0 +1,146 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "Support/macros.h"
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Publish the topology and residual capacities of a network into a
+ * POSIX shared memory object, which can be read by other processes on the
+ * same host with ShmSnapshotReader.
+ *
+ * The snapshots are protected by a sequence lock: the publisher never waits
+ * for the readers, which retry if the snapshot they have read has been
+ * modified in the meanwhile. The topology is written only when it changes.
+ *
+ * There must be a single publisher per object.
+ */
+class ShmSnapshotWriter final
+{
+  NONCOPYABLE_NONMOVABLE(ShmSnapshotWriter);
+
+ public:
+  /**
+   * @brief Create the shared memory object.
+   *
+   * An object with the same name left by a writer that did not terminate
+   * cleanly must be removed manually, e.g., from /dev/shm on Linux.
+   *
+   * @param aName the name of the object, which must start with '/'
+   * @param aMaxEdges the maximum number of edges of the networks published
+   *
+   * @throw std::runtime_error if the object cannot be created, also because
+   * an object with the same name already exists
+   */
+  explicit ShmSnapshotWriter(const std::string& aName,
+                             const std::size_t  aMaxEdges);
+
+  //! Remove the shared memory object.
+  ~ShmSnapshotWriter();
+
+  /**
+   * @brief Publish the current state of a network.
+   *
+   * @return the version of the snapshot published, starting from 1
+   *
+   * @throw std::runtime_error if the network has too many edges
+   */
+  std::uint64_t publish(const CapacityNetwork& aNetwork);
+
+ private:
+  const std::string           theName;
+  const std::size_t           theMaxEdges;
+  std::size_t                 theSize;
+  void*                       theAddress;
+  CapacityNetwork::EdgeVector theEdges; //!< last topology published
+};
+
+/**
+ * @brief Read the snapshots published by a ShmSnapshotWriter.
+ *
+ * The object is mapped into memory upon construction, hence reading a
+ * snapshot does not require any system call.
+ */
+class ShmSnapshotReader final
+{
+  NONCOPYABLE_NONMOVABLE(ShmSnapshotReader);
+
+ public:
+  //! A consistent copy of the network published.
+  struct Snapshot {
+    std::uint64_t               theVersion         = 0;
+    std::uint64_t               theTopologyVersion = 0;
+    std::size_t                 theNumNodes        = 0;
+    CapacityNetwork::EdgeVector theEdges;      //!< (src, dst)
+    std::vector<double>         theCapacities; //!< same order as theEdges
+  };
+
+  /**
+   * @brief Open an existing shared memory object.
+   *
+   * @throw std::runtime_error if the object cannot be opened or it has not
+   * been created by a ShmSnapshotWriter
+   */
+  explicit ShmSnapshotReader(const std::string& aName);
+
+  ~ShmSnapshotReader();
+
+  /**
+   * @brief Copy the most recent snapshot.
+   *
+   * The edges are copied only if the topology has changed since the
+   * snapshot passed was read, while the capacities are always copied.
+   *
+   * @param aSnapshot the snapshot overwritten
+   * @return false if no snapshot has been published yet, in which case
+   * aSnapshot is not changed
+   */
+  bool read(Snapshot& aSnapshot) const;
+
+  //! \return the version of the most recent snapshot, or 0 if none.
+  std::uint64_t version() const noexcept;
+
+ private:
+  std::size_t theSize;
+  void*       theAddress;
+};
+
+} // namespace qr
+} // namespace uiiit
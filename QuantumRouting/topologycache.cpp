@@ -0,0 +1,131 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/topologycache.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+const char MAGIC[] = "QRTOPO02";
+
+struct CacheRecord {
+  std::uint32_t theSrc;
+  std::uint32_t theDst;
+  double        theCapacity;
+};
+static_assert(sizeof(CacheRecord) == 16, "unexpected cache record size");
+
+} // namespace
+
+void saveTopologyCache(const std::string&     aFilename,
+                       const CapacityNetwork& aNetwork) {
+  const auto          myWeights  = aNetwork.weights();
+  const std::uint64_t myNumNodes = aNetwork.numNodes();
+  const std::uint64_t mySize     = myWeights.size();
+  if (myNumNodes > std::uint64_t(std::numeric_limits<std::uint32_t>::max()) +
+                       1) {
+    throw std::runtime_error("too many nodes for a topology cache: " +
+                             std::to_string(myNumNodes));
+  }
+
+  std::ofstream myStream(aFilename, std::ios::binary | std::ios::trunc);
+  myStream.write(MAGIC, sizeof(MAGIC) - 1);
+  myStream.write(reinterpret_cast<const char*>(&myNumNodes),
+                 sizeof(myNumNodes));
+  myStream.write(reinterpret_cast<const char*>(&mySize), sizeof(mySize));
+  for (const auto& myWeight : myWeights) {
+    const CacheRecord myRecord{
+        static_cast<std::uint32_t>(std::get<0>(myWeight)),
+        static_cast<std::uint32_t>(std::get<1>(myWeight)),
+        std::get<2>(myWeight)};
+    myStream.write(reinterpret_cast<const char*>(&myRecord), sizeof(myRecord));
+  }
+  if (not myStream) {
+    throw std::runtime_error("cannot write topology cache: " + aFilename);
+  }
+}
+
+CapacityNetwork::WeightVector loadTopologyCache(const std::string& aFilename,
+                                                std::size_t&       aNumNodes) {
+  std::ifstream myStream(aFilename, std::ios::binary | std::ios::ate);
+  if (not myStream) {
+    throw std::runtime_error("cannot read topology cache: " + aFilename);
+  }
+  const auto myLength = static_cast<std::uint64_t>(myStream.tellg());
+  myStream.seekg(0);
+
+  char          myMagic[sizeof(MAGIC) - 1];
+  std::uint64_t myNumNodes = 0;
+  std::uint64_t mySize     = 0;
+  myStream.read(myMagic, sizeof(myMagic));
+  myStream.read(reinterpret_cast<char*>(&myNumNodes), sizeof(myNumNodes));
+  myStream.read(reinterpret_cast<char*>(&mySize), sizeof(mySize));
+  if (not myStream or std::memcmp(myMagic, MAGIC, sizeof(myMagic)) != 0) {
+    throw std::runtime_error("invalid topology cache: " + aFilename);
+  }
+
+  // check the number of edges against the file length before allocating
+  const auto myHeaderLength =
+      sizeof(myMagic) + sizeof(myNumNodes) + sizeof(mySize);
+  if (mySize != (myLength - myHeaderLength) / sizeof(CacheRecord) or
+      (myLength - myHeaderLength) % sizeof(CacheRecord) != 0) {
+    throw std::runtime_error("invalid number of edges in topology cache: " +
+                             aFilename);
+  }
+
+  CapacityNetwork::WeightVector ret;
+  ret.reserve(mySize);
+  for (std::uint64_t i = 0; i < mySize; i++) {
+    CacheRecord myRecord;
+    myStream.read(reinterpret_cast<char*>(&myRecord), sizeof(myRecord));
+    if (not myStream) {
+      throw std::runtime_error("truncated topology cache: " + aFilename);
+    }
+    if (myRecord.theSrc >= myNumNodes or myRecord.theDst >= myNumNodes) {
+      throw std::runtime_error("invalid node in topology cache: " +
+                               aFilename);
+    }
+    ret.emplace_back(myRecord.theSrc, myRecord.theDst, myRecord.theCapacity);
+  }
+  aNumNodes = myNumNodes;
+  return ret;
+}
+
+} // namespace qr
+} // namespace uiiit
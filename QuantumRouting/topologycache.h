@@ -0,0 +1,72 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "QuantumRouting/capacitynetwork.h"
+
+#include <string>
+
+namespace uiiit {
+namespace qr {
+
+/**
+ * @brief Save the nodes, edges and capacities of a network to a binary cache
+ * file, so that the same topology can be loaded again without parsing the
+ * GraphML file or drawing the EPR rates of the links.
+ *
+ * The file format, in native byte order, is the magic string "QRTOPO02",
+ * followed by the number of nodes and the number of edges as 64-bit unsigned
+ * integers and then, for each edge, the source and destination as 32-bit
+ * unsigned integers and the capacity as a double.
+ *
+ * @throw std::runtime_error if the file cannot be written or a node does not
+ * fit into 32 bits
+ */
+void saveTopologyCache(const std::string&     aFilename,
+                       const CapacityNetwork& aNetwork);
+
+/**
+ * @brief Load the edges and their capacities from a binary cache file written
+ * by saveTopologyCache().
+ *
+ * @param aFilename the name of the file
+ * @param aNumNodes the number of nodes, including the isolated ones
+ * @return the edges and their capacities
+ *
+ * @throw std::runtime_error if the file cannot be read or it is not a valid
+ * topology cache
+ */
+CapacityNetwork::WeightVector loadTopologyCache(const std::string& aFilename,
+                                                std::size_t&       aNumNodes);
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,260 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+const char MAGIC[] = "QRTRACE2";
+
+class RingBuffer final
+{
+ public:
+  explicit RingBuffer(const std::size_t aCapacity)
+      : theRecords(aCapacity)
+      , theMask(aCapacity - 1)
+      , theNext(0) {
+    // noop
+  }
+
+  void push(const TraceRecord& aRecord) noexcept {
+    theRecords[theNext & theMask] = aRecord;
+    ++theNext;
+  }
+
+  //! \return the records, oldest first.
+  std::vector<TraceRecord> records() const {
+    std::vector<TraceRecord> ret;
+    const auto myFirst =
+        theNext > theRecords.size() ? theNext - theRecords.size() : 0;
+    ret.reserve(theNext - myFirst);
+    for (auto i = myFirst; i < theNext; ++i) {
+      ret.emplace_back(theRecords[i & theMask]);
+    }
+    return ret;
+  }
+
+  void clear() noexcept {
+    theNext = 0;
+  }
+
+ private:
+  std::vector<TraceRecord> theRecords;
+  const std::uint64_t      theMask;
+  std::uint64_t            theNext;
+};
+
+struct Registry {
+  std::mutex                             theMutex;
+  std::list<std::unique_ptr<RingBuffer>> theBuffers;
+  std::size_t                            theCapacity = 1 << 16;
+  std::atomic<bool>                      theEnabled{false};
+
+  static Registry& instance() {
+    static Registry myInstance;
+    return myInstance;
+  }
+};
+
+thread_local RingBuffer*   theLocalBuffer = nullptr;
+thread_local std::uint32_t theLocalPoint  = 0;
+thread_local std::uint32_t theLocalSeed   = 0;
+
+RingBuffer& localBuffer() {
+  if (theLocalBuffer == nullptr) {
+    auto&                             myRegistry = Registry::instance();
+    const std::lock_guard<std::mutex> myLock(myRegistry.theMutex);
+    myRegistry.theBuffers.emplace_back(
+        std::make_unique<RingBuffer>(myRegistry.theCapacity));
+    theLocalBuffer = myRegistry.theBuffers.back().get();
+  }
+  return *theLocalBuffer;
+}
+
+template <class T>
+void write(std::ostream& aOutput, const T& aValue) {
+  aOutput.write(reinterpret_cast<const char*>(&aValue), sizeof(T));
+}
+
+template <class T>
+void read(std::istream& aInput, T& aValue) {
+  aInput.read(reinterpret_cast<char*>(&aValue), sizeof(T));
+  if (not aInput) {
+    throw std::runtime_error("truncated trace");
+  }
+}
+
+} // namespace
+
+std::string Trace::name(const TraceEvent aEvent) {
+  switch (aEvent) {
+    case TraceEvent::FlowCandidate:
+      return "flow-candidate";
+    case TraceEvent::FlowEdgeRemoved:
+      return "flow-edge-removed";
+    case TraceEvent::FlowAdmitted:
+      return "flow-admitted";
+    case TraceEvent::FlowRejected:
+      return "flow-rejected";
+    case TraceEvent::AppPathFound:
+      return "app-path-found";
+    case TraceEvent::AppPathExpired:
+      return "app-path-expired";
+    case TraceEvent::AppAllocated:
+      return "app-allocated";
+    case TraceEvent::AppEdgeRemoved:
+      return "app-edge-removed";
+    case TraceEvent::AppRemoved:
+      return "app-removed";
+    case TraceEvent::LaneCandidate:
+      return "lane-candidate";
+    case TraceEvent::ReachableNode:
+      return "reachable-node";
+  }
+  return "unknown";
+}
+
+std::string TraceRecord::toString() const {
+  std::stringstream myStream;
+  myStream << theTime << ' ' << Trace::name(TraceEvent(theEvent)) << ' '
+           << theArgs[0] << ' ' << theArgs[1] << ' ' << theArgs[2]
+           << ' ' << theValue << " point " << thePoint << " seed " << theSeed;
+  return myStream.str();
+}
+
+bool Trace::enabled() noexcept {
+  return Registry::instance().theEnabled.load(std::memory_order_relaxed);
+}
+
+void Trace::enable(const bool aEnabled) noexcept {
+  Registry::instance().theEnabled.store(aEnabled, std::memory_order_relaxed);
+}
+
+void Trace::registerThread() {
+  if (enabled()) {
+    localBuffer();
+  }
+}
+
+void Trace::experiment(const std::size_t aPoint,
+                       const std::size_t aSeed) noexcept {
+  theLocalPoint = static_cast<std::uint32_t>(aPoint);
+  theLocalSeed  = static_cast<std::uint32_t>(aSeed);
+}
+
+void Trace::capacity(const std::size_t aCapacity) {
+  if (aCapacity == 0) {
+    throw std::runtime_error("invalid null trace buffer capacity");
+  }
+  std::size_t myCapacity = 1;
+  while (myCapacity < aCapacity) {
+    myCapacity <<= 1;
+  }
+  auto&                             myRegistry = Registry::instance();
+  const std::lock_guard<std::mutex> myLock(myRegistry.theMutex);
+  myRegistry.theCapacity = myCapacity;
+}
+
+void Trace::record(const TraceEvent    aEvent,
+                   const std::uint32_t aArg0,
+                   const std::uint32_t aArg1,
+                   const std::uint32_t aArg2,
+                   const double        aValue) {
+  localBuffer().push(TraceRecord{
+      static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count()),
+      static_cast<std::uint32_t>(aEvent),
+      {aArg0, aArg1, aArg2},
+      aValue,
+      theLocalPoint,
+      theLocalSeed});
+}
+
+void Trace::save(std::ostream& aOutput) {
+  auto&                             myRegistry = Registry::instance();
+  const std::lock_guard<std::mutex> myLock(myRegistry.theMutex);
+  aOutput.write(MAGIC, sizeof(MAGIC) - 1);
+  write(aOutput, static_cast<std::uint64_t>(myRegistry.theBuffers.size()));
+  for (const auto& myBuffer : myRegistry.theBuffers) {
+    const auto myRecords = myBuffer->records();
+    write(aOutput, static_cast<std::uint64_t>(myRecords.size()));
+    aOutput.write(reinterpret_cast<const char*>(myRecords.data()),
+                  myRecords.size() * sizeof(TraceRecord));
+  }
+  if (not aOutput) {
+    throw std::runtime_error("could not write the trace");
+  }
+}
+
+std::vector<std::vector<TraceRecord>> Trace::load(std::istream& aInput) {
+  char myMagic[sizeof(MAGIC) - 1];
+  aInput.read(myMagic, sizeof(myMagic));
+  if (not aInput or std::memcmp(myMagic, MAGIC, sizeof(myMagic)) != 0) {
+    throw std::runtime_error("invalid trace: wrong magic");
+  }
+  std::uint64_t myNumBuffers;
+  read(aInput, myNumBuffers);
+  std::vector<std::vector<TraceRecord>> ret(myNumBuffers);
+  for (auto& myRecords : ret) {
+    std::uint64_t myNumRecords;
+    read(aInput, myNumRecords);
+    myRecords.resize(myNumRecords);
+    for (auto& myRecord : myRecords) {
+      read(aInput, myRecord);
+    }
+  }
+  return ret;
+}
+
+void Trace::clear() {
+  auto&                             myRegistry = Registry::instance();
+  const std::lock_guard<std::mutex> myLock(myRegistry.theMutex);
+  for (auto& myBuffer : myRegistry.theBuffers) {
+    myBuffer->clear();
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
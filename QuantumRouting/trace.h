@@ -0,0 +1,187 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Maximum level of the QR_TRACE statements compiled in:
+ * - 0: none
+ * - 1: outcome of every flow or application routed
+ * - 2: also the steps within the routing loops
+ */
+#ifndef QR_TRACE_LEVEL
+#define QR_TRACE_LEVEL 0
+#endif
+
+/**
+ * Record a trace event in the ring buffer of the calling thread, if the level
+ * is compiled in and tracing has been enabled at run-time.
+ *
+ * The arguments are not evaluated if the level is not compiled in.
+ */
+#define QR_TRACE(aLevel, aEvent, aArg0, aArg1, aArg2, aValue)                 \
+  do {                                                                        \
+    if constexpr ((aLevel) <= QR_TRACE_LEVEL) {                               \
+      if (::uiiit::qr::Trace::enabled()) {                                    \
+        ::uiiit::qr::Trace::record(                                           \
+            ::uiiit::qr::TraceEvent::aEvent, aArg0, aArg1, aArg2, aValue);    \
+      }                                                                       \
+    }                                                                         \
+  } while (false)
+
+namespace uiiit {
+namespace qr {
+
+//! The events traced, with the meaning of their arguments and value.
+enum class TraceEvent : std::uint32_t {
+  FlowCandidate   = 0, //!< src, dst, num hops; gross rate
+  FlowEdgeRemoved = 1, //!< edge src, edge dst, -; capacity
+  FlowAdmitted    = 2, //!< src, dst, num hops; gross rate
+  FlowRejected    = 3, //!< src, dst, Dijkstra calls; net rate
+  AppPathFound    = 4, //!< host, peer, num hops; 1 if valid, else 0
+  AppPathExpired  = 5, //!< host, peer, num hops; -
+  AppAllocated    = 6, //!< host, peer, num hops; gross rate
+  AppEdgeRemoved  = 7, //!< edge src, edge dst, -; -
+  AppRemoved      = 8, //!< host, -, -; -
+  LaneCandidate   = 9, //!< lane, src, num hops; gross rate
+  ReachableNode   = 10, //!< src, dst, distance; -
+};
+
+//! Binary record of a trace event.
+struct TraceRecord {
+  std::uint64_t theTime;    //!< ns since the steady clock epoch
+  std::uint32_t theEvent;   //!< TraceEvent
+  std::uint32_t theArgs[3]; //!< meaning depends on the event
+  double        theValue;   //!< meaning depends on the event
+  std::uint32_t thePoint;   //!< grid point of the experiment
+  std::uint32_t theSeed;    //!< seed of the experiment, lower 32 bits
+
+  std::string toString() const;
+};
+static_assert(sizeof(TraceRecord) == 40, "unexpected trace record size");
+
+/**
+ * @brief Tracing of the routing algorithms into per-thread ring buffers.
+ *
+ * Every thread writes to its own buffer without synchronization, once the
+ * buffer has been created with registerThread() or upon the first record.
+ * When a buffer is full the oldest records are overwritten. The records are
+ * tagged with the experiment currently run by the thread, see experiment(),
+ * so that the traces of different points of a sweep can be told apart.
+ *
+ * The buffers survive the threads, so that they can be saved at the end of
+ * an experiment. Saving and clearing must not happen concurrently with
+ * tracing.
+ *
+ * The binary file format, in native byte order, is:
+ * - magic "QRTRACE2" (8 bytes)
+ * - number of buffers (uint64)
+ * - for each buffer: number of records (uint64) followed by the records,
+ *   oldest first, see TraceRecord
+ */
+class Trace final
+{
+ public:
+  //! \return a human-readable name of the event.
+  static std::string name(const TraceEvent aEvent);
+
+  //! \return true if tracing is enabled at run-time.
+  static bool enabled() noexcept;
+
+  //! Enable or disable tracing at run-time. Disabled by default.
+  static void enable(const bool aEnabled) noexcept;
+
+  /**
+   * @brief Create the buffer of the calling thread, if tracing is enabled
+   * and this has not been done yet.
+   *
+   * Meant to be called by the worker threads before they start routing, so
+   * that recording does not allocate. Threads that are not registered create
+   * their buffer when they record the first event.
+   *
+   * @throw std::bad_alloc if the buffer cannot be allocated
+   */
+  static void registerThread();
+
+  /**
+   * @brief Set the experiment run by the calling thread, with which its
+   * records are tagged from now on. Both are zero by default.
+   *
+   * @param aPoint the index of the grid point of a sweep
+   * @param aSeed the seed of the experiment
+   */
+  static void experiment(const std::size_t aPoint,
+                         const std::size_t aSeed) noexcept;
+
+  /**
+   * @brief Set the number of records of the buffers created afterwards.
+   *
+   * @param aCapacity the capacity, rounded up to the next power of two
+   *
+   * @throw std::runtime_error if the capacity is zero
+   */
+  static void capacity(const std::size_t aCapacity);
+
+  /**
+   * @brief Record an event in the buffer of the calling thread.
+   *
+   * Does not allocate if the thread has been registered with
+   * registerThread(), otherwise the buffer is created on the first call.
+   */
+  static void record(const TraceEvent    aEvent,
+                     const std::uint32_t aArg0,
+                     const std::uint32_t aArg1,
+                     const std::uint32_t aArg2,
+                     const double        aValue);
+
+  //! Write all the buffers to a binary stream.
+  static void save(std::ostream& aOutput);
+
+  /**
+   * @brief Read the buffers written by save().
+   *
+   * @return the records of each buffer, oldest first
+   *
+   * @throw std::runtime_error if the input is not a valid trace
+   */
+  static std::vector<std::vector<TraceRecord>> load(std::istream& aInput);
+
+  //! Remove all the records from the buffers.
+  static void clear();
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,192 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/workload.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+namespace {
+
+const char MAGIC[] = "QRWKLD01";
+
+std::string errorMessage(const std::string& aAction,
+                         const std::string& aFilename) {
+  return "cannot " + aAction + " workload file " + aFilename + ": " +
+         std::strerror(errno);
+}
+
+} // namespace
+
+bool WorkloadEvent::operator==(const WorkloadEvent& aOther) const noexcept {
+  return theTime == aOther.theTime and theSrc == aOther.theSrc and
+         theDst == aOther.theDst and theNetRateId == aOther.theNetRateId and
+         theFidelityThresholdId == aOther.theFidelityThresholdId and
+         theDuration == aOther.theDuration;
+}
+
+std::string WorkloadEvent::toString() const {
+  std::stringstream myStream;
+  myStream << "time " << theTime << ", " << theSrc << " -> " << theDst
+           << ", net rate class " << theNetRateId << ", fidelity class "
+           << theFidelityThresholdId << ", duration " << theDuration;
+  return myStream.str();
+}
+
+WorkloadHeader WorkloadHeader::make(const std::size_t aNumNodes,
+                                    const std::size_t aNumNetRates,
+                                    const std::size_t aNumFidelityThresholds,
+                                    const std::size_t aSeed) {
+  WorkloadHeader ret;
+  std::memcpy(ret.theMagic, MAGIC, sizeof(ret.theMagic));
+  ret.theNumNodes              = static_cast<std::uint32_t>(aNumNodes);
+  ret.theNumNetRates           = static_cast<std::uint32_t>(aNumNetRates);
+  ret.theNumFidelityThresholds = static_cast<std::uint32_t>(
+      aNumFidelityThresholds);
+  ret.theReserved = 0;
+  ret.theSeed     = aSeed;
+  return ret;
+}
+
+void WorkloadHeader::check(const std::size_t aNumNodes,
+                           const std::size_t aNumNetRates,
+                           const std::size_t aNumFidelityThresholds) const {
+  if (theNumNodes != aNumNodes) {
+    throw std::runtime_error(
+        "the workload was recorded with " + std::to_string(theNumNodes) +
+        " nodes, but the network has " + std::to_string(aNumNodes));
+  }
+  if (theNumNetRates != aNumNetRates) {
+    throw std::runtime_error("the workload was recorded with " +
+                             std::to_string(theNumNetRates) +
+                             " net rate classes, but there are " +
+                             std::to_string(aNumNetRates));
+  }
+  if (theNumFidelityThresholds != aNumFidelityThresholds) {
+    throw std::runtime_error("the workload was recorded with " +
+                             std::to_string(theNumFidelityThresholds) +
+                             " fidelity classes, but there are " +
+                             std::to_string(aNumFidelityThresholds));
+  }
+}
+
+bool WorkloadHeader::valid(const WorkloadEvent& aEvent) const noexcept {
+  return aEvent.theSrc < theNumNodes and aEvent.theDst < theNumNodes and
+         aEvent.theSrc != aEvent.theDst and
+         aEvent.theNetRateId < theNumNetRates and
+         aEvent.theFidelityThresholdId < theNumFidelityThresholds;
+}
+
+WorkloadWriter::WorkloadWriter(const std::string&    aFilename,
+                               const WorkloadHeader& aHeader)
+    : theFilename(aFilename)
+    , theStream(aFilename, std::ios::binary | std::ios::trunc)
+    , theSize(0) {
+  theStream.write(reinterpret_cast<const char*>(&aHeader), sizeof(aHeader));
+  if (not theStream) {
+    throw std::runtime_error("cannot write workload file: " + theFilename);
+  }
+}
+
+void WorkloadWriter::operator()(const WorkloadEvent& aEvent) {
+  theStream.write(reinterpret_cast<const char*>(&aEvent), sizeof(aEvent));
+  if (not theStream) {
+    throw std::runtime_error("cannot write workload file: " + theFilename);
+  }
+  ++theSize;
+}
+
+WorkloadReader::WorkloadReader(const std::string& aFilename)
+    : theData(nullptr)
+    , theLength(0)
+    , theSize(0) {
+  const auto myFd = ::open(aFilename.c_str(), O_RDONLY);
+  if (myFd < 0) {
+    throw std::runtime_error(errorMessage("open", aFilename));
+  }
+  struct stat myStat;
+  if (::fstat(myFd, &myStat) != 0) {
+    const auto myError = errorMessage("stat", aFilename);
+    ::close(myFd);
+    throw std::runtime_error(myError);
+  }
+  theLength = static_cast<std::size_t>(myStat.st_size);
+  if (theLength < sizeof(WorkloadHeader) or
+      (theLength - sizeof(WorkloadHeader)) % sizeof(WorkloadEvent) != 0) {
+    ::close(myFd);
+    throw std::runtime_error("invalid size of workload file " + aFilename +
+                             ": " + std::to_string(theLength));
+  }
+  theData = ::mmap(nullptr, theLength, PROT_READ, MAP_PRIVATE, myFd, 0);
+  if (theData == MAP_FAILED) {
+    const auto myError = errorMessage("map", aFilename);
+    ::close(myFd);
+    throw std::runtime_error(myError);
+  }
+  ::close(myFd);
+  if (std::memcmp(header().theMagic, MAGIC, sizeof(header().theMagic)) != 0) {
+    ::munmap(theData, theLength);
+    throw std::runtime_error("invalid workload file: " + aFilename);
+  }
+  theSize = (theLength - sizeof(WorkloadHeader)) / sizeof(WorkloadEvent);
+
+  // the events are read once from the beginning to the end
+  ::madvise(theData, theLength, MADV_SEQUENTIAL);
+}
+
+WorkloadReader::~WorkloadReader() {
+  ::munmap(theData, theLength);
+}
+
+std::size_t WorkloadReader::replay(
+    const std::function<void(const WorkloadEvent&)>& aCallback) const {
+  for (const auto& myEvent : *this) {
+    if (not header().valid(myEvent)) {
+      throw std::runtime_error("invalid flow in workload file: " +
+                               myEvent.toString());
+    }
+    aCallback(myEvent);
+  }
+  return theSize;
+}
+
+} // namespace qr
+} // namespace uiiit
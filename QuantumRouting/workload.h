@@ -0,0 +1,191 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <cinttypes>
+#include <fstream>
+#include <functional>
+#include <string>
+
+namespace uiiit {
+namespace qr {
+
+//! Arrival of a new flow in a dynamic simulation.
+struct WorkloadEvent {
+  double        theTime;                //!< arrival time
+  std::uint32_t theSrc;                 //!< source node
+  std::uint32_t theDst;                 //!< destination node
+  std::uint32_t theNetRateId;           //!< index of the net rate class
+  std::uint32_t theFidelityThresholdId; //!< index of the fidelity class
+  double        theDuration;            //!< holding time, if admitted
+
+  bool operator==(const WorkloadEvent& aOther) const noexcept;
+
+  std::string toString() const;
+};
+static_assert(sizeof(WorkloadEvent) == 32, "unexpected workload event size");
+
+//! Properties of the simulation that generated a workload.
+struct WorkloadHeader {
+  char          theMagic[8];              //!< "QRWKLD01"
+  std::uint32_t theNumNodes;              //!< number of nodes in the network
+  std::uint32_t theNumNetRates;           //!< number of net rate classes
+  std::uint32_t theNumFidelityThresholds; //!< number of fidelity classes
+  std::uint32_t theReserved;              //!< always zero
+  std::uint64_t theSeed;                  //!< seed of the simulation
+
+  //! \return a header with the magic string set and the given properties.
+  static WorkloadHeader make(const std::size_t aNumNodes,
+                             const std::size_t aNumNetRates,
+                             const std::size_t aNumFidelityThresholds,
+                             const std::size_t aSeed);
+
+  /**
+   * @brief Check that the workload can be replayed in a simulation.
+   *
+   * @throw std::runtime_error if the number of nodes or classes differ from
+   * those in the header
+   */
+  void check(const std::size_t aNumNodes,
+             const std::size_t aNumNetRates,
+             const std::size_t aNumFidelityThresholds) const;
+
+  /**
+   * @return true if the event is between two different nodes of the network
+   * and its classes are among those of the workload.
+   */
+  bool valid(const WorkloadEvent& aEvent) const noexcept;
+};
+static_assert(sizeof(WorkloadHeader) == 32, "unexpected workload header size");
+
+/**
+ * @brief Record the sequence of flow arrivals of a simulation to a file.
+ *
+ * The binary file format, in native byte order, is a WorkloadHeader followed
+ * by the WorkloadEvent records, in order of arrival.
+ */
+class WorkloadWriter final
+{
+  NONCOPYABLE_NONMOVABLE(WorkloadWriter);
+
+ public:
+  /**
+   * @brief Create the file and write the header.
+   *
+   * @throw std::runtime_error if the file cannot be written
+   */
+  explicit WorkloadWriter(const std::string&    aFilename,
+                          const WorkloadHeader& aHeader);
+
+  //! Append an event to the file.
+  void operator()(const WorkloadEvent& aEvent);
+
+  //! \return the number of events written.
+  std::size_t size() const noexcept {
+    return theSize;
+  }
+
+ private:
+  const std::string theFilename;
+  std::ofstream     theStream;
+  std::size_t       theSize;
+};
+
+/**
+ * @brief Read-only view of a workload file written by WorkloadWriter, which
+ * is memory-mapped so that the events are paged in on demand.
+ *
+ * The events can be accessed directly, e.g., to interleave them with other
+ * events in a simulation, or passed in order to a function with replay(),
+ * which does not depend on how the flows are routed.
+ */
+class WorkloadReader final
+{
+  NONCOPYABLE_NONMOVABLE(WorkloadReader);
+
+ public:
+  /**
+   * @brief Map the file into memory.
+   *
+   * @throw std::runtime_error if the file cannot be read or it is not a valid
+   * workload file
+   */
+  explicit WorkloadReader(const std::string& aFilename);
+
+  ~WorkloadReader();
+
+  const WorkloadHeader& header() const noexcept {
+    return *static_cast<const WorkloadHeader*>(theData);
+  }
+
+  //! \return the number of events.
+  std::size_t size() const noexcept {
+    return theSize;
+  }
+
+  //! \return the event in the given position, not checked.
+  const WorkloadEvent& operator[](const std::size_t aIndex) const noexcept {
+    return begin()[aIndex];
+  }
+
+  const WorkloadEvent* begin() const noexcept {
+    return reinterpret_cast<const WorkloadEvent*>(
+        static_cast<const char*>(theData) + sizeof(WorkloadHeader));
+  }
+
+  const WorkloadEvent* end() const noexcept {
+    return begin() + theSize;
+  }
+
+  /**
+   * @brief Call a function on every event, in order of arrival.
+   *
+   * @param aCallback The function called, e.g., to route the flow.
+   *
+   * @return the number of events replayed.
+   *
+   * @throw std::runtime_error if an event is not valid according to the
+   * header, in which case the function is not called on the following ones
+   */
+  std::size_t
+  replay(const std::function<void(const WorkloadEvent&)>& aCallback) const;
+
+ private:
+  void*       theData;
+  std::size_t theLength;
+  std::size_t theSize;
+};
+
+} // namespace qr
+} // namespace uiiit
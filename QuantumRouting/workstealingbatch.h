@@ -0,0 +1,254 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+namespace detail {
+
+//! True if T has a member function cost() const returning a number.
+template <class T, class = void>
+struct HasCost : std::false_type {};
+
+template <class T>
+struct HasCost<T,
+               std::void_t<decltype(double(std::declval<const T&>().cost()))>>
+    : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @brief Execute a function on a batch of parameters using a pool of threads
+ * that steal work from one another.
+ *
+ * If PARAMETERS has a member function cost() const, then the parameters are
+ * executed in order of decreasing cost (longest-processing-time first),
+ * otherwise in the order given. The parameters are dealt round-robin to
+ * per-thread deques: each thread executes the items of its own deque from
+ * the front and, when this is empty, it steals the item at the back of the
+ * deque of another thread, i.e., the one its owner would execute last, so
+ * that no thread sits idle while there is work pending.
+ *
+ * The threads are started upon construction.
+ */
+template <class PARAMETERS>
+class WorkStealingBatch final
+{
+  NONCOPYABLE_NONMOVABLE(WorkStealingBatch);
+
+ public:
+  using Function = std::function<void(PARAMETERS&&)>;
+
+  //! Activity of a single thread, in seconds, on its own cache line.
+  struct alignas(64) ThreadStats {
+    double      theBusy     = 0; //!< time spent executing the function
+    double      theIdle     = 0; //!< time not executing until batch end
+    std::size_t theExecuted = 0; //!< number of items executed
+    std::size_t theStolen   = 0; //!< number of items stolen from others
+
+    std::string toString() const {
+      std::stringstream myStream;
+      myStream << "busy " << theBusy << " s, idle " << theIdle << " s, "
+               << theExecuted << " items executed (" << theStolen
+               << " stolen)";
+      return myStream.str();
+    }
+  };
+
+  /**
+   * @brief Start executing the given parameters.
+   *
+   * @param aNumThreads The number of threads.
+   * @param aParameters The parameters to be passed to the function, one
+   * execution per element.
+   * @param aFunction The function to be executed.
+   *
+   * @throw std::runtime_error if the number of threads is zero
+   * @throw std::system_error if a thread cannot be started, after joining
+   * the ones already started
+   */
+  explicit WorkStealingBatch(const std::size_t         aNumThreads,
+                             std::vector<PARAMETERS>&& aParameters,
+                             const Function&           aFunction)
+      : theFunction(aFunction)
+      , theDeques(aNumThreads)
+      , theStats(aNumThreads)
+      , theThreads()
+      , theMutex()
+      , theExceptions()
+      , theStart(Clock::now())
+      , theWaited(false) {
+    if (aNumThreads == 0) {
+      throw std::runtime_error("invalid number of threads: 0");
+    }
+
+    if constexpr (detail::HasCost<PARAMETERS>::value) {
+      std::stable_sort(aParameters.begin(),
+                       aParameters.end(),
+                       [](const PARAMETERS& aLhs, const PARAMETERS& aRhs) {
+                         return aLhs.cost() > aRhs.cost();
+                       });
+    }
+    for (std::size_t i = 0; i < aParameters.size(); i++) {
+      theDeques[i % aNumThreads].theItems.emplace_back(
+          std::move(aParameters[i]));
+    }
+
+    theThreads.reserve(aNumThreads);
+    try {
+      for (std::size_t i = 0; i < aNumThreads; i++) {
+        theThreads.emplace_back([this, i]() { work(i); });
+      }
+    } catch (...) {
+      // drop the pending items so that the threads started exit soon
+      for (auto& myDeque : theDeques) {
+        const std::lock_guard<std::mutex> myLock(myDeque.theMutex);
+        myDeque.theItems.clear();
+      }
+      for (auto& myThread : theThreads) {
+        myThread.join();
+      }
+      throw;
+    }
+  }
+
+  ~WorkStealingBatch() {
+    wait();
+  }
+
+  /**
+   * @brief Wait for all the executions to complete.
+   *
+   * @return the messages of the exceptions thrown by the function, if any.
+   */
+  std::vector<std::string> wait() {
+    if (not theWaited) {
+      for (auto& myThread : theThreads) {
+        myThread.join();
+      }
+      theWaited = true;
+      const auto myDuration = seconds(Clock::now() - theStart);
+      for (auto& myStats : theStats) {
+        myStats.theIdle = std::max(0.0, myDuration - myStats.theBusy);
+      }
+    }
+    return theExceptions;
+  }
+
+  //! \return the per-thread activity, only meaningful after wait().
+  const std::vector<ThreadStats>& stats() const noexcept {
+    return theStats;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Deque {
+    std::mutex             theMutex;
+    std::deque<PARAMETERS> theItems;
+  };
+
+  static double seconds(const Clock::duration& aDuration) {
+    return std::chrono::duration<double>(aDuration).count();
+  }
+
+  void work(const std::size_t aId) {
+    auto& myStats = theStats[aId];
+    while (true) {
+      std::optional<PARAMETERS> myItem;
+
+      // own deque first, then the other ones starting from the next thread
+      for (std::size_t i = 0; i < theDeques.size() and not myItem; i++) {
+        auto& myDeque = theDeques[(aId + i) % theDeques.size()];
+        const std::lock_guard<std::mutex> myLock(myDeque.theMutex);
+        if (myDeque.theItems.empty()) {
+          continue;
+        }
+        if (i == 0) {
+          myItem.emplace(std::move(myDeque.theItems.front()));
+          myDeque.theItems.pop_front();
+        } else {
+          myItem.emplace(std::move(myDeque.theItems.back()));
+          myDeque.theItems.pop_back();
+          myStats.theStolen++;
+        }
+      }
+      if (not myItem) {
+        // items are never added, hence there is no more work to do
+        return;
+      }
+
+      const auto myBegin = Clock::now();
+      try {
+        theFunction(std::move(*myItem));
+      } catch (const std::exception& aErr) {
+        const std::lock_guard<std::mutex> myLock(theMutex);
+        theExceptions.emplace_back(aErr.what());
+      } catch (...) {
+        const std::lock_guard<std::mutex> myLock(theMutex);
+        theExceptions.emplace_back("unknown exception");
+      }
+      myStats.theBusy += seconds(Clock::now() - myBegin);
+      myStats.theExecuted++;
+    }
+  }
+
+ private:
+  const Function           theFunction;
+  std::vector<Deque>       theDeques;
+  std::vector<ThreadStats> theStats;
+  std::vector<std::thread> theThreads;
+  std::mutex               theMutex;
+  std::vector<std::string> theExceptions;
+  const Clock::time_point  theStart;
+  bool                     theWaited;
+};
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+"""Convert flow requests from CSV to the binary format of --flow-file, see QuantumRouting/flowreader.h"""
+
+import argparse
+import struct
+import sys
+
+REQUEST = struct.Struct("=dIIdd")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("output", help="binary output file")
+    parser.add_argument(
+        "--input",
+        default="-",
+        help="CSV input file, with lines time,src,dst,net-rate,fidelity-threshold",
+    )
+    args = parser.parse_args()
+
+    fin = sys.stdin if args.input == "-" else open(args.input, "r")
+    with open(args.output, "wb") as fout:
+        fout.write(b"QRFLOWS1")
+        for num, line in enumerate(fin):
+            line = line.strip()
+            if not line or line.startswith("#") or (num == 0 and not line[0].isdigit()):
+                continue
+            time, src, dst, net_rate, fidelity = line.split(",")
+            fout.write(
+                REQUEST.pack(
+                    float(time), int(src), int(dst), float(net_rate), float(fidelity)
+                )
+            )
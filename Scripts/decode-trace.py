@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Decode a binary trace saved with --trace-file, see QuantumRouting/trace.h"""
+
+import argparse
+import struct
+import sys
+
+EVENTS = [
+    "flow-candidate",
+    "flow-edge-removed",
+    "flow-admitted",
+    "flow-rejected",
+    "app-path-found",
+    "app-path-expired",
+    "app-allocated",
+    "app-edge-removed",
+    "app-removed",
+    "lane-candidate",
+    "reachable-node",
+]
+
+RECORD = struct.Struct("=QIIIIdII")
+
+
+def records(f):
+    if f.read(8) != b"QRTRACE2":
+        raise RuntimeError("invalid trace: wrong magic")
+    (num_buffers,) = struct.unpack("=Q", f.read(8))
+    for buffer in range(num_buffers):
+        (num_records,) = struct.unpack("=Q", f.read(8))
+        data = f.read(num_records * RECORD.size)
+        if len(data) != num_records * RECORD.size:
+            raise RuntimeError("truncated trace")
+        for fields in RECORD.iter_unpack(data):
+            yield (buffer,) + fields
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("trace", help="binary trace file")
+    parser.add_argument(
+        "--sort", action="store_true", help="sort by time across all the threads"
+    )
+    args = parser.parse_args()
+
+    with open(args.trace, "rb") as f:
+        rows = list(records(f))
+    if args.sort:
+        rows.sort(key=lambda x: x[1])
+
+    print("thread,time,event,arg0,arg1,arg2,value,point,seed")
+    for thread, time, event, arg0, arg1, arg2, value, point, seed in rows:
+        name = EVENTS[event] if event < len(EVENTS) else "unknown"
+        sys.stdout.write(
+            f"{thread},{time},{name},{arg0},{arg1},{arg2},{value},{point},{seed}\n"
+        )
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+"""Decode a workload recorded with --record-workload, see QuantumRouting/workload.h"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("=8sIIIIQ")
+EVENT = struct.Struct("=dIIIId")
+
+
+def events(f):
+    header = f.read(HEADER.size)
+    if len(header) != HEADER.size:
+        raise RuntimeError("truncated workload")
+    magic, num_nodes, num_net_rates, num_fidelities, _, seed = HEADER.unpack(header)
+    if magic != b"QRWKLD01":
+        raise RuntimeError("invalid workload: wrong magic")
+    sys.stderr.write(
+        f"seed {seed}, {num_nodes} nodes, {num_net_rates} net rate classes, "
+        f"{num_fidelities} fidelity classes\n"
+    )
+    data = f.read()
+    if len(data) % EVENT.size != 0:
+        raise RuntimeError("truncated workload")
+    yield from EVENT.iter_unpack(data)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("workload", help="binary workload file")
+    args = parser.parse_args()
+
+    print("time,src,dst,net-rate-class,fidelity-class,duration")
+    with open(args.workload, "rb") as f:
+        for time, src, dst, net_rate, fidelity, duration in events(f):
+            sys.stdout.write(f"{time},{src},{dst},{net_rate},{fidelity},{duration}\n")
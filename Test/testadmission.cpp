@@ -0,0 +1,322 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/admission.h"
+#include "QuantumRouting/admissionserver.h"
+#include "QuantumRouting/latencyhistogram.h"
+#include "QuantumRouting/topologycache.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glog/logging.h>
+
+#include <cinttypes>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace uiiit {
+namespace qr {
+
+struct TestAdmission : public ::testing::Test {
+  TestAdmission()
+      : theCacheFilename(
+            (boost::filesystem::current_path() / "topology.bin").string())
+      , theSocketPath(
+            (boost::filesystem::current_path() / "admission.sock").string()) {
+    // noop
+  }
+
+  void TearDown() {
+    boost::filesystem::remove(theCacheFilename);
+    boost::filesystem::remove(theSocketPath);
+  }
+
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3   all weights are 4, except 0->4 which is 1
+  //  \              ^
+  //   \---> 4 ------+
+  static CapacityNetwork::WeightVector exampleEdgeWeights() {
+    return CapacityNetwork::WeightVector({
+        {0, 1, 4},
+        {1, 2, 4},
+        {2, 3, 4},
+        {0, 4, 1},
+        {4, 3, 4},
+    });
+  }
+
+  static std::unique_ptr<CapacityNetwork> exampleNetwork() {
+    return std::make_unique<CapacityNetwork>(exampleEdgeWeights());
+  }
+
+  const std::string theCacheFilename;
+  const std::string theSocketPath;
+};
+
+TEST_F(TestAdmission, test_topology_cache) {
+  // node 5 is isolated
+  const CapacityNetwork myNetwork(exampleEdgeWeights(), 6);
+  ASSERT_EQ(6, myNetwork.numNodes());
+  saveTopologyCache(theCacheFilename, myNetwork);
+  std::size_t myNumNodes = 0;
+  ASSERT_EQ(exampleEdgeWeights(),
+            loadTopologyCache(theCacheFilename, myNumNodes));
+  ASSERT_EQ(6, myNumNodes);
+
+  saveTopologyCache(theCacheFilename,
+                    CapacityNetwork(CapacityNetwork::WeightVector()));
+  ASSERT_TRUE(loadTopologyCache(theCacheFilename, myNumNodes).empty());
+  ASSERT_EQ(0, myNumNodes);
+
+  ASSERT_THROW(loadTopologyCache(theCacheFilename + ".missing", myNumNodes),
+               std::runtime_error);
+  {
+    std::ofstream myStream(theCacheFilename);
+    myStream << "not a topology cache";
+  }
+  ASSERT_THROW(loadTopologyCache(theCacheFilename, myNumNodes),
+               std::runtime_error);
+
+  // the number of edges does not match the length of the file
+  const auto myWrite = [this](const std::uint64_t aNumNodes,
+                              const std::uint64_t aNumEdges,
+                              const std::size_t   aNumRecords) {
+    std::ofstream myStream(theCacheFilename, std::ios::binary);
+    myStream.write("QRTOPO02", 8);
+    myStream.write(reinterpret_cast<const char*>(&aNumNodes),
+                   sizeof(aNumNodes));
+    myStream.write(reinterpret_cast<const char*>(&aNumEdges),
+                   sizeof(aNumEdges));
+    for (std::size_t i = 0; i < aNumRecords; i++) {
+      const std::uint32_t myNodes[2] = {0, 1};
+      const double        myCapacity = 1;
+      myStream.write(reinterpret_cast<const char*>(myNodes), sizeof(myNodes));
+      myStream.write(reinterpret_cast<const char*>(&myCapacity),
+                     sizeof(myCapacity));
+    }
+  };
+  myWrite(2, 1, 1);
+  ASSERT_EQ(1, loadTopologyCache(theCacheFilename, myNumNodes).size());
+  myWrite(2, std::numeric_limits<std::uint64_t>::max(), 1);
+  ASSERT_THROW(loadTopologyCache(theCacheFilename, myNumNodes),
+               std::runtime_error);
+  myWrite(2, 2, 1);
+  ASSERT_THROW(loadTopologyCache(theCacheFilename, myNumNodes),
+               std::runtime_error);
+
+  // an edge refers to a node beyond the number of nodes
+  myWrite(1, 1, 1);
+  ASSERT_THROW(loadTopologyCache(theCacheFilename, myNumNodes),
+               std::runtime_error);
+}
+
+TEST_F(TestAdmission, test_controller) {
+  ASSERT_THROW(AdmissionController(nullptr), std::runtime_error);
+
+  // the latencies of the network are used, if any
+  auto       myNetwork   = exampleNetwork();
+  const auto myLatencies = std::make_shared<DecisionLatencies>(
+      std::vector<std::string>({"low", "high"}));
+  myNetwork->latencies(myLatencies, [](const auto& aFlow) {
+    return aFlow.theNetRate < 2 ? std::size_t(0) : std::size_t(1);
+  });
+  ASSERT_EQ(myLatencies,
+            AdmissionController(std::move(myNetwork)).network().latencies());
+
+  AdmissionController myController(exampleNetwork());
+  const auto myTotalCapacity = myController.network().totalCapacity();
+  ASSERT_NE(nullptr, myController.network().latencies());
+  ASSERT_EQ(0, myController.latency(0.99));
+
+  // invalid requests
+  for (const auto& myRequest : {AdmissionRequest::admit(1, 0, 0, 1),
+                                AdmissionRequest::admit(1, 0, 5, 1),
+                                AdmissionRequest::admit(1, 0, 3, 0)}) {
+    const auto myResponse = myController(myRequest);
+    ASSERT_EQ(AdmissionStatus::Invalid, myResponse.theStatus);
+    ASSERT_EQ(1, myResponse.theTag);
+  }
+
+  // the first flow uses the shortest path, the second one the longest
+  const auto myFirst = myController(AdmissionRequest::admit(10, 0, 3, 1));
+  LOG(INFO) << myFirst.toString();
+  ASSERT_EQ(AdmissionStatus::Ok, myFirst.theStatus);
+  ASSERT_EQ(AdmissionType::Admit, myFirst.theType);
+  ASSERT_EQ(10, myFirst.theTag);
+  ASSERT_EQ(2, myFirst.theHops);
+  ASSERT_EQ(1, myFirst.theNetRate);
+
+  const auto mySecond = myController(AdmissionRequest::admit(11, 0, 3, 1));
+  ASSERT_EQ(AdmissionStatus::Ok, mySecond.theStatus);
+  ASSERT_EQ(3, mySecond.theHops);
+  ASSERT_NE(myFirst.theFlow, mySecond.theFlow);
+
+  const auto myThird = myController(AdmissionRequest::admit(12, 0, 3, 4));
+  ASSERT_EQ(AdmissionStatus::Rejected, myThird.theStatus);
+  ASSERT_EQ(2, myController.numFlows());
+  ASSERT_EQ(3, myController.numDecisions());
+
+  // query
+  const auto myQuery =
+      myController(AdmissionRequest::query(13, mySecond.theFlow));
+  ASSERT_EQ(AdmissionStatus::Ok, myQuery.theStatus);
+  ASSERT_EQ(3, myQuery.theHops);
+  ASSERT_EQ(1, myQuery.theGrossRate);
+  ASSERT_EQ(AdmissionStatus::UnknownFlow,
+            myController(AdmissionRequest::query(14, 99)).theStatus);
+
+  // release
+  ASSERT_EQ(AdmissionStatus::Ok,
+            myController(AdmissionRequest::release(15, myFirst.theFlow))
+                .theStatus);
+  ASSERT_EQ(AdmissionStatus::UnknownFlow,
+            myController(AdmissionRequest::release(16, myFirst.theFlow))
+                .theStatus);
+  ASSERT_EQ(AdmissionStatus::Ok,
+            myController(AdmissionRequest::release(17, mySecond.theFlow))
+                .theStatus);
+  ASSERT_EQ(0, myController.numFlows());
+  ASSERT_FLOAT_EQ(myTotalCapacity, myController.network().totalCapacity());
+
+  // the released capacity can be used again
+  ASSERT_EQ(AdmissionStatus::Ok,
+            myController(AdmissionRequest::admit(18, 0, 3, 4)).theStatus);
+
+  // stats
+  const auto myStats = myController(AdmissionRequest::stats(19));
+  LOG(INFO) << myStats.toString();
+  ASSERT_EQ(AdmissionStatus::Ok, myStats.theStatus);
+  ASSERT_EQ(1, myStats.theNumFlows);
+  ASSERT_EQ(6, myStats.theNumDecisions);
+  ASSERT_EQ(0, myStats.theHops);
+  ASSERT_EQ(0, myStats.theFlow);
+  ASSERT_GT(myStats.theLatencyP50, 0);
+  ASSERT_LE(myStats.theLatencyP50, myStats.theLatencyP99);
+  ASSERT_THROW(myController.latency(1.1), std::runtime_error);
+
+  // all the decisions are recorded in the histograms
+  const auto& myHistograms = *myController.network().latencies();
+  ASSERT_EQ(4,
+            myHistograms(DecisionLatencies::Decision::Admission, 0).count());
+  ASSERT_EQ(2, myHistograms(DecisionLatencies::Decision::Release, 0).count());
+}
+
+TEST_F(TestAdmission, test_topology_deltas) {
+  using Delta = CapacityNetwork::TopologyDelta;
+  AdmissionController myController(exampleNetwork());
+
+  const auto myFirst  = myController(AdmissionRequest::admit(1, 0, 3, 1));
+  const auto mySecond = myController(AdmissionRequest::admit(2, 0, 3, 1));
+  const auto myThird  = myController(AdmissionRequest::admit(3, 1, 3, 1));
+  ASSERT_EQ(2, myFirst.theHops);
+  ASSERT_EQ(3, mySecond.theHops);
+  ASSERT_EQ(2, myThird.theHops);
+
+  // invalid changes
+  ASSERT_THROW(myController.applyTopologyDeltas({Delta::removeEdge(3, 2)}),
+               std::runtime_error);
+  ASSERT_EQ(3, myController.numFlows());
+
+  // 2->3 is crossed by the second and third flows: only the latter is
+  // released to fit the new capacity
+  ASSERT_EQ(std::vector<std::uint64_t>({myThird.theFlow}),
+            myController.applyTopologyDeltas({Delta::setCapacity(2, 3, 1.5)}));
+  ASSERT_EQ(2, myController.numFlows());
+  ASSERT_EQ(AdmissionStatus::UnknownFlow,
+            myController(AdmissionRequest::query(4, myThird.theFlow))
+                .theStatus);
+
+  // all the flows crossing a removed edge are released
+  ASSERT_EQ(std::vector<std::uint64_t>({myFirst.theFlow}),
+            myController.applyTopologyDeltas(
+                {Delta::removeEdge(0, 4), Delta::addEdge(1, 3, 1)}));
+  ASSERT_EQ(1, myController.numFlows());
+
+  // no flows released if they all fit
+  ASSERT_TRUE(
+      myController.applyTopologyDeltas({Delta::setCapacity(0, 1, 1)}).empty());
+
+  // the capacity of all the flows is eventually restored
+  ASSERT_EQ(AdmissionStatus::Ok,
+            myController(AdmissionRequest::release(5, mySecond.theFlow))
+                .theStatus);
+  ASSERT_EQ(0, myController.numFlows());
+  ASSERT_FLOAT_EQ(1 + 4 + 1.5 + 4 + 1, myController.network().totalCapacity());
+}
+
+TEST_F(TestAdmission, test_server) {
+  AdmissionController myController(exampleNetwork());
+  AdmissionServer     myServer(theSocketPath, myController);
+  std::thread         myThread([&myServer]() { myServer.run(); });
+
+  {
+    // pipeline all the requests, then read all the responses
+    AdmissionClient   myClient(theSocketPath);
+    const std::size_t N = 1000;
+    for (std::size_t i = 0; i < N; i++) {
+      myClient.send(AdmissionRequest::admit(i, 0, 3, 0.001));
+    }
+    myClient.flush();
+    for (std::size_t i = 0; i < N; i++) {
+      const auto myResponse = myClient.receive();
+      ASSERT_EQ(i, myResponse.theTag);
+      ASSERT_EQ(AdmissionStatus::Ok, myResponse.theStatus);
+      ASSERT_EQ(i, myResponse.theFlow);
+    }
+
+    // another client sees the same state
+    AdmissionClient myAnotherClient(theSocketPath);
+    ASSERT_EQ(AdmissionStatus::Ok,
+              myAnotherClient(AdmissionRequest::release(0, 0)).theStatus);
+    const auto myStats = myAnotherClient(AdmissionRequest::stats(1));
+    ASSERT_EQ(N - 1, myStats.theNumFlows);
+    ASSERT_EQ(N + 1, myStats.theNumDecisions);
+
+    // invalid type
+    auto myRequest    = AdmissionRequest::stats(2);
+    myRequest.theType = static_cast<AdmissionType>(42);
+    ASSERT_EQ(AdmissionStatus::Invalid, myClient(myRequest).theStatus);
+  }
+
+  myServer.stop();
+  myThread.join();
+  ASSERT_EQ(1003, myServer.numRequests());
+  ASSERT_THROW(AdmissionClient(theSocketPath + ".missing"), std::runtime_error);
+}
+
+} // namespace qr
+} // namespace uiiit
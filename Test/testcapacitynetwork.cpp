@@ -30,6 +30,7 @@ SOFTWARE.
 */
 
 #include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/latencyhistogram.h"
 #include "Support/random.h"
 #include "Support/tostring.h"
 
@@ -37,9 +38,15 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <cmath>
 #include <ctime>
+#include <future>
+#include <limits>
+#include <map>
 #include <set>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 
 namespace uiiit {
 namespace qr {
@@ -129,6 +136,14 @@ TEST_F(TestCapacityNetwork, test_measurement_probability) {
   ASSERT_FLOAT_EQ(0.314, myNetwork.measurementProbability());
   ASSERT_THROW(myNetwork.measurementProbability(-0.5), std::runtime_error);
   ASSERT_THROW(myNetwork.measurementProbability(2), std::runtime_error);
+
+  // the powers are precomputed for all the possible path lengths
+  ASSERT_EQ(myNetwork.numNodes(), myNetwork.swapSuccess().size());
+  ASSERT_EQ(0.314, myNetwork.swapSuccess().base());
+  for (std::size_t n = 0; n <= myNetwork.numNodes(); n++) {
+    ASSERT_EQ(std::pow(0.314, n), myNetwork.swapSuccess()(n)) << "n = " << n;
+  }
+  ASSERT_EQ(0.314, myNetwork.clone()->swapSuccess().base());
 }
 
 TEST_F(TestCapacityNetwork, test_graph_properties) {
@@ -326,6 +341,379 @@ TEST_F(TestCapacityNetwork, test_route_flows_another) {
   ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
 }
 
+TEST_F(TestCapacityNetwork, test_check_policies) {
+  constexpr CapacityNetwork::MaxHopsPolicy myConstexprPolicy(2);
+  static_assert(myConstexprPolicy.maxHops() == 2);
+
+  // route the same flow with a policy and with the equivalent function
+  const auto myRoute = [this](const auto& aPolicy) {
+    CapacityNetwork myNetwork(exampleEdgeWeights());
+    myNetwork.measurementProbability(0.5);
+    std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 1.0}});
+    myNetwork.route(myFlows, aPolicy);
+    return std::make_tuple(myFlows[0].thePath,
+                           myFlows[0].theDijsktra,
+                           myNetwork.weights(),
+                           myNetwork.counters().theEdgeLookups);
+  };
+  for (std::size_t myMaxHops = 1; myMaxHops <= 4; myMaxHops++) {
+    const CapacityNetwork::FlowCheckFunction myFunction =
+        [myMaxHops](const auto& aFlow) {
+          return aFlow.thePath.size() <= myMaxHops;
+        };
+    const auto myExpected = myRoute(myFunction);
+    const auto myActual   = myRoute(CapacityNetwork::MaxHopsPolicy(myMaxHops));
+    ASSERT_EQ(std::get<0>(myExpected), std::get<0>(myActual));
+    ASSERT_EQ(std::get<2>(myExpected), std::get<2>(myActual));
+    ASSERT_EQ(std::get<3>(myExpected), std::get<3>(myActual));
+
+    // the path 0 -> 4 -> 3 is found but has not enough capacity, then the
+    // next one 0 -> 1 -> 2 -> 3 is too long, unless the bound is 3 or more:
+    // the policy does not build the candidates beyond the bound, but the
+    // number of Dijkstra calls is the same
+    ASSERT_EQ(std::get<1>(myExpected), std::get<1>(myActual));
+    ASSERT_EQ(myMaxHops < 3, std::get<0>(myActual).empty());
+  }
+
+  // fidelity threshold, with F = 0.9925: 0.9925 with 1 edge, then 0.985075
+  // with 2 edges, 0.97772 with 3 edges, and 0.97045 with 4 edges
+  ASSERT_THROW(CapacityNetwork::FidelityThresholdPolicy(1, 1, 1, 0.2, 0.5, 5),
+               std::runtime_error);
+  const CapacityNetwork::FidelityThresholdPolicy myHigh(
+      1, 1, 1, 0.9925, 0.98, 5);
+  const CapacityNetwork::FidelityThresholdPolicy myLow(
+      1, 1, 1, 0.9925, 0.975, 5);
+  const CapacityNetwork::FidelityThresholdPolicy myNone(
+      1, 1, 1, 0.9925, 0.5, 5);
+  ASSERT_EQ(2, myHigh.maxHops());
+  ASSERT_EQ(3, myLow.maxHops());
+  ASSERT_EQ(std::numeric_limits<std::size_t>::max(), myNone.maxHops());
+  ASSERT_TRUE(std::get<0>(myRoute(myHigh)).empty());
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}),
+            std::get<0>(myRoute(myLow)));
+  for (std::size_t n = 1; n < 10; n++) {
+    ASSERT_EQ(fidelitySwapping(1, 1, 1, n, 0.9925) >= 0.975,
+              myLow(CapacityNetwork::AppDescriptor::Path(n)))
+        << "n = " << n;
+  }
+
+  // the same for applications: with at most two hops only peer 3 is
+  // reachable from host 0
+  const auto myRouteApps = [this](const auto& aPolicy) {
+    CapacityNetwork myNetwork(anotherExampleEdgeWeights());
+    myNetwork.measurementProbability(0.5);
+    std::vector<CapacityNetwork::AppDescriptor> myApps({{0, {3, 6}, 1}});
+    myNetwork.route(myApps, 1, 4, aPolicy);
+    return std::make_pair(myApps[0].toString(), myNetwork.weights());
+  };
+  const CapacityNetwork::AppCheckFunction myFunction = [](const auto& aPath) {
+    return aPath.size() <= 2;
+  };
+  const auto myExpected = myRouteApps(myFunction);
+  ASSERT_EQ(myExpected, myRouteApps(CapacityNetwork::MaxHopsPolicy(2)));
+  ASSERT_EQ(myExpected, myRouteApps(myHigh));
+  ASSERT_NE(myExpected, myRouteApps(CapacityNetwork::MaxHopsPolicy(4)));
+}
+
+TEST_F(TestCapacityNetwork, test_link_qualities) {
+  using LinkQuality = CapacityNetwork::LinkQuality;
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+
+  // default qualities
+  ASSERT_EQ(LinkQuality({1, 0.5}), myNetwork.linkQuality(0, 1));
+  ASSERT_THROW(myNetwork.linkQuality(0, 3), std::runtime_error);
+
+  // invalid changes are not applied
+  ASSERT_THROW(myNetwork.linkQualities({{0, 1, {0.9, 1}}, {0, 3, {0.9, 1}}}),
+               std::runtime_error);
+  ASSERT_THROW(myNetwork.linkQualities({{0, 1, {0.25, 1}}}),
+               std::runtime_error);
+  ASSERT_THROW(myNetwork.linkQualities({{0, 1, {0.9, 1.5}}}),
+               std::runtime_error);
+  ASSERT_EQ(LinkQuality({1, 0.5}), myNetwork.linkQuality(0, 1));
+
+  myNetwork.linkQualities(
+      {{0, 1, {0.9, 1}}, {1, 2, {0.99, 1}}, {2, 3, {0.99, 1}}});
+  ASSERT_EQ(LinkQuality({0.9, 1}), myNetwork.linkQuality(0, 1));
+  ASSERT_EQ(LinkQuality({0.99, 1}), myNetwork.clone()->linkQuality(1, 2));
+  myNetwork.measurementProbability(0.8);
+  ASSERT_EQ(LinkQuality({1, 0.8}), myNetwork.linkQuality(4, 3));
+  ASSERT_EQ(LinkQuality({0.99, 1}), myNetwork.linkQuality(2, 3));
+
+  // swaps happen at the intermediate nodes only
+  ASSERT_FLOAT_EQ(0.8, myNetwork.pathSwapSuccess(0, {4, 3}));
+  ASSERT_FLOAT_EQ(1, myNetwork.pathSwapSuccess(0, {1, 2, 3}));
+  ASSERT_FLOAT_EQ(1, myNetwork.pathSwapSuccess(4, {3}));
+  ASSERT_THROW(myNetwork.pathSwapSuccess(0, {3}), std::runtime_error);
+
+  // fidelity with heterogeneous links
+  ASSERT_FLOAT_EQ(0.9, myNetwork.pathFidelity(0, {1}));
+  ASSERT_FLOAT_EQ(0.25 + 0.75 * (2.6 / 3) * (2.96 / 3) * (2.96 / 3),
+                  myNetwork.pathFidelity(0, {1, 2, 3}));
+  ASSERT_THROW(myNetwork.pathFidelity(0, {}), std::runtime_error);
+
+  // with links all of the same quality the fidelity is fidelitySwapping()
+  ASSERT_THROW(myNetwork.swapReliability(0.9, 0.5, 0.4), std::runtime_error);
+  myNetwork.swapReliability(0.9, 0.5, 0.95);
+  myNetwork.linkQualities(
+      {{0, 1, {0.95, 1}}, {1, 2, {0.95, 1}}, {2, 3, {0.95, 1}}});
+  const CapacityNetwork::FidelityThresholdPolicy myPolicy(
+      0.9, 0.5, 0.95, 0.95, 0.5, 5);
+  for (std::size_t n = 1; n <= 3; n++) {
+    const std::vector<unsigned long> myPath({1, 2, 3});
+    const auto                       myFidelity = myNetwork.pathFidelity(
+        0, std::vector<unsigned long>(myPath.begin(), myPath.begin() + n));
+    ASSERT_FLOAT_EQ(fidelitySwapping(0.9, 0.5, 0.95, n, 0.95), myFidelity)
+        << "n = " << n;
+    ASSERT_FLOAT_EQ(myPolicy.fidelity(n), myFidelity) << "n = " << n;
+  }
+  ASSERT_FLOAT_EQ(0.95, myPolicy.fidelity(1));
+
+  // the quality of a link is kept when its capacity is exhausted
+  const auto myFidelity = myNetwork.pathFidelity(0, {1, 2, 3});
+  std::vector<CapacityNetwork::AppDescriptor> myApps({{0, {1}, 1}});
+  myNetwork.route(myApps, 0.1, 99);
+  ASSERT_EQ(4, myNetwork.numEdges());
+  ASSERT_FLOAT_EQ(myFidelity, myNetwork.pathFidelity(0, {1, 2, 3}));
+
+  // the quality of a link is forgotten when the link is removed
+  myNetwork.applyTopologyDeltas(
+      {CapacityNetwork::TopologyDelta::removeEdge(0, 1)});
+  ASSERT_THROW(myNetwork.linkQuality(0, 1), std::runtime_error);
+  myNetwork.applyTopologyDeltas(
+      {CapacityNetwork::TopologyDelta::addEdge(0, 1, 4)});
+  ASSERT_EQ(LinkQuality({1, 0.8}), myNetwork.linkQuality(0, 1));
+}
+
+TEST_F(TestCapacityNetwork, test_route_weighted) {
+  using PathMetric = CapacityNetwork::PathMetric;
+  const auto myMakeNetwork = [this]() {
+    auto ret = std::make_unique<CapacityNetwork>(exampleEdgeWeights());
+    ret->measurementProbability(0.5);
+    ret->linkQualities(
+        {{0, 1, {0.9, 1}}, {1, 2, {0.99, 1}}, {2, 3, {0.99, 1}}});
+    return ret;
+  };
+
+  // 0 -> 4 -> 3 has the highest fidelity, but a swap success of 0.5,
+  // while 0 -> 1 -> 2 -> 3 has lower fidelity, but swaps that never fail
+  auto myNetwork = myMakeNetwork();
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 1.0}});
+  myNetwork->route(myFlows, PathMetric::GrossRate);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[0].theGrossRate);
+  ASSERT_EQ(1, myFlows[0].theDijsktra);
+
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myNetwork->route(myFlows, PathMetric::Fidelity);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[0].theGrossRate);
+  ASSERT_EQ(1, myFlows[0].theDijsktra);
+  ASSERT_EQ(CapacityNetwork::WeightVector({
+                {0, 1, 3},
+                {1, 2, 3},
+                {2, 3, 3},
+                {0, 4, 0},
+                {4, 3, 3},
+            }),
+            myNetwork->weights());
+
+  // the edge 0 -> 4 has not enough capacity anymore
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 1.0);
+  myNetwork->route(myFlows, PathMetric::Fidelity);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+  ASSERT_EQ(1, myFlows[0].theDijsktra);
+
+  // the best path does not meet the fidelity threshold
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myNetwork->route(
+      myFlows, PathMetric::Fidelity, [&myNetwork](const auto& aFlow) {
+        return myNetwork->pathFidelity(aFlow.theSrc, aFlow.thePath) >= 0.99;
+      });
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+
+  // the gross rate is not feasible on the best path, the search is repeated
+  // without its smallest capacity edge
+  myNetwork = myMakeNetwork();
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.6);
+  myNetwork->route(myFlows, PathMetric::Fidelity);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(0.6, myFlows[0].theGrossRate);
+  ASSERT_EQ(2, myFlows[0].theDijsktra);
+
+  // without link qualities the gross rate metric finds the shortest paths
+  CapacityNetwork myPlain(exampleEdgeWeights());
+  myPlain.measurementProbability(0.5);
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myPlain.route(myFlows, PathMetric::GrossRate);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[0].theGrossRate);
+
+  // ill-formed flows
+  myFlows.clear();
+  myFlows.emplace_back(0, 0, 1.0);
+  ASSERT_THROW(myPlain.route(myFlows, PathMetric::GrossRate),
+               std::runtime_error);
+}
+
+TEST_F(TestCapacityNetwork, test_route_constrained) {
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  myNetwork.linkQualities({{0, 1, {0.9, 1}},
+                           {1, 2, {0.99, 1}},
+                           {2, 3, {0.99, 1}},
+                           {4, 3, {0.8, 0.5}}});
+  ASSERT_FLOAT_EQ(0.8, myNetwork.pathFidelity(0, {4, 3}));
+  ASSERT_LT(0.85, myNetwork.pathFidelity(0, {1, 2, 3}));
+
+  // the shortest path is found first and then rejected because of its low
+  // fidelity, even though a longer path meets the threshold
+  const auto myCheck = [&myNetwork](const auto& aFlow) {
+    return myNetwork.pathFidelity(aFlow.theSrc, aFlow.thePath) >= 0.85;
+  };
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 0.5}});
+  auto myRetry = myNetwork.clone();
+  myRetry->route(myFlows, myCheck);
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+
+  // the constrained search discards the shortest path during the search
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myNetwork.routeConstrained(myFlows, 0.85);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(0.5, myFlows[0].theGrossRate);
+  ASSERT_EQ(4, myFlows[0].theDijsktra);
+  ASSERT_EQ(CapacityNetwork::WeightVector({
+                {0, 1, 3.5},
+                {1, 2, 3.5},
+                {2, 3, 3.5},
+                {0, 4, 1},
+                {4, 3, 4},
+            }),
+            myNetwork.weights());
+
+  // without a fidelity threshold the shortest path is found, unless the
+  // capacity is not enough for its gross rate
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.5);
+  myFlows.emplace_back(0, 3, 0.5);
+  myFlows.emplace_back(0, 3, 1.0);
+  myNetwork.routeConstrained(myFlows, 0);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[0].theGrossRate);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[1].thePath);
+  ASSERT_FLOAT_EQ(0.5, myFlows[1].theGrossRate);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[2].thePath);
+  ASSERT_FLOAT_EQ(1, myFlows[2].theGrossRate);
+
+  // no path meets the fidelity threshold
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.1);
+  myNetwork.routeConstrained(myFlows, 0.9);
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+  ASSERT_EQ(4, myFlows[0].theDijsktra);
+
+  // the flow is rejected if the search exceeds the maximum number of labels,
+  // even though a path exists, and the network is not changed
+  const auto myWeights = myNetwork.weights();
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.1);
+  myNetwork.routeConstrained(myFlows, 0, 3);
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+  ASSERT_EQ(myWeights, myNetwork.weights());
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.1);
+  myNetwork.routeConstrained(myFlows, 0, 4);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+
+  // ill-formed requests
+  myFlows.clear();
+  myFlows.emplace_back(0, 0, 1.0);
+  ASSERT_THROW(myNetwork.routeConstrained(myFlows, 0.5), std::runtime_error);
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 1.0);
+  ASSERT_THROW(myNetwork.routeConstrained(myFlows, -0.1), std::runtime_error);
+  ASSERT_THROW(myNetwork.routeConstrained(myFlows, 1.1), std::runtime_error);
+  ASSERT_THROW(myNetwork.routeConstrained(myFlows, 0.5, 0), std::runtime_error);
+  ASSERT_TRUE(myFlows[0].thePath.empty());
+}
+
+TEST_F(TestCapacityNetwork, test_compact_network) {
+  static_assert(sizeof(CompactCapacityNetwork::Index) == 4);
+  static_assert(sizeof(CompactCapacityNetwork::Capacity) == 4);
+  static_assert(sizeof(CompactCapacityNetwork::FlowDescriptor) <
+                sizeof(CapacityNetwork::FlowDescriptor));
+
+  CompactCapacityNetwork::WeightVector myWeights;
+  for (const auto& elem : exampleEdgeWeights()) {
+    myWeights.emplace_back(
+        std::get<0>(elem), std::get<1>(elem), std::get<2>(elem));
+  }
+  CapacityNetwork        myNetwork(exampleEdgeWeights());
+  CompactCapacityNetwork myCompact(myWeights);
+  myNetwork.measurementProbability(0.5);
+  myCompact.measurementProbability(0.5);
+  ASSERT_EQ(myNetwork.numNodes(), myCompact.numNodes());
+  ASSERT_EQ(myNetwork.numEdges(), myCompact.numEdges());
+  ASSERT_FLOAT_EQ(myNetwork.totalCapacity(), myCompact.totalCapacity());
+
+  std::size_t myDiameter        = 0;
+  std::size_t myCompactDiameter = 0;
+  const auto  myReachable = myNetwork.reachableNodes(0, 99, myDiameter);
+  const auto  myCompactReachable =
+      myCompact.reachableNodes(0, 99, myCompactDiameter);
+  ASSERT_EQ(myDiameter, myCompactDiameter);
+  ASSERT_EQ(myReachable.size(), myCompactReachable.size());
+  for (const auto& elem : myCompactReachable) {
+    ASSERT_EQ(myReachable.at(elem.first).size(), elem.second.size());
+  }
+
+  // the same flows are routed along the same paths with the same rates
+  std::vector<CapacityNetwork::FlowDescriptor>        myFlows;
+  std::vector<CompactCapacityNetwork::FlowDescriptor> myCompactFlows;
+  for (const auto& elem : std::vector<std::pair<unsigned long, double>>(
+           {{3, 0.5}, {3, 0.5}, {2, 1.0}, {3, 0.25}, {4, 0.25}})) {
+    myFlows.emplace_back(0, elem.first, elem.second);
+    myCompactFlows.emplace_back(0, elem.first, elem.second);
+  }
+  myNetwork.route(myFlows);
+  myCompact.route(myCompactFlows);
+  ASSERT_EQ(myFlows.size(), myCompactFlows.size());
+  for (std::size_t i = 0; i < myFlows.size(); i++) {
+    ASSERT_EQ(myFlows[i].thePath,
+              std::vector<unsigned long>(myCompactFlows[i].thePath.begin(),
+                                         myCompactFlows[i].thePath.end()))
+        << i;
+    ASSERT_FLOAT_EQ(myFlows[i].theGrossRate, myCompactFlows[i].theGrossRate)
+        << i;
+  }
+
+  // the residual capacities are the same, within the float precision
+  const auto myResidual        = myNetwork.weights();
+  const auto myCompactResidual = myCompact.weights();
+  ASSERT_EQ(myResidual.size(), myCompactResidual.size());
+  for (std::size_t i = 0; i < myResidual.size(); i++) {
+    ASSERT_EQ(std::get<0>(myResidual[i]), std::get<0>(myCompactResidual[i]));
+    ASSERT_EQ(std::get<1>(myResidual[i]), std::get<1>(myCompactResidual[i]));
+    ASSERT_FLOAT_EQ(std::get<2>(myResidual[i]),
+                    std::get<2>(myCompactResidual[i]));
+  }
+
+  // the constrained search is available on the compact network, too
+  myCompactFlows.clear();
+  myCompactFlows.emplace_back(4, 3, 0.5);
+  myCompact.routeConstrained(myCompactFlows, 0);
+  ASSERT_EQ(std::vector<CompactCapacityNetwork::Index>({3}),
+            myCompactFlows[0].thePath);
+  ASSERT_FLOAT_EQ(0.5, myCompactFlows[0].theGrossRate);
+}
+
 TEST_F(TestCapacityNetwork, test_route_apps) {
   CapacityNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -410,6 +798,11 @@ TEST_F(TestCapacityNetwork, test_route_apps) {
   ASSERT_EQ(4, std::get<0>(myWeights[2]));
   ASSERT_EQ(3, std::get<1>(myWeights[2]));
   ASSERT_FLOAT_EQ(3, std::get<2>(myWeights[2]));
+  const std::vector<double> myNodeCapacities({1.9, 0, 2.1, 0, 3});
+  for (std::size_t i = 0; i < myNodeCapacities.size(); i++) {
+    ASSERT_FLOAT_EQ(myNodeCapacities[i], myNetwork.nodeCapacities()[i])
+        << "node " << i;
+  }
 
   // consume the remaining capacity
   myApps = std::vector<CapacityNetwork::AppDescriptor>({
@@ -431,6 +824,227 @@ TEST_F(TestCapacityNetwork, test_route_apps) {
   ASSERT_FLOAT_EQ(0, myNetwork.totalCapacity());
 }
 
+TEST_F(TestCapacityNetwork, test_submit) {
+  CapacityNetwork myExpected(exampleEdgeWeights());
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.drain();
+
+  // the requests are pipelined and served in order of submission
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({
+      {0, 3, 1},
+      {0, 3, 1},
+      {0, 0, 1},
+      {1, 3, 2},
+      {0, 3, 1},
+  });
+  std::vector<std::future<CapacityNetwork::FlowDescriptor>> myFutures;
+  for (const auto& myFlow : myFlows) {
+    myFutures.emplace_back(myNetwork.submit(myFlow));
+  }
+  for (std::size_t i = 0; i < myFlows.size(); i++) {
+    std::vector<CapacityNetwork::FlowDescriptor> mySingle({myFlows[i]});
+    if (myFlows[i].theSrc == myFlows[i].theDst) {
+      ASSERT_THROW(myExpected.route(mySingle), std::runtime_error);
+      ASSERT_THROW(myFutures[i].get(), std::runtime_error);
+      continue;
+    }
+    myExpected.route(mySingle);
+    const auto myFlow = myFutures[i].get();
+    ASSERT_EQ(mySingle[0].thePath, myFlow.thePath) << myFlow.toString();
+    ASSERT_EQ(mySingle[0].theGrossRate, myFlow.theGrossRate);
+  }
+
+  // applications are returned through the future
+  std::vector<CapacityNetwork::AppDescriptor> myApps({
+      {0, {2, 3}, 1},
+      {1, {3}, 1},
+  });
+  auto myAppsFuture = myNetwork.submit(
+      std::vector<CapacityNetwork::AppDescriptor>(myApps), 0.5, 99);
+  auto myBadFuture = myNetwork.submit(
+      std::vector<CapacityNetwork::AppDescriptor>({{0, {0}, 1}}), 1, 1);
+  myNetwork.drain();
+  ASSERT_THROW(myBadFuture.get(), std::runtime_error);
+  myExpected.route(myApps, 0.5, 99);
+  const auto myRouted = myAppsFuture.get();
+  ASSERT_EQ(myApps.size(), myRouted.size());
+  for (std::size_t i = 0; i < myApps.size(); i++) {
+    ASSERT_FLOAT_EQ(myApps[i].grossRate(), myRouted[i].grossRate());
+  }
+  ASSERT_EQ(myExpected.weights(), myNetwork.weights());
+
+  // requests still pending are served before the network is destroyed
+  std::future<CapacityNetwork::FlowDescriptor> myPending;
+  {
+    CapacityNetwork myOther(exampleEdgeWeights());
+    myPending = myOther.submit({0, 2, 1});
+  }
+  ASSERT_EQ(std::vector<unsigned long>({1, 2}), myPending.get().thePath);
+
+  // the first requests may be submitted by many threads at the same time
+  const std::size_t                            N = 4;
+  CapacityNetwork                              myShared(exampleEdgeWeights());
+  std::vector<CapacityNetwork::FlowDescriptor> mySequential;
+  std::vector<std::thread>                     myThreads;
+  std::vector<std::future<CapacityNetwork::FlowDescriptor>> mySharedFutures(N);
+  for (std::size_t t = 0; t < N; t++) {
+    mySequential.emplace_back(0, 3, 1);
+    myThreads.emplace_back([&myShared, &mySharedFutures, t]() {
+      mySharedFutures[t] = myShared.submit({0, 3, 1});
+    });
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  for (auto& myFuture : mySharedFutures) {
+    ASSERT_FALSE(myFuture.get().thePath.empty());
+  }
+  CapacityNetwork myReference(exampleEdgeWeights());
+  myReference.route(mySequential);
+  ASSERT_EQ(myReference.weights(), myShared.weights());
+}
+
+TEST_F(TestCapacityNetwork, test_probe) {
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+
+  // ill-formed requests
+  ASSERT_THROW(myNetwork.probe({0, 0, 1}), std::runtime_error);
+  ASSERT_THROW(myNetwork.probe({0, 42, 1}), std::runtime_error);
+  ASSERT_THROW(myNetwork.probe({0, 3, 0}), std::runtime_error);
+
+  // the probe returns what route() would do next, without side effects
+  const std::vector<CapacityNetwork::FlowDescriptor> myFlows({
+      {0, 3, 0.5},
+      {0, 3, 0.25},
+      {0, 3, 0.5},
+      {1, 3, 0.5},
+      {0, 3, 0.5},
+  });
+  for (const auto& myFlow : myFlows) {
+    const auto myWeights  = myNetwork.weights();
+    const auto myCounters = myNetwork.counters().toString();
+    const auto myProbed   = myNetwork.probe(myFlow);
+    ASSERT_EQ(myWeights, myNetwork.weights());
+    ASSERT_EQ(myCounters, myNetwork.counters().toString());
+
+    std::vector<CapacityNetwork::FlowDescriptor> mySingle({myFlow});
+    myNetwork.route(mySingle);
+    ASSERT_EQ(mySingle[0].thePath, myProbed.thePath) << myProbed.toString();
+    ASSERT_FLOAT_EQ(mySingle[0].theGrossRate, myProbed.theGrossRate);
+    ASSERT_EQ(mySingle[0].theDijsktra, myProbed.theDijsktra);
+  }
+
+  // the check function is honored
+  const auto myRejected = myNetwork.probe(
+      {1, 2, 0.1}, [](const auto& aFlow) { return aFlow.thePath.size() > 1; });
+  ASSERT_TRUE(myRejected.thePath.empty());
+
+  // concurrent probes from multiple threads
+  CapacityNetwork myFresh(exampleEdgeWeights());
+  const auto      myExpected = myFresh.probe({0, 2, 0.1});
+  ASSERT_EQ(std::vector<unsigned long>({1, 2}), myExpected.thePath);
+  std::vector<std::future<bool>> myResults;
+  for (auto i = 0; i < 4; i++) {
+    myResults.emplace_back(std::async(std::launch::async, [&]() {
+      for (auto j = 0; j < 100; j++) {
+        const auto myProbed = myFresh.probe({0, 2, 0.1});
+        if (myProbed.thePath != myExpected.thePath or
+            myProbed.theGrossRate != myExpected.theGrossRate) {
+          return false;
+        }
+      }
+      return true;
+    }));
+  }
+  for (auto& myResult : myResults) {
+    ASSERT_TRUE(myResult.get());
+  }
+
+  // concurrent probes checking the fidelity of the path with the link
+  // qualities, which does not change the network
+  myFresh.linkQualities({{0, 1, {0.99, 1}}, {1, 2, {0.9, 1}}});
+  const auto myFidelityCheck = [&myFresh](const auto& aFlow) {
+    return myFresh.pathFidelity(aFlow.theSrc, aFlow.thePath) >= 0.85;
+  };
+  const auto myFidelityExpected = myFresh.probe({0, 2, 0.1}, myFidelityCheck);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2}), myFidelityExpected.thePath);
+  const auto myCountersBefore = myFresh.counters().toString();
+  myResults.clear();
+  for (auto i = 0; i < 4; i++) {
+    myResults.emplace_back(std::async(std::launch::async, [&]() {
+      for (auto j = 0; j < 100; j++) {
+        const auto myProbed = myFresh.probe({0, 2, 0.1}, myFidelityCheck);
+        if (myProbed.thePath != myFidelityExpected.thePath or
+            myProbed.theGrossRate != myFidelityExpected.theGrossRate) {
+          return false;
+        }
+      }
+      return true;
+    }));
+  }
+  for (auto& myResult : myResults) {
+    ASSERT_TRUE(myResult.get());
+  }
+  ASSERT_EQ(myCountersBefore, myFresh.counters().toString());
+
+  // applications
+  CapacityNetwork myOther(exampleEdgeWeights());
+  myOther.measurementProbability(0.5);
+  std::vector<CapacityNetwork::AppDescriptor> myApps({
+      {0, {2, 3}, 1},
+      {1, {3}, 1},
+  });
+  ASSERT_THROW(myOther.probe(std::vector<CapacityNetwork::AppDescriptor>(
+                                 {{0, {0}, 1}}),
+                             1,
+                             1),
+               std::runtime_error);
+  const auto myWeights = myOther.weights();
+  const auto myProbed  = myOther.probe(myApps, 1.4, 99);
+  ASSERT_EQ(myWeights, myOther.weights());
+  myOther.route(myApps, 1.4, 99);
+  ASSERT_EQ(myApps.size(), myProbed.size());
+  for (std::size_t i = 0; i < myApps.size(); i++) {
+    ASSERT_FLOAT_EQ(myApps[i].grossRate(), myProbed[i].grossRate());
+    ASSERT_EQ(myApps[i].theVisits, myProbed[i].theVisits);
+  }
+}
+
+TEST_F(TestCapacityNetwork, test_latencies) {
+  using Decision = DecisionLatencies::Decision;
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  ASSERT_EQ(nullptr, myNetwork.latencies());
+
+  // classes by net rate
+  const auto myLatencies =
+      std::make_shared<DecisionLatencies>(std::vector<std::string>({"1", "2"}));
+  myNetwork.latencies(myLatencies, [](const auto& aFlow) {
+    return aFlow.theNetRate < 1.5 ? 0 : 1;
+  });
+  ASSERT_EQ(myLatencies, myNetwork.latencies());
+
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({
+      {0, 3, 1},
+      {0, 3, 2},
+      {3, 0, 2},
+  });
+  myNetwork.route(myFlows);
+  ASSERT_EQ(1, (*myLatencies)(Decision::Admission, 0).count());
+  ASSERT_EQ(2, (*myLatencies)(Decision::Admission, 1).count());
+
+  // the net rate is restored from the gross rate upon release
+  myNetwork.measurementProbability(0.5);
+  myNetwork.addCapacityToPath(0, {1, 2, 3}, 2 / 0.25);
+  ASSERT_EQ(0, (*myLatencies)(Decision::Release, 0).count());
+  ASSERT_EQ(1, (*myLatencies)(Decision::Release, 1).count());
+
+  // disable
+  myNetwork.latencies(nullptr);
+  myNetwork.addCapacityToPath(0, {1}, 1);
+  ASSERT_EQ(1, (*myLatencies)(Decision::Release, 1).count());
+}
+
 TEST_F(TestCapacityNetwork, test_add_capacity_to_edge) {
   CapacityNetwork myNetwork(exampleEdgeWeights());
   myNetwork.measurementProbability(0.5);
@@ -472,5 +1086,195 @@ TEST_F(TestCapacityNetwork, test_add_capacity_to_edge) {
   ASSERT_NO_THROW(myNetwork.addCapacityToPath(0, {1}, 1));
 }
 
+TEST_F(TestCapacityNetwork, test_apply_topology_deltas) {
+  using Delta = CapacityNetwork::TopologyDelta;
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  const auto      myWeightMap = [&myNetwork]() {
+    std::map<std::pair<unsigned long, unsigned long>, double> ret;
+    for (const auto& elem : myNetwork.weights()) {
+      ret.emplace(std::make_pair(std::get<0>(elem), std::get<1>(elem)),
+                  std::get<2>(elem));
+    }
+    return ret;
+  };
+
+  // invalid changes do not modify the network
+  const auto myOriginal = myNetwork.weights();
+  for (const auto& myDeltas : std::vector<std::vector<Delta>>({
+           {Delta::addEdge(0, 1, 1)},
+           {Delta::removeEdge(1, 0)},
+           {Delta::setCapacity(1, 0, 1)},
+           {Delta::addEdge(0, 42, 1)},
+           {Delta::addEdge(2, 2, 1)},
+           {Delta::addEdge(1, 0, -1)},
+           {Delta::setCapacity(0, 1, 2), Delta::removeEdge(0, 1)},
+           {Delta::setCapacity(0, 1, 1), Delta::addEdge(0, 1, 1)},
+       })) {
+    ASSERT_THROW(myNetwork.applyTopologyDeltas(myDeltas), std::runtime_error)
+        << myDeltas.back().toString();
+    ASSERT_EQ(myOriginal, myNetwork.weights());
+  }
+
+  // the reservations are carried over
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 1}});
+  myNetwork.route(myFlows);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  const auto myOverbooked = myNetwork.applyTopologyDeltas({
+      Delta::setCapacity(4, 3, 2),
+      Delta::setCapacity(0, 4, 0.5),
+      Delta::addEdge(1, 3, 2),
+      Delta::removeEdge(2, 3),
+  });
+  ASSERT_EQ(CapacityNetwork::WeightVector({{0, 4, 0.5}}), myOverbooked);
+  auto myWeights = myWeightMap();
+  ASSERT_EQ(5, myWeights.size());
+  ASSERT_FLOAT_EQ(4, (myWeights[{0, 1}]));
+  ASSERT_FLOAT_EQ(4, (myWeights[{1, 2}]));
+  ASSERT_FLOAT_EQ(-0.5, (myWeights[{0, 4}]));
+  ASSERT_FLOAT_EQ(1, (myWeights[{4, 3}]));
+  ASSERT_FLOAT_EQ(2, (myWeights[{1, 3}]));
+
+  // new flows cannot use the overbooked edge
+  myFlows = std::vector<CapacityNetwork::FlowDescriptor>({{0, 3, 1}});
+  myNetwork.route(myFlows);
+  ASSERT_EQ(std::vector<unsigned long>({1, 3}), myFlows[0].thePath);
+
+  // the capacity of released flows is added back
+  myNetwork.addCapacityToPath(0, {4, 3}, 1);
+  myWeights = myWeightMap();
+  ASSERT_FLOAT_EQ(0.5, (myWeights[{0, 4}]));
+  ASSERT_FLOAT_EQ(2, (myWeights[{4, 3}]));
+
+  // the capacity reserved on removed edges is reported
+  ASSERT_EQ(CapacityNetwork::WeightVector({{1, 3, 1}}),
+            myNetwork.applyTopologyDeltas({Delta::removeEdge(1, 3)}));
+  ASSERT_EQ(4, myNetwork.numEdges());
+  ASSERT_TRUE(myNetwork.applyTopologyDeltas({}).empty());
+
+  // the node capacities are consistent with the edge weights
+  std::vector<double> myExpected(myNetwork.numNodes(), 0);
+  for (const auto& elem : myNetwork.weights()) {
+    myExpected[std::get<0>(elem)] += std::get<2>(elem);
+  }
+  ASSERT_EQ(myExpected, myNetwork.nodeCapacities());
+}
+
+TEST_F(TestCapacityNetwork, test_apply_capacity_deltas) {
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+
+  // the node capacities are always consistent with the edge weights
+  const auto myCheckCapacities = [&myNetwork]() {
+    std::vector<double> myExpected(myNetwork.numNodes(), 0);
+    for (const auto& elem : myNetwork.weights()) {
+      myExpected[std::get<0>(elem)] += std::get<2>(elem);
+    }
+    ASSERT_EQ(myExpected, myNetwork.nodeCapacities());
+  };
+
+  // invalid changes do not modify the network
+  const auto myOriginal = myNetwork.weights();
+  for (const auto& myDeltas : std::vector<CapacityNetwork::WeightVector>({
+           {{1, 0, 1}},
+           {{0, 4, -2}},
+           {{0, 1, 1}, {0, 4, -0.6}, {0, 4, -0.6}},
+           {{0, 1, 1}, {0, 42, 1}},
+       })) {
+    ASSERT_THROW(myNetwork.applyCapacityDeltas(myDeltas), std::runtime_error);
+    ASSERT_EQ(myOriginal, myNetwork.weights());
+  }
+  ASSERT_TRUE(myNetwork.applyCapacityDeltas({}).empty());
+
+  // the reservations are carried over
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 1}});
+  myNetwork.route(myFlows);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  myCheckCapacities();
+  ASSERT_EQ(CapacityNetwork::WeightVector({{0, 4, 0.5}}),
+            myNetwork.applyCapacityDeltas({
+                {4, 3, 1},
+                {0, 4, -0.5},
+                {0, 1, 2},
+                {2, 3, 0},
+                {0, 1, -1},
+            }));
+  ASSERT_EQ(CapacityNetwork::WeightVector({
+                {0, 1, 5},
+                {1, 2, 4},
+                {2, 3, 4},
+                {0, 4, -0.5},
+                {4, 3, 4},
+            }),
+            myNetwork.weights());
+  ASSERT_EQ(std::vector<double>({4.5, 4, 4, 0, 4}),
+            myNetwork.nodeCapacities());
+  ASSERT_FLOAT_EQ(16.5, myNetwork.totalCapacity());
+
+  // the base capacities are restored when the flow is released
+  myNetwork.addCapacityToPath(0, {4, 3}, 1);
+  myCheckCapacities();
+  ASSERT_FLOAT_EQ(18.5, myNetwork.totalCapacity());
+  ASSERT_TRUE(myNetwork
+                  .applyTopologyDeltas(
+                      {CapacityNetwork::TopologyDelta::setCapacity(0, 4, 0)})
+                  .empty());
+  ASSERT_FLOAT_EQ(18, myNetwork.totalCapacity());
+
+  // elastic applications exhaust the capacity of some edges
+  std::vector<CapacityNetwork::AppDescriptor> myApps({{0, {3}, 1}});
+  myNetwork.route(myApps, 100, 2);
+  myCheckCapacities();
+  ASSERT_EQ(2, myNetwork.numEdges());
+  ASSERT_TRUE(myNetwork.applyCapacityDeltas({{0, 1, 1}, {2, 3, 1}}).empty());
+  ASSERT_EQ(3, myNetwork.numEdges());
+  myCheckCapacities();
+}
+
+TEST_F(TestCapacityNetwork, test_counters) {
+  CapacityNetwork myNetwork(exampleEdgeWeights());
+  myNetwork.measurementProbability(0.5);
+  ASSERT_EQ(0, myNetwork.counters().theVerticesSettled);
+  ASSERT_EQ(0, myNetwork.counters().theEdgeLookups);
+
+  // two Dijkstra calls from 0: the first one reaches all the vertices and
+  // finds 0->4->3, then 0->4 is removed and 4 becomes unreachable
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({
+      {0, 3, 1.0},
+  });
+  myNetwork.route(myFlows);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0].thePath);
+  ASSERT_EQ(2, myFlows[0].theDijsktra);
+  ASSERT_EQ(5 + 4, myNetwork.counters().theVerticesSettled);
+  ASSERT_EQ(5 + 3, myNetwork.counters().theEdgesScanned);
+  ASSERT_EQ(1, myNetwork.counters().theGraphCopies);
+  ASSERT_EQ(0, myNetwork.counters().theKspSearches);
+  // 0->4 checked and removed, then 0->1->2->3 checked and reserved
+  ASSERT_EQ(1 + 2 + 3 + 3, myNetwork.counters().theEdgeLookups);
+
+  // one k-shortest path search per host/peer pair
+  std::vector<CapacityNetwork::AppDescriptor> myApps({
+      {0, {3, 4}, 1.0},
+  });
+  myNetwork.route(myApps, 1, 2);
+  ASSERT_EQ(2, myNetwork.counters().theKspSearches);
+  ASSERT_EQ(1, myNetwork.counters().theGraphCopies);
+  ASSERT_LT(9, myNetwork.counters().theEdgeLookups);
+
+  // the counters are not reset
+  const auto  myBefore = myNetwork.counters().theVerticesSettled;
+  std::size_t myDiameter;
+  myNetwork.reachableNodes(0, 99, myDiameter);
+  ASSERT_LT(myBefore, myNetwork.counters().theVerticesSettled);
+
+  // only the constrained search expands labels: 0, 4, 3
+  ASSERT_EQ(0, myNetwork.counters().theLabelsExpanded);
+  CapacityNetwork myConstrained(exampleEdgeWeights());
+  myFlows.clear();
+  myFlows.emplace_back(0, 3, 0.1);
+  myConstrained.routeConstrained(myFlows, 0);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[0].thePath);
+  ASSERT_EQ(4, myFlows[0].theDijsktra);
+  ASSERT_EQ(3, myConstrained.counters().theLabelsExpanded);
+}
+
 } // namespace qr
 } // namespace uiiit
@@ -0,0 +1,246 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/concurrentnetwork.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <list>
+#include <stdexcept>
+#include <thread>
+
+namespace uiiit {
+namespace qr {
+
+struct TestConcurrentNetwork : public ::testing::Test {
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3   all weights are 4, except 0->4 which is 1
+  //  \              ^
+  //   \---> 4 ------+
+  CapacityNetwork::WeightVector exampleEdgeWeights() {
+    return CapacityNetwork::WeightVector({
+        {0, 1, 4},
+        {1, 2, 4},
+        {2, 3, 4},
+        {0, 4, 1},
+        {4, 3, 4},
+    });
+  }
+
+  // bidirectional grid with aSize x aSize nodes
+  CapacityNetwork::EdgeVector gridEdges(const unsigned long aSize) {
+    CapacityNetwork::EdgeVector ret;
+    for (unsigned long i = 0; i < aSize; i++) {
+      for (unsigned long j = 0; j < aSize; j++) {
+        if (j + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, i * aSize + j + 1);
+        }
+        if (i + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, (i + 1) * aSize + j);
+        }
+      }
+    }
+    return ret;
+  }
+};
+
+TEST_F(TestConcurrentNetwork, test_ctor) {
+  auto myDuplicate = exampleEdgeWeights();
+  myDuplicate.emplace_back(myDuplicate.front());
+  ASSERT_THROW(ConcurrentNetwork{myDuplicate}, std::runtime_error);
+
+  ConcurrentNetwork myNetwork(exampleEdgeWeights());
+  ASSERT_EQ(5, myNetwork.numNodes());
+  ASSERT_EQ(5, myNetwork.numEdges());
+  ASSERT_EQ(17, myNetwork.totalCapacity());
+  ASSERT_EQ(exampleEdgeWeights(), myNetwork.weights());
+
+  ASSERT_THROW(myNetwork.measurementProbability(1.1), std::runtime_error);
+  myNetwork.measurementProbability(0.5);
+  ASSERT_EQ(0.5, myNetwork.measurementProbability());
+}
+
+TEST_F(TestConcurrentNetwork, test_admit_release) {
+  ConcurrentNetwork myNetwork(exampleEdgeWeights());
+
+  // invalid requests
+  for (const auto& myFlow : std::vector<CapacityNetwork::FlowDescriptor>(
+           {{0, 0, 1}, {0, 5, 1}, {5, 0, 1}, {0, 3, 0}})) {
+    auto myCopy = myFlow;
+    ASSERT_THROW(myNetwork.admit(myCopy), std::runtime_error);
+  }
+  ASSERT_EQ(17, myNetwork.totalCapacity());
+
+  // 0->4->3 is the shortest path but it is not feasible
+  CapacityNetwork::FlowDescriptor myFirst(0, 3, 1.5);
+  ASSERT_TRUE(myNetwork.admit(myFirst));
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFirst.thePath);
+  ASSERT_EQ(2, myFirst.theDijsktra);
+  ASSERT_EQ(1.5, myFirst.theGrossRate);
+  ASSERT_EQ(17 - 4.5, myNetwork.totalCapacity());
+
+  // no path from 3, rejected by the check function
+  CapacityNetwork::FlowDescriptor mySecond(3, 0, 1);
+  ASSERT_FALSE(myNetwork.admit(mySecond));
+  ASSERT_TRUE(mySecond.thePath.empty());
+  CapacityNetwork::FlowDescriptor myThird(0, 2, 1);
+  ASSERT_FALSE(myNetwork.admit(myThird, [](const auto&) { return false; }));
+  ASSERT_TRUE(myThird.thePath.empty());
+
+  // not enough capacity left
+  CapacityNetwork::FlowDescriptor myFourth(0, 3, 3);
+  ASSERT_FALSE(myNetwork.admit(myFourth));
+  ASSERT_EQ(3, myFourth.theDijsktra);
+
+  // release the capacity
+  myNetwork.release(myFirst);
+  ASSERT_EQ(17, myNetwork.totalCapacity());
+  CapacityNetwork::FlowDescriptor myInvalid(0, 3, 1);
+  myInvalid.thePath = {2, 3};
+  ASSERT_THROW(myNetwork.release(myInvalid), std::runtime_error);
+  ASSERT_EQ(0, myNetwork.numConflicts());
+}
+
+TEST_F(TestConcurrentNetwork, test_same_as_capacity_network) {
+  support::UniformRv myWeightRv(1, 10, 42, 0, 0);
+  CapacityNetwork    myReference(gridEdges(6), myWeightRv, true);
+  myReference.measurementProbability(0.9);
+  ConcurrentNetwork myNetwork(myReference.weights());
+  myNetwork.measurementProbability(0.9);
+
+  support::UniformIntRv<unsigned long> myNodeRv(
+      0, myNetwork.numNodes() - 1, 42, 0, 0);
+  support::UniformRv myRateRv(0.5, 4, 42, 1, 0);
+  support::UniformRv myCoinRv(0, 1, 42, 2, 0);
+  const auto         myCheck = [](const auto& aFlow) {
+    return aFlow.thePath.size() <= 6;
+  };
+  std::list<CapacityNetwork::FlowDescriptor> myAdmitted;
+  std::size_t                                myNumRerouted = 0;
+  for (std::size_t i = 0; i < 1000; i++) {
+    const auto mySrc  = myNodeRv();
+    const auto myDst  = (mySrc + 1 + myNodeRv() % 35) % 36;
+    const auto myRate = myRateRv();
+
+    std::vector<CapacityNetwork::FlowDescriptor> myExpected(
+        {{mySrc, myDst, myRate}});
+    myReference.route(myExpected, myCheck);
+    CapacityNetwork::FlowDescriptor myFlow(mySrc, myDst, myRate);
+    ASSERT_EQ(not myExpected[0].thePath.empty(),
+              myNetwork.admit(myFlow, myCheck));
+    ASSERT_EQ(myExpected[0].thePath, myFlow.thePath);
+    ASSERT_EQ(myExpected[0].theGrossRate, myFlow.theGrossRate);
+    ASSERT_EQ(myExpected[0].theDijsktra, myFlow.theDijsktra);
+    if (not myFlow.thePath.empty()) {
+      myNumRerouted += myFlow.theDijsktra > 1 ? 1 : 0;
+      myAdmitted.emplace_back(myFlow);
+    }
+
+    // release the oldest flow from time to time
+    if (not myAdmitted.empty() and myCoinRv() < 0.4) {
+      const auto& myOldest = myAdmitted.front();
+      myNetwork.release(myOldest);
+      myReference.addCapacityToPath(
+          myOldest.theSrc, myOldest.thePath, myOldest.theGrossRate);
+      myAdmitted.pop_front();
+    }
+  }
+  ASSERT_EQ(myReference.weights(), myNetwork.weights());
+  ASSERT_GT(myNumRerouted, 0);
+}
+
+TEST_F(TestConcurrentNetwork, test_concurrent) {
+  // many threads admit and release flows with the same end-points, so that
+  // they compete for the same edges; the capacities are at least 10 and the
+  // rates at most 5, and every thread holds at most one flow at a time, so
+  // the other threads cannot exhaust the capacity between the end-points
+  // and every thread must be able to admit flows, whatever the scheduling
+  support::UniformRv myWeightRv(10, 20, 42, 0, 0);
+  CapacityNetwork    myReference(gridEdges(4), myWeightRv, true);
+  ConcurrentNetwork  myNetwork(myReference.weights());
+  const auto         myInitialCapacity = myNetwork.totalCapacity();
+
+  const std::size_t        N = 4;
+  std::atomic<std::size_t> myReady(0);
+  std::vector<std::thread> myThreads;
+  std::vector<std::size_t> myAdmitted(N, 0);
+  for (std::size_t t = 0; t < N; t++) {
+    myThreads.emplace_back([&myNetwork, &myReady, &myAdmitted, N, t]() {
+      // wait for all the threads to start together
+      myReady++;
+      while (myReady.load() < N) {
+        std::this_thread::yield();
+      }
+
+      std::list<CapacityNetwork::FlowDescriptor> myFlows;
+      support::UniformRv myRateRv(1, 5, 42, t, 0);
+      for (std::size_t i = 0; i < 2000; i++) {
+        if (not myFlows.empty()) {
+          myNetwork.release(myFlows.front());
+          myFlows.pop_front();
+        }
+        CapacityNetwork::FlowDescriptor myFlow(0, 15, myRateRv());
+        if (myNetwork.admit(myFlow)) {
+          myAdmitted[t]++;
+          myFlows.emplace_back(myFlow);
+        }
+      }
+      for (const auto& myFlow : myFlows) {
+        myNetwork.release(myFlow);
+      }
+    });
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+
+  LOG(INFO) << "admitted " << ::testing::PrintToString(myAdmitted) << ", "
+            << myNetwork.numConflicts() << " conflicts";
+  for (const auto myNum : myAdmitted) {
+    ASSERT_GT(myNum, 0);
+  }
+  ASSERT_NEAR(myInitialCapacity, myNetwork.totalCapacity(), 1e-6);
+  const auto myExpected = myReference.weights();
+  const auto myActual   = myNetwork.weights();
+  ASSERT_EQ(myExpected.size(), myActual.size());
+  for (std::size_t e = 0; e < myExpected.size(); e++) {
+    ASSERT_NEAR(std::get<2>(myExpected[e]), std::get<2>(myActual[e]), 1e-6);
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
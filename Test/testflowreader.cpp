@@ -0,0 +1,152 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/flowreader.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glog/logging.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace uiiit {
+namespace qr {
+
+struct TestFlowReader : public ::testing::Test {
+  TestFlowReader()
+      : theFilename(
+            (boost::filesystem::current_path() / "flows.dat").string()) {
+    // noop
+  }
+
+  void SetUp() {
+    boost::filesystem::remove(theFilename);
+  }
+
+  void TearDown() {
+    if (not VLOG_IS_ON(1)) {
+      boost::filesystem::remove(theFilename);
+    }
+  }
+
+  void write(const std::string& aContent) const {
+    std::ofstream myOutput(theFilename, std::ios::binary | std::ios::trunc);
+    myOutput << aContent;
+  }
+
+  std::vector<FlowRequest> readAll(const std::size_t aBufferSize = 4096) const {
+    FlowReader               myReader(theFilename, 4, aBufferSize);
+    std::vector<FlowRequest> ret;
+    FlowRequest              myRequest;
+    while (myReader.next(myRequest)) {
+      ret.emplace_back(myRequest);
+    }
+    EXPECT_EQ(ret.size(), myReader.count());
+    return ret;
+  }
+
+  const std::string              theFilename;
+  const std::vector<FlowRequest> theRequests{
+      {0.0, 1, 2, 10.0, 0.9},
+      {0.5, 3, 0, 2.5, 0.75},
+      {0.5, 2, 1, 1.0, 0.5},
+  };
+};
+
+TEST_F(TestFlowReader, test_csv) {
+  write("time,src,dst,net-rate,fidelity-threshold\n"
+        "0,1,2,10,0.9\n"
+        "\n"
+        "# comment\n"
+        "0.5,3,0,2.5,0.75\r\n"
+        "0.5,2,1,1,0.5");
+  ASSERT_EQ(theRequests, readAll());
+
+  write("");
+  ASSERT_TRUE(readAll().empty());
+}
+
+TEST_F(TestFlowReader, test_binary) {
+  for (const std::size_t myBufferSize : {1, 2, 3, 4096}) {
+    {
+      std::ofstream myOutput(theFilename, std::ios::binary | std::ios::trunc);
+      myOutput.write("QRFLOWS1", 8);
+      myOutput.write(reinterpret_cast<const char*>(theRequests.data()),
+                     theRequests.size() * sizeof(FlowRequest));
+    }
+    ASSERT_EQ(theRequests, readAll(myBufferSize));
+  }
+
+  // truncated
+  boost::filesystem::resize_file(theFilename,
+                                 boost::filesystem::file_size(theFilename) - 1);
+  ASSERT_THROW(readAll(), std::runtime_error);
+}
+
+TEST_F(TestFlowReader, test_invalid) {
+  ASSERT_THROW(FlowReader myReader(theFilename, 4), std::runtime_error);
+
+  for (const auto& myContent : std::vector<std::string>({
+           "0,1,2,10",         // missing field
+           "0,1,2,10,0.9,1",   // extra field
+           "0,1,2,ten,0.9",    // not a number
+           "0,-1,2,10,0.9",    // negative node
+           "0,1,1,10,0.9",     // to itself
+           "0,1,4,10,0.9",     // destination out of range
+           "0,4,1,10,0.9",     // source out of range
+           "0,1,2,0,0.9",      // null rate
+           "0,1,2,10,1.5",     // invalid fidelity
+           "1,1,2,10,0.9\n0,1,2,10,0.9", // out of order
+       })) {
+    write(myContent);
+    ASSERT_THROW(readAll(), std::runtime_error) << myContent;
+  }
+
+  // the error reports the line of the offending request
+  write("time,src,dst,net-rate,fidelity-threshold\n"
+        "0,1,2,10,0.9\n"
+        "0,1,5,10,0.9\n");
+  try {
+    readAll();
+    FAIL() << "exception not thrown";
+  } catch (const std::runtime_error& aErr) {
+    ASSERT_NE(std::string::npos,
+              std::string(aErr.what()).find(":line 3: node out of range"))
+        << aErr.what();
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,372 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/flowrouter.h"
+#include "QuantumRouting/mpscqueue.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestFlowRouter : public ::testing::Test {
+  // bidirectional grid with aSize x aSize nodes
+  CapacityNetwork::EdgeVector gridEdges(const unsigned long aSize) {
+    CapacityNetwork::EdgeVector ret;
+    for (unsigned long i = 0; i < aSize; i++) {
+      for (unsigned long j = 0; j < aSize; j++) {
+        if (j + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, i * aSize + j + 1);
+        }
+        if (i + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, (i + 1) * aSize + j);
+        }
+      }
+    }
+    return ret;
+  }
+
+  std::vector<CapacityNetwork::FlowDescriptor>
+  randomFlows(const std::size_t aNumFlows, const std::size_t aSeed) {
+    support::UniformIntRv<unsigned long> myNodeRv(0, 35, aSeed, 0, 0);
+    support::UniformRv                   myRateRv(0.5, 4, aSeed, 1, 0);
+    std::vector<CapacityNetwork::FlowDescriptor> ret;
+    for (std::size_t i = 0; i < aNumFlows; i++) {
+      const auto mySrc = myNodeRv();
+      ret.emplace_back(mySrc, (mySrc + 1 + myNodeRv() % 35) % 36, myRateRv());
+    }
+    return ret;
+  }
+};
+
+TEST_F(TestFlowRouter, test_mpsc_queue) {
+  MpscQueue<std::pair<std::size_t, std::size_t>> myQueue;
+  ASSERT_FALSE(myQueue.pop().has_value());
+
+  const std::size_t        N = 4;
+  const std::size_t        M = 10000;
+  std::vector<std::thread> myThreads;
+  for (std::size_t t = 0; t < N; t++) {
+    myThreads.emplace_back([&myQueue, t]() {
+      for (std::size_t i = 0; i < M; i++) {
+        myQueue.push({t, i});
+      }
+    });
+  }
+
+  // the elements pushed by the same producer are received in order
+  std::vector<std::size_t> myNext(N, 0);
+  std::size_t              myReceived = 0;
+  while (myReceived < N * M) {
+    const auto myElem = myQueue.pop();
+    if (myElem.has_value()) {
+      ASSERT_EQ(myNext[myElem->first], myElem->second);
+      ++myNext[myElem->first];
+      ++myReceived;
+    }
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  ASSERT_FALSE(myQueue.pop().has_value());
+  ASSERT_EQ(std::vector<std::size_t>(N, M), myNext);
+
+  // elements not popped are destroyed with the queue
+  myQueue.push({0, 0});
+}
+
+TEST_F(TestFlowRouter, test_ctor) {
+  ASSERT_THROW(FlowRouter(nullptr, 1), std::runtime_error);
+  ASSERT_THROW(FlowRouter(std::make_unique<CapacityNetwork>(
+                              CapacityNetwork::WeightVector({{0, 1, 1}})),
+                          0),
+               std::runtime_error);
+
+  FlowRouter myRouter(std::make_unique<CapacityNetwork>(
+                          CapacityNetwork::WeightVector({{0, 1, 1}})),
+                      1);
+  ASSERT_NE(nullptr, myRouter.stop());
+  ASSERT_EQ(nullptr, myRouter.stop());
+  ASSERT_THROW(myRouter.submit({0, 1, 1}), std::runtime_error);
+}
+
+TEST_F(TestFlowRouter, test_same_as_route) {
+  support::UniformRv myWeightRv(1, 10, 42, 0, 0);
+  CapacityNetwork    myReference(gridEdges(6), myWeightRv, true);
+  const auto         myCheck = [](const auto& aFlow) {
+    return aFlow.thePath.size() <= 6;
+  };
+
+  for (const std::size_t myMaxBatch : {1, 7, 1000}) {
+    CapacityNetwork myExpected(myReference.weights());
+    FlowRouter      myRouter(
+        std::make_unique<CapacityNetwork>(myReference.weights()),
+        myMaxBatch,
+        myCheck);
+
+    // first round: admissions only
+    std::vector<std::future<CapacityNetwork::FlowDescriptor>> myFutures;
+    auto myFlows = randomFlows(500, 42);
+    for (const auto& myFlow : myFlows) {
+      myFutures.emplace_back(myRouter.submit(myFlow));
+    }
+    // the expected flows are routed one at a time, without reusing the
+    // shortest path trees across the flows
+    for (auto& myFlow : myFlows) {
+      std::vector<CapacityNetwork::FlowDescriptor> mySingle({myFlow});
+      myExpected.route(mySingle, myCheck);
+      myFlow.movePathRateFrom(mySingle[0]);
+      myFlow.theDijsktra = mySingle[0].theDijsktra;
+    }
+    std::vector<CapacityNetwork::FlowDescriptor> myAdmitted;
+    for (std::size_t i = 0; i < myFlows.size(); i++) {
+      const auto myFlow = myFutures[i].get();
+      ASSERT_EQ(myFlows[i].thePath, myFlow.thePath);
+      ASSERT_EQ(myFlows[i].theGrossRate, myFlow.theGrossRate);
+      ASSERT_EQ(myFlows[i].theDijsktra, myFlow.theDijsktra);
+      if (not myFlow.thePath.empty()) {
+        myAdmitted.emplace_back(myFlow);
+      }
+    }
+    ASSERT_FALSE(myAdmitted.empty());
+
+    // second round: releases interleaved with admissions
+    myFutures.clear();
+    std::vector<std::future<void>> myReleased;
+    myFlows = randomFlows(myAdmitted.size(), 43);
+    for (std::size_t i = 0; i < myFlows.size(); i++) {
+      myReleased.emplace_back(myRouter.release(myAdmitted[i]));
+      myExpected.addCapacityToPath(myAdmitted[i].theSrc,
+                                   myAdmitted[i].thePath,
+                                   myAdmitted[i].theGrossRate);
+      myFutures.emplace_back(myRouter.submit(myFlows[i]));
+      std::vector<CapacityNetwork::FlowDescriptor> mySingle({myFlows[i]});
+      myExpected.route(mySingle, myCheck);
+      myFlows[i].movePathRateFrom(mySingle[0]);
+    }
+    for (std::size_t i = 0; i < myFlows.size(); i++) {
+      myReleased[i].get();
+      ASSERT_EQ(myFlows[i].thePath, myFutures[i].get().thePath);
+    }
+
+    const auto myNetwork = myRouter.stop();
+    ASSERT_EQ(myExpected.weights(), myNetwork->weights());
+    ASSERT_EQ(500 + 2 * myAdmitted.size(), myRouter.numRequests());
+    ASSERT_GE(myRouter.numBatches() * myMaxBatch, myRouter.numRequests());
+  }
+}
+
+TEST_F(TestFlowRouter, test_invalid_requests) {
+  FlowRouter myRouter(std::make_unique<CapacityNetwork>(
+                          CapacityNetwork::WeightVector({{0, 1, 10}})),
+                      100);
+
+  // an ill-formed flow does not prevent the others in the same batch
+  auto myFirst  = myRouter.submit({0, 1, 1});
+  auto myBad    = myRouter.submit({0, 0, 1});
+  auto mySecond = myRouter.submit({0, 1, 1});
+  ASSERT_EQ(std::vector<unsigned long>({1}), myFirst.get().thePath);
+  ASSERT_THROW(myBad.get(), std::runtime_error);
+  ASSERT_EQ(std::vector<unsigned long>({1}), mySecond.get().thePath);
+
+  CapacityNetwork::FlowDescriptor myInvalid(1, 0, 1);
+  myInvalid.thePath = {0};
+  ASSERT_THROW(myRouter.release(myInvalid).get(), std::runtime_error);
+}
+
+TEST_F(TestFlowRouter, test_concurrent_producers) {
+  support::UniformRv myWeightRv(10, 20, 42, 0, 0);
+  CapacityNetwork    myReference(gridEdges(6), myWeightRv, true);
+  FlowRouter         myRouter(
+      std::make_unique<CapacityNetwork>(myReference.weights()), 16);
+
+  // every producer admits flows and releases those admitted
+  const std::size_t        N = 4;
+  std::vector<std::thread> myThreads;
+  std::vector<std::size_t> myAdmitted(N, 0);
+  for (std::size_t t = 0; t < N; t++) {
+    myThreads.emplace_back([this, &myRouter, &myAdmitted, t]() {
+      std::vector<std::future<CapacityNetwork::FlowDescriptor>> myFutures;
+      for (const auto& myFlow : randomFlows(1000, t)) {
+        myFutures.emplace_back(myRouter.submit(myFlow));
+      }
+      std::vector<std::future<void>> myReleased;
+      for (auto& myFuture : myFutures) {
+        const auto myFlow = myFuture.get();
+        if (not myFlow.thePath.empty()) {
+          ++myAdmitted[t];
+          myReleased.emplace_back(myRouter.release(myFlow));
+        }
+      }
+      for (auto& myFuture : myReleased) {
+        myFuture.get();
+      }
+    });
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+
+  std::size_t myTotAdmitted = 0;
+  for (const auto myValue : myAdmitted) {
+    ASSERT_GT(myValue, 0);
+    myTotAdmitted += myValue;
+  }
+  const auto myNetwork = myRouter.stop();
+  ASSERT_EQ(N * 1000 + myTotAdmitted, myRouter.numRequests());
+  ASSERT_FLOAT_EQ(myReference.totalCapacity(), myNetwork->totalCapacity());
+}
+
+TEST_F(TestFlowRouter, test_snapshots) {
+  support::UniformRv myWeightRv(10, 20, 42, 0, 0);
+  CapacityNetwork    myReference(gridEdges(6), myWeightRv, true);
+
+  FlowRouter myDisabled(
+      std::make_unique<CapacityNetwork>(myReference.weights()), 16);
+  ASSERT_THROW(myDisabled.reader(), std::runtime_error);
+
+  FlowRouter myRouter(std::make_unique<CapacityNetwork>(myReference.weights()),
+                      16,
+                      [](const auto&) { return true; },
+                      true);
+
+  // the readers take consistent snapshots while the writer serves the
+  // requests of the producers, which admit flows and release those admitted
+  std::atomic<bool>          myDone(false);
+  std::vector<std::thread>   myReaders;
+  std::vector<std::uint64_t> myLastVersions(2, 0);
+  for (std::size_t r = 0; r < myLastVersions.size(); r++) {
+    myReaders.emplace_back([&, r]() {
+      auto myReader = myRouter.reader();
+      while (not myDone.load()) {
+        auto myGuard = myReader->read();
+        ASSERT_GE(myGuard.version(), myLastVersions[r]);
+        myLastVersions[r] = myGuard.version();
+        const auto myCapacities = myGuard->nodeCapacities();
+        ASSERT_NEAR(std::accumulate(
+                        myCapacities.begin(), myCapacities.end(), 0.0),
+                    myGuard->totalCapacity(),
+                    1e-6);
+        ASSERT_LE(myGuard->totalCapacity(),
+                  myReference.totalCapacity() + 1e-6);
+      }
+    });
+  }
+
+  std::vector<std::thread> myProducers;
+  for (std::size_t t = 0; t < 2; t++) {
+    myProducers.emplace_back([this, &myRouter, t]() {
+      std::vector<std::future<CapacityNetwork::FlowDescriptor>> myFutures;
+      for (const auto& myFlow : randomFlows(500, t)) {
+        myFutures.emplace_back(myRouter.submit(myFlow));
+      }
+      std::vector<std::future<void>> myReleased;
+      for (auto& myFuture : myFutures) {
+        const auto myFlow = myFuture.get();
+        if (not myFlow.thePath.empty()) {
+          myReleased.emplace_back(myRouter.release(myFlow));
+        }
+      }
+      for (auto& myFuture : myReleased) {
+        myFuture.get();
+      }
+    });
+  }
+  for (auto& myThread : myProducers) {
+    myThread.join();
+  }
+  const auto myNetwork = myRouter.stop();
+  myDone.store(true);
+  for (auto& myThread : myReaders) {
+    myThread.join();
+  }
+
+  // the last snapshot is the network after the last batch
+  auto       myReader = myRouter.reader();
+  const auto myGuard  = myReader->read();
+  ASSERT_EQ(myRouter.numBatches(), myGuard.version());
+  ASSERT_EQ(myNetwork->weights(), myGuard->weights());
+  ASSERT_FLOAT_EQ(myReference.totalCapacity(), myGuard->totalCapacity());
+}
+
+TEST_F(TestFlowRouter, test_stop_while_submitting) {
+  for (std::size_t myRun = 0; myRun < 20; myRun++) {
+    support::UniformRv myWeightRv(10, 20, myRun, 0, 0);
+    FlowRouter         myRouter(
+        std::make_unique<CapacityNetwork>(gridEdges(6), myWeightRv, true), 4);
+
+    // every request is either served or rejected when submitted
+    const std::size_t        N = 4;
+    std::vector<std::thread> myThreads;
+    std::vector<std::size_t> myServed(N, 0);
+    for (std::size_t t = 0; t < N; t++) {
+      myThreads.emplace_back([this, &myRouter, &myServed, t]() {
+        std::vector<std::future<CapacityNetwork::FlowDescriptor>> myFutures;
+        try {
+          for (const auto& myFlow : randomFlows(1000, t)) {
+            myFutures.emplace_back(myRouter.submit(myFlow));
+          }
+        } catch (const std::runtime_error&) {
+          // stopped
+        }
+        for (auto& myFuture : myFutures) {
+          myFuture.get();
+          ++myServed[t];
+        }
+      });
+    }
+    myRouter.stop();
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+
+    std::size_t myTotServed = 0;
+    for (const auto myValue : myServed) {
+      myTotServed += myValue;
+    }
+    ASSERT_EQ(myTotServed, myRouter.numRequests());
+  }
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,96 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/instrumentation.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+namespace uiiit {
+namespace qr {
+
+struct TestInstrumentation : public ::testing::Test {};
+
+TEST_F(TestInstrumentation, test_work_counters) {
+  WorkCounters myCounters;
+  ASSERT_EQ("0,0,0,0,0,0", myCounters.toCsv());
+  ASSERT_EQ(6, WorkCounters::names().size());
+
+  WorkCounters myOther;
+  myOther.theVerticesSettled = 1;
+  myOther.theEdgesScanned    = 2;
+  myOther.theGraphCopies     = 3;
+  myOther.theKspSearches     = 4;
+  myOther.theEdgeLookups     = 5;
+  myOther.theLabelsExpanded  = 6;
+  myCounters += myOther;
+  myCounters += myOther;
+  ASSERT_EQ("2,4,6,8,10,12", myCounters.toCsv());
+}
+
+TEST_F(TestInstrumentation, test_phase_timers) {
+  PhaseTimers myTimers;
+  ASSERT_EQ(PhaseTimers::NUM_PHASES, PhaseTimers::names().size());
+  ASSERT_EQ("0,0,0,0,0", myTimers.toCsv());
+
+  {
+    PhaseTimers::Scope myScope(&myTimers, PhaseTimers::Phase::Routing);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_GE(myTimers.elapsed(PhaseTimers::Phase::Routing), 0.01);
+  ASSERT_EQ(0, myTimers.elapsed(PhaseTimers::Phase::Topology));
+  ASSERT_EQ(0, myTimers.elapsed(PhaseTimers::Phase::Statistics));
+
+  // accumulated across scopes
+  const auto myBefore = myTimers.elapsed(PhaseTimers::Phase::Routing);
+  {
+    PhaseTimers::Scope myScope(&myTimers, PhaseTimers::Phase::Routing);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_GE(myTimers.elapsed(PhaseTimers::Phase::Routing), myBefore + 0.01);
+
+  // scopes with null timers do nothing
+  ASSERT_NO_THROW(PhaseTimers::Scope(nullptr, PhaseTimers::Phase::Topology));
+}
+
+TEST_F(TestInstrumentation, test_instrumentation) {
+  Instrumentation myInstrumentation;
+  ASSERT_EQ(PhaseTimers::names().size() + WorkCounters::names().size(),
+            Instrumentation::names().size());
+  ASSERT_EQ("time-topology", Instrumentation::names().front());
+  ASSERT_EQ("labels-expanded", Instrumentation::names().back());
+  ASSERT_EQ("0,0,0,0,0,0,0,0,0,0,0", myInstrumentation.toCsv());
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,148 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/latencyhistogram.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestLatencyHistogram : public ::testing::Test {};
+
+TEST_F(TestLatencyHistogram, test_histogram) {
+  ASSERT_THROW(LatencyHistogram(0), std::runtime_error);
+  ASSERT_THROW(LatencyHistogram(17), std::runtime_error);
+
+  LatencyHistogram myHistogram(7);
+  ASSERT_EQ(128 + 57 * 64, myHistogram.size());
+  ASSERT_EQ(0, myHistogram.count());
+  ASSERT_EQ(0, myHistogram.min());
+  ASSERT_EQ(0, myHistogram.max());
+  ASSERT_EQ(0, myHistogram.mean());
+  ASSERT_EQ(0, myHistogram.percentile(0.5));
+  ASSERT_THROW(myHistogram.percentile(1.1), std::runtime_error);
+  ASSERT_THROW(myHistogram.percentile(-0.1), std::runtime_error);
+
+  // small values are exact
+  for (std::uint64_t i = 1; i <= 100; i++) {
+    myHistogram.record(i);
+  }
+  ASSERT_EQ(100, myHistogram.count());
+  ASSERT_EQ(1, myHistogram.min());
+  ASSERT_EQ(100, myHistogram.max());
+  ASSERT_DOUBLE_EQ(50.5, myHistogram.mean());
+  ASSERT_EQ(1, myHistogram.percentile(0));
+  ASSERT_EQ(50, myHistogram.percentile(0.5));
+  ASSERT_EQ(99, myHistogram.percentile(0.99));
+  ASSERT_EQ(100, myHistogram.percentile(1));
+
+  // large values have a bounded relative error
+  for (std::uint64_t myValue = 129; myValue < 1e15; myValue = myValue * 1.37) {
+    LatencyHistogram mySingle(7);
+    mySingle.record(myValue, 3);
+    mySingle.record(myValue * 2);
+    ASSERT_EQ(4, mySingle.count());
+    const auto myEstimate = mySingle.percentile(0.5);
+    ASSERT_GE(myEstimate, myValue);
+    ASSERT_LE(static_cast<double>(myEstimate - myValue), myValue / 64.0);
+  }
+  LatencyHistogram myOther(7);
+  myOther.record(1000);
+  myOther.record(1001);
+  const auto myValue = myOther.percentile(0.4);
+  ASSERT_GE(myValue, 1000);
+  ASSERT_LE(std::abs(static_cast<double>(myValue) - 1000), 1000.0 / 64);
+
+  // extreme values
+  LatencyHistogram myExtreme(7);
+  myExtreme.record(std::numeric_limits<std::uint64_t>::max());
+  myExtreme.record(0);
+  ASSERT_EQ(0, myExtreme.percentile(0.5));
+  ASSERT_EQ(std::numeric_limits<std::uint64_t>::max(),
+            myExtreme.percentile(1));
+
+  // merge
+  ASSERT_THROW(myHistogram.merge(LatencyHistogram(8)), std::runtime_error);
+  myHistogram.merge(myOther);
+  ASSERT_EQ(102, myHistogram.count());
+  ASSERT_EQ(1, myHistogram.min());
+  ASSERT_EQ(1001, myHistogram.max());
+  ASSERT_EQ(100, myHistogram.percentile(0.98));
+  myHistogram.merge(LatencyHistogram(7));
+  ASSERT_EQ(102, myHistogram.count());
+  ASSERT_EQ(1, myHistogram.min());
+}
+
+TEST_F(TestLatencyHistogram, test_decision_latencies) {
+  using Decision = DecisionLatencies::Decision;
+  ASSERT_THROW(DecisionLatencies({}), std::runtime_error);
+
+  DecisionLatencies myLatencies({"low", "high"});
+  myLatencies.record(Decision::Admission, 0, 10);
+  myLatencies.record(Decision::Admission, 1, 20);
+  myLatencies.record(Decision::Admission, 1, 30);
+  myLatencies.record(Decision::Release, 1, 5);
+  ASSERT_THROW(myLatencies.record(Decision::Release, 2, 5),
+               std::runtime_error);
+  ASSERT_EQ(1, myLatencies(Decision::Admission, 0).count());
+  ASSERT_EQ(2, myLatencies(Decision::Admission, 1).count());
+  ASSERT_EQ(0, myLatencies(Decision::Release, 0).count());
+  ASSERT_EQ(1, myLatencies(Decision::Release, 1).count());
+  ASSERT_THROW(myLatencies(Decision::Release, 2), std::runtime_error);
+
+  ASSERT_THROW(myLatencies.merge(DecisionLatencies({"low"})),
+               std::runtime_error);
+  myLatencies.merge(myLatencies);
+  ASSERT_EQ(4, myLatencies(Decision::Admission, 1).count());
+
+  std::stringstream myStream;
+  myLatencies.toCsv(myStream);
+  ASSERT_EQ("decision,class,count,min-ns,mean-ns,p50-ns,p90-ns,p99-ns,"
+            "p999-ns,p9999-ns,max-ns\n"
+            "admission,low,2,10,10,10,10,10,10,10,10\n"
+            "admission,high,4,20,25,20,30,30,30,30,30\n"
+            "admission,all,6,10,20,20,30,30,30,30,30\n"
+            "release,low,0,0,0,0,0,0,0,0,0\n"
+            "release,high,2,5,5,5,5,5,5,5,5\n"
+            "release,all,2,5,5,5,5,5,5,5,5\n",
+            myStream.str());
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,275 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/lockstepnetwork.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestLockstepNetwork : public ::testing::Test {
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3   all weights are 4, except 0->4 which is 1
+  //  \              ^
+  //   \---> 4 ------+
+  CapacityNetwork::WeightVector exampleEdgeWeights(const double aScale) {
+    return CapacityNetwork::WeightVector({
+        {0, 1, 4 * aScale},
+        {1, 2, 4 * aScale},
+        {2, 3, 4 * aScale},
+        {0, 4, 1 * aScale},
+        {4, 3, 4 * aScale},
+    });
+  }
+
+  // bidirectional grid with aSize x aSize nodes
+  CapacityNetwork::EdgeVector gridEdges(const unsigned long aSize) {
+    CapacityNetwork::EdgeVector ret;
+    for (unsigned long i = 0; i < aSize; i++) {
+      for (unsigned long j = 0; j < aSize; j++) {
+        if (j + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, i * aSize + j + 1);
+        }
+        if (i + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, (i + 1) * aSize + j);
+        }
+      }
+    }
+    return ret;
+  }
+
+  // each lane must take the same decisions as a stand-alone network
+  void checkSameAsCapacityNetwork(const CapacityNetwork::EdgeVector& aEdges) {
+    const std::size_t N = 5;
+
+    std::vector<std::unique_ptr<CapacityNetwork>> myReference;
+    std::vector<CapacityNetwork::WeightVector>    myWeights;
+    for (std::size_t l = 0; l < N; l++) {
+      support::UniformRv myWeightRv(1, 10, l, 0, 0);
+      myReference.emplace_back(
+          std::make_unique<CapacityNetwork>(aEdges, myWeightRv, true));
+      myReference.back()->measurementProbability(0.9);
+      myWeights.emplace_back(myReference.back()->weights());
+    }
+    LockstepNetwork myNetwork(myWeights);
+    myNetwork.measurementProbability(0.9);
+
+    struct Admitted {
+      unsigned long              theSrc;
+      std::vector<unsigned long> thePath;
+      double                     theGrossRate;
+    };
+    std::vector<std::list<Admitted>> myAdmitted(N);
+
+    support::UniformIntRv<unsigned long> myNodeRv(
+        0, myNetwork.numNodes() - 1, 42, 0, 0);
+    support::UniformRv myRateRv(0.5, 4, 42, 1, 0);
+    support::UniformRv myCoinRv(0, 1, 42, 2, 0);
+    const auto         myCheck = [](const std::size_t aLane,
+                                const auto&       aFlow) {
+      return aFlow.thePath.size() <= 4 + aLane;
+    };
+    std::size_t myNumAdmitted = 0;
+    std::size_t myNumRerouted = 0;
+    for (std::size_t i = 0; i < 500; i++) {
+      // some lanes share the same src/dst pair
+      const auto mySharedSrc = myNodeRv();
+      const auto mySharedDst = (mySharedSrc + 1 + myNodeRv() % 35) % 36;
+
+      std::vector<std::optional<CapacityNetwork::FlowDescriptor>> myFlows(N);
+      for (std::size_t l = 0; l < N; l++) {
+        if (myCoinRv() < 0.2) {
+          continue;
+        }
+        if (myCoinRv() < 0.5) {
+          myFlows[l].emplace(mySharedSrc, mySharedDst, myRateRv());
+        } else {
+          const auto mySrc = myNodeRv();
+          myFlows[l].emplace(
+              mySrc, (mySrc + 1 + myNodeRv() % 35) % 36, myRateRv());
+        }
+      }
+      myNetwork.route(myFlows, myCheck);
+
+      for (std::size_t l = 0; l < N; l++) {
+        if (not myFlows[l]) {
+          continue;
+        }
+        std::vector<CapacityNetwork::FlowDescriptor> myExpected(
+            {{myFlows[l]->theSrc, myFlows[l]->theDst, myFlows[l]->theNetRate}});
+        myReference[l]->route(myExpected, [&myCheck, l](const auto& aFlow) {
+          return myCheck(l, aFlow);
+        });
+        ASSERT_EQ(myExpected[0].thePath, myFlows[l]->thePath);
+        ASSERT_EQ(myExpected[0].theGrossRate, myFlows[l]->theGrossRate);
+        ASSERT_EQ(myExpected[0].theDijsktra, myFlows[l]->theDijsktra);
+        if (not myFlows[l]->thePath.empty()) {
+          myNumAdmitted++;
+          myNumRerouted += myFlows[l]->theDijsktra > 1 ? 1 : 0;
+          myAdmitted[l].emplace_back(Admitted{myFlows[l]->theSrc,
+                                              myFlows[l]->thePath,
+                                              myFlows[l]->theGrossRate});
+        }
+
+        // release the oldest flow from time to time
+        if (not myAdmitted[l].empty() and myCoinRv() < 0.4) {
+          const auto& myOldest = myAdmitted[l].front();
+          myNetwork.addCapacityToPath(
+              l, myOldest.theSrc, myOldest.thePath, myOldest.theGrossRate);
+          myReference[l]->addCapacityToPath(
+              myOldest.theSrc, myOldest.thePath, myOldest.theGrossRate);
+          myAdmitted[l].pop_front();
+        }
+      }
+
+      const auto myTotalCapacity = myNetwork.totalCapacity();
+      for (std::size_t l = 0; l < N; l++) {
+        ASSERT_FLOAT_EQ(myReference[l]->totalCapacity(), myTotalCapacity[l]);
+      }
+    }
+
+    // make sure that all the code paths have been exercised
+    ASSERT_GT(myNumAdmitted, 0);
+    ASSERT_GT(myNumRerouted, 0);
+
+  }
+};
+
+TEST_F(TestLockstepNetwork, test_ctor) {
+  ASSERT_THROW(LockstepNetwork({}), std::runtime_error);
+
+  auto myDifferentSize = exampleEdgeWeights(1);
+  myDifferentSize.pop_back();
+  ASSERT_THROW(LockstepNetwork({exampleEdgeWeights(1), myDifferentSize}),
+               std::runtime_error);
+
+  auto myDifferentEdge            = exampleEdgeWeights(1);
+  std::get<1>(myDifferentEdge[0]) = 2;
+  ASSERT_THROW(LockstepNetwork({exampleEdgeWeights(1), myDifferentEdge}),
+               std::runtime_error);
+
+  auto myDuplicate = exampleEdgeWeights(1);
+  myDuplicate.emplace_back(myDuplicate.front());
+  ASSERT_THROW(LockstepNetwork({myDuplicate}), std::runtime_error);
+
+  LockstepNetwork myNetwork(
+      {exampleEdgeWeights(1), exampleEdgeWeights(2), exampleEdgeWeights(3)});
+  ASSERT_EQ(3, myNetwork.numLanes());
+  ASSERT_EQ(5, myNetwork.numNodes());
+  ASSERT_EQ(5, myNetwork.numEdges());
+  ASSERT_EQ(std::vector<double>({17, 34, 51}), myNetwork.totalCapacity());
+  ASSERT_EQ(34, myNetwork.totalCapacity(1));
+  ASSERT_THROW(myNetwork.totalCapacity(3), std::runtime_error);
+  ASSERT_EQ(std::vector<double>({10, 8, 8, 0, 8}), myNetwork.nodeCapacities(1));
+  ASSERT_THROW(myNetwork.nodeCapacities(3), std::runtime_error);
+
+  ASSERT_EQ(2, myNetwork.hops(0, 3));
+  ASSERT_EQ(0, myNetwork.hops(1, 4)); // not reachable
+  ASSERT_EQ(1, myNetwork.hops(4, 3));
+  ASSERT_EQ(2, myNetwork.diameter());
+  ASSERT_THROW(myNetwork.hops(0, 5), std::runtime_error);
+
+  ASSERT_THROW(myNetwork.measurementProbability(1.1), std::runtime_error);
+  myNetwork.measurementProbability(0.5);
+  ASSERT_EQ(0.5, myNetwork.measurementProbability());
+}
+
+TEST_F(TestLockstepNetwork, test_route_flows) {
+  LockstepNetwork myNetwork({exampleEdgeWeights(1), exampleEdgeWeights(2)});
+
+  // invalid requests
+  std::vector<std::optional<CapacityNetwork::FlowDescriptor>> myFlows(1);
+  ASSERT_THROW(myNetwork.route(myFlows), std::runtime_error);
+  myFlows.resize(2);
+  myFlows[1].emplace(0, 0, 1);
+  ASSERT_THROW(myNetwork.route(myFlows), std::runtime_error);
+  myFlows[1].emplace(0, 5, 1);
+  ASSERT_THROW(myNetwork.route(myFlows), std::runtime_error);
+  myFlows[1].emplace(0, 3, 0);
+  ASSERT_THROW(myNetwork.route(myFlows), std::runtime_error);
+
+  // 0->4->3 is the shortest path in both lanes, but it is feasible only in
+  // the second lane
+  myFlows[0].emplace(0, 3, 1.5);
+  myFlows[1].emplace(0, 3, 1.5);
+  myNetwork.route(myFlows);
+  ASSERT_EQ(std::vector<unsigned long>({1, 2, 3}), myFlows[0]->thePath);
+  ASSERT_EQ(2, myFlows[0]->theDijsktra);
+  ASSERT_EQ(std::vector<unsigned long>({4, 3}), myFlows[1]->thePath);
+  ASSERT_EQ(1, myFlows[1]->theDijsktra);
+  ASSERT_EQ(std::vector<double>({17 - 4.5, 34 - 3}),
+            myNetwork.totalCapacity());
+
+  // no path from 3, one lane only, rejected by the check function
+  myFlows[0].emplace(3, 0, 1);
+  myFlows[1].reset();
+  myNetwork.route(myFlows);
+  ASSERT_TRUE(myFlows[0]->thePath.empty());
+  ASSERT_EQ(1, myFlows[0]->theDijsktra);
+  myFlows[0].emplace(0, 2, 1);
+  myNetwork.route(myFlows, [](const auto, const auto&) { return false; });
+  ASSERT_TRUE(myFlows[0]->thePath.empty());
+  ASSERT_FALSE(myFlows[1]);
+
+  // release the capacity
+  myNetwork.addCapacityToPath(0, 0, {1, 2, 3}, 1.5);
+  myNetwork.addCapacityToPath(1, 0, {4, 3}, 1.5);
+  ASSERT_EQ(std::vector<double>({17, 34}), myNetwork.totalCapacity());
+  ASSERT_THROW(myNetwork.addCapacityToPath(0, 0, {2}, 1), std::runtime_error);
+  ASSERT_THROW(myNetwork.addCapacityToPath(2, 0, {1}, 1), std::runtime_error);
+}
+
+TEST_F(TestLockstepNetwork, test_same_as_capacity_network) {
+  checkSameAsCapacityNetwork(gridEdges(6));
+}
+
+TEST_F(TestLockstepNetwork, test_same_as_capacity_network_edge_order) {
+  // the edges are added in an order different from that of the nodes, which
+  // changes the paths chosen among those with the same number of hops
+  auto myEdges = gridEdges(6);
+  std::reverse(myEdges.begin(), myEdges.end());
+  std::rotate(myEdges.begin(), myEdges.begin() + 7, myEdges.end());
+  checkSameAsCapacityNetwork(myEdges);
+}
+
+} // namespace qr
+} // namespace uiiit
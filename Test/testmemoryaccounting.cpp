@@ -0,0 +1,170 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/memoryaccounting.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestMemoryAccounting : public ::testing::Test {
+  static std::size_t index(const MemoryUsage::Subsystem aSubsystem) {
+    return static_cast<std::size_t>(aSubsystem);
+  }
+};
+
+TEST_F(TestMemoryAccounting, test_usage) {
+  MemoryUsage myUsage;
+  ASSERT_EQ(2 + 2 * MemoryUsage::NUM_SUBSYSTEMS, MemoryUsage::names().size());
+  ASSERT_EQ("0,0,0,0,0,0,0,0,0,0,0,0", myUsage.toCsv());
+
+  ASSERT_EQ(Instrumentation::names().size() + MemoryUsage::names().size(),
+            Instrumentation::names(false, true).size());
+  ASSERT_EQ("bytes-other", Instrumentation::names(true, true).back());
+  Instrumentation myInstrumentation;
+  myInstrumentation.theMemory.emplace();
+  const auto myCsv = myInstrumentation.toCsv();
+  ASSERT_EQ(Instrumentation::names(false, true).size(),
+            std::count(myCsv.begin(), myCsv.end(), ',') + 1);
+}
+
+TEST_F(TestMemoryAccounting, test_accounting) {
+  MemoryUsage myUsage;
+  {
+    MemoryAccounting myAccounting(myUsage);
+    ASSERT_THROW(MemoryAccounting myOther(myUsage), std::runtime_error);
+
+    auto myOther = std::make_unique<std::vector<char>>(100);
+    {
+      MemoryAccounting::Scope myScope(MemoryUsage::Subsystem::Graph);
+      std::vector<char>       myGraph(1000);
+      {
+        MemoryAccounting::Scope myInnerScope(MemoryUsage::Subsystem::Paths);
+        std::vector<char>       myPaths(2000);
+      }
+      std::vector<char> myMoreGraph(3000);
+    }
+  }
+
+  // allocations outside the accounting are ignored
+  std::vector<char> myIgnored(10000);
+
+  // the blocks allocated may be slightly larger than requested
+  ASSERT_EQ(2, myUsage.theAllocations[index(MemoryUsage::Subsystem::Graph)]);
+  ASSERT_LE(4000, myUsage.theBytes[index(MemoryUsage::Subsystem::Graph)]);
+  ASSERT_GT(4100, myUsage.theBytes[index(MemoryUsage::Subsystem::Graph)]);
+  ASSERT_EQ(1, myUsage.theAllocations[index(MemoryUsage::Subsystem::Paths)]);
+  ASSERT_LE(2000, myUsage.theBytes[index(MemoryUsage::Subsystem::Paths)]);
+  ASSERT_GT(2100, myUsage.theBytes[index(MemoryUsage::Subsystem::Paths)]);
+  ASSERT_EQ(0,
+            myUsage.theAllocations[index(MemoryUsage::Subsystem::Descriptors)]);
+  // also the message of the exception above
+  ASSERT_LE(2, myUsage.theAllocations[index(MemoryUsage::Subsystem::Other)]);
+  ASSERT_LE(100 + sizeof(std::vector<char>),
+            myUsage.theBytes[index(MemoryUsage::Subsystem::Other)]);
+#ifdef __GLIBC__
+  // the vectors of 1000 and 2000 bytes are alive at the same time
+  ASSERT_LE(3000, myUsage.theHeapPeak);
+  ASSERT_GT(6000, myUsage.theHeapPeak);
+#endif
+  ASSERT_LE(0, myUsage.theRssPeakDelta);
+}
+
+TEST_F(TestMemoryAccounting, test_per_thread) {
+  MemoryUsage myUsage;
+  {
+    MemoryAccounting myAccounting(myUsage);
+
+    // allocations in other threads are ignored, while the accounting can be
+    // active concurrently in another thread
+    MemoryUsage myOtherUsage;
+    std::thread myThread([&myOtherUsage]() {
+      MemoryAccounting  myOtherAccounting(myOtherUsage);
+      std::vector<char> myData(5000);
+    });
+    myThread.join();
+    ASSERT_LE(5000,
+              myOtherUsage.theBytes[index(MemoryUsage::Subsystem::Other)]);
+  }
+  ASSERT_GT(5000, myUsage.theBytes[index(MemoryUsage::Subsystem::Other)]);
+}
+
+TEST_F(TestMemoryAccounting, test_freed_before) {
+  ASSERT_TRUE(MemoryAccounting::enabled());
+
+  // the memory allocated before the accounting started is freed during it
+  auto        myBefore = std::make_unique<std::vector<char>>(10000);
+  MemoryUsage myUsage;
+  {
+    MemoryAccounting        myAccounting(myUsage);
+    MemoryAccounting::Scope myScope(MemoryUsage::Subsystem::Graph);
+    myBefore.reset();
+    std::vector<char> myData(1000);
+  }
+  ASSERT_LE(1000, myUsage.theBytes[index(MemoryUsage::Subsystem::Graph)]);
+#ifdef __GLIBC__
+  ASSERT_LE(1000, myUsage.theHeapPeak);
+  ASSERT_GT(1100, myUsage.theHeapPeak);
+#endif
+}
+
+TEST_F(TestMemoryAccounting, test_graph_copies) {
+  CapacityNetwork::WeightVector myWeights;
+  for (std::size_t i = 0; i < 100; i++) {
+    myWeights.emplace_back(i, (i + 1) % 100, 1.0);
+  }
+  CapacityNetwork myNetwork(myWeights);
+
+  // the graph copied is charged to Graph even within another subsystem
+  MemoryUsage myUsage;
+  {
+    MemoryAccounting        myAccounting(myUsage);
+    MemoryAccounting::Scope myScope(MemoryUsage::Subsystem::Descriptors);
+    auto                    myClone = myNetwork.clone();
+    ASSERT_EQ(myNetwork.numNodes(), myClone->numNodes());
+  }
+  ASSERT_LE(100, myUsage.theAllocations[index(MemoryUsage::Subsystem::Graph)]);
+  ASSERT_GT(
+      myUsage.theBytes[index(MemoryUsage::Subsystem::Graph)],
+      myUsage.theBytes[index(MemoryUsage::Subsystem::Descriptors)]);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,117 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/paramgrid.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestParamGrid : public ::testing::Test {};
+
+TEST_F(TestParamGrid, test_empty) {
+  ParamGrid myGrid({});
+  ASSERT_EQ(1, myGrid.size());
+  ASSERT_EQ(0, myGrid.dimensions());
+  ASSERT_TRUE(myGrid.point(0).empty());
+  ASSERT_TRUE(myGrid.args(0).empty());
+  ASSERT_THROW(myGrid.point(1), std::out_of_range);
+}
+
+TEST_F(TestParamGrid, test_lists_and_ranges) {
+  ParamGrid myGrid({"graphml-file=garr,topo", "arrival-rate=1:2:0.5"});
+  ASSERT_EQ(6, myGrid.size());
+  ASSERT_EQ(2, myGrid.dimensions());
+
+  ASSERT_EQ(ParamGrid::Point({{"graphml-file", "garr"}, {"arrival-rate", "1"}}),
+            myGrid.point(0));
+  ASSERT_EQ(
+      ParamGrid::Point({{"graphml-file", "garr"}, {"arrival-rate", "1.5"}}),
+      myGrid.point(1));
+  ASSERT_EQ(ParamGrid::Point({{"graphml-file", "topo"}, {"arrival-rate", "2"}}),
+            myGrid.point(5));
+  ASSERT_EQ(std::vector<std::string>(
+                {"--graphml-file", "topo", "--arrival-rate", "1"}),
+            myGrid.args(3));
+
+  // ranges include the end value even with inexact steps
+  ASSERT_EQ(11, ParamGrid({"q=0:1:0.1"}).size());
+  ASSERT_EQ("0.3", ParamGrid({"q=0:1:0.1"}).point(3)[0].second);
+
+  // integral ranges are printed as integers, the others without exponent
+  // unless needed
+  ASSERT_EQ("1000000", ParamGrid({"mu=0:1e6:5e5"}).point(2)[0].second);
+  ASSERT_EQ("-2", ParamGrid({"mu=-2:2:1"}).point(0)[0].second);
+  ASSERT_EQ("1000000.5",
+            ParamGrid({"mu=0.5:1000001:1e6"}).point(1)[0].second);
+  ASSERT_EQ("0.123456789012345",
+            ParamGrid({"q=0.123456789012345:1:1"}).point(0)[0].second);
+}
+
+TEST_F(TestParamGrid, test_filename) {
+  ParamGrid myGrid({"mu=40,60", "q=0.5"});
+  ASSERT_EQ("out-60-0.5-60.csv",
+            ParamGrid::filename("out-{mu}-{q}-{mu}.csv", myGrid.point(1)));
+  ASSERT_EQ("out.csv", ParamGrid::filename("out.csv", myGrid.point(1)));
+  ASSERT_EQ("out-{k}.csv", ParamGrid::filename("out-{k}.csv", myGrid.point(0)));
+}
+
+TEST_F(TestParamGrid, test_invalid) {
+  ASSERT_THROW(ParamGrid({"mu"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"=1,2"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu="}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1,,2"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1,2", "mu=3"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1:2"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1:a:2"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=2:1:1"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1:2:0"}), std::runtime_error);
+
+  // non-finite or too large ranges
+  ASSERT_THROW(ParamGrid({"mu=nan:2:1"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1:inf:1"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=1:2:nan"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=0:1e9:1"}), std::runtime_error);
+  ASSERT_THROW(ParamGrid({"mu=0:1:1e-300"}), std::runtime_error);
+  ASSERT_EQ(ParamGrid::MAX_RANGE_VALUES,
+            ParamGrid({"mu=1:" + std::to_string(ParamGrid::MAX_RANGE_VALUES) +
+                       ":1"})
+                .size());
+  ASSERT_THROW(ParamGrid({"mu=0:" +
+                          std::to_string(ParamGrid::MAX_RANGE_VALUES) + ":1"}),
+               std::runtime_error);
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,110 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/instrumentation.h"
+#include "QuantumRouting/perfcounters.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <stdexcept>
+
+namespace uiiit {
+namespace qr {
+
+struct TestPerfCounters : public ::testing::Test {};
+
+TEST_F(TestPerfCounters, test_sample) {
+  PerfCounters::Sample myFirst;
+  myFirst.theCycles       = 10;
+  myFirst.theInstructions = 20;
+  myFirst.theLlcMisses    = 3;
+  myFirst.theBranchMisses = 4;
+  auto mySecond           = myFirst;
+  mySecond += myFirst;
+  ASSERT_EQ("20,40,6,8", mySecond.toCsv());
+  ASSERT_EQ("10,20,3,4", (mySecond - myFirst).toCsv());
+  ASSERT_EQ(4, PerfCounters::Sample::names().size());
+}
+
+TEST_F(TestPerfCounters, test_read) {
+  std::unique_ptr<PerfCounters> myCounters;
+  try {
+    myCounters = std::make_unique<PerfCounters>();
+  } catch (const std::runtime_error& aErr) {
+    GTEST_SKIP() << aErr.what();
+  }
+
+  const auto      myBefore = myCounters->read();
+  volatile double mySum    = 0;
+  for (auto i = 0; i < 100000; i++) {
+    mySum = mySum + i;
+  }
+  const auto myAfter = myCounters->read();
+  ASSERT_GT(myAfter.theCycles, myBefore.theCycles);
+  ASSERT_GT(myAfter.theInstructions, myBefore.theInstructions + 100000);
+}
+
+TEST_F(TestPerfCounters, test_phase_timers) {
+  ASSERT_EQ(PhaseTimers::NUM_PHASES *
+                (1 + PerfCounters::Sample::names().size()),
+            PhaseTimers::names(true).size());
+  ASSERT_EQ("cycles-topology",
+            PhaseTimers::names(true)[PhaseTimers::NUM_PHASES]);
+  ASSERT_EQ("branch-misses-statistics", PhaseTimers::names(true).back());
+  ASSERT_EQ(PhaseTimers::names(true).size() + WorkCounters::names().size(),
+            Instrumentation::names(true).size());
+
+  std::shared_ptr<PerfCounters> myCounters;
+  try {
+    myCounters = std::make_shared<PerfCounters>();
+  } catch (const std::runtime_error& aErr) {
+    GTEST_SKIP() << aErr.what();
+  }
+
+  PhaseTimers myTimers;
+  ASSERT_FALSE(myTimers.hasPerfCounters());
+  myTimers.perfCounters(myCounters);
+  ASSERT_TRUE(myTimers.hasPerfCounters());
+  {
+    PhaseTimers::Scope myScope(&myTimers, PhaseTimers::Phase::Routing);
+    volatile double mySum = 0;
+    for (auto i = 0; i < 100000; i++) {
+      mySum = mySum + i;
+    }
+  }
+  ASSERT_LT(100000,
+            myTimers.sample(PhaseTimers::Phase::Routing).theInstructions);
+  ASSERT_EQ(0, myTimers.sample(PhaseTimers::Phase::Topology).theInstructions);
+}
+
+} // namespace qr
+} // namespace uiiit
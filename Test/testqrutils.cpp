@@ -160,6 +160,30 @@ TEST_F(TestQrUtils, test_fidelity_swapping) {
   ASSERT_FLOAT_EQ(0.279446282739145, fidelitySwapping(0.9, 0.5, 0.95, 4, 0.98));
 }
 
+TEST_F(TestQrUtils, test_power_table) {
+  const PowerTable myTable(0.5, 4);
+  ASSERT_EQ(4, myTable.size());
+  ASSERT_EQ(0.5, myTable.base());
+  for (std::size_t n = 0; n < 10; n++) {
+    ASSERT_EQ(std::pow(0.5, n), myTable(n)) << "n = " << n;
+  }
+
+  const PowerTable myEmpty;
+  ASSERT_EQ(0, myEmpty.size());
+  ASSERT_EQ(1, myEmpty(0));
+  ASSERT_EQ(1, myEmpty(42));
+}
+
+TEST_F(TestQrUtils, test_fidelity_table) {
+  const FidelityTable myTable(0.9, 0.5, 0.95, 0.98, 3);
+  ASSERT_EQ(3, myTable.size());
+  for (unsigned long L = 0; L < 10; L++) {
+    ASSERT_EQ(fidelitySwapping(0.9, 0.5, 0.95, L, 0.98), myTable(L))
+        << "L = " << L;
+  }
+  ASSERT_FLOAT_EQ(0.279446282739145, myTable(4));
+}
+
 TEST_F(TestQrUtils, DISABLED_print_fidelity_per_hops) {
   constexpr double p1  = 1.0;
   constexpr double p2  = 1.0;
@@ -0,0 +1,212 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/rcu.h"
+#include "Support/random.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace uiiit {
+namespace qr {
+
+struct TestRcu : public ::testing::Test {
+  //! Object that keeps track of the number of instances alive.
+  struct Counted {
+    explicit Counted(const int aValue)
+        : theValue(aValue) {
+      ++theAlive;
+    }
+    ~Counted() {
+      --theAlive;
+    }
+    const int          theValue;
+    static std::size_t theAlive;
+  };
+
+  void SetUp() {
+    Counted::theAlive = 0;
+  }
+
+  // bidirectional grid with aSize x aSize nodes
+  CapacityNetwork::EdgeVector gridEdges(const unsigned long aSize) {
+    CapacityNetwork::EdgeVector ret;
+    for (unsigned long i = 0; i < aSize; i++) {
+      for (unsigned long j = 0; j < aSize; j++) {
+        if (j + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, i * aSize + j + 1);
+        }
+        if (i + 1 < aSize) {
+          ret.emplace_back(i * aSize + j, (i + 1) * aSize + j);
+        }
+      }
+    }
+    return ret;
+  }
+};
+
+std::size_t TestRcu::Counted::theAlive = 0;
+
+TEST_F(TestRcu, test_reclaim) {
+  ASSERT_THROW(Rcu<Counted>(nullptr), std::runtime_error);
+
+  {
+    Rcu<Counted> myRcu(std::make_unique<const Counted>(0), 2);
+    ASSERT_THROW(myRcu.publish(nullptr), std::runtime_error);
+    ASSERT_EQ(1, Counted::theAlive);
+
+    auto myReader = myRcu.reader();
+    {
+      auto myGuard = myReader->read();
+      ASSERT_EQ(0, myGuard->theValue);
+      ASSERT_EQ(0, myGuard.version());
+
+      // the version being read is kept until the end of the read section
+      ASSERT_EQ(1, myRcu.publish(std::make_unique<const Counted>(1)));
+      ASSERT_EQ(2, myRcu.publish(std::make_unique<const Counted>(2)));
+      ASSERT_EQ(0, (*myGuard).theValue);
+      ASSERT_EQ(2, myRcu.reclaim());
+      ASSERT_EQ(3, Counted::theAlive);
+      ASSERT_EQ(2, myRcu.current().theValue);
+    }
+    ASSERT_EQ(0, myRcu.reclaim());
+    ASSERT_EQ(1, Counted::theAlive);
+
+    // a read section started after a publish does not keep the old version
+    {
+      auto myGuard = myReader->read();
+      ASSERT_EQ(2, myGuard->theValue);
+      ASSERT_EQ(2, myGuard.version());
+      ASSERT_EQ(3, myRcu.publish(std::make_unique<const Counted>(3)));
+      ASSERT_EQ(1, myRcu.reclaim());
+      auto myAnotherReader = myRcu.reader();
+      auto myAnotherGuard  = myAnotherReader->read();
+      ASSERT_EQ(3, myAnotherGuard->theValue);
+    }
+    ASSERT_EQ(0, myRcu.reclaim());
+
+    // the number of readers is limited
+    auto myAnotherReader = myRcu.reader();
+    ASSERT_THROW(myRcu.reader(), std::runtime_error);
+    myAnotherReader.reset();
+    ASSERT_NO_THROW(myRcu.reader());
+
+    // the old versions still kept are deleted on destruction
+    auto myGuard = myReader->read();
+    myRcu.publish(std::make_unique<const Counted>(4));
+    ASSERT_EQ(2, Counted::theAlive);
+  }
+  ASSERT_EQ(0, Counted::theAlive);
+}
+
+TEST_F(TestRcu, test_network_snapshots) {
+  // the writer admits and releases flows and publishes a snapshot of the
+  // network after each of them, while the readers check that every snapshot
+  // is consistent with the total capacity expected for its version
+  support::UniformRv  myWeightRv(1, 10, 42, 0, 0);
+  CapacityNetwork     myNetwork(gridEdges(5), myWeightRv, true);
+  const std::size_t   N = 2000;
+  std::vector<double> myExpected(N + 1);
+  myExpected[0] = myNetwork.totalCapacity();
+
+  Rcu<CapacityNetwork>     myRcu(myNetwork.clone());
+  std::atomic<bool>        myDone(false);
+  std::vector<std::thread> myReaders;
+  std::vector<std::size_t> myNumReads(3, 0);
+  for (std::size_t r = 0; r < myNumReads.size(); r++) {
+    myReaders.emplace_back([&, r]() {
+      auto          myReader      = myRcu.reader();
+      std::uint64_t myLastVersion = 0;
+      while (not myDone.load()) {
+        auto myGuard = myReader->read();
+        ASSERT_GE(myGuard.version(), myLastVersion);
+        myLastVersion = myGuard.version();
+
+        const auto myCapacities = myGuard->nodeCapacities();
+        const auto myTotal      = myGuard->totalCapacity();
+        ASSERT_FLOAT_EQ(myExpected[myGuard.version()], myTotal);
+        ASSERT_FLOAT_EQ(myTotal,
+                        std::accumulate(
+                            myCapacities.begin(), myCapacities.end(), 0.0));
+        if (myNumReads[r] % 100 == 0) {
+          std::size_t  myDiameter = 0;
+          WorkCounters myCounters;
+          myGuard->reachableNodes(1, 100, myDiameter, myCounters);
+          ASSERT_EQ(8, myDiameter);
+          ASSERT_GT(myCounters.theVerticesSettled, 0);
+        }
+        myNumReads[r]++;
+      }
+    });
+  }
+
+  support::UniformIntRv<unsigned long> myNodeRv(
+      0, myNetwork.numNodes() - 1, 42, 0, 0);
+  std::list<CapacityNetwork::FlowDescriptor> myAdmitted;
+  for (std::size_t i = 1; i <= N; i++) {
+    if (i % 3 == 0 and not myAdmitted.empty()) {
+      const auto& myOldest = myAdmitted.front();
+      myNetwork.addCapacityToPath(
+          myOldest.theSrc, myOldest.thePath, myOldest.theGrossRate);
+      myAdmitted.pop_front();
+    } else {
+      const auto mySrc = myNodeRv();
+      std::vector<CapacityNetwork::FlowDescriptor> myFlows(
+          {{mySrc, (mySrc + 1 + myNodeRv() % 24) % 25, 1}});
+      myNetwork.route(myFlows);
+      if (not myFlows[0].thePath.empty()) {
+        myAdmitted.emplace_back(myFlows[0]);
+      }
+    }
+    myExpected[i] = myNetwork.totalCapacity();
+    ASSERT_EQ(i, myRcu.publish(myNetwork.clone()));
+  }
+  myDone.store(true);
+  for (auto& myReader : myReaders) {
+    myReader.join();
+  }
+
+  LOG(INFO) << "reads " << ::testing::PrintToString(myNumReads);
+  ASSERT_EQ(0, myRcu.reclaim());
+  ASSERT_FLOAT_EQ(myNetwork.totalCapacity(), myRcu.current().totalCapacity());
+  ASSERT_EQ(myNetwork.weights(), myRcu.current().weights());
+}
+
+} // namespace qr
+} // namespace uiiit
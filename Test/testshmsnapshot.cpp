@@ -0,0 +1,176 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/capacitynetwork.h"
+#include "QuantumRouting/shmsnapshot.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace uiiit {
+namespace qr {
+
+struct TestShmSnapshot : public ::testing::Test {
+  TestShmSnapshot()
+      : theName("/qr-test-shm-snapshot-" + std::to_string(::getpid())) {
+    // noop
+  }
+
+  //   /--> 1 -- >2 -+
+  //  /              v
+  // 0               3   all weights are 4, except 0->4 which is 1
+  //  \              ^
+  //   \---> 4 ------+
+  static CapacityNetwork::WeightVector exampleEdgeWeights() {
+    return CapacityNetwork::WeightVector({
+        {0, 1, 4},
+        {1, 2, 4},
+        {2, 3, 4},
+        {0, 4, 1},
+        {4, 3, 4},
+    });
+  }
+
+  const std::string theName;
+};
+
+TEST_F(TestShmSnapshot, test_publish_read) {
+  ASSERT_THROW(ShmSnapshotReader myReader(theName), std::runtime_error);
+
+  CapacityNetwork   myNetwork(exampleEdgeWeights());
+  ShmSnapshotWriter myWriter(theName, 6);
+  ShmSnapshotReader myReader(theName);
+
+  // the object of a writer is not replaced by another one
+  ASSERT_THROW(ShmSnapshotWriter(theName, 6), std::runtime_error);
+
+  ShmSnapshotReader::Snapshot mySnapshot;
+  ASSERT_EQ(0, myReader.version());
+  ASSERT_FALSE(myReader.read(mySnapshot));
+
+  ASSERT_EQ(1, myWriter.publish(myNetwork));
+  ASSERT_EQ(1, myReader.version());
+  ASSERT_TRUE(myReader.read(mySnapshot));
+  ASSERT_EQ(1, mySnapshot.theVersion);
+  ASSERT_EQ(1, mySnapshot.theTopologyVersion);
+  ASSERT_EQ(5, mySnapshot.theNumNodes);
+  const auto myWeights = myNetwork.weights();
+  ASSERT_EQ(myWeights.size(), mySnapshot.theEdges.size());
+  ASSERT_EQ(myWeights.size(), mySnapshot.theCapacities.size());
+  for (std::size_t i = 0; i < myWeights.size(); i++) {
+    ASSERT_EQ(std::get<0>(myWeights[i]), mySnapshot.theEdges[i].first);
+    ASSERT_EQ(std::get<1>(myWeights[i]), mySnapshot.theEdges[i].second);
+    ASSERT_EQ(std::get<2>(myWeights[i]), mySnapshot.theCapacities[i]);
+  }
+
+  // only the capacities change
+  std::vector<CapacityNetwork::FlowDescriptor> myFlows({{0, 3, 1}});
+  myNetwork.route(myFlows);
+  ASSERT_EQ(2, myWriter.publish(myNetwork));
+  ASSERT_TRUE(myReader.read(mySnapshot));
+  ASSERT_EQ(2, mySnapshot.theVersion);
+  ASSERT_EQ(1, mySnapshot.theTopologyVersion);
+  ASSERT_EQ(std::vector<double>({4, 4, 4, 0, 3}), mySnapshot.theCapacities);
+
+  // the topology changes, too
+  using Delta = CapacityNetwork::TopologyDelta;
+  myNetwork.applyTopologyDeltas({Delta::addEdge(3, 0, 2)});
+  ASSERT_EQ(3, myWriter.publish(myNetwork));
+  ASSERT_TRUE(myReader.read(mySnapshot));
+  ASSERT_EQ(2, mySnapshot.theTopologyVersion);
+  ASSERT_EQ(6, mySnapshot.theEdges.size());
+  ASSERT_EQ(std::vector<double>({4, 4, 4, 0, 3, 2}), mySnapshot.theCapacities);
+
+  // too many edges
+  myNetwork.applyTopologyDeltas({Delta::addEdge(3, 1, 2)});
+  ASSERT_THROW(myWriter.publish(myNetwork), std::runtime_error);
+  ASSERT_EQ(3, myReader.version());
+}
+
+TEST_F(TestShmSnapshot, test_concurrent) {
+  // the writer changes the capacities of all the edges by the same amount
+  // before publishing, hence all the capacities in a consistent snapshot are
+  // the same
+  CapacityNetwork::WeightVector myEdges;
+  for (unsigned long i = 0; i < 1000; i++) {
+    myEdges.emplace_back(i, (i + 1) % 1000, 0);
+  }
+  CapacityNetwork   myNetwork(myEdges);
+  ShmSnapshotWriter myWriter(theName, myEdges.size());
+  myWriter.publish(myNetwork);
+
+  auto myIncrease = myEdges;
+  for (auto& elem : myIncrease) {
+    std::get<2>(elem) = 1;
+  }
+
+  std::atomic<bool>        myDone(false);
+  std::vector<std::thread> myReaders;
+  std::vector<std::size_t> myNumReads(2, 0);
+  for (std::size_t r = 0; r < myNumReads.size(); r++) {
+    myReaders.emplace_back([&, r]() {
+      ShmSnapshotReader           myReader(theName);
+      ShmSnapshotReader::Snapshot mySnapshot;
+      std::uint64_t               myLastVersion = 0;
+      do {
+        ASSERT_TRUE(myReader.read(mySnapshot));
+        ASSERT_GE(mySnapshot.theVersion, myLastVersion);
+        myLastVersion = mySnapshot.theVersion;
+        ASSERT_EQ(1, mySnapshot.theTopologyVersion);
+        ASSERT_EQ(myEdges.size(), mySnapshot.theCapacities.size());
+        for (const auto myCapacity : mySnapshot.theCapacities) {
+          ASSERT_EQ(mySnapshot.theVersion - 1, myCapacity);
+        }
+        myNumReads[r]++;
+      } while (not myDone.load());
+    });
+  }
+
+  for (std::size_t i = 0; i < 2000; i++) {
+    myNetwork.applyCapacityDeltas(myIncrease);
+    myWriter.publish(myNetwork);
+  }
+  myDone.store(true);
+  for (auto& myReader : myReaders) {
+    myReader.join();
+  }
+  LOG(INFO) << "snapshots read: " << myNumReads[0] << ", " << myNumReads[1];
+}
+
+} // namespace qr
+} // namespace uiiit
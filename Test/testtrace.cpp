@@ -0,0 +1,174 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/trace.h"
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace uiiit {
+namespace qr {
+
+struct TestTrace : public ::testing::Test {
+  void SetUp() override {
+    Trace::clear();
+    Trace::enable(true);
+  }
+  void TearDown() override {
+    Trace::enable(false);
+    Trace::clear();
+  }
+
+  static std::vector<std::vector<TraceRecord>> saveAndLoad() {
+    std::stringstream myStream;
+    Trace::save(myStream);
+    return Trace::load(myStream);
+  }
+
+  static std::size_t numRecords() {
+    std::size_t ret = 0;
+    for (const auto& myBuffer : saveAndLoad()) {
+      ret += myBuffer.size();
+    }
+    return ret;
+  }
+};
+
+TEST_F(TestTrace, test_save_load) {
+  Trace::record(TraceEvent::FlowAdmitted, 1, 2, 3, 4.5);
+  Trace::record(TraceEvent::FlowRejected, 6, 7, 8, 9.5);
+
+  const auto myBuffers = saveAndLoad();
+  std::vector<TraceRecord> myRecords;
+  for (const auto& myBuffer : myBuffers) {
+    myRecords.insert(myRecords.end(), myBuffer.begin(), myBuffer.end());
+  }
+  ASSERT_EQ(2, myRecords.size());
+  ASSERT_EQ(static_cast<std::uint32_t>(TraceEvent::FlowAdmitted),
+            myRecords[0].theEvent);
+  ASSERT_EQ(3, myRecords[0].theArgs[2]);
+  ASSERT_EQ(9.5, myRecords[1].theValue);
+  ASSERT_LE(myRecords[0].theTime, myRecords[1].theTime);
+  ASSERT_EQ("flow-rejected", Trace::name(TraceEvent(myRecords[1].theEvent)));
+
+  std::stringstream myInvalid("QRTRACE0");
+  ASSERT_THROW(Trace::load(myInvalid), std::runtime_error);
+  std::stringstream myTruncated(std::string("QRTRACE2\x01", 9));
+  ASSERT_THROW(Trace::load(myTruncated), std::runtime_error);
+}
+
+TEST_F(TestTrace, test_ring_buffer_per_thread) {
+  ASSERT_THROW(Trace::capacity(0), std::runtime_error);
+
+  // the buffer of a new thread has the current capacity, rounded up to 4
+  Trace::capacity(3);
+  std::thread myThread([]() {
+    for (std::uint32_t i = 0; i < 10; i++) {
+      Trace::record(TraceEvent::AppRemoved, i, 0, 0, 0);
+    }
+  });
+  myThread.join();
+  Trace::capacity(1 << 16);
+
+  std::vector<std::uint32_t> myHosts;
+  for (const auto& myBuffer : saveAndLoad()) {
+    for (const auto& myRecord : myBuffer) {
+      myHosts.emplace_back(myRecord.theArgs[0]);
+    }
+  }
+  ASSERT_EQ(std::vector<std::uint32_t>({6, 7, 8, 9}), myHosts);
+}
+
+TEST_F(TestTrace, test_register_thread) {
+  const auto myNumBuffers = saveAndLoad().size();
+
+  // registering creates the buffer once, before any event is recorded
+  std::thread myThread([]() {
+    Trace::registerThread();
+    Trace::registerThread();
+  });
+  myThread.join();
+  ASSERT_EQ(myNumBuffers + 1, saveAndLoad().size());
+  ASSERT_EQ(0, numRecords());
+
+  // nothing is registered if tracing is disabled, nor by enabling it
+  Trace::enable(false);
+  std::thread myDisabled([]() { Trace::registerThread(); });
+  myDisabled.join();
+  std::thread myEnabling([]() { Trace::enable(true); });
+  myEnabling.join();
+  ASSERT_EQ(myNumBuffers + 1, saveAndLoad().size());
+}
+
+TEST_F(TestTrace, test_experiment) {
+  // the records are tagged with the experiment of the thread
+  std::thread myThread([]() {
+    Trace::record(TraceEvent::AppRemoved, 1, 0, 0, 0);
+    Trace::experiment(3, (std::size_t(1) << 32) + 42);
+    Trace::record(TraceEvent::AppRemoved, 2, 0, 0, 0);
+  });
+  myThread.join();
+
+  std::vector<std::vector<std::uint32_t>> myTags;
+  for (const auto& myBuffer : saveAndLoad()) {
+    for (const auto& myRecord : myBuffer) {
+      myTags.push_back(
+          {myRecord.theArgs[0], myRecord.thePoint, myRecord.theSeed});
+    }
+  }
+  ASSERT_EQ(std::vector<std::vector<std::uint32_t>>({{1, 0, 0}, {2, 3, 42}}),
+            myTags);
+}
+
+TEST_F(TestTrace, test_macro) {
+  auto myEvaluated = 0;
+  auto myArg       = [&myEvaluated]() { return ++myEvaluated; };
+
+  // levels above the maximum are never compiled in
+  QR_TRACE(QR_TRACE_LEVEL + 1, AppRemoved, myArg(), 0, 0, 0);
+  ASSERT_EQ(0, myEvaluated);
+  ASSERT_EQ(0, numRecords());
+
+  // levels compiled in are recorded only if enabled at run-time
+  Trace::enable(false);
+  QR_TRACE(QR_TRACE_LEVEL, AppRemoved, myArg(), 0, 0, 0);
+  ASSERT_EQ(0, myEvaluated);
+  Trace::enable(true);
+  QR_TRACE(QR_TRACE_LEVEL, AppRemoved, myArg(), 0, 0, 0);
+  ASSERT_EQ(QR_TRACE_LEVEL > 0 ? 1 : 0, myEvaluated);
+  ASSERT_EQ(QR_TRACE_LEVEL > 0 ? 1 : 0, numRecords());
+}
+
+} // namespace qr
+} // namespace uiiit
@@ -0,0 +1,168 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/workload.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glog/logging.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace uiiit {
+namespace qr {
+
+struct TestWorkload : public ::testing::Test {
+  TestWorkload()
+      : theFilename(
+            (boost::filesystem::current_path() / "workload.bin").string()) {
+    // noop
+  }
+
+  void SetUp() {
+    boost::filesystem::remove(theFilename);
+  }
+
+  void TearDown() {
+    if (not VLOG_IS_ON(1)) {
+      boost::filesystem::remove(theFilename);
+    }
+  }
+
+  const std::string theFilename;
+};
+
+TEST_F(TestWorkload, test_record_replay) {
+  const std::vector<WorkloadEvent> myEvents({
+      {0.0, 1, 2, 0, 1, 3.5},
+      {0.5, 3, 0, 1, 0, 0.25},
+      {2.0, 2, 1, 1, 1, 7.0},
+  });
+
+  {
+    WorkloadWriter myWriter(theFilename, WorkloadHeader::make(4, 2, 2, 42));
+    for (const auto& myEvent : myEvents) {
+      myWriter(myEvent);
+    }
+    ASSERT_EQ(myEvents.size(), myWriter.size());
+  }
+
+  WorkloadReader myReader(theFilename);
+  ASSERT_EQ(4, myReader.header().theNumNodes);
+  ASSERT_EQ(2, myReader.header().theNumNetRates);
+  ASSERT_EQ(2, myReader.header().theNumFidelityThresholds);
+  ASSERT_EQ(42, myReader.header().theSeed);
+  ASSERT_EQ(myEvents.size(), myReader.size());
+  ASSERT_EQ(myEvents,
+            std::vector<WorkloadEvent>(myReader.begin(), myReader.end()));
+  ASSERT_EQ(myEvents[1], myReader[1]);
+
+  ASSERT_NO_THROW(myReader.header().check(4, 2, 2));
+  ASSERT_THROW(myReader.header().check(5, 2, 2), std::runtime_error);
+  ASSERT_THROW(myReader.header().check(4, 1, 2), std::runtime_error);
+  ASSERT_THROW(myReader.header().check(4, 2, 3), std::runtime_error);
+}
+
+TEST_F(TestWorkload, test_replay_callback) {
+  {
+    WorkloadWriter myWriter(theFilename, WorkloadHeader::make(3, 2, 1, 0));
+    myWriter(WorkloadEvent{0.0, 0, 1, 1, 0, 1.0});
+    myWriter(WorkloadEvent{1.0, 2, 0, 0, 0, 2.0});
+  }
+  std::vector<WorkloadEvent> myReplayed;
+  {
+    WorkloadReader myReader(theFilename);
+    ASSERT_EQ(2, myReader.replay([&myReplayed](const WorkloadEvent& aEvent) {
+      myReplayed.emplace_back(aEvent);
+    }));
+    ASSERT_EQ(std::vector<WorkloadEvent>(myReader.begin(), myReader.end()),
+              myReplayed);
+  }
+
+  // the events after an invalid one are not replayed
+  for (const auto& myInvalid : std::vector<WorkloadEvent>({
+           {2.0, 1, 3, 0, 0, 1.0}, // node out of range
+           {2.0, 1, 1, 0, 0, 1.0}, // same source and destination
+           {2.0, 1, 0, 2, 0, 1.0}, // net rate class out of range
+           {2.0, 1, 0, 0, 1, 1.0}, // fidelity class out of range
+       })) {
+    {
+      WorkloadWriter myWriter(theFilename, WorkloadHeader::make(3, 2, 1, 0));
+      myWriter(WorkloadEvent{0.0, 0, 1, 1, 0, 1.0});
+      myWriter(myInvalid);
+      myWriter(WorkloadEvent{3.0, 2, 0, 0, 0, 2.0});
+    }
+    WorkloadReader myReader(theFilename);
+    ASSERT_FALSE(myReader.header().valid(myInvalid));
+    myReplayed.clear();
+    ASSERT_THROW(myReader.replay([&myReplayed](const WorkloadEvent& aEvent) {
+      myReplayed.emplace_back(aEvent);
+    }),
+                 std::runtime_error);
+    ASSERT_EQ(1, myReplayed.size());
+  }
+}
+
+TEST_F(TestWorkload, test_empty) {
+  { WorkloadWriter myWriter(theFilename, WorkloadHeader::make(2, 1, 1, 0)); }
+  WorkloadReader myReader(theFilename);
+  ASSERT_EQ(0, myReader.size());
+  ASSERT_EQ(myReader.begin(), myReader.end());
+}
+
+TEST_F(TestWorkload, test_invalid) {
+  ASSERT_THROW(WorkloadReader myReader(theFilename), std::runtime_error);
+
+  {
+    WorkloadWriter myWriter(theFilename, WorkloadHeader::make(2, 1, 1, 0));
+    myWriter(WorkloadEvent{0.0, 0, 1, 0, 0, 1.0});
+  }
+
+  // truncated event
+  boost::filesystem::resize_file(theFilename,
+                                 boost::filesystem::file_size(theFilename) - 1);
+  ASSERT_THROW(WorkloadReader myReader(theFilename), std::runtime_error);
+
+  // wrong magic
+  {
+    std::ofstream myOutput(theFilename, std::ios::binary | std::ios::trunc);
+    const std::vector<char> myZeros(sizeof(WorkloadHeader), 0);
+    myOutput.write(myZeros.data(), myZeros.size());
+  }
+  ASSERT_THROW(WorkloadReader myReader(theFilename), std::runtime_error);
+}
+
+} // namespace qr
+} // namespace uiiit
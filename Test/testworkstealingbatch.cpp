@@ -0,0 +1,140 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ quantum routing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/quantum-routing
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2022 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "QuantumRouting/workstealingbatch.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace qr {
+
+struct TestWorkStealingBatch : public ::testing::Test {
+  struct Plain {
+    std::size_t theValue;
+  };
+
+  struct Costly {
+    std::size_t theValue;
+    double      cost() const {
+      return static_cast<double>(theValue);
+    }
+  };
+};
+
+TEST_F(TestWorkStealingBatch, test_cost_detection) {
+  static_assert(not detail::HasCost<Plain>::value);
+  static_assert(detail::HasCost<Costly>::value);
+}
+
+TEST_F(TestWorkStealingBatch, test_all_executed) {
+  for (const std::size_t myNumThreads : {1, 2, 5}) {
+    std::vector<Plain> myParameters;
+    std::size_t        myExpected = 0;
+    for (std::size_t i = 0; i < 100; i++) {
+      myParameters.emplace_back(Plain{i});
+      myExpected += i;
+    }
+    std::atomic<std::size_t> mySum(0);
+    WorkStealingBatch<Plain> myBatch(
+        myNumThreads, std::move(myParameters), [&mySum](Plain&& aPlain) {
+          mySum += aPlain.theValue;
+          if (aPlain.theValue % 10 == 0) {
+            throw std::runtime_error("multiple of ten");
+          }
+        });
+    ASSERT_EQ(10, myBatch.wait().size());
+    ASSERT_EQ(myExpected, mySum);
+
+    ASSERT_EQ(myNumThreads, myBatch.stats().size());
+    std::size_t myExecuted = 0;
+    for (const auto& myStats : myBatch.stats()) {
+      myExecuted += myStats.theExecuted;
+      ASSERT_GE(myStats.theBusy, 0);
+      ASSERT_GE(myStats.theIdle, 0);
+    }
+    ASSERT_EQ(100, myExecuted);
+  }
+
+  ASSERT_THROW(
+      WorkStealingBatch<Plain>(0, std::vector<Plain>(), [](Plain&&) {}),
+      std::runtime_error);
+}
+
+TEST_F(TestWorkStealingBatch, test_longest_first) {
+  std::vector<Costly> myParameters;
+  for (std::size_t i = 0; i < 10; i++) {
+    myParameters.emplace_back(Costly{(i * 7) % 10});
+  }
+  std::vector<std::size_t>  myOrder;
+  WorkStealingBatch<Costly> myBatch(
+      1, std::move(myParameters), [&myOrder](Costly&& aCostly) {
+        myOrder.emplace_back(aCostly.theValue);
+      });
+  ASSERT_TRUE(myBatch.wait().empty());
+  ASSERT_EQ(std::vector<std::size_t>({9, 8, 7, 6, 5, 4, 3, 2, 1, 0}), myOrder);
+}
+
+TEST_F(TestWorkStealingBatch, test_steal) {
+  // the first item, dealt to the first thread, is much longer than the others
+  std::vector<Plain> myParameters;
+  for (std::size_t i = 0; i < 20; i++) {
+    myParameters.emplace_back(Plain{i});
+  }
+  std::vector<std::size_t> myOrder; // only the second thread adds
+  WorkStealingBatch<Plain> myBatch(
+      2, std::move(myParameters), [&myOrder](Plain&& aPlain) {
+        if (aPlain.theValue != 0) {
+          myOrder.emplace_back(aPlain.theValue);
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(aPlain.theValue == 0 ? 200 : 1));
+      });
+  ASSERT_TRUE(myBatch.wait().empty());
+  ASSERT_EQ(1, myBatch.stats()[0].theExecuted);
+  ASSERT_EQ(19, myBatch.stats()[1].theExecuted);
+  ASSERT_EQ(9, myBatch.stats()[1].theStolen);
+  ASSERT_GT(myBatch.stats()[1].theIdle, myBatch.stats()[0].theIdle);
+
+  // own items from the front, then stolen from the back of the other deque
+  ASSERT_EQ(std::vector<std::size_t>({1,  3,  5,  7,  9,  11, 13, 15, 17, 19,
+                                      18, 16, 14, 12, 10, 8,  6,  4,  2}),
+            myOrder);
+}
+
+} // namespace qr
+} // namespace uiiit